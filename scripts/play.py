@@ -5,7 +5,10 @@ This script loads a trained model and lets it play the game.
 Use this to see how well your agent has learned!
 
 To run:
-    python scripts/play.py
+    python scripts/play.py                  # fastest engine this machine has
+    python scripts/play.py --engine eager   # plain PyTorch (model.predict)
+    python scripts/play.py --incremental    # re-encode only the patches that changed
+    python scripts/play.py --record logs/trajectories/play.gtt   # save every step
 
 Teacher Note: Inference vs Training
 ===================================
@@ -14,6 +17,7 @@ During inference (playing), we use deterministic=True to always pick
 the action the model thinks is best.
 """
 
+import argparse
 import os
 import sys
 import time
@@ -24,6 +28,8 @@ sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
 from stable_baselines3 import PPO
 from src.gametrainer.env_vit import StardewViTEnv
 from src.gametrainer.hardware import detect_accelerator, print_accelerator_banner
+from src.gametrainer.inference import ENGINES, InferenceEngine
+from src.gametrainer import profiler
 
 # Check both model directories (old CNN and new ViT)
 MODEL_DIRS = [
@@ -33,6 +39,35 @@ MODEL_DIRS = [
 
 
 def main():
+    parser = argparse.ArgumentParser(description="Run a trained ViT agent")
+    parser.add_argument(
+        "--engine",
+        choices=ENGINES,
+        default="auto",
+        help="Inference backend: onnx (ONNX Runtime/TensorRT), compile "
+             "(torch.compile), eager, or auto (best available; default)"
+    )
+    parser.add_argument(
+        "--incremental",
+        action="store_true",
+        help="Only run the ViT on patches that changed since the last frame "
+             "(approximate, stateful: uses the eager engine)"
+    )
+    parser.add_argument(
+        "--profile",
+        action="store_true",
+        help="Time every step stage; print p50/p99 per stage and write logs/play_trace.json"
+    )
+    parser.add_argument(
+        "--record",
+        metavar="PATH",
+        help="Save every step to this trajectory file for offline training "
+             "(see src/gametrainer/recorder.py)"
+    )
+    args = parser.parse_args()
+    if args.profile and not profiler.enable(trace=True):
+        print("  [!] Profiling needs the C++ extension (GAMETRAINER_BUILD_CPP=1)")
+
     accel = detect_accelerator(prefer_gpu=True)
     print_accelerator_banner(accel)
 
@@ -79,8 +114,26 @@ def main():
         print(f"  [!!] Failed to load model: {e}")
         return
 
+    # Teacher Note: Playing only needs "frame in, best action out", so we
+    # hand that part to an optimized runtime (see inference.py)
+    engine_name = args.engine
+    extractor = model.policy.features_extractor
+    if args.incremental and hasattr(extractor, "enable_incremental"):
+        # Keeps per-frame state between calls - not something an exported graph can do
+        if extractor.enable_incremental():
+            engine_name = "eager"
+    try:
+        engine = InferenceEngine(model, model_path, accel.chosen, engine=engine_name)
+    except Exception as e:
+        print(f"  [!!] Failed to set up inference: {e}")
+        return
+
     print("\nCreating environment...")
     env = StardewViTEnv(render_mode='human')
+    if args.record:
+        from src.gametrainer.recorder import RecordingEnv
+        env = RecordingEnv(env, args.record)
+        print(f"  Recording every step -> {args.record}")
 
     print("\n" + "=" * 60)
     print("PLAYING - Switch to Stardew Valley window!")
@@ -96,7 +149,7 @@ def main():
     try:
         while True:
             # Get action from model (deterministic = always best action)
-            action, _ = model.predict(obs, deterministic=True)
+            action, _ = engine.predict(obs, deterministic=True)
             obs, reward, terminated, truncated, info = env.step(action)
 
             total_reward += reward
@@ -124,6 +177,10 @@ def main():
 
     finally:
         env.close()
+        if profiler.enabled():
+            print(profiler.report())
+            os.makedirs("logs", exist_ok=True)
+            print(f"Trace: {profiler.write_trace('logs/play_trace.json'):,} spans -> logs/play_trace.json")
 
 
 if __name__ == "__main__":
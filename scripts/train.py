@@ -11,6 +11,12 @@ Usage:
 
     python scripts/train.py small --freeze    # Freeze ViT backbone (faster training)
     python scripts/train.py small --steps 50000  # Custom timestep count
+    python scripts/train.py small --envs 2       # Two game windows at once
+    python scripts/train.py small --pipelined    # Native capture/reward thread
+    python scripts/train.py small --envs 8 --subproc  # One process per window
+    python scripts/train.py tiny --replay logs/replay.gtr  # Benchmark, no game needed
+    python scripts/train.py small --record logs/trajectories/run1.gtt  # Save every step
+    python scripts/train.py small --pin-threads  # Native threads on P-cores / MMCSS
 
 Teacher Note: Why ViT over CNN?
 ===============================
@@ -31,6 +37,7 @@ import sys
 import time
 import argparse
 import subprocess
+from functools import partial
 import numpy as np
 
 # Add project root to path for imports
@@ -135,15 +142,21 @@ def check_all_dependencies() -> bool:
 def do_imports():
     """Import training modules after dependencies are verified."""
     global PPO, DummyVecEnv, CheckpointCallback, BaseCallback
-    global StardewViTEnv, ViTFeaturesExtractor, ViTSmallFeaturesExtractor, ViTTinyFeaturesExtractor
-    global detect_accelerator, print_accelerator_banner
+    global StardewViTEnv, StardewVecEnv, ShmSubprocVecEnv, ScreenCapture, PinnedRolloutBuffer, FeatureCacheRolloutBuffer, ViTFeaturesExtractor, ViTSmallFeaturesExtractor, ViTTinyFeaturesExtractor
+    global detect_accelerator, print_accelerator_banner, profiler, scheduling
 
     from stable_baselines3 import PPO
     from stable_baselines3.common.vec_env import DummyVecEnv
     from stable_baselines3.common.callbacks import CheckpointCallback, BaseCallback
 
     from src.gametrainer.env_vit import StardewViTEnv
+    from src.gametrainer.vec_env import StardewVecEnv
+    from src.gametrainer.shm_vec_env import ShmSubprocVecEnv
+    from src.gametrainer.screen import ScreenCapture
+    from src.gametrainer.pinned_buffer import PinnedRolloutBuffer
+    from src.gametrainer.feature_cache import FeatureCacheRolloutBuffer
     from src.gametrainer.hardware import detect_accelerator, print_accelerator_banner
+    from src.gametrainer import profiler, scheduling
     from src.gametrainer.vit_extractor import (
         ViTFeaturesExtractor,
         ViTSmallFeaturesExtractor,
@@ -220,10 +233,96 @@ def create_action_logging_callback():
             print(">>> STARTING GPU UPDATE PHASE (LEARNING) <<<")
             print("The bot will pause for a moment while the neural network weights are updated.")
             print("="*70 + "\n")
+            if profiler.enabled():
+                print(profiler.report("STEP PROFILE (this run so far)") + "\n")
+                print(scheduling.report() + "\n")
 
     return ActionLoggingCallback
 
 
+def create_throughput_callback():
+    """Create the replay benchmark callback class after imports are done."""
+
+    class ThroughputCallback(BaseCallback):
+        """
+        Times PPO's two phases: collecting rollouts (env steps/s) and the
+        update in between (minibatch gradient steps/s).
+
+        Teacher Note: SB3 calls _on_rollout_start / _on_rollout_end around
+        every collection, so the time from a rollout's end to the next
+        one's start is exactly the update.
+        """
+
+        def __init__(self, verbose: int = 0):
+            super().__init__(verbose)
+            self.collect_s = 0.0
+            self.train_s = 0.0
+            self.rollouts = 0
+            self.updates = 0
+            self._t0 = None
+            self._mark = None
+            self._last_end = None
+
+        def _on_training_start(self) -> None:
+            self._t0 = time.perf_counter()
+
+        def _on_rollout_start(self) -> None:
+            now = time.perf_counter()
+            self._count_update(now)
+            self._mark = now
+
+        def _on_step(self) -> bool:
+            return True
+
+        def _on_rollout_end(self) -> None:
+            now = time.perf_counter()
+            self.collect_s += now - self._mark
+            self.rollouts += 1
+            self._last_end = now
+
+        def _on_training_end(self) -> None:
+            self._count_update(time.perf_counter())
+
+        def _count_update(self, now: float) -> None:
+            """An update ran from the last rollout end until now."""
+            if self._last_end is None:
+                return
+            m = self.model
+            per_epoch = -(-m.n_steps * m.n_envs // m.batch_size)
+            self.train_s += now - self._last_end
+            self.updates += m.n_epochs * per_epoch
+            self._last_end = None
+
+        def results(self) -> dict:
+            wall = time.perf_counter() - self._t0 if self._t0 else 0.0
+            steps = self.model.num_timesteps
+            return {
+                "timesteps": steps,
+                "rollouts": self.rollouts,
+                "steps_per_s": steps / self.collect_s if self.collect_s else 0.0,
+                "wall_steps_per_s": steps / wall if wall else 0.0,
+                "updates_per_s": self.updates / self.train_s if self.train_s else 0.0,
+                "collect_s": self.collect_s,
+                "train_s": self.train_s,
+                "stages": profiler.stats(),
+            }
+
+        def report(self) -> str:
+            r = self.results()
+            return "\n".join([
+                "=" * 72,
+                "REPLAY BENCHMARK",
+                "=" * 72,
+                f"  Timesteps:               {r['timesteps']:,} ({r['rollouts']} rollouts)",
+                f"  Env steps/s (collect):   {r['steps_per_s']:.1f}",
+                f"  Env steps/s (wall):      {r['wall_steps_per_s']:.1f}",
+                f"  PPO updates/s:           {r['updates_per_s']:.1f} (minibatch gradient steps)",
+                f"  Time collecting / training: {r['collect_s']:.1f} s / {r['train_s']:.1f} s",
+            ])
+
+    return ThroughputCallback
+
+
 # =============================================================================
 # ARGUMENT PARSING
 # =============================================================================
@@ -242,6 +341,12 @@ Examples:
 
   python scripts/train.py small --freeze       # Freeze backbone (faster)
   python scripts/train.py small --steps 50000  # Train for 50k steps
+  python scripts/train.py small --envs 2       # Two game windows, batched
+  python scripts/train.py small --pipelined    # Capture + reward off the main thread
+  python scripts/train.py small --envs 8 --subproc  # One process per window, shared-memory obs
+  python scripts/train.py tiny --replay logs/replay.gtr --steps 4096  # Throughput benchmark
+  python scripts/train.py small --record logs/trajectories/run1.gtt  # Save every step
+  python scripts/train.py small --pin-threads  # Native threads on P-cores / MMCSS
 
 ViT Sizes:
   tiny   5.7M params, ~3GB VRAM  - Fast experiments
@@ -271,6 +376,59 @@ ViT Sizes:
         help=f"Total training timesteps (default: {DEFAULT_TIMESTEPS:,})"
     )
 
+    parser.add_argument(
+        "--envs",
+        type=int,
+        default=1,
+        help="Game instances to train on at once, one window each (default: 1)"
+    )
+
+    parser.add_argument(
+        "--pipelined",
+        action="store_true",
+        help="Run capture, reward features and preprocessing on the native step pipeline"
+    )
+
+    parser.add_argument(
+        "--subproc",
+        action="store_true",
+        help="With --envs: one process per game window, observations in shared memory"
+    )
+
+    parser.add_argument(
+        "--sendinput",
+        action="store_true",
+        help="With --envs: send input through SendInput (focusing each window in turn) instead of "
+             "posting window messages - for games that ignore messages, which can't be detected"
+    )
+
+    parser.add_argument(
+        "--profile",
+        action="store_true",
+        help="Time every step stage (p50/p99 per stage, Chrome trace in logs/vit/step_trace.json)"
+    )
+
+    parser.add_argument(
+        "--replay",
+        metavar="PATH",
+        help="Benchmark: play this replay file instead of the game (made if missing, "
+             "see scripts/record_replay.py); reports steps/s, PPO updates/s and stage latency"
+    )
+
+    parser.add_argument(
+        "--record",
+        metavar="PATH",
+        help="Save every step (observation, action, reward, reward features) to this "
+             "trajectory file for offline training (see src/gametrainer/recorder.py)"
+    )
+
+    parser.add_argument(
+        "--pin-threads",
+        action="store_true",
+        help="Pin the native capture/input/pipeline threads to performance cores with MMCSS "
+             "priorities, recorder/window tracker to efficiency cores (see src/gametrainer/scheduling.py)"
+    )
+
     parser.add_argument(
         "--resume",
         action="store_true",
@@ -329,19 +487,71 @@ def main():
         print("  [OK] C++ input extension loaded")
     except ImportError:
         print("  [!!] WARNING: C++ input extension not found!")
-        print("       Actions will NOT be sent to the game!")
-        print("       Run 'pip install -e .' to build the extension.")
-        response = input("       Continue anyway? (y/n): ")
-        if response.lower() != 'y':
-            return
+        if args.replay:
+            print("       Replay benchmark: numpy fallbacks, no native stage timings.")
+        else:
+            print("       Actions will NOT be sent to the game!")
+            print("       Run 'pip install -e .' to build the extension.")
+            response = input("       Continue anyway? (y/n): ")
+            if response.lower() != 'y':
+                return
 
     # 4. Create directories
     os.makedirs(MODEL_DIR, exist_ok=True)
     os.makedirs(LOG_DIR, exist_ok=True)
 
+    # 4.5 Native thread placement, before the env starts those threads
+    if args.pin_threads:
+        if scheduling.pin_for_game():
+            masks = scheduling.core_masks()
+            print(f"  Native threads pinned (P-cores {masks['performance']:#x}, "
+                  f"E-cores {masks['efficiency']:#x})")
+        else:
+            print("  [!] --pin-threads needs the C++ extension (GAMETRAINER_BUILD_CPP=1)")
+
     # 5. Initialize Environment
+    # Teacher Note: With --envs N, StardewVecEnv steps N game windows together
+    # (one capture, native per-instance workers) and PPO gets N observations
+    # per forward pass. n_steps below is per instance.
+    # --pipelined moves each step's capture and pixel work onto a native
+    # thread (src/gametrainer/pipeline.py). --subproc gives every window its
+    # own process instead (own capture, own Python interpreter), with the
+    # observations handed over in shared memory (src/gametrainer/shm_vec_env.py).
     print("\nInitializing environment...")
-    env = DummyVecEnv([lambda: StardewViTEnv(render_mode='rgb_array')])
+    if args.replay:
+        # Teacher Note: A replay benchmark plays recorded frames on the
+        # replay's clock and swallows input (with its real timing) - same
+        # env code, no game, and the same numbers on every run.
+        if not os.path.exists(args.replay):
+            from src.gametrainer.replay import write_synthetic
+            print(f"  Replay {args.replay} not found: generating a synthetic one...")
+            write_synthetic(args.replay)
+        env = DummyVecEnv([partial(StardewViTEnv, render_mode='rgb_array', replay=args.replay)] * args.envs)
+    elif args.envs > 1 and args.subproc:
+        hwnds = ScreenCapture().find_windows("Stardew Valley")[:args.envs]
+        if not hwnds:
+            print("  [!] No game windows found")
+            return
+        if len(hwnds) < args.envs:
+            print(f"  [!] Only {len(hwnds)} game window(s) found (asked for {args.envs})")
+        env = ShmSubprocVecEnv([
+            partial(StardewViTEnv, render_mode='rgb_array', hwnd=hwnd, pipelined=args.pipelined,
+                    sendinput=args.sendinput)
+            for hwnd in hwnds
+        ])
+    elif args.envs > 1:
+        env = StardewVecEnv(num_envs=args.envs, render_mode='rgb_array', pipelined=args.pipelined,
+                            sendinput=args.sendinput)
+        if env.num_envs < args.envs:
+            print(f"  [!] Only {env.num_envs} game window(s) found (asked for {args.envs})")
+    else:
+        env = DummyVecEnv([lambda: StardewViTEnv(render_mode='rgb_array', pipelined=args.pipelined)])
+    if args.record:
+        # Teacher Note: Recording costs one memcpy per step; a native thread
+        # writes to disk, so training never waits for it.
+        from src.gametrainer.recorder import RecordingVecEnv
+        env = RecordingVecEnv(env, args.record)
+        print(f"  Recording every step -> {args.record}")
 
     # 6. Select ViT variant based on argument
     print(f"\n{'='*60}")
@@ -350,6 +560,10 @@ def main():
     print(f"  Model Size:     {args.size.upper()}")
     print(f"  Freeze Backbone: {args.freeze}")
     print(f"  Training Steps: {args.steps:,}")
+    print(f"  Game Instances: {env.num_envs}")
+    print(f"  Pipelined Step: {args.pipelined}")
+    if args.replay:
+        print(f"  Replay:         {args.replay} (benchmark)")
 
     if args.size == "tiny":
         features_extractor_class = ViTTinyFeaturesExtractor
@@ -374,12 +588,16 @@ def main():
     print_accelerator_banner(accel)
 
     # 7. Policy kwargs
+    # Teacher Note: normalize_images=False keeps SB3 from dividing by 255
+    # on its own; the extractor folds that into its single normalization op.
     policy_kwargs = dict(
         features_extractor_class=features_extractor_class,
         features_extractor_kwargs=dict(
             pretrained=True,
             freeze_backbone=args.freeze,
+            raw_pixels=True,
         ),
+        normalize_images=False,
         net_arch=dict(
             pi=[256, 128],
             vf=[256, 128],
@@ -404,6 +622,10 @@ def main():
             )
             model_paths.append(os.path.join(MODEL_DIR, checkpoints[0]))
 
+    # A benchmark always starts from a fresh model (and never saves one)
+    if args.replay:
+        model_paths = []
+
     for path in model_paths:
         if os.path.exists(path):
             print(f"Found existing model: {path}")
@@ -423,6 +645,14 @@ def main():
 
     if model is None:
         print("Creating new PPO agent with ViT...")
+        # Teacher Note: A frozen ViT gives the same features for the same
+        # frame, so store those (1.5 KB/step) and skip the ViT in PPO's
+        # update epochs; a trained ViT needs the frames themselves.
+        if args.freeze:
+            buffer_kwargs = dict(rollout_buffer_class=FeatureCacheRolloutBuffer,
+                                 rollout_buffer_kwargs=dict(features_dim=features_dim))
+        else:
+            buffer_kwargs = dict(rollout_buffer_class=PinnedRolloutBuffer)   # uint8 + pinned, one upload per rollout
         model = PPO(
             "CnnPolicy",
             env,
@@ -430,6 +660,7 @@ def main():
             verbose=1,
             tensorboard_log=LOG_DIR,
             device=accel.chosen,
+            **buffer_kwargs,
             learning_rate=1e-4,
             n_steps=1024,
             batch_size=32,
@@ -440,6 +671,10 @@ def main():
             ent_coef=0.01,
         )
 
+    if isinstance(model.rollout_buffer, FeatureCacheRolloutBuffer):
+        model.rollout_buffer.attach(model.policy)
+        print("  Rollout buffer: cached backbone features")
+
     # 9. Print model summary
     print(f"\n{'='*60}")
     print("MODEL SUMMARY")
@@ -451,6 +686,13 @@ def main():
     print(f"  Frozen parameters:    {total_params - trainable_params:,}")
     print('='*60)
 
+    if args.profile or args.replay:
+        if profiler.enable(trace=True):
+            profiler.instrument_policy(model.policy)
+            print("  Profiling: on (per-stage latency at every rollout end)")
+        else:
+            print("  [!] Profiling needs the C++ extension (GAMETRAINER_BUILD_CPP=1)")
+
     # 10. Setup callbacks
     from stable_baselines3.common.callbacks import CallbackList
 
@@ -463,16 +705,22 @@ def main():
     ActionLoggingCallbackClass = create_action_logging_callback()
     action_logger = ActionLoggingCallbackClass(log_freq=1000)
 
-    callback_list = CallbackList([checkpoint_callback, action_logger])
+    throughput = None
+    if args.replay:
+        throughput = create_throughput_callback()()
+        callback_list = CallbackList([action_logger, throughput])
+    else:
+        callback_list = CallbackList([checkpoint_callback, action_logger])
 
     # 11. Start training
     print(f"\nStarting training for {args.steps:,} timesteps...")
-    print("Switch to the Stardew Valley window NOW!")
-    print("=" * 60)
+    if not args.replay:
+        print("Switch to the Stardew Valley window NOW!")
+        print("=" * 60)
 
-    for i in range(5, 0, -1):
-        print(f"  Starting in {i}...")
-        time.sleep(1)
+        for i in range(5, 0, -1):
+            print(f"  Starting in {i}...")
+            time.sleep(1)
 
     print("\n[TRAINING STARTED]\n")
 
@@ -494,16 +742,33 @@ def main():
         print("\n" + "=" * 60)
         print("TRAINING COMPLETE!")
         print("=" * 60)
-        model.save(f"{MODEL_DIR}/final_model")
-        print(f"Model saved to: {MODEL_DIR}/final_model.zip")
+        if not args.replay:
+            model.save(f"{MODEL_DIR}/final_model")
+            print(f"Model saved to: {MODEL_DIR}/final_model.zip")
 
     except KeyboardInterrupt:
-        print("\n\nTraining interrupted. Saving model...")
-        model.save(f"{MODEL_DIR}/interrupted_model")
-        print(f"Model saved to: {MODEL_DIR}/interrupted_model.zip")
+        if not args.replay:
+            print("\n\nTraining interrupted. Saving model...")
+            model.save(f"{MODEL_DIR}/interrupted_model")
+            print(f"Model saved to: {MODEL_DIR}/interrupted_model.zip")
 
     finally:
         env.close()
+        if throughput is not None:
+            # Teacher Note: The JSON is what CI compares between runs.
+            import json
+            print(throughput.report())
+            bench_path = os.path.join(LOG_DIR, "replay_bench.json")
+            os.makedirs(LOG_DIR, exist_ok=True)
+            with open(bench_path, "w") as f:
+                json.dump(throughput.results(), f, indent=2)
+            print(f"Results: {bench_path}")
+        if profiler.enabled():
+            print(profiler.report())
+            print(scheduling.report())
+            trace_path = os.path.join(LOG_DIR, "step_trace.json")
+            os.makedirs(LOG_DIR, exist_ok=True)
+            print(f"Trace: {profiler.write_trace(trace_path):,} spans -> {trace_path}")
 
 
 if __name__ == "__main__":
@@ -5,6 +5,7 @@ This script shows how to:
 1. Extract and save just the CNN (feature extractor) from a trained model
 2. Load a pre-trained CNN into a new model
 3. Fine-tune vs freeze layers
+4. Train a model offline on recorded steps (train.py/play.py --record)
 
 Teacher Note: Transfer learning lets you reuse what the model learned about
 "seeing" (edges, shapes, UI patterns) while retraining what it learned about
@@ -166,23 +167,70 @@ def compare_before_after(model_path: str, new_task_model_path: str = None):
         print("No comparison model provided. Train on a new task first!")
 
 
+def behavior_clone(model_path: str, trajectory_path: str, output_path: str,
+                   epochs: int = 1, batch_size: int = 64):
+    """
+    Fine-tune a model's policy to pick the actions in a trajectory file
+    (recorded with --record), then save it.
+
+    Teacher Note: This is offline training - the game isn't running, so it
+    goes as fast as the GPU can read batches from the memory-mapped file.
+    Recorded actions are only as good as the agent that played them, so
+    use it to give a new model (or a bigger ViT) a head start, then let
+    PPO take over.
+    """
+    from torch.utils.data import DataLoader
+    from src.gametrainer.recorder import TrajectoryReader
+
+    trajectory = TrajectoryReader(trajectory_path)
+    print(f"\nBehavior cloning {model_path} on {len(trajectory):,} recorded steps")
+    model = PPO.load(model_path)
+    policy = model.policy
+    policy.set_training_mode(True)
+    loader = DataLoader(trajectory.torch_dataset(), batch_size=batch_size, shuffle=True)
+
+    for epoch in range(epochs):
+        total_loss, seen = 0.0, 0
+        for obs, actions, _ in loader:
+            # get_distribution normalizes the uint8 observations itself
+            dist = policy.get_distribution(obs.to(policy.device))
+            loss = -dist.log_prob(actions.to(policy.device)).mean()
+            policy.optimizer.zero_grad()
+            loss.backward()
+            policy.optimizer.step()
+            total_loss += loss.item() * len(actions)
+            seen += len(actions)
+        print(f"  Epoch {epoch + 1}/{epochs}: loss {total_loss / max(1, seen):.4f}")
+
+    model.save(output_path)
+    print(f"Saved cloned model to: {output_path}")
+    return output_path
+
+
 if __name__ == "__main__":
     import argparse
 
     parser = argparse.ArgumentParser(description="Transfer Learning Utilities")
-    parser.add_argument("command", choices=["inspect", "extract", "info"],
+    parser.add_argument("command", choices=["inspect", "extract", "clone", "info"],
                        help="Command to run")
     parser.add_argument("--model", type=str, default="models/ppo_stardew/final_model.zip",
                        help="Path to model file")
-    parser.add_argument("--output", type=str, default="models/pretrained_cnn.pt",
-                       help="Output path for extracted CNN")
+    parser.add_argument("--output", type=str, default=None,
+                       help="Output path (extract: models/pretrained_cnn.pt, clone: models/cloned_model)")
+    parser.add_argument("--trajectory", type=str, default=None,
+                       help="clone: trajectory file recorded with --record")
+    parser.add_argument("--epochs", type=int, default=1, help="clone: passes over the trajectory")
 
     args = parser.parse_args()
 
     if args.command == "inspect":
         inspect_model(args.model)
     elif args.command == "extract":
-        save_feature_extractor(args.model, args.output)
+        save_feature_extractor(args.model, args.output or "models/pretrained_cnn.pt")
+    elif args.command == "clone":
+        if not args.trajectory:
+            parser.error("clone needs --trajectory")
+        behavior_clone(args.model, args.trajectory, args.output or "models/cloned_model", args.epochs)
     elif args.command == "info":
         print("""
 TRANSFER LEARNING GUIDE
@@ -208,4 +256,6 @@ What can be transferred between training runs:
 4. Commands:
    python scripts/transfer_learning.py inspect --model models/ppo_stardew/final_model.zip
    python scripts/transfer_learning.py extract --model models/ppo_stardew/final_model.zip
+   python scripts/transfer_learning.py clone --model models/ppo_stardew/final_model.zip \\
+       --trajectory logs/trajectories/run1.gtt --epochs 3
 """)
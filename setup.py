@@ -27,8 +27,28 @@ if sys.platform == "win32" and os.environ.get("GAMETRAINER_BUILD_CPP") == "1":
             "src.gametrainer.clib",
             sources=[
                 "src/cpp/clib.cpp",
+                "src/cpp/batch_observe.cpp",
+                "src/cpp/capture.cpp",
+                "src/cpp/capture_ring.cpp",
+                "src/cpp/delta_codec.cpp",
+                "src/cpp/event_bus.cpp",
+                "src/cpp/input.cpp",
+                "src/cpp/parallel.cpp",
+                "src/cpp/preprocess.cpp",
+                "src/cpp/profiler.cpp",
+                "src/cpp/recorder.cpp",
+                "src/cpp/replay.cpp",
+                "src/cpp/reward.cpp",
+                "src/cpp/scheduling.cpp",
+                "src/cpp/step_pipeline.cpp",
+                "src/cpp/template_match.cpp",
+                "src/cpp/tile_hash.cpp",
+                "src/cpp/timing.cpp",
+                "src/cpp/trajectory.cpp",
+                "src/cpp/window_input.cpp",
+                "src/cpp/window_tracker.cpp",
             ],
-            libraries=["user32", "kernel32"],
+            libraries=["user32", "kernel32", "d3d11", "dxgi", "avrt"],
         )
     ]
 
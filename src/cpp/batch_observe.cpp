@@ -0,0 +1,36 @@
+#include "batch_observe.h"
+
+#include <algorithm>
+
+#include "parallel.h"
+#include "preprocess.h"
+#include "profiler.h"
+
+// ============================================================================
+// BATCHED OBSERVATIONS IMPLEMENTATION
+// ============================================================================
+
+void ObserveBatch(const FrameView& frame, const FrameView* before,
+                  const BatchInstance* instances, int count,
+                  uint8_t* obs, int out_w, int out_h, int threads,
+                  RewardFeatures* features) {
+    ScopedSpan span(PROFILE_OBSERVE_BATCH);
+    const size_t obs_size = (size_t)3 * out_w * out_h;
+    ParallelFor(count, threads, [&](int i) {
+        const BatchInstance& inst = instances[i];
+        const FrameView view = SubView(frame, inst.rect);
+        if (view.width == 0 || view.height == 0) {
+            // Window outside the captured frame (moved, minimized...)
+            if (obs) std::fill(obs + i * obs_size, obs + (i + 1) * obs_size, (uint8_t)0);
+            if (inst.reward) features[i] = RewardFeatures{-1.0f, -1.0f, -1.0f, -1.0f};
+            return;
+        }
+
+        if (obs) PreprocessFrame(view, obs + i * obs_size, out_w, out_h);
+        if (inst.reward) {
+            FrameView before_view;
+            if (before) before_view = SubView(*before, inst.rect);
+            features[i] = inst.reward->Compute(view, before ? &before_view : nullptr, inst.regions);
+        }
+    });
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+#include "frame.h"
+#include "reward.h"
+
+// ============================================================================
+// BATCHED OBSERVATIONS (several game instances, one frame)
+// ============================================================================
+//
+// Teacher Note: StardewVecEnv runs N game windows side by side. Instead of N
+// captures, we capture ONE frame covering all of them (one DXGI copy), and
+// every instance is just a rectangle of it. Each step then needs, per
+// instance, the 224x224 observation (PreprocessFrame) and the reward pixel
+// statistics (RewardFeatureExtractor). Instances don't share any state, so
+// they are processed in parallel, one per thread, and the observations land
+// in one contiguous (N, 3, out_h, out_w) buffer that goes to the policy as a
+// single batch.
+
+struct BatchInstance {
+    FrameRect rect;                    // instance window inside the frame
+    RewardFeatureExtractor* reward;    // null = no reward features
+    RewardRegions regions;             // relative to rect
+};
+
+// obs: count * 3 * out_h * out_w bytes, or null to skip observations.
+// before: the previous frame (same size as frame) for the cursor diff, or null.
+// features: count entries, filled where instances[i].reward is set.
+// threads: 0 = one per core (see parallel.h).
+void ObserveBatch(const FrameView& frame, const FrameView* before,
+                  const BatchInstance* instances, int count,
+                  uint8_t* obs, int out_w, int out_h, int threads,
+                  RewardFeatures* features);
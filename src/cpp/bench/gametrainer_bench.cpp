@@ -0,0 +1,328 @@
+// ============================================================================
+// GAMETRAINER NATIVE MICROBENCHMARKS
+// ============================================================================
+//
+// Teacher Note: One number per kernel, measured the same way on every
+// machine and every release, so a change that makes something slower shows
+// up as a number instead of a feeling. Built by CMake (gametrainer_bench,
+// Google Benchmark) against gametrainer_core - the same code clib runs.
+//
+// Two families:
+//   Synthetic/...  vision kernels on generated frames; no desktop needed,
+//                  safe on build machines and CI
+//   Desktop/...    touch the real machine: SendInput (zero-distance mouse
+//                  moves), timer precision, DXGI capture FPS. Capture FPS
+//                  depends on what is on screen - DXGI only delivers a new
+//                  frame when something changed, so play a video or the game.
+//
+//     gametrainer_bench --benchmark_filter=Synthetic
+//     gametrainer_bench --benchmark_out=bench.json --benchmark_out_format=json
+//
+// The Python mss backend is not native and isn't measured here.
+
+#include <benchmark/benchmark.h>
+
+#include <Windows.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "capture.h"
+#include "capture_ring.h"
+#include "delta_codec.h"
+#include "event_bus.h"
+#include "input.h"
+#include "preprocess.h"
+#include "reward.h"
+#include "template_match.h"
+#include "tile_hash.h"
+#include "timing.h"
+
+namespace {
+
+// ----------------------------------------------------------------------------
+// Synthetic frames
+// ----------------------------------------------------------------------------
+
+// A BGRA frame with smooth gradients, blocky "UI" rectangles and noise, so
+// kernels see realistic (not constant) data. Deterministic for a given seed.
+struct SyntheticFrame {
+    int width;
+    int height;
+    std::vector<uint8_t> pixels;
+
+    SyntheticFrame(int w, int h, uint32_t seed = 1) : width(w), height(h), pixels((size_t)w * h * 4) {
+        uint32_t state = seed * 2654435761u + 1;
+        auto next = [&] {
+            state = state * 1664525u + 1013904223u;
+            return state >> 24;
+        };
+        for (int y = 0; y < h; ++y) {
+            uint8_t* row = &pixels[(size_t)y * w * 4];
+            for (int x = 0; x < w; ++x) {
+                const bool block = ((x / 48) + (y / 32)) % 7 == 0;
+                row[x * 4 + 0] = (uint8_t)(block ? 40 : (x * 255 / w) ^ (next() & 15));
+                row[x * 4 + 1] = (uint8_t)(block ? 200 : (y * 255 / h) ^ (next() & 15));
+                row[x * 4 + 2] = (uint8_t)(block ? 60 : ((x + y) & 255));
+                row[x * 4 + 3] = 255;
+            }
+        }
+    }
+
+    FrameView View() const { return {pixels.data(), width, height, width * 4, 4}; }
+};
+
+// Grayscale copy of a w x h patch of frame at (x, y), as a template.
+std::vector<uint8_t> GrayPatch(const FrameView& frame, int x, int y, int w, int h) {
+    std::vector<uint8_t> out((size_t)w * h);
+    for (int r = 0; r < h; ++r) {
+        const uint8_t* row = frame.Row(y + r) + (size_t)x * frame.pixel_stride;
+        for (int c = 0; c < w; ++c) out[(size_t)r * w + c] = GrayFromBgr(row + c * frame.pixel_stride);
+    }
+    return out;
+}
+
+// Common window sizes (Args = width, height).
+void FrameSizes(benchmark::internal::Benchmark* b) {
+    b->Args({1280, 720})->Args({1920, 1080})->Args({2560, 1440});
+}
+
+// ----------------------------------------------------------------------------
+// Synthetic: vision kernels
+// ----------------------------------------------------------------------------
+
+// Fused resize + BGR->RGB CHW to the 224x224 ViT observation: ns per frame.
+void BM_Preprocess(benchmark::State& state) {
+    const SyntheticFrame frame((int)state.range(0), (int)state.range(1));
+    std::vector<uint8_t> out((size_t)3 * 224 * 224);
+    for (auto _ : state) {
+        PreprocessFrame(frame.View(), out.data(), 224, 224);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * (int64_t)frame.pixels.size());
+    state.SetLabel(PreprocessSimdLevel());
+}
+BENCHMARK(BM_Preprocess)->Name("Synthetic/Preprocess")->Apply(FrameSizes)->Unit(benchmark::kMicrosecond);
+
+// One reward-feature pass (motion + notification grids, energy, cursor).
+void BM_RewardFeatures(benchmark::State& state) {
+    const SyntheticFrame frame((int)state.range(0), (int)state.range(1), 1);
+    const SyntheticFrame before((int)state.range(0), (int)state.range(1), 2);
+    const FrameView view = frame.View();
+    const FrameView before_view = before.View();
+    const RewardRegions regions = {{view.width - 120, view.height - 260, 24, 200},
+                                   {view.width / 2 - 32, view.height / 2 - 32, 64, 64}};
+    RewardFeatureExtractor extractor;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(extractor.Compute(view, &before_view, regions));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RewardFeatures)->Name("Synthetic/RewardFeatures")->Apply(FrameSizes)->Unit(benchmark::kMicrosecond);
+
+// Change-detection tile hashes over a whole frame.
+void BM_TileHashes(benchmark::State& state) {
+    const SyntheticFrame frame((int)state.range(0), (int)state.range(1));
+    const FrameView view = frame.View();
+    std::vector<uint64_t> hashes((size_t)TileCount(view.width, CAPTURE_TILE) * TileCount(view.height, CAPTURE_TILE));
+    for (auto _ : state) {
+        ComputeTileHashes(view, CAPTURE_TILE, hashes.data());
+        benchmark::DoNotOptimize(hashes.data());
+    }
+    state.SetBytesProcessed(state.iterations() * (int64_t)frame.pixels.size());
+}
+BENCHMARK(BM_TileHashes)->Name("Synthetic/TileHashes")->Apply(FrameSizes)->Unit(benchmark::kMicrosecond);
+
+// Two consecutive "frames": the same pixels, with a band of rows changed
+// (a moving sprite / a HUD update, ~10% of the frame).
+struct FramePair {
+    SyntheticFrame prev;
+    std::vector<uint8_t> cur;
+
+    FramePair(int w, int h) : prev(w, h, 1), cur(prev.pixels) {
+        const SyntheticFrame other(w, h, 2);
+        const size_t band = cur.size() / 10;
+        const size_t start = cur.size() / 2;
+        std::copy(other.pixels.begin() + start, other.pixels.begin() + start + band, cur.begin() + start);
+    }
+};
+
+// Delta-encode a frame against the previous one (recorder / replay files).
+void BM_DeltaEncode(benchmark::State& state) {
+    const FramePair pair((int)state.range(0), (int)state.range(1));
+    std::vector<uint8_t> out(DeltaMaxEncodedSize(pair.cur.size()));
+    size_t size = 0;
+    for (auto _ : state) {
+        size = DeltaEncode(pair.cur.data(), pair.prev.pixels.data(), pair.cur.size(), out.data());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * (int64_t)pair.cur.size());
+    state.counters["ratio"] = (double)pair.cur.size() / (double)size;
+    state.SetLabel(DeltaSimdLevel());
+}
+BENCHMARK(BM_DeltaEncode)
+    ->Name("Synthetic/DeltaEncode")->Args({224, 224})->Apply(FrameSizes)->Unit(benchmark::kMicrosecond);
+
+// Apply that packet in place to the previous frame.
+void BM_DeltaDecode(benchmark::State& state) {
+    const FramePair pair((int)state.range(0), (int)state.range(1));
+    std::vector<uint8_t> packet(DeltaMaxEncodedSize(pair.cur.size()));
+    packet.resize(DeltaEncode(pair.cur.data(), pair.prev.pixels.data(), pair.cur.size(), packet.data()));
+    std::vector<uint8_t> frame = pair.prev.pixels;
+    for (auto _ : state) {
+        // Applying an XOR delta twice restores the frame, so every
+        // iteration does the same work.
+        DeltaDecode(packet.data(), packet.size(), frame.data(), frame.size());
+        benchmark::DoNotOptimize(frame.data());
+    }
+    state.SetBytesProcessed(state.iterations() * (int64_t)frame.size());
+    state.SetLabel(DeltaSimdLevel());
+}
+BENCHMARK(BM_DeltaDecode)
+    ->Name("Synthetic/DeltaDecode")->Args({224, 224})->Apply(FrameSizes)->Unit(benchmark::kMicrosecond);
+
+// Publish one event to the bus from `threads` publishers at once, with a
+// subscriber attached (otherwise publishing returns immediately).
+void BM_EventBusPublish(benchmark::State& state) {
+    static int subscriber = 0;
+    if (state.thread_index() == 0) subscriber = EventBusSubscribe();
+    int64_t i = 0;
+    for (auto _ : state) {
+        EventBusPublish(EVENT_STEP, (uint32_t)state.thread_index(), i, i, 0.5);
+        ++i;
+    }
+    if (state.thread_index() == 0) EventBusUnsubscribe(subscriber);
+}
+BENCHMARK(BM_EventBusPublish)->Name("Synthetic/EventBusPublish")->ThreadRange(1, 4);
+
+// Template match of one square template (Args = template size, hinted):
+// hinted = the search starts where it was found last time (the usual case
+// in play), else the whole 1280x720 scene is scanned.
+void BM_TemplateMatch(benchmark::State& state) {
+    const int size = (int)state.range(0);
+    const bool hinted = state.range(1) != 0;
+    const SyntheticFrame frame(1280, 720);
+    const FrameView view = frame.View();
+    const int tx = 900, ty = 500;
+    const std::vector<uint8_t> templ = GrayPatch(view, tx, ty, size, size);
+
+    TemplateMatcher matcher;
+    matcher.AddTemplate(templ.data(), size, size, size);
+    const int hint_xy[2] = {tx + 3, ty - 2};
+    const char has_hint[1] = {(char)hinted};
+    MatchResult result;
+    for (auto _ : state) {
+        matcher.SetScene(view);
+        matcher.FindAll(hint_xy, has_hint, 32, 0.8f, 1, &result);
+        benchmark::DoNotOptimize(result);
+    }
+    state.counters["score"] = result.score;
+}
+BENCHMARK(BM_TemplateMatch)
+    ->Name("Synthetic/TemplateMatch")
+    ->ArgNames({"size", "hinted"})
+    ->ArgsProduct({{16, 32, 64, 128}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+// ----------------------------------------------------------------------------
+// Desktop: input, timing, capture
+// ----------------------------------------------------------------------------
+
+// SendInput throughput: batches of zero-distance mouse moves (the cursor
+// doesn't go anywhere). Arg = events per SendInput call.
+void BM_SendInputBatch(benchmark::State& state) {
+    const int count = (int)state.range(0);
+    std::vector<BatchEvent> events(count, BatchEvent{EVENT_MOUSE_MOVE, 0, 0});
+    UINT sent = 0;
+    for (auto _ : state) {
+        sent = SendBatch(events.data(), count);
+        benchmark::DoNotOptimize(sent);
+    }
+    if (sent != (UINT)count) state.SkipWithError("SendInput rejected the batch (UIPI / secure desktop?)");
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_SendInputBatch)->Name("Desktop/SendInputBatch")->Arg(1)->Arg(8)->Arg(MAX_BATCH_EVENTS)
+    ->Unit(benchmark::kMicrosecond);
+
+// Sleep precision (Args = requested us, precise mode): how late a sleep
+// wakes up. late_us is the mean overshoot, max_late_us the worst.
+void BM_PreciseSleep(benchmark::State& state) {
+    const uint32_t us = (uint32_t)state.range(0);
+    SetPreciseTiming(state.range(1) != 0);
+    double late_total = 0.0;
+    double late_max = 0.0;
+    for (auto _ : state) {
+        const int64_t start = QpcNow();
+        PreciseSleepUs(us);
+        const double late = QpcToUs(QpcNow() - start) - us;
+        late_total += late;
+        late_max = std::max(late_max, late);
+    }
+    SetPreciseTiming(false);
+    state.counters["late_us"] = benchmark::Counter(late_total, benchmark::Counter::kAvgIterations);
+    state.counters["max_late_us"] = late_max;
+}
+BENCHMARK(BM_PreciseSleep)
+    ->Name("Desktop/Sleep")
+    ->ArgNames({"us", "precise"})
+    ->ArgsProduct({{1000, 10000, 30000}, {0, 1}})
+    ->Iterations(100)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// The primary monitor's desktop rectangle, as a capture region.
+CaptureRegion PrimaryOutputRegion(DesktopDuplicator& dupl) {
+    const RECT r = dupl.OutputRect();
+    return {r.left, r.top, r.right - r.left, r.bottom - r.top};
+}
+
+// DXGI Desktop Duplication: new frames per second delivered to a caller
+// that grabs in a loop (fps), and the copy cost per frame (time).
+void BM_CaptureDxgi(benchmark::State& state) {
+    DesktopDuplicator& dupl = GetDesktopDuplicator();
+    if (!dupl.IsOpen() && !dupl.Open(0, 0)) {
+        state.SkipWithError("DXGI duplication unavailable (no desktop / remote session?)");
+        return;
+    }
+    const CaptureRegion region = PrimaryOutputRegion(dupl);
+    std::vector<uint8_t> buf((size_t)region.width * region.height * 4);
+    int64_t new_frames = 0;
+    for (auto _ : state) {
+        if (dupl.Grab(region, buf.data(), region.width * 4, 100, false) == GRAB_NEW_FRAME) ++new_frames;
+    }
+    state.counters["fps"] = benchmark::Counter((double)new_frames, benchmark::Counter::kIsRate);
+    state.counters["new_frame_ratio"] = (double)new_frames / (double)std::max<int64_t>(1, state.iterations());
+}
+BENCHMARK(BM_CaptureDxgi)->Name("Desktop/CaptureDxgi")->MinTime(2.0)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// Capture ring: the background thread grabs, the caller reads the newest
+// frame by timestamp (what the env does every step).
+void BM_CaptureRing(benchmark::State& state) {
+    DesktopDuplicator& dupl = GetDesktopDuplicator();
+    if (!dupl.IsOpen() && !dupl.Open(0, 0)) {
+        state.SkipWithError("DXGI duplication unavailable (no desktop / remote session?)");
+        return;
+    }
+    const CaptureRegion region = PrimaryOutputRegion(dupl);
+    CaptureRing& ring = GetCaptureRing();
+    if (!ring.Start(region, 4)) {
+        state.SkipWithError("capture ring failed to start");
+        return;
+    }
+    std::vector<uint8_t> buf((size_t)region.width * region.height * 4);
+    FrameStamp stamp = {0, 0};
+    uint64_t first_seq = 0;
+    for (auto _ : state) {
+        if (ring.ReadLatest(buf.data(), region.width, region.height, region.width * 4, 100, &stamp) && first_seq == 0) first_seq = stamp.seq;
+    }
+    ring.Stop();
+    const double frames = first_seq ? (double)(stamp.seq - first_seq) : 0.0;
+    state.counters["fps"] = benchmark::Counter(frames, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_CaptureRing)->Name("Desktop/CaptureRingLatest")->MinTime(2.0)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,261 @@
+#include "capture.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "profiler.h"
+
+using Microsoft::WRL::ComPtr;
+
+// ============================================================================
+// DXGI DESKTOP DUPLICATION IMPLEMENTATION
+// ============================================================================
+
+bool DesktopDuplicator::Open(int desktop_x, int desktop_y) {
+    Close();
+    open_point_ = {desktop_x, desktop_y};
+    error_.clear();
+
+    ComPtr<IDXGIFactory1> factory;
+    if (FAILED(CreateDXGIFactory1(IID_PPV_ARGS(&factory)))) {
+        error_ = "CreateDXGIFactory1 failed";
+        return false;
+    }
+
+    // Find the adapter + output whose desktop rectangle contains the point.
+    ComPtr<IDXGIAdapter1> adapter;
+    ComPtr<IDXGIOutput> output;
+    for (UINT a = 0; !output && factory->EnumAdapters1(a, &adapter) != DXGI_ERROR_NOT_FOUND; ++a) {
+        ComPtr<IDXGIOutput> candidate;
+        for (UINT o = 0; adapter->EnumOutputs(o, &candidate) != DXGI_ERROR_NOT_FOUND; ++o) {
+            DXGI_OUTPUT_DESC desc;
+            candidate->GetDesc(&desc);
+            const RECT& r = desc.DesktopCoordinates;
+            if (desktop_x >= r.left && desktop_x < r.right &&
+                desktop_y >= r.top && desktop_y < r.bottom) {
+                output = candidate;
+                output_rect_ = r;
+                break;
+            }
+        }
+        if (!output) adapter.Reset();
+    }
+    if (!output) {
+        error_ = "no monitor contains that point";
+        return false;
+    }
+
+    // The device must live on the same adapter as the output.
+    if (FAILED(D3D11CreateDevice(adapter.Get(), D3D_DRIVER_TYPE_UNKNOWN, nullptr, 0,
+                                 nullptr, 0, D3D11_SDK_VERSION,
+                                 &device_, nullptr, &context_))) {
+        Close();
+        error_ = "D3D11CreateDevice failed";
+        return false;
+    }
+
+    ComPtr<IDXGIOutput1> output1;
+    if (FAILED(output.As(&output1)) || FAILED(output1->DuplicateOutput(device_.Get(), &dupl_))) {
+        Close();
+        error_ = "DuplicateOutput failed (another duplication, or a secure desktop)";
+        return false;
+    }
+
+    DXGI_OUTDUPL_DESC dd;
+    dupl_->GetDesc(&dd);
+
+    // Our staging copy, the tile map and every row copy assume the desktop
+    // image is BGRA8 in desktop orientation.
+    const DXGI_FORMAT format = dd.ModeDesc.Format;
+    if (format != DXGI_FORMAT_B8G8R8A8_UNORM && format != DXGI_FORMAT_B8G8R8A8_UNORM_SRGB) {
+        Close();
+        error_ = "unsupported desktop format " + std::to_string((int)format) +
+                 " (HDR / FP16 desktops are not BGRA8)";
+        return false;
+    }
+    if (dd.Rotation != DXGI_MODE_ROTATION_IDENTITY && dd.Rotation != DXGI_MODE_ROTATION_UNSPECIFIED) {
+        Close();
+        error_ = "rotated monitors are not supported";
+        return false;
+    }
+
+    // CPU-readable copy of the whole output.
+    D3D11_TEXTURE2D_DESC td = {};
+    td.Width = dd.ModeDesc.Width;
+    td.Height = dd.ModeDesc.Height;
+    td.MipLevels = 1;
+    td.ArraySize = 1;
+    td.Format = format;
+    td.SampleDesc.Count = 1;
+    td.Usage = D3D11_USAGE_STAGING;
+    td.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    if (FAILED(device_->CreateTexture2D(&td, nullptr, &staging_))) {
+        Close();
+        error_ = "could not create the staging texture";
+        return false;
+    }
+
+    // Fresh duplication: we know nothing about what changed, so everything did.
+    tiles_x_ = ((int)td.Width + CAPTURE_TILE - 1) / CAPTURE_TILE;
+    tiles_y_ = ((int)td.Height + CAPTURE_TILE - 1) / CAPTURE_TILE;
+    tile_seq_.assign((size_t)tiles_x_ * tiles_y_, frame_seq_ + 1);
+    return true;
+}
+
+void DesktopDuplicator::Close() {
+    staging_.Reset();
+    dupl_.Reset();
+    context_.Reset();
+    device_.Reset();
+    has_frame_ = false;
+}
+
+// Desktop Duplication is lost on mode changes, UAC prompts, fullscreen
+// switches... The fix is always the same: build it again.
+bool DesktopDuplicator::Reopen() {
+    return Open(open_point_.x, open_point_.y);
+}
+
+GrabResult DesktopDuplicator::Acquire(int timeout_ms) {
+    DXGI_OUTDUPL_FRAME_INFO info;
+    ComPtr<IDXGIResource> resource;
+    HRESULT hr = dupl_->AcquireNextFrame((UINT)std::max(timeout_ms, 0), &info, &resource);
+
+    if (hr == DXGI_ERROR_WAIT_TIMEOUT) return GRAB_UNCHANGED;
+    if (hr == DXGI_ERROR_ACCESS_LOST) {
+        if (!Reopen()) return GRAB_ERROR;
+        hr = dupl_->AcquireNextFrame((UINT)std::max(timeout_ms, 0), &info, &resource);
+        if (hr == DXGI_ERROR_WAIT_TIMEOUT) return GRAB_UNCHANGED;
+    }
+    if (FAILED(hr)) return GRAB_ERROR;
+
+    // LastPresentTime == 0 means only the mouse pointer moved.
+    GrabResult result = GRAB_UNCHANGED;
+    if (info.LastPresentTime.QuadPart != 0 || !has_frame_) {
+        ComPtr<ID3D11Texture2D> texture;
+        if (SUCCEEDED(resource.As(&texture))) {
+            context_->CopyResource(staging_.Get(), texture.Get());
+            has_frame_ = true;
+            last_present_qpc_ = info.LastPresentTime.QuadPart;
+            ++frame_seq_;
+            MarkFrameChanges(info);
+            result = GRAB_NEW_FRAME;
+        }
+    }
+    dupl_->ReleaseFrame();
+    return result;
+}
+
+void DesktopDuplicator::MarkTiles(const RECT& r) {
+    const int tx0 = std::max(0, (int)r.left / CAPTURE_TILE);
+    const int ty0 = std::max(0, (int)r.top / CAPTURE_TILE);
+    const int tx1 = std::min(tiles_x_, ((int)r.right + CAPTURE_TILE - 1) / CAPTURE_TILE);
+    const int ty1 = std::min(tiles_y_, ((int)r.bottom + CAPTURE_TILE - 1) / CAPTURE_TILE);
+    for (int ty = ty0; ty < ty1; ++ty) {
+        for (int tx = tx0; tx < tx1; ++tx) tile_seq_[(size_t)ty * tiles_x_ + tx] = frame_seq_;
+    }
+}
+
+void DesktopDuplicator::MarkAllTiles() {
+    std::fill(tile_seq_.begin(), tile_seq_.end(), frame_seq_);
+}
+
+// Teacher Note: Each frame comes with "metadata": MOVE rects (a block of
+// pixels was copied elsewhere, e.g. a dragged window) and DIRTY rects
+// (pixels were redrawn). Both must be fetched before ReleaseFrame.
+void DesktopDuplicator::MarkFrameChanges(const DXGI_OUTDUPL_FRAME_INFO& info) {
+    if (info.TotalMetadataBufferSize == 0) {
+        MarkAllTiles();   // new image but no rectangles: assume everything
+        return;
+    }
+    if (metadata_.size() < info.TotalMetadataBufferSize) metadata_.resize(info.TotalMetadataBufferSize);
+
+    UINT move_bytes = 0;
+    HRESULT hr = dupl_->GetFrameMoveRects(info.TotalMetadataBufferSize,
+                                          (DXGI_OUTDUPL_MOVE_RECT*)metadata_.data(), &move_bytes);
+    if (FAILED(hr)) {
+        MarkAllTiles();
+        return;
+    }
+    const DXGI_OUTDUPL_MOVE_RECT* moves = (const DXGI_OUTDUPL_MOVE_RECT*)metadata_.data();
+    for (UINT i = 0; i < move_bytes / sizeof(DXGI_OUTDUPL_MOVE_RECT); ++i) MarkTiles(moves[i].DestinationRect);
+
+    UINT dirty_bytes = 0;
+    hr = dupl_->GetFrameDirtyRects(info.TotalMetadataBufferSize - move_bytes,
+                                   (RECT*)(metadata_.data() + move_bytes), &dirty_bytes);
+    if (FAILED(hr)) {
+        MarkAllTiles();
+        return;
+    }
+    const RECT* dirty = (const RECT*)(metadata_.data() + move_bytes);
+    for (UINT i = 0; i < dirty_bytes / sizeof(RECT); ++i) MarkTiles(dirty[i]);
+}
+
+bool DesktopDuplicator::ChangedSince(const CaptureRegion& region, uint64_t since_seq) const {
+    if (tile_seq_.empty() || since_seq == 0) return true;
+    RECT local;
+    local.left = region.left - output_rect_.left;
+    local.top = region.top - output_rect_.top;
+    local.right = local.left + region.width;
+    local.bottom = local.top + region.height;
+
+    const int tx0 = std::max(0, (int)local.left / CAPTURE_TILE);
+    const int ty0 = std::max(0, (int)local.top / CAPTURE_TILE);
+    const int tx1 = std::min(tiles_x_, ((int)local.right + CAPTURE_TILE - 1) / CAPTURE_TILE);
+    const int ty1 = std::min(tiles_y_, ((int)local.bottom + CAPTURE_TILE - 1) / CAPTURE_TILE);
+    // Not on this output at all (e.g. the window moved to another monitor):
+    // we can't vouch for it, so say "changed".
+    if (tx0 >= tx1 || ty0 >= ty1) return true;
+    for (int ty = ty0; ty < ty1; ++ty) {
+        for (int tx = tx0; tx < tx1; ++tx) {
+            if (tile_seq_[(size_t)ty * tiles_x_ + tx] > since_seq) return true;
+        }
+    }
+    return false;
+}
+
+GrabResult DesktopDuplicator::Grab(const CaptureRegion& region, uint8_t* dst, int dst_stride, int timeout_ms,
+                                   bool copy_unchanged) {
+    if (!IsOpen() && !Reopen()) return GRAB_ERROR;
+
+    GrabResult result = Acquire(timeout_ms);
+    if (result == GRAB_ERROR || !has_frame_) return GRAB_ERROR;
+    if (result == GRAB_UNCHANGED && !copy_unchanged) return result;
+    ScopedSpan span(PROFILE_CAPTURE);   // the copy, not the wait for a new frame
+
+    // Clip the region to the output, in output-local pixels.
+    const int x0 = std::max(region.left, (int)output_rect_.left) - output_rect_.left;
+    const int y0 = std::max(region.top, (int)output_rect_.top) - output_rect_.top;
+    const int x1 = std::min(region.left + region.width, (int)output_rect_.right) - output_rect_.left;
+    const int y1 = std::min(region.top + region.height, (int)output_rect_.bottom) - output_rect_.top;
+    if (x1 <= x0 || y1 <= y0) return result;
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (FAILED(context_->Map(staging_.Get(), 0, D3D11_MAP_READ, 0, &mapped))) return GRAB_ERROR;
+
+    // Where the clipped rectangle lands inside the caller's buffer.
+    const int dst_x = x0 + output_rect_.left - region.left;
+    const int dst_y = y0 + output_rect_.top - region.top;
+    const size_t row_bytes = (size_t)(x1 - x0) * 4;
+
+    const uint8_t* src = (const uint8_t*)mapped.pData + (size_t)y0 * mapped.RowPitch + (size_t)x0 * 4;
+    uint8_t* out = dst + (size_t)dst_y * dst_stride + (size_t)dst_x * 4;
+    for (int y = y0; y < y1; ++y) {
+        memcpy(out, src, row_bytes);
+        src += mapped.RowPitch;
+        out += dst_stride;
+    }
+
+    context_->Unmap(staging_.Get(), 0);
+    return result;
+}
+
+DesktopDuplicator& GetDesktopDuplicator() {
+    static DesktopDuplicator duplicator;
+    return duplicator;
+}
+
+std::mutex& GetCaptureMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <Windows.h>
+#include <d3d11.h>
+#include <dxgi1_2.h>
+#include <wrl/client.h>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// NATIVE SCREEN CAPTURE ("the eyes", fast path)
+// ============================================================================
+//
+// Teacher Note: mss captures with GDI BitBlt - the CPU asks Windows to copy
+// the screen pixels for it, every frame, which tops out around 30-40 FPS on
+// a 1080p+ window. DXGI Desktop Duplication instead hands us the frame the
+// GPU already composited. We copy it once into a CPU-readable "staging"
+// texture and from there straight into the caller's buffer.
+//
+// The caller owns the destination buffer (a numpy array allocated once), so
+// grabbing a frame allocates nothing.
+//
+// Frames are BGRA (4 bytes per pixel). Dropping alpha is left to the
+// consumer: a numpy view [:, :, :3] costs nothing.
+
+struct CaptureRegion {
+    int left;    // desktop coordinates
+    int top;
+    int width;
+    int height;
+};
+
+// Change tracking granularity (pixels). DXGI reports dirty/move rectangles
+// per frame; we fold them into a grid of TILE x TILE tiles that remember the
+// last frame number that touched them. "Did this region change since frame
+// N?" is then a max over a handful of tiles.
+constexpr int CAPTURE_TILE = 32;
+
+// Result of DesktopDuplicator::Grab.
+enum GrabResult {
+    GRAB_ERROR = -1,     // device lost / not open; nothing copied
+    GRAB_UNCHANGED = 0,  // no new frame within the timeout; last frame copied
+    GRAB_NEW_FRAME = 1,  // a new frame was copied
+};
+
+class DesktopDuplicator {
+public:
+    // Duplicates the monitor ("output") containing desktop point (x, y).
+    // Only unrotated 8-bit BGRA desktops are supported (that is the layout
+    // every copy below assumes); anything else - HDR / FP16, a portrait
+    // monitor - fails with the reason in LastError().
+    bool Open(int desktop_x, int desktop_y);
+    const std::string& LastError() const { return error_; }
+    void Close();
+    bool IsOpen() const { return dupl_ != nullptr; }
+
+    // Desktop rectangle covered by the open output.
+    RECT OutputRect() const { return output_rect_; }
+
+    // Copies `region` (clipped to the output) into dst as BGRA rows of
+    // dst_stride bytes. Pixels outside the output are left untouched.
+    // With copy_unchanged = false, GRAB_UNCHANGED leaves dst untouched too.
+    GrabResult Grab(const CaptureRegion& region, uint8_t* dst, int dst_stride, int timeout_ms,
+                    bool copy_unchanged = true);
+
+    // When the last new frame was presented (QPC ticks, 0 = none yet).
+    int64_t LastPresentQpc() const { return last_present_qpc_; }
+
+    // Number of the last new frame (1, 2, 3...; 0 = none yet). Keeps
+    // counting across Reopen(), which marks the whole output changed.
+    uint64_t FrameSeq() const { return frame_seq_; }
+
+    // True if any pixel of the desktop rectangle may have changed after
+    // frame `since_seq`. Errs on the side of "changed".
+    bool ChangedSince(const CaptureRegion& region, uint64_t since_seq) const;
+
+private:
+    bool Reopen();
+    GrabResult Acquire(int timeout_ms);
+    void MarkTiles(const RECT& r);     // output-local pixels
+    void MarkAllTiles();
+    void MarkFrameChanges(const DXGI_OUTDUPL_FRAME_INFO& info);
+
+    Microsoft::WRL::ComPtr<ID3D11Device> device_;
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext> context_;
+    Microsoft::WRL::ComPtr<IDXGIOutputDuplication> dupl_;
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> staging_;
+
+    RECT output_rect_ = {};
+    POINT open_point_ = {};
+    bool has_frame_ = false;
+    int64_t last_present_qpc_ = 0;
+
+    uint64_t frame_seq_ = 0;
+    int tiles_x_ = 0;
+    int tiles_y_ = 0;
+    std::vector<uint64_t> tile_seq_;   // last frame that changed each tile
+    std::vector<uint8_t> metadata_;    // move + dirty rect scratch
+    std::string error_;                // why the last Open failed
+};
+
+// Process-wide duplicator. Desktop Duplication allows one duplication per
+// monitor per process, so every ScreenCapture shares it (hold the mutex).
+DesktopDuplicator& GetDesktopDuplicator();
+std::mutex& GetCaptureMutex();
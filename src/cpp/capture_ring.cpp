@@ -0,0 +1,201 @@
+#include "capture_ring.h"
+
+#include <chrono>
+#include <cstring>
+
+#include "event_bus.h"
+#include "profiler.h"
+#include "scheduling.h"
+#include "timing.h"
+
+// ============================================================================
+// CAPTURE RING IMPLEMENTATION
+// ============================================================================
+
+namespace {
+    // How long one AcquireNextFrame may wait before we check running_ again.
+    constexpr int RING_ACQUIRE_TIMEOUT_MS = 16;
+    // Back-off after a failed grab (output lost, not open yet...).
+    constexpr int RING_ERROR_BACKOFF_MS = 50;
+}
+
+bool CaptureRing::Start(const CaptureRegion& region, int slots) {
+    Stop();
+    if (region.width <= 0 || region.height <= 0) return false;
+    if (slots < 2) slots = 2;
+
+    {
+        // Readers from the previous run may still be copying out of slots_.
+        std::unique_lock<std::mutex> lock(mutex_);
+        released_cv_.wait(lock, [&] {
+            for (const Slot& slot : slots_) {
+                if (slot.readers > 0) return false;
+            }
+            return true;
+        });
+        region_ = region;
+        slots_.assign(slots, Slot{});
+        for (Slot& slot : slots_) slot.pixels.assign((size_t)region.width * region.height * 4, 0);
+        latest_ = -1;
+        confirmed_us_ = 0;
+    }
+
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&CaptureRing::Run, this);
+    return true;
+}
+
+void CaptureRing::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_.store(false, std::memory_order_release);
+    }
+    published_cv_.notify_all();
+    released_cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+int CaptureRing::ClaimForWrite() const {
+    // The oldest slot that is neither the newest frame nor being copied out.
+    int claimed = -1;
+    for (int i = 0; i < (int)slots_.size(); ++i) {
+        if (i == latest_ || slots_[i].readers > 0) continue;
+        if (claimed < 0 || slots_[i].stamp.seq < slots_[claimed].stamp.seq) claimed = i;
+    }
+    return claimed;
+}
+
+void CaptureRing::Run() {
+    ScopedNativeThread scheduling(THREAD_CAPTURE);
+    const int stride = region_.width * 4;
+    while (running_.load(std::memory_order_acquire)) {
+        // 1. Claim the oldest slot that is not the newest frame and that no
+        //    reader has pinned. Readers skip it (seq 0) while we write, so
+        //    copies never see half a frame. With every other slot pinned we
+        //    wait for a reader to finish.
+        int claimed = -1;
+        FrameStamp old_stamp;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            released_cv_.wait(lock, [&] {
+                claimed = ClaimForWrite();
+                return claimed >= 0 || !IsRunning();
+            });
+            if (claimed < 0) break;
+            old_stamp = slots_[claimed].stamp;
+            slots_[claimed].stamp.seq = 0;
+        }
+
+        // 2. Wait for the next desktop frame and copy it straight into the slot.
+        GrabResult result;
+        int64_t present_qpc;
+        uint64_t frame_seq;
+        {
+            std::lock_guard<std::mutex> lock(GetCaptureMutex());
+            DesktopDuplicator& dupl = GetDesktopDuplicator();
+            result = dupl.Grab(region_, slots_[claimed].pixels.data(), stride, RING_ACQUIRE_TIMEOUT_MS, false);
+            present_qpc = dupl.LastPresentQpc();
+            frame_seq = dupl.FrameSeq();
+        }
+        const int64_t now_us = QpcNowUs();
+
+        // 3. Publish.
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (result == GRAB_NEW_FRAME) {
+                const int64_t present_us = present_qpc ? (int64_t)QpcToUs(present_qpc) : now_us;
+                slots_[claimed].stamp = {present_us, frame_seq};
+                latest_ = claimed;
+                confirmed_us_ = now_us;
+            } else {
+                slots_[claimed].stamp = old_stamp;   // untouched, still valid
+                if (result == GRAB_UNCHANGED && latest_ >= 0) confirmed_us_ = now_us;
+            }
+        }
+        published_cv_.notify_all();
+
+        if (result == GRAB_NEW_FRAME && EventBusActive()) {
+            const int64_t present_us = present_qpc ? (int64_t)QpcToUs(present_qpc) : now_us;
+            EventBusPublish(EVENT_FRAME, 0, (int64_t)frame_seq, present_us, (double)(now_us - present_us));
+        }
+
+        if (result == GRAB_ERROR) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(RING_ERROR_BACKOFF_MS));
+        }
+    }
+}
+
+int CaptureRing::FindAtOrAfter(int64_t t_us) const {
+    // First frame presented at or after t...
+    int best = -1;
+    for (int i = 0; i < (int)slots_.size(); ++i) {
+        const FrameStamp& s = slots_[i].stamp;
+        if (s.seq == 0 || s.present_us < t_us) continue;
+        if (best < 0 || s.present_us < slots_[best].stamp.present_us) best = i;
+    }
+    if (best >= 0) return best;
+    // ...or the newest frame, if it was still on screen at t.
+    if (latest_ >= 0 && confirmed_us_ >= t_us) return latest_;
+    return -1;
+}
+
+void CaptureRing::CopyOut(std::unique_lock<std::mutex>& lock, int slot, uint8_t* dst, int dst_stride,
+                          FrameStamp* stamp) {
+    // Everything the copy needs, read while we still hold the lock. The
+    // pin keeps pixels from being claimed (and slots_ from being
+    // reallocated) until we drop it below.
+    const CaptureRegion region = region_;
+    const FrameStamp frame = slots_[slot].stamp;
+    const uint8_t* src = slots_[slot].pixels.data();
+    lock.unlock();
+
+    const size_t row_bytes = (size_t)region.width * 4;
+    if ((size_t)dst_stride == row_bytes) {
+        memcpy(dst, src, row_bytes * region.height);
+    } else {
+        for (int y = 0; y < region.height; ++y) {
+            memcpy(dst + (size_t)y * dst_stride, src + y * row_bytes, row_bytes);
+        }
+    }
+    if (stamp) *stamp = frame;
+
+    lock.lock();
+    if (--slots_[slot].readers == 0) {
+        lock.unlock();
+        released_cv_.notify_all();
+    }
+}
+
+bool CaptureRing::ReadLatest(uint8_t* dst, int width, int height, int dst_stride, int timeout_ms,
+                             FrameStamp* stamp) {
+    ScopedSpan span(PROFILE_FRAME_WAIT);
+    std::unique_lock<std::mutex> lock(mutex_);
+    published_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms > 0 ? timeout_ms : 0), [&] {
+        return latest_ >= 0 || !IsRunning();
+    });
+    if (latest_ < 0 || region_.width != width || region_.height != height) return false;
+    const int slot = latest_;
+    ++slots_[slot].readers;
+    CopyOut(lock, slot, dst, dst_stride, stamp);
+    return true;
+}
+
+bool CaptureRing::ReadAtOrAfter(int64_t t_us, uint8_t* dst, int width, int height, int dst_stride,
+                                int timeout_ms, FrameStamp* stamp) {
+    ScopedSpan span(PROFILE_FRAME_WAIT);
+    std::unique_lock<std::mutex> lock(mutex_);
+    int slot = -1;
+    published_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms > 0 ? timeout_ms : 0), [&] {
+        slot = FindAtOrAfter(t_us);
+        return slot >= 0 || !IsRunning();
+    });
+    if (slot < 0 || region_.width != width || region_.height != height) return false;
+    ++slots_[slot].readers;
+    CopyOut(lock, slot, dst, dst_stride, stamp);
+    return true;
+}
+
+CaptureRing& GetCaptureRing() {
+    static CaptureRing ring;
+    return ring;
+}
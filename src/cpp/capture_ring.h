@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "capture.h"
+
+// ============================================================================
+// CAPTURE RING (continuous background capture)
+// ============================================================================
+//
+// Teacher Note: StardewViTEnv.step grabs a "before" frame, acts, sleeps,
+// then grabs an "after" frame - and the next "before" is really the same
+// picture as the last "after". Instead, a background thread keeps copying
+// every new desktop frame into a ring of N preallocated slots, each stamped
+// with the time it was presented (QPC microseconds, see timing.h).
+//
+// Python then just asks:
+//   - latest():          the newest frame
+//   - at_or_after(t):    the first frame shown at or after time t, waiting
+//                        for it if needed
+// so "the frame 30 ms after I pressed the key" is exact, and nothing is
+// captured twice.
+//
+// If the screen does not change, DXGI delivers no new frame. The newest
+// slot then stays valid, and we remember until when it was confirmed
+// unchanged, so at_or_after(t) still succeeds on a static screen.
+//
+// A reader holds mutex_ only long enough to pick a slot and pin it
+// (Slot::readers); the copy itself runs unlocked. The capture thread never
+// claims a pinned slot, so a frame being copied out is never overwritten,
+// and a slow reader doesn't stall the capture thread or other readers.
+
+struct FrameStamp {
+    int64_t present_us;   // when the frame was presented (QPC us)
+    uint64_t seq;         // DesktopDuplicator::FrameSeq() of the frame
+};
+
+class CaptureRing {
+public:
+    ~CaptureRing() { Stop(); }
+
+    // Starts the capture thread for `region` with `slots` frames (>= 2).
+    // The duplicator must already be open (capture_open).
+    bool Start(const CaptureRegion& region, int slots);
+    void Stop();
+    bool IsRunning() const { return running_.load(std::memory_order_acquire); }
+    CaptureRegion Region() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return region_;
+    }
+
+    // Copies the newest frame into dst, a width x height BGRA buffer with
+    // rows of dst_stride bytes. Waits up to timeout_ms for the first frame;
+    // false if there is none, or if the ring's region isn't width x height
+    // (checked under the lock: a restart on another region can't overflow dst).
+    bool ReadLatest(uint8_t* dst, int width, int height, int dst_stride, int timeout_ms, FrameStamp* stamp);
+
+    // Copies the oldest frame still on screen at or after t_us, waiting up
+    // to timeout_ms for it. False on timeout or a region mismatch, as above.
+    bool ReadAtOrAfter(int64_t t_us, uint8_t* dst, int width, int height, int dst_stride, int timeout_ms,
+                       FrameStamp* stamp);
+
+private:
+    struct Slot {
+        std::vector<uint8_t> pixels;
+        FrameStamp stamp = {0, 0};   // seq 0 = empty or being written
+        int readers = 0;             // copies in progress; the writer skips it
+    };
+
+    void Run();
+    int FindAtOrAfter(int64_t t_us) const;   // slot index or -1; needs mutex_
+    int ClaimForWrite() const;                // slot index or -1; needs mutex_
+    // Copies slots_[slot] out and unpins it. Called with `lock` held and the
+    // slot pinned; unlocks for the copy.
+    void CopyOut(std::unique_lock<std::mutex>& lock, int slot, uint8_t* dst, int dst_stride,
+                 FrameStamp* stamp);
+
+    CaptureRegion region_ = {};
+    std::vector<Slot> slots_;
+    int latest_ = -1;                 // slot holding the newest frame
+    int64_t confirmed_us_ = 0;        // newest frame known unchanged until here
+
+    mutable std::mutex mutex_;
+    std::condition_variable published_cv_;
+    std::condition_variable released_cv_;    // a slot's last reader finished
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+};
+
+// Process-wide ring: there is one duplicator per process (see capture.h).
+CaptureRing& GetCaptureRing();
@@ -1,133 +1,44 @@
 #include <Python.h>
-#include <Windows.h>
-#include <random>
-#include <thread>
+#include <algorithm>
 #include <chrono>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
 
-// ============================================================================
-// PART 1: NATIVE INPUT IMPLEMENTATION
-// ============================================================================
-
-namespace {
-    std::mt19937& GetRNG() {
-        static thread_local std::mt19937 generator(std::random_device{}());
-        return generator;
-    }
-}
-
-// Wraps a relative mouse move.
-void SendMouseMove(int dx, int dy) {
-    INPUT inp = {0};
-    inp.type = INPUT_MOUSE;
-    inp.mi.dx      = dx;
-    inp.mi.dy      = dy;
-    inp.mi.dwFlags = MOUSEEVENTF_MOVE;
-    SendInput(1, &inp, sizeof(inp));
-}
-
-// Breaks a long move into small, slightly randomized steps.
-void JitteredMouseMove(int targetX, int targetY) {
-    auto& rng = GetRNG();
-    std::uniform_int_distribution<int> step_dist(10, 15);
-    std::uniform_int_distribution<int> jitter_dist(-1, 1);
-    std::uniform_int_distribution<int> sleep_dist(60, 90);
-
-    int steps = step_dist(rng);
-    for (int i = 1; i <= steps; ++i) {
-        float frac = (float)i / steps;
-        int x = (int)(frac * targetX) + jitter_dist(rng);
-        int y = (int)(frac * targetY) + jitter_dist(rng);
-        SendMouseMove(x, y);
-        
-        std::this_thread::sleep_for(std::chrono::milliseconds(sleep_dist(rng)));
-    }
-}
-
-// Sends a left mouse button click (down + up).
-// Note: Added delay between down/up to help games register the click.
-void SendMouseClick() {
-    INPUT inputs[2] = {0};
-    // Left button down
-    inputs[0].type = INPUT_MOUSE;
-    inputs[0].mi.dwFlags = MOUSEEVENTF_LEFTDOWN;
-    inputs[0].mi.dwExtraInfo = 0;
-    // Left button up
-    inputs[1].type = INPUT_MOUSE;
-    inputs[1].mi.dwFlags = MOUSEEVENTF_LEFTUP;
-    inputs[1].mi.dwExtraInfo = 0;
-    
-    // Send down
-    SendInput(1, &inputs[0], sizeof(INPUT));
-    // Small delay
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
-    // Send up
-    SendInput(1, &inputs[1], sizeof(INPUT));
-}
-
-// Sends a right mouse button click (down + up).
-// Note: Added delay between down/up to help games register the click.
-void SendMouseRightClick() {
-    INPUT inputs[2] = {0};
-    // Right button down
-    inputs[0].type = INPUT_MOUSE;
-    inputs[0].mi.dwFlags = MOUSEEVENTF_RIGHTDOWN;
-    inputs[0].mi.dwExtraInfo = 0;
-    // Right button up
-    inputs[1].type = INPUT_MOUSE;
-    inputs[1].mi.dwFlags = MOUSEEVENTF_RIGHTUP;
-    inputs[1].mi.dwExtraInfo = 0;
-    
-    // Send down
-    SendInput(1, &inputs[0], sizeof(INPUT));
-    // Small delay
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
-    // Send up
-    SendInput(1, &inputs[1], sizeof(INPUT));
-}
-
-// Simple key down + key up.
-// Teacher Note: Games using DirectInput (like Stardew Valley / MonoGame) read
-// HARDWARE SCAN CODES, not virtual key codes. We use MapVirtualKey to find them.
-void SendKey(WORD vkCode) {
-    INPUT inputs[2] = {0};
-
-    // Convert virtual key to hardware scan code
-    UINT scanCode = MapVirtualKey(vkCode, MAPVK_VK_TO_VSC);
-
-    // Key down - using SCAN CODE (critical for games!)
-    inputs[0].type        = INPUT_KEYBOARD;
-    inputs[0].ki.wVk      = 0;  // Must be 0 when using scan codes
-    inputs[0].ki.wScan    = scanCode;
-    inputs[0].ki.dwFlags  = KEYEVENTF_SCANCODE;
-    inputs[0].ki.dwExtraInfo = 0;
-
-    // Key up - also using scan code
-    inputs[1].type        = INPUT_KEYBOARD;
-    inputs[1].ki.wVk      = 0;
-    inputs[1].ki.wScan    = scanCode;
-    inputs[1].ki.dwFlags  = KEYEVENTF_SCANCODE | KEYEVENTF_KEYUP;
-    inputs[1].ki.dwExtraInfo = 0;
-
-    // Send key down
-    SendInput(1, &inputs[0], sizeof(INPUT));
-
-    // Small delay - some games need this to register the key press
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
-
-    // Send key up
-    SendInput(1, &inputs[1], sizeof(INPUT));
-}
-
+#include "batch_observe.h"
+#include "capture.h"
+#include "capture_ring.h"
+#include "delta_codec.h"
+#include "event_bus.h"
+#include "input.h"
+#include "parallel.h"
+#include "preprocess.h"
+#include "profiler.h"
+#include "recorder.h"
+#include "replay.h"
+#include "reward.h"
+#include "scheduling.h"
+#include "step_pipeline.h"
+#include "template_match.h"
+#include "tile_hash.h"
+#include "timing.h"
+#include "window_tracker.h"
 
 // ============================================================================
-// PART 2: PYTHON BINDINGS (C API)
+// PYTHON BINDINGS (C API)
 // ============================================================================
 
 // Python wrapper for SendKey
 static PyObject* method_send_key(PyObject* self, PyObject* args) {
     int vkCode;
-    if (!PyArg_ParseTuple(args, "i", &vkCode)) return NULL;
-    SendKey((WORD)vkCode);
+    int hold_ms = DEFAULT_HOLD_US / 1000;
+    if (!PyArg_ParseTuple(args, "i|i", &vkCode, &hold_ms)) return NULL;
+    // Sleeps inside - let other Python threads run meanwhile
+    Py_BEGIN_ALLOW_THREADS
+    SendKey((WORD)vkCode, hold_ms > 0 ? hold_ms : 0);
+    Py_END_ALLOW_THREADS
     Py_RETURN_NONE;
 }
 
@@ -139,35 +50,2151 @@ static PyObject* method_send_mouse_move(PyObject* self, PyObject* args) {
     Py_RETURN_NONE;
 }
 
+// Parses (dx, dy, duration_ms=150, seed=0[, hwnd=0]) for the trajectory
+// wrappers; hwnd is only accepted when the caller passes somewhere to put it.
+static bool ParseTrajectoryArgs(PyObject* args, TrajectoryParams& params, unsigned long long* hwnd = nullptr) {
+    unsigned int duration_ms = DEFAULT_TRAJECTORY_MS;
+    unsigned long long seed = 0;
+    const bool ok = hwnd
+        ? PyArg_ParseTuple(args, "ii|IKK", &params.dx, &params.dy, &duration_ms, &seed, hwnd)
+        : PyArg_ParseTuple(args, "ii|IK", &params.dx, &params.dy, &duration_ms, &seed);
+    if (!ok) return false;
+    params.duration_ms = duration_ms;
+    params.seed = seed;
+    return true;
+}
+
 // Python wrapper for JitteredMouseMove
 static PyObject* method_jitter_move(PyObject* self, PyObject* args) {
-    int x, y;
-    if (!PyArg_ParseTuple(args, "ii", &x, &y)) return NULL;
-    JitteredMouseMove(x, y);
+    TrajectoryParams params;
+    if (!ParseTrajectoryArgs(args, params)) return NULL;
+    // Sleeps inside - let other Python threads run meanwhile
+    Py_BEGIN_ALLOW_THREADS
+    JitteredMouseMove(params);
+    Py_END_ALLOW_THREADS
     Py_RETURN_NONE;
 }
 
+// Python wrapper for BuildTrajectory: ([(dx, dy), ...], step_us, seed)
+static PyObject* method_trajectory(PyObject* self, PyObject* args) {
+    TrajectoryParams params;
+    if (!ParseTrajectoryArgs(args, params)) return NULL;
+    Trajectory path;
+    BuildTrajectory(params, path);
+
+    PyObject* steps = PyList_New(path.count);
+    if (!steps) return NULL;
+    for (int i = 0; i < path.count; ++i) {
+        PyList_SET_ITEM(steps, i, Py_BuildValue("(ii)", path.dx[i], path.dy[i]));
+    }
+    return Py_BuildValue("(NIK)", steps, path.step_us, (unsigned long long)path.seed);
+}
+
 // Python wrapper for SendMouseClick
 static PyObject* method_send_mouse_click(PyObject* self, PyObject* args) {
     if (!PyArg_ParseTuple(args, "")) return NULL;
+    // Sleeps inside - let other Python threads run meanwhile
+    Py_BEGIN_ALLOW_THREADS
     SendMouseClick();
+    Py_END_ALLOW_THREADS
     Py_RETURN_NONE;
 }
 
 // Python wrapper for SendMouseRightClick
 static PyObject* method_send_mouse_right_click(PyObject* self, PyObject* args) {
     if (!PyArg_ParseTuple(args, "")) return NULL;
+    // Sleeps inside - let other Python threads run meanwhile
+    Py_BEGIN_ALLOW_THREADS
     SendMouseRightClick();
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
+}
+
+// True for a buffer of 4-byte ints. numpy int32 is 'l' where C long is
+// 32 bits (Windows).
+static bool IsInt32Format(const Py_buffer& view) {
+    if (view.itemsize != 4 || !view.format) return false;
+    const char* f = view.format;
+    if (*f == '<' || *f == '=' || *f == '@') ++f;
+    return (f[0] == 'i' || f[0] == 'l') && f[1] == '\0';
+}
+
+// Parses send_batch's argument into a BatchEvent array.
+// Accepts either a sequence of (type, a, b) tuples (a/b optional, default 0)
+// or a buffer of int32 (type, a, b) triplets: array('i') or a flat/(n, 3)
+// numpy int32 array. Anything else with the right byte count (float32,
+// int64, bytes...) is a TypeError, not a batch of garbage events.
+// Returns the event count, or -1 with a Python exception set.
+static int ParseBatchEvents(PyObject* obj, BatchEvent* out) {
+    constexpr Py_ssize_t FIELDS = (Py_ssize_t)(sizeof(BatchEvent) / sizeof(int));
+    if (PyObject_CheckBuffer(obj)) {
+        Py_buffer view;
+        if (PyObject_GetBuffer(obj, &view, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) < 0) return -1;
+        const bool shape_ok = view.ndim == 1 || (view.ndim == 2 && view.shape[1] == FIELDS);
+        if (!IsInt32Format(view) || !shape_ok) {
+            PyErr_Format(PyExc_TypeError,
+                         "send_batch buffer must be int32 (type, a, b) triplets, flat or shaped (n, %zd); "
+                         "got format '%s', itemsize %zd, %d dimension(s)",
+                         FIELDS, view.format ? view.format : "B", view.itemsize, view.ndim);
+            PyBuffer_Release(&view);
+            return -1;
+        }
+        Py_ssize_t n = view.len / (Py_ssize_t)sizeof(BatchEvent);
+        bool ok = view.len % (Py_ssize_t)sizeof(BatchEvent) == 0 && n <= MAX_BATCH_EVENTS;
+        if (ok) memcpy(out, view.buf, (size_t)view.len);
+        PyBuffer_Release(&view);
+        if (!ok) {
+            PyErr_Format(PyExc_ValueError,
+                         "send_batch buffer must hold at most %d packed int32 (type, a, b) triplets",
+                         MAX_BATCH_EVENTS);
+            return -1;
+        }
+        return (int)n;
+    }
+
+    PyObject* seq = PySequence_Fast(obj, "send_batch expects a sequence of event tuples or a buffer");
+    if (!seq) return -1;
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+    if (n > MAX_BATCH_EVENTS) {
+        Py_DECREF(seq);
+        PyErr_Format(PyExc_ValueError, "send_batch accepts at most %d events", MAX_BATCH_EVENTS);
+        return -1;
+    }
+    PyObject** items = PySequence_Fast_ITEMS(seq);
+    for (Py_ssize_t i = 0; i < n; ++i) {
+        BatchEvent ev = {0, 0, 0};
+        if (!PyArg_ParseTuple(items[i], "i|ii", &ev.type, &ev.a, &ev.b)) {
+            Py_DECREF(seq);
+            return -1;
+        }
+        out[i] = ev;
+    }
+    Py_DECREF(seq);
+    return (int)n;
+}
+
+// Python wrapper for SendBatch
+static PyObject* method_send_batch(PyObject* self, PyObject* args) {
+    PyObject* obj;
+    if (!PyArg_ParseTuple(args, "O", &obj)) return NULL;
+
+    BatchEvent events[MAX_BATCH_EVENTS];
+    int count = ParseBatchEvents(obj, events);
+    if (count < 0) return NULL;
+    for (int i = 0; i < count; ++i) {
+        if (events[i].type < 0 || events[i].type >= EVENT_TYPE_COUNT) {
+            PyErr_Format(PyExc_ValueError, "send_batch: unknown event type %d at index %d",
+                         events[i].type, i);
+            return NULL;
+        }
+    }
+    if (count == 0) return PyLong_FromLong(0);
+    return PyLong_FromUnsignedLong(SendBatch(events, count));
+}
+
+// ----------------------------------------------------------------------------
+// Asynchronous (queued) input
+// ----------------------------------------------------------------------------
+
+// Teacher Note: Every queued-input function takes an optional trailing
+// hwnd. 0 (the default) is the process-wide SendInput worker; any other
+// value is that window's own worker, which posts window messages to it
+// (see window_input.h). Each window gets its own queue.
+
+// The worker for hwnd (0 = the SendInput one), started.
+static std::shared_ptr<InputWorker> WorkerFor(unsigned long long hwnd) {
+    if (hwnd == 0) {
+        InputWorker& worker = GetInputWorker();
+        worker.Start();
+        return std::shared_ptr<InputWorker>(&worker, [](InputWorker*) {});
+    }
+    return GetWindowInputWorker((HWND)(uintptr_t)hwnd);
+}
+
+// Posts one command's events to an input worker. The whole command goes in
+// one Post() outside the GIL: Post() keeps it together even if the queue
+// fills and we have to wait for the worker, and other Python threads run
+// meanwhile.
+static void PostEvents(const TimedEvent* events, int count, unsigned long long hwnd = 0) {
+    std::shared_ptr<InputWorker> worker = WorkerFor(hwnd);
+    Py_BEGIN_ALLOW_THREADS
+    worker->Post(events, count);
+    Py_END_ALLOW_THREADS
+}
+
+static uint32_t HoldMsToUs(int hold_ms) {
+    return hold_ms > 0 ? (uint32_t)hold_ms * 1000u : 0u;
+}
+
+// A hold needs a release time: hold_us == 0 would be a bare press that
+// nothing releases. Returns false with ValueError set.
+static bool CheckHoldMs(const char* name, int hold_ms) {
+    if (hold_ms > 0) return true;
+    PyErr_Format(PyExc_ValueError, "%s: hold_ms must be > 0 (got %d); use key_down() for an open-ended press",
+                 name, hold_ms);
+    return false;
+}
+
+// Python wrapper: queued key tap
+static PyObject* method_post_key(PyObject* self, PyObject* args) {
+    int vkCode;
+    int hold_ms = DEFAULT_HOLD_US / 1000;
+    unsigned long long hwnd = 0;
+    if (!PyArg_ParseTuple(args, "i|iK", &vkCode, &hold_ms, &hwnd)) return NULL;
+    TimedEvent events[2];
+    PostEvents(events, MakeKeyTap(vkCode, HoldMsToUs(hold_ms), events), hwnd);
+    Py_RETURN_NONE;
+}
+
+// Python wrapper: queued left click
+static PyObject* method_post_mouse_click(PyObject* self, PyObject* args) {
+    int hold_ms = DEFAULT_HOLD_US / 1000;
+    unsigned long long hwnd = 0;
+    if (!PyArg_ParseTuple(args, "|iK", &hold_ms, &hwnd)) return NULL;
+    TimedEvent events[2];
+    PostEvents(events, MakeMouseClick(false, HoldMsToUs(hold_ms), events), hwnd);
+    Py_RETURN_NONE;
+}
+
+// Python wrapper: queued right click
+static PyObject* method_post_mouse_right_click(PyObject* self, PyObject* args) {
+    int hold_ms = DEFAULT_HOLD_US / 1000;
+    unsigned long long hwnd = 0;
+    if (!PyArg_ParseTuple(args, "|iK", &hold_ms, &hwnd)) return NULL;
+    TimedEvent events[2];
+    PostEvents(events, MakeMouseClick(true, HoldMsToUs(hold_ms), events), hwnd);
+    Py_RETURN_NONE;
+}
+
+// Python wrapper: queued jittered move (played back by the input worker)
+static PyObject* method_post_jitter_move(PyObject* self, PyObject* args) {
+    TrajectoryParams params;
+    unsigned long long hwnd = 0;
+    if (!ParseTrajectoryArgs(args, params, &hwnd)) return NULL;
+    Trajectory path;
+    BuildTrajectory(params, path);
+    TimedEvent events[MAX_TRAJECTORY_STEPS];
+    PostEvents(events, MakeTrajectoryMove(path, events), hwnd);
+    Py_RETURN_NONE;
+}
+
+// Python wrapper: queued batch (sent together, then delay_ms before the next item)
+static PyObject* method_post_batch(PyObject* self, PyObject* args) {
+    PyObject* obj;
+    int delay_ms = 0;
+    unsigned long long hwnd = 0;
+    if (!PyArg_ParseTuple(args, "O|iK", &obj, &delay_ms, &hwnd)) return NULL;
+
+    BatchEvent batch[MAX_BATCH_EVENTS];
+    int count = ParseBatchEvents(obj, batch);
+    if (count < 0) return NULL;
+
+    TimedEvent events[MAX_BATCH_EVENTS];
+    for (int i = 0; i < count; ++i) {
+        if (batch[i].type < 0 || batch[i].type >= EVENT_TYPE_COUNT) {
+            PyErr_Format(PyExc_ValueError, "post_batch: unknown event type %d at index %d",
+                         batch[i].type, i);
+            return NULL;
+        }
+        events[i] = {batch[i], 0};
+    }
+    if (count > 0) events[count - 1].delay_us = HoldMsToUs(delay_ms);
+    PostEvents(events, count, hwnd);
+    Py_RETURN_NONE;
+}
+
+// Python wrapper: queued key press (stays down until key_up)
+static PyObject* method_key_down(PyObject* self, PyObject* args) {
+    int vkCode;
+    unsigned long long hwnd = 0;
+    if (!PyArg_ParseTuple(args, "i|K", &vkCode, &hwnd)) return NULL;
+    TimedEvent e = {{EVENT_KEY_DOWN, vkCode, 0}, 0};
+    PostEvents(&e, 1, hwnd);
+    Py_RETURN_NONE;
+}
+
+// Python wrapper: queued key release
+static PyObject* method_key_up(PyObject* self, PyObject* args) {
+    int vkCode;
+    unsigned long long hwnd = 0;
+    if (!PyArg_ParseTuple(args, "i|K", &vkCode, &hwnd)) return NULL;
+    TimedEvent e = {{EVENT_KEY_UP, vkCode, 0}, 0};
+    PostEvents(&e, 1, hwnd);
+    Py_RETURN_NONE;
+}
+
+// Python wrapper: press now, worker releases after hold_ms
+static PyObject* method_hold_key(PyObject* self, PyObject* args) {
+    int vkCode, hold_ms;
+    unsigned long long hwnd = 0;
+    if (!PyArg_ParseTuple(args, "ii|K", &vkCode, &hold_ms, &hwnd)) return NULL;
+    if (!CheckHoldMs("hold_key", hold_ms)) return NULL;
+    TimedEvent e;
+    PostEvents(&e, MakeKeyHold(vkCode, HoldMsToUs(hold_ms), &e), hwnd);
+    Py_RETURN_NONE;
+}
+
+// Python wrapper: hold several keys together (one SendInput for the presses)
+static PyObject* method_hold_keys(PyObject* self, PyObject* args) {
+    PyObject* obj;
+    int hold_ms;
+    unsigned long long hwnd = 0;
+    if (!PyArg_ParseTuple(args, "Oi|K", &obj, &hold_ms, &hwnd)) return NULL;
+    if (!CheckHoldMs("hold_keys", hold_ms)) return NULL;
+
+    PyObject* seq = PySequence_Fast(obj, "hold_keys expects a sequence of VK codes");
+    if (!seq) return NULL;
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+    if (n > MAX_HELD_INPUTS) {
+        Py_DECREF(seq);
+        PyErr_Format(PyExc_ValueError, "hold_keys accepts at most %d keys", MAX_HELD_INPUTS);
+        return NULL;
+    }
+    TimedEvent events[MAX_HELD_INPUTS];
+    PyObject** items = PySequence_Fast_ITEMS(seq);
+    for (Py_ssize_t i = 0; i < n; ++i) {
+        int vkCode = (int)PyLong_AsLong(items[i]);
+        if (vkCode == -1 && PyErr_Occurred()) {
+            Py_DECREF(seq);
+            return NULL;
+        }
+        MakeKeyHold(vkCode, HoldMsToUs(hold_ms), &events[i]);
+    }
+    Py_DECREF(seq);
+    PostEvents(events, (int)n, hwnd);
+    Py_RETURN_NONE;
+}
+
+// Python wrapper: release every held key/button now
+static PyObject* method_release_all(PyObject* self, PyObject* args) {
+    unsigned long long hwnd = 0;
+    if (!PyArg_ParseTuple(args, "|K", &hwnd)) return NULL;
+    TimedEvent e = {{EVENT_RELEASE_ALL, 0, 0}, 0};
+    PostEvents(&e, 1, hwnd);
+    Py_RETURN_NONE;
+}
+
+// Python wrapper: block until every queued event has been sent
+static PyObject* method_flush(PyObject* self, PyObject* args) {
+    unsigned long long hwnd = 0;
+    if (!PyArg_ParseTuple(args, "|K", &hwnd)) return NULL;
+    std::shared_ptr<InputWorker> worker = WorkerFor(hwnd);
+    Py_BEGIN_ALLOW_THREADS
+    worker->Wait(-1);
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
+}
+
+// Python wrapper: like flush() with a timeout; returns True if drained
+static PyObject* method_wait(PyObject* self, PyObject* args) {
+    int timeout_ms = -1;
+    unsigned long long hwnd = 0;
+    if (!PyArg_ParseTuple(args, "|iK", &timeout_ms, &hwnd)) return NULL;
+    std::shared_ptr<InputWorker> worker = WorkerFor(hwnd);
+    bool drained;
+    Py_BEGIN_ALLOW_THREADS
+    drained = worker->Wait(timeout_ms);
+    Py_END_ALLOW_THREADS
+    return PyBool_FromLong(drained);
+}
+
+// Python wrapper: number of queued events not yet sent
+static PyObject* method_pending(PyObject* self, PyObject* args) {
+    unsigned long long hwnd = 0;
+    if (!PyArg_ParseTuple(args, "|K", &hwnd)) return NULL;
+    return PyLong_FromUnsignedLongLong(WorkerFor(hwnd)->Pending());
+}
+
+// Python wrapper: holds dropped because MAX_HELD_INPUTS keys were already held
+static PyObject* method_dropped_holds(PyObject* self, PyObject* args) {
+    unsigned long long hwnd = 0;
+    if (!PyArg_ParseTuple(args, "|K", &hwnd)) return NULL;
+    return PyLong_FromUnsignedLongLong(WorkerFor(hwnd)->DroppedHolds());
+}
+
+// Python wrapper: does input for hwnd still go to the window, or did it
+// fall back to SendInput? window_input_mode(hwnd, probe=False) -> "window"
+// or "sendinput"; probe=True checks the window answers first.
+static PyObject* method_window_input_mode(PyObject* self, PyObject* args) {
+    unsigned long long hwnd;
+    int probe = 0;
+    if (!PyArg_ParseTuple(args, "K|p", &hwnd, &probe)) return NULL;
+    std::shared_ptr<InputWorker> worker = WorkerFor(hwnd);
+    WindowTarget* target = worker->Target();
+    if (target && probe) {
+        Py_BEGIN_ALLOW_THREADS
+        target->Probe();
+        Py_END_ALLOW_THREADS
+    }
+    return PyUnicode_FromString(target && !target->UsingFallback() ? "window" : "sendinput");
+}
+
+// Python wrapper: force hwnd's input through SendInput (True) or back to
+// window messages (False), e.g. once the caller sees the game ignores them.
+static PyObject* method_window_input_fallback(PyObject* self, PyObject* args) {
+    unsigned long long hwnd;
+    int fallback;
+    if (!PyArg_ParseTuple(args, "Kp", &hwnd, &fallback)) return NULL;
+    WindowTarget* target = WorkerFor(hwnd)->Target();
+    if (target) target->SetFallback(fallback != 0);
+    Py_RETURN_NONE;
+}
+
+// Python wrapper: hwnd's virtual cursor -> (x, y), in client coordinates or
+// with screen=True in screen coordinates (None if that conversion fails).
+static PyObject* method_window_input_cursor(PyObject* self, PyObject* args) {
+    unsigned long long hwnd;
+    int screen = 0;
+    if (!PyArg_ParseTuple(args, "K|p", &hwnd, &screen)) return NULL;
+    WindowTarget* target = WorkerFor(hwnd)->Target();
+    if (!target) Py_RETURN_NONE;
+    POINT p = target->Cursor();
+    if (screen && !ClientToScreen((HWND)(uintptr_t)hwnd, &p)) Py_RETURN_NONE;
+    return Py_BuildValue("(ii)", (int)p.x, (int)p.y);
+}
+
+// Python wrapper for CloseWindowInputWorker: sends what's queued, then frees
+// the window's worker.
+static PyObject* method_window_input_close(PyObject* self, PyObject* args) {
+    unsigned long long hwnd;
+    if (!PyArg_ParseTuple(args, "K", &hwnd)) return NULL;
+    if (hwnd != 0) {
+        Py_BEGIN_ALLOW_THREADS
+        CloseWindowInputWorker((HWND)(uintptr_t)hwnd);
+        Py_END_ALLOW_THREADS
+    }
+    Py_RETURN_NONE;
+}
+
+// Python wrapper for SetInputNullSink: input_null_sink(enabled). Process-wide;
+// holds and sleeps still happen, nothing reaches the desktop.
+static PyObject* method_input_null_sink(PyObject* self, PyObject* args) {
+    int enabled;
+    if (!PyArg_ParseTuple(args, "p", &enabled)) return NULL;
+    SetInputNullSink(enabled != 0);
+    Py_RETURN_NONE;
+}
+
+// Python wrapper for NullSinkEvents: events swallowed by the null sink
+static PyObject* method_input_null_sink_events(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    return PyLong_FromUnsignedLongLong(NullSinkEvents());
+}
+
+// Python wrapper for CursorPosition: the cached cursor in screen coordinates
+// -> (x, y), or None if Windows won't tell us.
+static PyObject* method_cursor_pos(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    POINT p;
+    if (!CursorPosition(&p)) Py_RETURN_NONE;
+    return Py_BuildValue("(ii)", (int)p.x, (int)p.y);
+}
+
+// Python wrapper for SetCursorResyncInterval: set_cursor_resync(interval_ms)
+static PyObject* method_set_cursor_resync(PyObject* self, PyObject* args) {
+    int interval_ms;
+    if (!PyArg_ParseTuple(args, "i", &interval_ms)) return NULL;
+    SetCursorResyncInterval(interval_ms);
+    Py_RETURN_NONE;
+}
+
+// Python wrapper for CursorResyncs
+static PyObject* method_cursor_resyncs(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    return PyLong_FromUnsignedLongLong(CursorResyncs());
+}
+
+// ----------------------------------------------------------------------------
+// Timing
+// ----------------------------------------------------------------------------
+
+// Python wrapper for SetPreciseTiming
+static PyObject* method_set_precise_timing(PyObject* self, PyObject* args) {
+    int enabled;
+    int spin_us = 500;
+    if (!PyArg_ParseTuple(args, "p|i", &enabled, &spin_us)) return NULL;
+    SetPreciseTiming(enabled != 0, spin_us > 0 ? (uint32_t)spin_us : 0u);
+    Py_RETURN_NONE;
+}
+
+// Python wrapper for PreciseTimingEnabled
+static PyObject* method_precise_timing(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    return PyBool_FromLong(PreciseTimingEnabled());
+}
+
+// Python wrapper for PreciseSleepUs; returns the measured delay in us
+static PyObject* method_precise_sleep(PyObject* self, PyObject* args) {
+    int us;
+    if (!PyArg_ParseTuple(args, "i", &us)) return NULL;
+    int64_t start;
+    int64_t end;
+    Py_BEGIN_ALLOW_THREADS
+    start = QpcNow();
+    PreciseSleepUs(us > 0 ? (uint32_t)us : 0u);
+    end = QpcNow();
+    Py_END_ALLOW_THREADS
+    return PyFloat_FromDouble(QpcToUs(end - start));
+}
+
+// Python wrapper for GetDelayStats
+static PyObject* method_timer_stats(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    DelayStats st = GetDelayStats();
+    double n = st.count ? (double)st.count : 1.0;
+    return Py_BuildValue(
+        "{s:K,s:d,s:d,s:d,s:d,s:d,s:d,s:O}",
+        "count", (unsigned long long)st.count,
+        "mean_requested_us", st.requested_total_us / n,
+        "mean_actual_us", st.actual_total_us / n,
+        "mean_late_us", (st.actual_total_us - st.requested_total_us) / n,
+        "max_late_us", st.max_late_us,
+        "last_requested_us", st.last_requested_us,
+        "last_actual_us", st.last_actual_us,
+        "precise", PreciseTimingEnabled() ? Py_True : Py_False);
+}
+
+// Python wrapper for ResetDelayStats
+static PyObject* method_reset_timer_stats(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    ResetDelayStats();
+    Py_RETURN_NONE;
+}
+
+// Python wrapper for QpcNowUs: the clock capture_ring_* timestamps use
+static PyObject* method_qpc_us(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    return PyLong_FromLongLong(QpcNowUs());
+}
+
+// ----------------------------------------------------------------------------
+// Screen capture (DXGI Desktop Duplication)
+// ----------------------------------------------------------------------------
+
+// Gets a writable, C-contiguous view of a caller-owned frame buffer that
+// holds at least width * height * bytes_per_pixel bytes.
+static bool GetFrameBuffer(PyObject* obj, int width, int height, int bytes_per_pixel, Py_buffer* view) {
+    if (width <= 0 || height <= 0) {
+        PyErr_SetString(PyExc_ValueError, "frame width and height must be positive");
+        return false;
+    }
+    if (PyObject_GetBuffer(obj, view, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS) < 0) return false;
+    if (view->len < (Py_ssize_t)width * height * bytes_per_pixel) {
+        PyBuffer_Release(view);
+        PyErr_Format(PyExc_ValueError, "frame buffer too small: need %d x %d x %d bytes",
+                     height, width, bytes_per_pixel);
+        return false;
+    }
+    return true;
+}
+
+// Python wrapper for DesktopDuplicator::Open; returns the output rectangle
+static PyObject* method_capture_open(PyObject* self, PyObject* args) {
+    int x, y;
+    if (!PyArg_ParseTuple(args, "ii", &x, &y)) return NULL;
+    bool ok;
+    RECT r;
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS
+    {
+        std::lock_guard<std::mutex> lock(GetCaptureMutex());
+        ok = GetDesktopDuplicator().Open(x, y);
+        r = GetDesktopDuplicator().OutputRect();
+        error = GetDesktopDuplicator().LastError();
+    }
+    Py_END_ALLOW_THREADS
+    if (!ok) {
+        PyErr_Format(PyExc_OSError, "DXGI Desktop Duplication unavailable for point (%d, %d): %s",
+                     x, y, error.c_str());
+        return NULL;
+    }
+    return Py_BuildValue("(iiii)", (int)r.left, (int)r.top, (int)r.right, (int)r.bottom);
+}
+
+// Python wrapper for DesktopDuplicator::Grab.
+// capture_grab(out, left, top, width, height, timeout_ms=0) -> True if a new
+// frame arrived; `out` (uint8, height x width x 4, BGRA) always holds the latest.
+static PyObject* method_capture_grab(PyObject* self, PyObject* args) {
+    PyObject* obj;
+    CaptureRegion region;
+    int timeout_ms = 0;
+    if (!PyArg_ParseTuple(args, "Oiiii|i", &obj, &region.left, &region.top,
+                          &region.width, &region.height, &timeout_ms)) return NULL;
+
+    Py_buffer view;
+    if (!GetFrameBuffer(obj, region.width, region.height, 4, &view)) return NULL;
+
+    GrabResult result;
+    Py_BEGIN_ALLOW_THREADS
+    {
+        // Scoped so the mutex is released before we take the GIL back.
+        std::lock_guard<std::mutex> lock(GetCaptureMutex());
+        result = GetDesktopDuplicator().Grab(region, (uint8_t*)view.buf, region.width * 4, timeout_ms);
+    }
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
+
+    if (result == GRAB_ERROR) {
+        PyErr_SetString(PyExc_OSError, "DXGI capture failed (output lost or not open)");
+        return NULL;
+    }
+    return PyBool_FromLong(result == GRAB_NEW_FRAME);
+}
+
+// Python wrapper for DesktopDuplicator::Close
+static PyObject* method_capture_close(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    Py_BEGIN_ALLOW_THREADS
+    {
+        std::lock_guard<std::mutex> lock(GetCaptureMutex());
+        GetDesktopDuplicator().Close();
+    }
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
+}
+
+// ----------------------------------------------------------------------------
+// Capture ring (background capture thread)
+// ----------------------------------------------------------------------------
+
+// Python wrapper for CaptureRing::Start.
+// capture_ring_start(left, top, width, height, slots=4); call capture_open first.
+static PyObject* method_capture_ring_start(PyObject* self, PyObject* args) {
+    CaptureRegion region;
+    int slots = 4;
+    if (!PyArg_ParseTuple(args, "iiii|i", &region.left, &region.top,
+                          &region.width, &region.height, &slots)) return NULL;
+    bool ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = GetCaptureRing().Start(region, slots);
+    Py_END_ALLOW_THREADS
+    if (!ok) {
+        PyErr_SetString(PyExc_ValueError, "capture ring region must have a positive size");
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+// Python wrapper for CaptureRing::Stop
+static PyObject* method_capture_ring_stop(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    Py_BEGIN_ALLOW_THREADS
+    GetCaptureRing().Stop();
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
+}
+
+// (present_us, seq) on success, None when no frame was available in time.
+static PyObject* StampOrNone(bool ok, const FrameStamp& stamp) {
+    if (!ok) Py_RETURN_NONE;
+    return Py_BuildValue("(LK)", (long long)stamp.present_us, (unsigned long long)stamp.seq);
+}
+
+// Python wrapper for CaptureRing::ReadLatest.
+// capture_ring_latest(out, timeout_ms=100) -> (present_us, seq) or None
+static PyObject* method_capture_ring_latest(PyObject* self, PyObject* args) {
+    PyObject* obj;
+    int timeout_ms = 100;
+    if (!PyArg_ParseTuple(args, "O|i", &obj, &timeout_ms)) return NULL;
+
+    CaptureRing& ring = GetCaptureRing();
+    if (!ring.IsRunning()) {
+        PyErr_SetString(PyExc_RuntimeError, "capture ring is not running");
+        return NULL;
+    }
+    const CaptureRegion region = ring.Region();
+    Py_buffer view;
+    if (!GetFrameBuffer(obj, region.width, region.height, 4, &view)) return NULL;
+
+    bool ok;
+    FrameStamp stamp;
+    Py_BEGIN_ALLOW_THREADS
+    ok = ring.ReadLatest((uint8_t*)view.buf, region.width, region.height, region.width * 4, timeout_ms, &stamp);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
+    return StampOrNone(ok, stamp);
+}
+
+// Python wrapper for CaptureRing::ReadAtOrAfter.
+// capture_ring_at_or_after(out, t_us, timeout_ms=100) -> (present_us, seq) or None
+static PyObject* method_capture_ring_at_or_after(PyObject* self, PyObject* args) {
+    PyObject* obj;
+    long long t_us;
+    int timeout_ms = 100;
+    if (!PyArg_ParseTuple(args, "OL|i", &obj, &t_us, &timeout_ms)) return NULL;
+
+    CaptureRing& ring = GetCaptureRing();
+    if (!ring.IsRunning()) {
+        PyErr_SetString(PyExc_RuntimeError, "capture ring is not running");
+        return NULL;
+    }
+    const CaptureRegion region = ring.Region();
+    Py_buffer view;
+    if (!GetFrameBuffer(obj, region.width, region.height, 4, &view)) return NULL;
+
+    bool ok;
+    FrameStamp stamp;
+    Py_BEGIN_ALLOW_THREADS
+    ok = ring.ReadAtOrAfter((int64_t)t_us, (uint8_t*)view.buf, region.width, region.height, region.width * 4,
+                            timeout_ms, &stamp);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
+    return StampOrNone(ok, stamp);
+}
+
+// ----------------------------------------------------------------------------
+// Replay capture (recorded frames, for benchmarks)
+// ----------------------------------------------------------------------------
+
+// The replay for a handle, or null with a ValueError set.
+static std::shared_ptr<ReplaySource> ReplayOrError(int handle) {
+    std::shared_ptr<ReplaySource> replay = GetReplay(handle);
+    if (!replay) PyErr_Format(PyExc_ValueError, "invalid replay handle %d", handle);
+    return replay;
+}
+
+// Python wrapper for OpenReplay: replay_open(path) -> handle. Maps the file
+// and pages it in; the playback clock starts now.
+static PyObject* method_replay_open(PyObject* self, PyObject* args) {
+    const char* path;
+    if (!PyArg_ParseTuple(args, "s", &path)) return NULL;
+    const std::string file(path);
+    std::string error;
+    int handle;
+    Py_BEGIN_ALLOW_THREADS
+    handle = OpenReplay(file, &error);
+    Py_END_ALLOW_THREADS
+    if (handle == 0) {
+        PyErr_SetString(PyExc_OSError, error.c_str());
+        return NULL;
+    }
+    return PyLong_FromLong(handle);
+}
+
+// replay_info(handle) -> (width, height, frame_count, frame_interval_us)
+static PyObject* method_replay_info(PyObject* self, PyObject* args) {
+    int handle;
+    if (!PyArg_ParseTuple(args, "i", &handle)) return NULL;
+    std::shared_ptr<ReplaySource> replay = ReplayOrError(handle);
+    if (!replay) return NULL;
+    return Py_BuildValue("(iiII)", replay->Width(), replay->Height(),
+                         replay->FrameCount(), replay->FrameIntervalUs());
+}
+
+// Python wrapper for ReplaySource::Start: replay_start(handle, start_us=now)
+static PyObject* method_replay_start(PyObject* self, PyObject* args) {
+    int handle;
+    long long start_us = -1;
+    if (!PyArg_ParseTuple(args, "i|L", &handle, &start_us)) return NULL;
+    std::shared_ptr<ReplaySource> replay = ReplayOrError(handle);
+    if (!replay) return NULL;
+    replay->Start(start_us < 0 ? QpcNowUs() : (int64_t)start_us);
+    Py_RETURN_NONE;
+}
+
+// Python wrapper for ReplaySource::SeqAt: replay_seq_at(handle, t_us) -> seq
+static PyObject* method_replay_seq_at(PyObject* self, PyObject* args) {
+    int handle;
+    long long t_us;
+    if (!PyArg_ParseTuple(args, "iL", &handle, &t_us)) return NULL;
+    std::shared_ptr<ReplaySource> replay = ReplayOrError(handle);
+    if (!replay) return NULL;
+    return PyLong_FromUnsignedLongLong(replay->SeqAt((int64_t)t_us));
+}
+
+// Python wrapper for ReplaySource::Read.
+// replay_read(handle, out, seq, x=0, y=0) -> (present_us, seq): copies the
+// part of frame seq at (x, y) the size of out, an (H, W, 4) uint8 array.
+static PyObject* method_replay_read(PyObject* self, PyObject* args) {
+    int handle;
+    PyObject* obj;
+    unsigned long long seq;
+    int x = 0;
+    int y = 0;
+    if (!PyArg_ParseTuple(args, "iOK|ii", &handle, &obj, &seq, &x, &y)) return NULL;
+    std::shared_ptr<ReplaySource> replay = ReplayOrError(handle);
+    if (!replay) return NULL;
+
+    Py_buffer view;
+    if (PyObject_GetBuffer(obj, &view, PyBUF_WRITABLE | PyBUF_ND | PyBUF_FORMAT) < 0) return NULL;
+    const bool is_u8 = view.itemsize == 1 && (!view.format || strcmp(view.format, "B") == 0);
+    if (!is_u8 || view.ndim != 3 || view.shape[2] != 4 || !PyBuffer_IsContiguous(&view, 'C')) {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyExc_ValueError, "out must be a C-contiguous (H, W, 4) uint8 array");
+        return NULL;
+    }
+    const int width = (int)view.shape[1];
+    const int height = (int)view.shape[0];
+
+    Py_BEGIN_ALLOW_THREADS
+    replay->Read(seq, x, y, width, height, (uint8_t*)view.buf, width * 4);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
+    return Py_BuildValue("(LK)", (long long)replay->PresentUs(seq), seq);
+}
+
+// Python wrapper for CloseReplay
+static PyObject* method_replay_close(PyObject* self, PyObject* args) {
+    int handle;
+    if (!PyArg_ParseTuple(args, "i", &handle)) return NULL;
+    CloseReplay(handle);
+    Py_RETURN_NONE;
+}
+
+// ----------------------------------------------------------------------------
+// Step recorder (trajectory files for offline training)
+// ----------------------------------------------------------------------------
+
+// The recorder for a handle, or null with a ValueError set.
+static std::shared_ptr<StepRecorder> RecorderOrError(int handle) {
+    std::shared_ptr<StepRecorder> recorder = GetRecorder(handle);
+    if (!recorder) PyErr_Format(PyExc_ValueError, "invalid recorder handle %d", handle);
+    return recorder;
+}
+
+// Python wrapper for OpenRecorder.
+// recorder_open(path, channels=3, height=224, width=224, chunk_records=64,
+// buffers=4, codec=RECORD_CODEC_RAW) -> handle. Creates the file and
+// starts its writer thread.
+static PyObject* method_recorder_open(PyObject* self, PyObject* args) {
+    const char* path;
+    int channels = 3;
+    int height = 224;
+    int width = 224;
+    int chunk_records = 64;
+    int buffers = 4;
+    int codec = RECORD_CODEC_RAW;
+    if (!PyArg_ParseTuple(args, "s|iiiiii", &path, &channels, &height, &width, &chunk_records, &buffers,
+                          &codec)) {
+        return NULL;
+    }
+    const std::string file(path);
+    std::string error;
+    int handle;
+    Py_BEGIN_ALLOW_THREADS
+    handle = OpenRecorder(file, channels, height, width, chunk_records, buffers, codec, &error);
+    Py_END_ALLOW_THREADS
+    if (handle == 0) {
+        PyErr_SetString(PyExc_OSError, error.c_str());
+        return NULL;
+    }
+    return PyLong_FromLong(handle);
+}
+
+// Python wrapper for StepRecorder::Add.
+// recorder_add(handle, obs, action, reward, timestamp_us, features=None,
+// env_id=0, flags=0, step=0) -> bool: obs is a C-contiguous (C, H, W)
+// uint8 array, features up to 4 floats. False if the record was dropped
+// (the disk is behind). Keeps the GIL: Add() is one memcpy, and holding it
+// means no Python thread can close the recorder halfway through.
+static PyObject* method_recorder_add(PyObject* self, PyObject* args) {
+    int handle;
+    PyObject* obj;
+    int action;
+    float reward;
+    long long timestamp_us;
+    PyObject* features = Py_None;
+    int env_id = 0;
+    int flags = 0;
+    unsigned long long step = 0;
+    if (!PyArg_ParseTuple(args, "iOifL|OiiK", &handle, &obj, &action, &reward, &timestamp_us,
+                          &features, &env_id, &flags, &step)) {
+        return NULL;
+    }
+    std::shared_ptr<StepRecorder> recorder = RecorderOrError(handle);
+    if (!recorder) return NULL;
+
+    StepMeta meta = {};
+    meta.timestamp_us = (int64_t)timestamp_us;
+    meta.step = step;
+    meta.action = action;
+    meta.reward = reward;
+    meta.env_id = (uint16_t)env_id;
+    meta.flags = (uint16_t)flags;
+    for (float& f : meta.features) f = -1.0f;
+    if (features != Py_None) {
+        PyObject* seq = PySequence_Fast(features, "features must be a sequence of floats");
+        if (!seq) return NULL;
+        const Py_ssize_t n = std::min<Py_ssize_t>(PySequence_Fast_GET_SIZE(seq), 4);
+        for (Py_ssize_t i = 0; i < n; ++i) {
+            meta.features[i] = (float)PyFloat_AsDouble(PySequence_Fast_GET_ITEM(seq, i));
+        }
+        Py_DECREF(seq);
+        if (PyErr_Occurred()) return NULL;
+    }
+
+    Py_buffer view;
+    if (PyObject_GetBuffer(obj, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) return NULL;
+    const bool is_u8 = view.itemsize == 1 && (!view.format || strcmp(view.format, "B") == 0);
+    if (!is_u8 || (size_t)view.len != recorder->ObsBytes()) {
+        PyBuffer_Release(&view);
+        PyErr_Format(PyExc_ValueError, "obs must be %zu bytes of uint8 CHW", recorder->ObsBytes());
+        return NULL;
+    }
+    const bool ok = recorder->Add((const uint8_t*)view.buf, meta);
+    PyBuffer_Release(&view);
+    return PyBool_FromLong(ok);
+}
+
+// recorder_stats(handle) as a dict (shared by recorder_close).
+static PyObject* RecorderStatsDict(const StepRecorder& recorder) {
+    const RecorderStats s = recorder.Stats();
+    return Py_BuildValue(
+        "{s:K,s:K,s:K,s:K,s:O}",
+        "records", (unsigned long long)s.records,
+        "dropped", (unsigned long long)s.dropped,
+        "chunks", (unsigned long long)s.chunks,
+        "bytes", (unsigned long long)s.bytes,
+        "write_error", s.write_error ? Py_True : Py_False);
+}
+
+// recorder_stats(handle) -> {records, dropped, chunks, bytes, write_error}
+static PyObject* method_recorder_stats(PyObject* self, PyObject* args) {
+    int handle;
+    if (!PyArg_ParseTuple(args, "i", &handle)) return NULL;
+    std::shared_ptr<StepRecorder> recorder = RecorderOrError(handle);
+    if (!recorder) return NULL;
+    return RecorderStatsDict(*recorder);
+}
+
+// Python wrapper for CloseRecorder.
+// recorder_close(handle) -> final stats, or None if already closed. Writes
+// the last chunk and the index.
+static PyObject* method_recorder_close(PyObject* self, PyObject* args) {
+    int handle;
+    if (!PyArg_ParseTuple(args, "i", &handle)) return NULL;
+    std::shared_ptr<StepRecorder> recorder = GetRecorder(handle);
+    if (!recorder) Py_RETURN_NONE;
+    recorder->Seal();   // with the GIL, so no recorder_add can be halfway through
+    Py_BEGIN_ALLOW_THREADS
+    CloseRecorder(handle);
+    Py_END_ALLOW_THREADS
+    return RecorderStatsDict(*recorder);
+}
+
+// ----------------------------------------------------------------------------
+// Frame preprocessing
+// ----------------------------------------------------------------------------
+
+// Gets a read-only view of an (H, W, 3|4) uint8 BGR(A) frame. Rows may be
+// padded and the channel axis may be a slice (frame[:, :, :3] of a BGRA
+// buffer), but each pixel's bytes must be adjacent.
+static bool GetFrameView(PyObject* obj, Py_buffer* view, FrameView* frame) {
+    if (PyObject_GetBuffer(obj, view, PyBUF_STRIDES | PyBUF_FORMAT) < 0) return false;
+    const bool is_u8 = view->itemsize == 1 && (!view->format || strcmp(view->format, "B") == 0);
+    if (!is_u8 || view->ndim != 3 || (view->shape[2] != 3 && view->shape[2] != 4) ||
+        view->strides[2] != 1 || (view->strides[1] != 3 && view->strides[1] != 4) ||
+        view->strides[0] < view->shape[1] * view->strides[1] || view->shape[0] <= 0 || view->shape[1] <= 0) {
+        PyBuffer_Release(view);
+        PyErr_SetString(PyExc_ValueError, "frame must be a uint8 (H, W, 3|4) array with contiguous pixels");
+        return false;
+    }
+    frame->data = (const uint8_t*)view->buf;
+    frame->width = (int)view->shape[1];
+    frame->height = (int)view->shape[0];
+    frame->row_stride = (int)view->strides[0];
+    frame->pixel_stride = (int)view->strides[1];
+    return true;
+}
+
+// Python wrapper for PreprocessFrame.
+// preprocess_frame(src, out, out_w=224, out_h=224): src is an (H, W, 3|4)
+// uint8 BGR(A) array (views like frame[:, :, :3] are fine); out is a
+// writable (3, out_h, out_w) uint8 array that receives planar RGB.
+static PyObject* method_preprocess_frame(PyObject* self, PyObject* args) {
+    PyObject* src_obj;
+    PyObject* out_obj;
+    int out_w = 224;
+    int out_h = 224;
+    if (!PyArg_ParseTuple(args, "OO|ii", &src_obj, &out_obj, &out_w, &out_h)) return NULL;
+    if (out_w <= 0 || out_h <= 0) {
+        PyErr_SetString(PyExc_ValueError, "out_w and out_h must be positive");
+        return NULL;
+    }
+
+    Py_buffer src;
+    FrameView frame;
+    if (!GetFrameView(src_obj, &src, &frame)) return NULL;
+
+    Py_buffer out;
+    if (!GetFrameBuffer(out_obj, out_w, out_h, 3, &out)) {
+        PyBuffer_Release(&src);
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    PreprocessFrame(frame, (uint8_t*)out.buf, out_w, out_h);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&out);
+    PyBuffer_Release(&src);
     Py_RETURN_NONE;
 }
 
+// Python wrapper for PreprocessSimdLevel
+static PyObject* method_preprocess_simd_level(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    return PyUnicode_FromString(PreprocessSimdLevel());
+}
+
+// ----------------------------------------------------------------------------
+// Delta frame codec
+// ----------------------------------------------------------------------------
+
+// Python wrapper for DeltaEncode.
+// delta_encode(cur, prev=None) -> bytes: cur and prev are C-contiguous
+// buffers of the same size (any shape); prev None makes a keyframe.
+static PyObject* method_delta_encode(PyObject* self, PyObject* args) {
+    PyObject* cur_obj;
+    PyObject* prev_obj = Py_None;
+    if (!PyArg_ParseTuple(args, "O|O", &cur_obj, &prev_obj)) return NULL;
+
+    Py_buffer cur;
+    if (PyObject_GetBuffer(cur_obj, &cur, PyBUF_C_CONTIGUOUS) < 0) return NULL;
+    Py_buffer prev = {};
+    const bool has_prev = prev_obj != Py_None;
+    if (has_prev) {
+        if (PyObject_GetBuffer(prev_obj, &prev, PyBUF_C_CONTIGUOUS) < 0) {
+            PyBuffer_Release(&cur);
+            return NULL;
+        }
+        if (prev.len != cur.len) {
+            PyBuffer_Release(&cur);
+            PyBuffer_Release(&prev);
+            PyErr_SetString(PyExc_ValueError, "prev must be the same size as cur");
+            return NULL;
+        }
+    }
+
+    std::vector<uint8_t> out(DeltaMaxEncodedSize((size_t)cur.len));
+    size_t size;
+    Py_BEGIN_ALLOW_THREADS
+    size = DeltaEncode((const uint8_t*)cur.buf, has_prev ? (const uint8_t*)prev.buf : nullptr,
+                       (size_t)cur.len, out.data());
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&cur);
+    if (has_prev) PyBuffer_Release(&prev);
+    return PyBytes_FromStringAndSize((const char*)out.data(), (Py_ssize_t)size);
+}
+
+// Python wrapper for DeltaDecode.
+// delta_decode(packet, dst): applies a packet in place to dst, a writable
+// C-contiguous buffer holding the previous frame (anything, for a
+// keyframe). ValueError if the packet is malformed or for another size.
+static PyObject* method_delta_decode(PyObject* self, PyObject* args) {
+    Py_buffer packet;
+    PyObject* dst_obj;
+    if (!PyArg_ParseTuple(args, "y*O", &packet, &dst_obj)) return NULL;
+    Py_buffer dst;
+    if (PyObject_GetBuffer(dst_obj, &dst, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS) < 0) {
+        PyBuffer_Release(&packet);
+        return NULL;
+    }
+    bool ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = DeltaDecode((const uint8_t*)packet.buf, (size_t)packet.len, (uint8_t*)dst.buf, (size_t)dst.len);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&packet);
+    PyBuffer_Release(&dst);
+    if (!ok) {
+        PyErr_SetString(PyExc_ValueError, "malformed delta packet (or not for a frame this size)");
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+// delta_simd_level() -> "avx2", "sse2" or "scalar"
+static PyObject* method_delta_simd_level(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    return PyUnicode_FromString(DeltaSimdLevel());
+}
+
+// ----------------------------------------------------------------------------
+// Reward features
+// ----------------------------------------------------------------------------
+
+// Parses None or an (x, y, width, height) tuple into r (None = empty).
+static bool ParseRect(PyObject* obj, FrameRect* r) {
+    *r = FrameRect{0, 0, 0, 0};
+    if (obj == Py_None) return true;
+    return PyArg_ParseTuple(obj, "iiii", &r->x, &r->y, &r->width, &r->height) != 0;
+}
+
+// Negative feature values mean "not available" and become None.
+static PyObject* FeatureOrNone(float value) {
+    if (value < 0) Py_RETURN_NONE;
+    return PyFloat_FromDouble(value);
+}
+
+// Python wrapper for OpenRewardExtractor
+static PyObject* method_reward_open(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    return PyLong_FromLong(OpenRewardExtractor());
+}
+
+// Python wrapper for RewardFeatureExtractor::Compute.
+// reward_features(handle, frame, energy_rect=None, before=None, cursor_rect=None)
+//   -> (notif_diff, motion_diff, energy_green, cursor_diff), None where unavailable.
+static PyObject* method_reward_features(PyObject* self, PyObject* args) {
+    int handle;
+    PyObject* frame_obj;
+    PyObject* energy_obj = Py_None;
+    PyObject* before_obj = Py_None;
+    PyObject* cursor_obj = Py_None;
+    if (!PyArg_ParseTuple(args, "iO|OOO", &handle, &frame_obj, &energy_obj, &before_obj, &cursor_obj)) return NULL;
+
+    std::shared_ptr<RewardFeatureExtractor> extractor = GetRewardExtractor(handle);
+    if (!extractor) {
+        PyErr_Format(PyExc_ValueError, "invalid reward extractor handle %d", handle);
+        return NULL;
+    }
+    RewardRegions regions;
+    if (!ParseRect(energy_obj, &regions.energy) || !ParseRect(cursor_obj, &regions.cursor)) return NULL;
+
+    Py_buffer frame_view;
+    FrameView frame;
+    if (!GetFrameView(frame_obj, &frame_view, &frame)) return NULL;
+
+    Py_buffer before_view;
+    FrameView before;
+    const bool has_before = before_obj != Py_None;
+    if (has_before) {
+        if (!GetFrameView(before_obj, &before_view, &before)) {
+            PyBuffer_Release(&frame_view);
+            return NULL;
+        }
+        if (before.width != frame.width || before.height != frame.height) {
+            PyBuffer_Release(&before_view);
+            PyBuffer_Release(&frame_view);
+            PyErr_SetString(PyExc_ValueError, "before and frame must have the same size");
+            return NULL;
+        }
+    }
+
+    RewardFeatures f;
+    Py_BEGIN_ALLOW_THREADS
+    f = extractor->Compute(frame, has_before ? &before : nullptr, regions);
+    Py_END_ALLOW_THREADS
+
+    if (has_before) PyBuffer_Release(&before_view);
+    PyBuffer_Release(&frame_view);
+
+    PyObject* result = PyTuple_New(4);
+    if (!result) return NULL;
+    PyTuple_SET_ITEM(result, 0, FeatureOrNone(f.notif_diff));
+    PyTuple_SET_ITEM(result, 1, FeatureOrNone(f.motion_diff));
+    PyTuple_SET_ITEM(result, 2, FeatureOrNone(f.energy_green));
+    PyTuple_SET_ITEM(result, 3, FeatureOrNone(f.cursor_diff));
+    return result;
+}
+
+// Python wrapper for RewardFeatureExtractor::Reset
+static PyObject* method_reward_reset(PyObject* self, PyObject* args) {
+    int handle;
+    if (!PyArg_ParseTuple(args, "i", &handle)) return NULL;
+    std::shared_ptr<RewardFeatureExtractor> extractor = GetRewardExtractor(handle);
+    if (extractor) extractor->Reset();
+    Py_RETURN_NONE;
+}
+
+// Python wrapper for CloseRewardExtractor
+static PyObject* method_reward_close(PyObject* self, PyObject* args) {
+    int handle;
+    if (!PyArg_ParseTuple(args, "i", &handle)) return NULL;
+    CloseRewardExtractor(handle);
+    Py_RETURN_NONE;
+}
+
+// ----------------------------------------------------------------------------
+// Batched observations (vectorized envs)
+// ----------------------------------------------------------------------------
+
+// Item i of an optional sequence (None = no sequence), as a borrowed ref:
+// Py_None when the sequence is missing.
+static PyObject* OptionalItem(PyObject* fast, Py_ssize_t i) {
+    return fast ? PySequence_Fast_GET_ITEM(fast, i) : Py_None;
+}
+
+// Parses the per-instance arguments shared by observe_batch and
+// pipeline_submit: rects plus optional reward_handles / energy_rects /
+// cursor_rects sequences (one entry per rect). extractors keeps every
+// instances[i].reward alive. False with a Python error set on bad input.
+static bool ParseBatchInstances(PyObject* rects_obj, PyObject* handles_obj, PyObject* energy_obj,
+                                PyObject* cursor_obj, std::vector<BatchInstance>* instances,
+                                std::vector<std::shared_ptr<RewardFeatureExtractor>>* extractors) {
+    PyObject* rects = PySequence_Fast(rects_obj, "rects must be a sequence of (x, y, w, h)");
+    if (!rects) return false;
+    const Py_ssize_t count = PySequence_Fast_GET_SIZE(rects);
+    PyObject* handles = NULL;
+    PyObject* energy = NULL;
+    PyObject* cursor = NULL;
+    bool ok = false;
+    instances->assign(count, BatchInstance{});
+    extractors->assign(count, nullptr);
+
+    // Optional per-instance sequences must have one entry per rect.
+    auto optional_seq = [&](PyObject* obj, const char* name, PyObject** fast) {
+        if (obj == Py_None) return true;
+        *fast = PySequence_Fast(obj, name);
+        if (!*fast) return false;
+        if (PySequence_Fast_GET_SIZE(*fast) != count) {
+            PyErr_Format(PyExc_ValueError, "%s needs one entry per rect", name);
+            return false;
+        }
+        return true;
+    };
+    if (!optional_seq(handles_obj, "reward_handles", &handles) ||
+        !optional_seq(energy_obj, "energy_rects", &energy) ||
+        !optional_seq(cursor_obj, "cursor_rects", &cursor)) goto done;
+
+    for (Py_ssize_t i = 0; i < count; ++i) {
+        BatchInstance& inst = (*instances)[i];
+        inst.reward = nullptr;
+        if (!ParseRect(PySequence_Fast_GET_ITEM(rects, i), &inst.rect) ||
+            !ParseRect(OptionalItem(energy, i), &inst.regions.energy) ||
+            !ParseRect(OptionalItem(cursor, i), &inst.regions.cursor)) goto done;
+        PyObject* handle = OptionalItem(handles, i);
+        if (handle != Py_None) {
+            const long h = PyLong_AsLong(handle);
+            if (h == -1 && PyErr_Occurred()) goto done;
+            (*extractors)[i] = GetRewardExtractor((int)h);
+            if (!(*extractors)[i]) {
+                PyErr_Format(PyExc_ValueError, "invalid reward extractor handle %ld", h);
+                goto done;
+            }
+            inst.reward = (*extractors)[i].get();
+        }
+    }
+    ok = true;
+
+done:
+    Py_XDECREF(cursor);
+    Py_XDECREF(energy);
+    Py_XDECREF(handles);
+    Py_DECREF(rects);
+    return ok;
+}
+
+// One (notif_diff, motion_diff, energy_green, cursor_diff) tuple per
+// instance, or None for instances without a reward extractor.
+static PyObject* BatchFeaturesList(const std::vector<BatchInstance>& instances,
+                                   const std::vector<RewardFeatures>& features) {
+    const Py_ssize_t count = (Py_ssize_t)instances.size();
+    PyObject* result = PyList_New(count);
+    if (!result) return NULL;
+    for (Py_ssize_t i = 0; i < count; ++i) {
+        PyObject* item;
+        if (!instances[i].reward) {
+            Py_INCREF(Py_None);
+            item = Py_None;
+        } else {
+            const RewardFeatures& f = features[i];
+            item = PyTuple_New(4);
+            if (!item) {
+                Py_DECREF(result);
+                return NULL;
+            }
+            PyTuple_SET_ITEM(item, 0, FeatureOrNone(f.notif_diff));
+            PyTuple_SET_ITEM(item, 1, FeatureOrNone(f.motion_diff));
+            PyTuple_SET_ITEM(item, 2, FeatureOrNone(f.energy_green));
+            PyTuple_SET_ITEM(item, 3, FeatureOrNone(f.cursor_diff));
+        }
+        PyList_SET_ITEM(result, i, item);
+    }
+    return result;
+}
+
+// Gets the writable (N, 3, out_h, out_w) uint8 observation buffer for
+// `count` instances.
+static bool GetObsBuffer(PyObject* obj, Py_ssize_t count, Py_buffer* view, int* out_w, int* out_h) {
+    if (PyObject_GetBuffer(obj, view, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS) < 0) return false;
+    if (view->itemsize != 1 || view->ndim != 4 || view->shape[0] != count || view->shape[1] != 3) {
+        PyBuffer_Release(view);
+        PyErr_SetString(PyExc_ValueError, "out must be a uint8 (N, 3, H, W) array with N = len(rects)");
+        return false;
+    }
+    *out_h = (int)view->shape[2];
+    *out_w = (int)view->shape[3];
+    return true;
+}
+
+// Python wrapper for ObserveBatch.
+// observe_batch(frame, rects, out=None, reward_handles=None, energy_rects=None,
+//               before=None, cursor_rects=None, threads=0)
+//   frame:  one (H, W, 3|4) uint8 BGR(A) frame holding every instance
+//   rects:  one (x, y, w, h) per instance, in frame pixels
+//   out:    writable (N, 3, out_h, out_w) uint8 array, or None
+//   reward_handles / energy_rects / cursor_rects: per instance (None entries
+//           allowed); the rects are relative to the instance's own rect
+//   -> [(notif_diff, motion_diff, energy_green, cursor_diff) or None, ...]
+static PyObject* method_observe_batch(PyObject* self, PyObject* args) {
+    PyObject* frame_obj;
+    PyObject* rects_obj;
+    PyObject* out_obj = Py_None;
+    PyObject* handles_obj = Py_None;
+    PyObject* energy_obj = Py_None;
+    PyObject* before_obj = Py_None;
+    PyObject* cursor_obj = Py_None;
+    int threads = 0;
+    if (!PyArg_ParseTuple(args, "OO|OOOOOi", &frame_obj, &rects_obj, &out_obj, &handles_obj,
+                          &energy_obj, &before_obj, &cursor_obj, &threads)) return NULL;
+
+    std::vector<BatchInstance> instances;
+    std::vector<std::shared_ptr<RewardFeatureExtractor>> extractors;
+    if (!ParseBatchInstances(rects_obj, handles_obj, energy_obj, cursor_obj, &instances, &extractors)) return NULL;
+    const Py_ssize_t count = (Py_ssize_t)instances.size();
+    std::vector<RewardFeatures> features(count);
+    PyObject* result = NULL;
+    Py_buffer frame_view, before_view, out_view;
+    FrameView frame, before;
+    bool has_frame = false, has_before = false, has_out = false;
+    int out_w = 0, out_h = 0;
+
+    if (!GetFrameView(frame_obj, &frame_view, &frame)) goto done;
+    has_frame = true;
+    if (before_obj != Py_None) {
+        if (!GetFrameView(before_obj, &before_view, &before)) goto done;
+        has_before = true;
+        if (before.width != frame.width || before.height != frame.height) {
+            PyErr_SetString(PyExc_ValueError, "before and frame must have the same size");
+            goto done;
+        }
+    }
+    if (out_obj != Py_None) {
+        if (!GetObsBuffer(out_obj, count, &out_view, &out_w, &out_h)) goto done;
+        has_out = true;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    ObserveBatch(frame, has_before ? &before : nullptr, instances.data(), (int)count,
+                 has_out ? (uint8_t*)out_view.buf : nullptr, out_w, out_h, threads, features.data());
+    Py_END_ALLOW_THREADS
+
+    result = BatchFeaturesList(instances, features);
+
+done:
+    if (has_out) PyBuffer_Release(&out_view);
+    if (has_before) PyBuffer_Release(&before_view);
+    if (has_frame) PyBuffer_Release(&frame_view);
+    return result;
+}
+
+// ----------------------------------------------------------------------------
+// Step pipeline (capture + batch observation on a background thread)
+// ----------------------------------------------------------------------------
+
+// Buffers of submitted jobs, keyed by (pipeline handle, job id). Released
+// when the job is taken (pipeline_result / pipeline_close); only touched
+// with the GIL held.
+static std::map<std::pair<int, uint64_t>, std::vector<Py_buffer>>& PipelineJobViews() {
+    static std::map<std::pair<int, uint64_t>, std::vector<Py_buffer>> views;
+    return views;
+}
+
+static void ReleasePipelineViews(int handle, uint64_t id) {
+    auto& all = PipelineJobViews();
+    auto it = all.find({handle, id});
+    if (it == all.end()) return;
+    for (Py_buffer& view : it->second) PyBuffer_Release(&view);
+    all.erase(it);
+}
+
+static std::shared_ptr<StepPipeline> PipelineOrError(int handle) {
+    std::shared_ptr<StepPipeline> pipeline = GetStepPipeline(handle);
+    if (!pipeline) PyErr_Format(PyExc_ValueError, "invalid pipeline handle %d", handle);
+    return pipeline;
+}
+
+// Python wrapper for OpenStepPipeline
+static PyObject* method_pipeline_open(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    return PyLong_FromLong(OpenStepPipeline());
+}
+
+// Python wrapper for StepPipeline::Submit.
+// pipeline_submit(handle, deadline_us, frame, before, rects, out=None,
+//                 reward_handles=None, energy_rects=None, cursor_rects=None,
+//                 threads=0, timeout_ms=100) -> job id
+//   frame:  writable BGRA buffer of the capture ring's size; the frame at
+//           deadline_us lands there
+//   before: None, or a BGR(A) view of an earlier frame buffer (same layout)
+//   the rest as for observe_batch. Every buffer stays in use until
+//   pipeline_result returns for this job.
+static PyObject* method_pipeline_submit(PyObject* self, PyObject* args) {
+    int handle;
+    long long deadline_us;
+    PyObject* frame_obj;
+    PyObject* before_obj;
+    PyObject* rects_obj;
+    PyObject* out_obj = Py_None;
+    PyObject* handles_obj = Py_None;
+    PyObject* energy_obj = Py_None;
+    PyObject* cursor_obj = Py_None;
+    int threads = 0;
+    int timeout_ms = 100;
+    if (!PyArg_ParseTuple(args, "iLOOO|OOOOii", &handle, &deadline_us, &frame_obj, &before_obj, &rects_obj,
+                          &out_obj, &handles_obj, &energy_obj, &cursor_obj, &threads, &timeout_ms)) return NULL;
+
+    std::shared_ptr<StepPipeline> pipeline = PipelineOrError(handle);
+    if (!pipeline) return NULL;
+    CaptureRing& ring = GetCaptureRing();
+    if (!ring.IsRunning()) {
+        PyErr_SetString(PyExc_RuntimeError, "capture ring is not running");
+        return NULL;
+    }
+    const CaptureRegion region = ring.Region();
+
+    auto job = std::make_unique<PipelineJob>();
+    if (!ParseBatchInstances(rects_obj, handles_obj, energy_obj, cursor_obj, &job->instances, &job->extractors)) {
+        return NULL;
+    }
+    std::vector<Py_buffer> views;
+    auto fail = [&]() -> PyObject* {
+        for (Py_buffer& view : views) PyBuffer_Release(&view);
+        return NULL;
+    };
+
+    Py_buffer view;
+    if (!GetFrameBuffer(frame_obj, region.width, region.height, 4, &view)) return fail();
+    views.push_back(view);
+    job->deadline_us = (int64_t)deadline_us;
+    job->timeout_ms = timeout_ms;
+    job->frame = (uint8_t*)view.buf;
+    job->frame_width = region.width;
+    job->frame_height = region.height;
+    job->frame_stride = region.width * 4;
+
+    if (before_obj != Py_None) {
+        FrameView before;
+        if (!GetFrameView(before_obj, &view, &before)) return fail();
+        views.push_back(view);
+        if (before.width != region.width || before.height != region.height ||
+            before.pixel_stride != 4 || before.row_stride != job->frame_stride) {
+            PyErr_SetString(PyExc_ValueError, "before must be a frame buffer like frame (BGRA, same size)");
+            return fail();
+        }
+        job->before = before.data;
+    }
+    if (out_obj != Py_None) {
+        if (!GetObsBuffer(out_obj, (Py_ssize_t)job->instances.size(), &view, &job->out_w, &job->out_h)) return fail();
+        views.push_back(view);
+        job->obs = (uint8_t*)view.buf;
+    }
+    job->threads = threads;
+
+    const uint64_t id = pipeline->Submit(std::move(job));
+    PipelineJobViews()[{handle, id}] = std::move(views);
+    return PyLong_FromUnsignedLongLong(id);
+}
+
+// Python wrapper for StepPipeline::WaitCaptured.
+// pipeline_captured(handle, job) -> (present_us, seq), or None if no frame came
+static PyObject* method_pipeline_captured(PyObject* self, PyObject* args) {
+    int handle;
+    unsigned long long id;
+    if (!PyArg_ParseTuple(args, "iK", &handle, &id)) return NULL;
+    std::shared_ptr<StepPipeline> pipeline = PipelineOrError(handle);
+    if (!pipeline) return NULL;
+    bool ok;
+    FrameStamp stamp;
+    Py_BEGIN_ALLOW_THREADS
+    ok = pipeline->WaitCaptured(id, &stamp);
+    Py_END_ALLOW_THREADS
+    return StampOrNone(ok, stamp);
+}
+
+// Python wrapper for StepPipeline::Take.
+// pipeline_result(handle, job) -> (stamp or None, [features or None, ...])
+// (the feature list is empty if no frame came). Frees the job's buffers.
+static PyObject* method_pipeline_result(PyObject* self, PyObject* args) {
+    int handle;
+    unsigned long long id;
+    if (!PyArg_ParseTuple(args, "iK", &handle, &id)) return NULL;
+    std::shared_ptr<StepPipeline> pipeline = PipelineOrError(handle);
+    if (!pipeline) return NULL;
+    std::unique_ptr<PipelineJob> job;
+    Py_BEGIN_ALLOW_THREADS
+    job = pipeline->Take(id);
+    Py_END_ALLOW_THREADS
+    ReleasePipelineViews(handle, id);
+    if (!job) {
+        PyErr_Format(PyExc_ValueError, "unknown pipeline job %llu", id);
+        return NULL;
+    }
+
+    PyObject* stamp = StampOrNone(job->captured, job->stamp);
+    PyObject* features = job->captured ? BatchFeaturesList(job->instances, job->features) : PyList_New(0);
+    if (!stamp || !features) {
+        Py_XDECREF(stamp);
+        Py_XDECREF(features);
+        return NULL;
+    }
+    return Py_BuildValue("(NN)", stamp, features);
+}
+
+// Python wrapper for CloseStepPipeline: waits for the jobs still running,
+// frees their buffers and stops the pipeline thread.
+static PyObject* method_pipeline_close(PyObject* self, PyObject* args) {
+    int handle;
+    if (!PyArg_ParseTuple(args, "i", &handle)) return NULL;
+    std::shared_ptr<StepPipeline> pipeline = GetStepPipeline(handle);
+    if (!pipeline) Py_RETURN_NONE;
+    auto& all = PipelineJobViews();
+    std::vector<uint64_t> ids;
+    for (auto it = all.lower_bound({handle, 0}); it != all.end() && it->first.first == handle; ++it) {
+        ids.push_back(it->first.second);
+    }
+    for (uint64_t id : ids) {
+        Py_BEGIN_ALLOW_THREADS
+        pipeline->Take(id);
+        Py_END_ALLOW_THREADS
+        ReleasePipelineViews(handle, id);
+    }
+    CloseStepPipeline(handle);
+    Py_BEGIN_ALLOW_THREADS
+    pipeline.reset();   // joins the pipeline thread (without the GIL)
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
+}
+
+// ----------------------------------------------------------------------------
+// Template matching
+// ----------------------------------------------------------------------------
+
+// Python wrapper for OpenTemplateMatcher
+static PyObject* method_matcher_open(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    return PyLong_FromLong(OpenTemplateMatcher());
+}
+
+// Python wrapper for TemplateMatcher::AddTemplate.
+// matcher_add(handle, template) -> id; template is a 2-D uint8 gray image.
+static PyObject* method_matcher_add(PyObject* self, PyObject* args) {
+    int handle;
+    PyObject* obj;
+    if (!PyArg_ParseTuple(args, "iO", &handle, &obj)) return NULL;
+    std::shared_ptr<TemplateMatcher> matcher = GetTemplateMatcher(handle);
+    if (!matcher) {
+        PyErr_Format(PyExc_ValueError, "invalid matcher handle %d", handle);
+        return NULL;
+    }
+
+    Py_buffer view;
+    if (PyObject_GetBuffer(obj, &view, PyBUF_STRIDES | PyBUF_FORMAT) < 0) return NULL;
+    const bool is_u8 = view.itemsize == 1 && (!view.format || strcmp(view.format, "B") == 0);
+    if (!is_u8 || view.ndim != 2 || view.strides[1] != 1 || view.strides[0] < view.shape[1] ||
+        view.shape[0] <= 0 || view.shape[1] <= 0) {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyExc_ValueError, "template must be a 2-D uint8 array with contiguous rows");
+        return NULL;
+    }
+    const int id = matcher->AddTemplate((const uint8_t*)view.buf, (int)view.shape[1], (int)view.shape[0],
+                                        (int)view.strides[0]);
+    PyBuffer_Release(&view);
+    return PyLong_FromLong(id);
+}
+
+// Python wrapper for TemplateMatcher::SetScene + FindAll.
+// matcher_find_all(handle, frame, hints, threshold=0.8, margin=32, threads=0)
+//   hints: one (x, y) or None per template id; threads: 0 = one per core
+//   -> [(score, x, y), ...] in template id order
+static PyObject* method_matcher_find_all(PyObject* self, PyObject* args) {
+    int handle;
+    PyObject* frame_obj;
+    PyObject* hints_obj;
+    float threshold = 0.8f;
+    int margin = 32;
+    int threads = 0;
+    if (!PyArg_ParseTuple(args, "iOO|fii", &handle, &frame_obj, &hints_obj, &threshold, &margin, &threads)) return NULL;
+    std::shared_ptr<TemplateMatcher> matcher = GetTemplateMatcher(handle);
+    if (!matcher) {
+        PyErr_Format(PyExc_ValueError, "invalid matcher handle %d", handle);
+        return NULL;
+    }
+
+    // Hints -> flat (x, y) pairs; has_hint marks which are real.
+    const int count = matcher->TemplateCount();
+    PyObject* hints = PySequence_Fast(hints_obj, "hints must be a sequence");
+    if (!hints) return NULL;
+    if (PySequence_Fast_GET_SIZE(hints) != count) {
+        Py_DECREF(hints);
+        PyErr_Format(PyExc_ValueError, "expected %d hints, got %zd", count, PySequence_Fast_GET_SIZE(hints));
+        return NULL;
+    }
+    std::vector<int> hint_xy((size_t)count * 2, 0);
+    std::vector<char> has_hint(count, 0);
+    for (int i = 0; i < count; ++i) {
+        PyObject* item = PySequence_Fast_GET_ITEM(hints, i);
+        if (item == Py_None) continue;
+        if (!PyArg_ParseTuple(item, "ii", &hint_xy[2 * i], &hint_xy[2 * i + 1])) {
+            Py_DECREF(hints);
+            return NULL;
+        }
+        has_hint[i] = 1;
+    }
+    Py_DECREF(hints);
+
+    Py_buffer frame_view;
+    FrameView frame;
+    if (!GetFrameView(frame_obj, &frame_view, &frame)) return NULL;
+
+    std::vector<MatchResult> results(count);
+    Py_BEGIN_ALLOW_THREADS
+    matcher->SetScene(frame);
+    matcher->FindAll(hint_xy.data(), has_hint.data(), margin, threshold, threads, results.data());
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&frame_view);
+
+    PyObject* list = PyList_New(count);
+    if (!list) return NULL;
+    for (int i = 0; i < count; ++i) {
+        PyList_SET_ITEM(list, i, Py_BuildValue("(fii)", results[i].score, results[i].x, results[i].y));
+    }
+    return list;
+}
+
+// Python wrapper for CloseTemplateMatcher
+static PyObject* method_matcher_close(PyObject* self, PyObject* args) {
+    int handle;
+    if (!PyArg_ParseTuple(args, "i", &handle)) return NULL;
+    CloseTemplateMatcher(handle);
+    Py_RETURN_NONE;
+}
+
+// ----------------------------------------------------------------------------
+// Change detection
+// ----------------------------------------------------------------------------
+
+// Python wrapper for DesktopDuplicator::FrameSeq
+static PyObject* method_capture_frame_seq(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    uint64_t seq;
+    Py_BEGIN_ALLOW_THREADS
+    {
+        std::lock_guard<std::mutex> lock(GetCaptureMutex());
+        seq = GetDesktopDuplicator().FrameSeq();
+    }
+    Py_END_ALLOW_THREADS
+    return PyLong_FromUnsignedLongLong(seq);
+}
+
+// Python wrapper for DesktopDuplicator::ChangedSince.
+// capture_changed_since(left, top, width, height, since_seq) -> bool
+static PyObject* method_capture_changed_since(PyObject* self, PyObject* args) {
+    CaptureRegion region;
+    unsigned long long since_seq;
+    if (!PyArg_ParseTuple(args, "iiiiK", &region.left, &region.top,
+                          &region.width, &region.height, &since_seq)) return NULL;
+    bool changed;
+    Py_BEGIN_ALLOW_THREADS
+    {
+        std::lock_guard<std::mutex> lock(GetCaptureMutex());
+        changed = GetDesktopDuplicator().ChangedSince(region, since_seq);
+    }
+    Py_END_ALLOW_THREADS
+    return PyBool_FromLong(changed);
+}
+
+// Python wrapper for ComputeTileHashes.
+// tile_hashes(frame, out, tile=CAPTURE_TILE): out is a uint64 array with
+// ceil(H / tile) x ceil(W / tile) elements.
+static PyObject* method_tile_hashes(PyObject* self, PyObject* args) {
+    PyObject* frame_obj;
+    PyObject* out_obj;
+    int tile = CAPTURE_TILE;
+    if (!PyArg_ParseTuple(args, "OO|i", &frame_obj, &out_obj, &tile)) return NULL;
+    if (tile <= 0) {
+        PyErr_SetString(PyExc_ValueError, "tile must be positive");
+        return NULL;
+    }
+
+    Py_buffer frame_view;
+    FrameView frame;
+    if (!GetFrameView(frame_obj, &frame_view, &frame)) return NULL;
+
+    Py_buffer out;
+    if (!GetFrameBuffer(out_obj, TileCount(frame.width, tile), TileCount(frame.height, tile),
+                        (int)sizeof(uint64_t), &out)) {
+        PyBuffer_Release(&frame_view);
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    ComputeTileHashes(frame, tile, (uint64_t*)out.buf);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&out);
+    PyBuffer_Release(&frame_view);
+    Py_RETURN_NONE;
+}
+
+// ----------------------------------------------------------------------------
+// Profiler
+// ----------------------------------------------------------------------------
+
+// Python wrapper for SetProfilerEnabled.
+// profiler_enable(enabled, trace=False): trace also keeps every span for
+// profiler_write_trace.
+static PyObject* method_profiler_enable(PyObject* self, PyObject* args) {
+    int enabled;
+    int trace = 0;
+    if (!PyArg_ParseTuple(args, "p|p", &enabled, &trace)) return NULL;
+    SetProfilerEnabled(enabled != 0, trace != 0);
+    Py_RETURN_NONE;
+}
+
+// Python wrapper for ProfilerEnabled
+static PyObject* method_profiler_enabled(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    return PyBool_FromLong(ProfilerEnabled());
+}
+
+// Python wrapper for ProfileRecord, in qpc_us() microseconds.
+// profiler_record(stage, start_us, end_us)
+static PyObject* method_profiler_record(PyObject* self, PyObject* args) {
+    int stage;
+    long long start_us;
+    long long end_us;
+    if (!PyArg_ParseTuple(args, "iLL", &stage, &start_us, &end_us)) return NULL;
+    if (!ProfileStageName(stage)) {
+        PyErr_Format(PyExc_ValueError, "unknown profiler stage %d", stage);
+        return NULL;
+    }
+    const double ticks_per_us = (double)QpcFrequency() / 1e6;
+    ProfileRecord(stage, (int64_t)((double)start_us * ticks_per_us), (int64_t)((double)end_us * ticks_per_us));
+    Py_RETURN_NONE;
+}
+
+// Python wrapper for ProfilerStats.
+// profiler_stats() -> {stage_name: {count, mean_us, p50_us, p90_us,
+// p99_us, max_us}} for every stage that recorded a span.
+static PyObject* method_profiler_stats(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    std::vector<StageLatency> stats;
+    Py_BEGIN_ALLOW_THREADS
+    stats = ProfilerStats();
+    Py_END_ALLOW_THREADS
+
+    PyObject* out = PyDict_New();
+    if (!out) return NULL;
+    for (int i = 0; i < (int)stats.size(); ++i) {
+        const StageLatency& s = stats[i];
+        if (s.count == 0) continue;
+        PyObject* entry = Py_BuildValue(
+            "{s:K,s:d,s:d,s:d,s:d,s:d}",
+            "count", (unsigned long long)s.count,
+            "mean_us", s.mean_us,
+            "p50_us", s.p50_us,
+            "p90_us", s.p90_us,
+            "p99_us", s.p99_us,
+            "max_us", s.max_us);
+        if (!entry || PyDict_SetItemString(out, ProfileStageName(i), entry) < 0) {
+            Py_XDECREF(entry);
+            Py_DECREF(out);
+            return NULL;
+        }
+        Py_DECREF(entry);
+    }
+    return out;
+}
+
+// Python wrapper for ProfilerDropped
+static PyObject* method_profiler_dropped(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    return PyLong_FromUnsignedLongLong(ProfilerDropped());
+}
+
+// Python wrapper for ProfilerWriteTrace; returns the number of events.
+static PyObject* method_profiler_write_trace(PyObject* self, PyObject* args) {
+    const char* path;
+    if (!PyArg_ParseTuple(args, "s", &path)) return NULL;
+    const std::string file(path);
+    int64_t written;
+    Py_BEGIN_ALLOW_THREADS
+    written = ProfilerWriteTrace(file);
+    Py_END_ALLOW_THREADS
+    if (written < 0) {
+        PyErr_Format(PyExc_OSError, "can't write trace to %s", path);
+        return NULL;
+    }
+    return PyLong_FromLongLong(written);
+}
+
+// Python wrapper for ProfilerReset
+static PyObject* method_profiler_reset(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    Py_BEGIN_ALLOW_THREADS
+    ProfilerReset();
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
+}
+
+// ----------------------------------------------------------------------------
+// Event bus
+// ----------------------------------------------------------------------------
+
+// Python wrapper for EventBusPublish.
+// bus_publish(type, source=0, i0=0, i1=0, f0=0.0, f1=0.0, f2=0.0, f3=0.0)
+static PyObject* method_bus_publish(PyObject* self, PyObject* args) {
+    unsigned int type;
+    unsigned int source = 0;
+    long long i0 = 0, i1 = 0;
+    double f0 = 0.0, f1 = 0.0, f2 = 0.0, f3 = 0.0;
+    if (!PyArg_ParseTuple(args, "I|ILLdddd", &type, &source, &i0, &i1, &f0, &f1, &f2, &f3)) return NULL;
+    EventBusPublish(type, source, i0, i1, f0, f1, f2, f3);
+    Py_RETURN_NONE;
+}
+
+// Python wrapper for EventBusActive
+static PyObject* method_bus_active(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    return PyBool_FromLong(EventBusActive());
+}
+
+// Python wrapper for EventBusPublished
+static PyObject* method_bus_published(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    return PyLong_FromUnsignedLongLong(EventBusPublished());
+}
+
+// Python wrapper for EventBusSubscribe; returns a handle.
+static PyObject* method_bus_subscribe(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    return PyLong_FromLong(EventBusSubscribe());
+}
+
+// Python wrapper for EventBusUnsubscribe
+static PyObject* method_bus_unsubscribe(PyObject* self, PyObject* args) {
+    int handle;
+    if (!PyArg_ParseTuple(args, "i", &handle)) return NULL;
+    EventBusUnsubscribe(handle);
+    Py_RETURN_NONE;
+}
+
+// Python wrapper for EventBusPoll.
+// bus_poll(handle, out) -> (count, dropped): out is a writable C-contiguous
+// buffer of 64-byte BusEvent records (events.EVENT_DTYPE); fills up to
+// len(out) of them.
+static PyObject* method_bus_poll(PyObject* self, PyObject* args) {
+    int handle;
+    PyObject* out_obj;
+    if (!PyArg_ParseTuple(args, "iO", &handle, &out_obj)) return NULL;
+    Py_buffer out;
+    if (PyObject_GetBuffer(out_obj, &out, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS) < 0) return NULL;
+    const int max_events = (int)std::min<Py_ssize_t>(out.len / (Py_ssize_t)sizeof(BusEvent), 1 << 20);
+    int count;
+    uint64_t dropped = 0;
+    Py_BEGIN_ALLOW_THREADS
+    count = EventBusPoll(handle, (BusEvent*)out.buf, max_events, &dropped);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&out);
+    if (count < 0) {
+        PyErr_Format(PyExc_ValueError, "unknown bus subscriber %d", handle);
+        return NULL;
+    }
+    return Py_BuildValue("(iK)", count, (unsigned long long)dropped);
+}
+
+// ----------------------------------------------------------------------------
+// Window tracker
+// ----------------------------------------------------------------------------
+
+static PyObject* HwndToPy(HWND hwnd) {
+    return PyLong_FromUnsignedLongLong((unsigned long long)(uintptr_t)hwnd);
+}
+
+// Parses (title, min_area) into a wide string.
+static bool ParseTitleArgs(PyObject* args, std::wstring* title, long long* min_area) {
+    PyObject* title_obj;
+    if (!PyArg_ParseTuple(args, "U|L", &title_obj, min_area)) return false;
+    Py_ssize_t len;
+    wchar_t* wide = PyUnicode_AsWideCharString(title_obj, &len);
+    if (!wide) return false;
+    title->assign(wide, (size_t)len);
+    PyMem_Free(wide);
+    return true;
+}
+
+// Python wrapper for FindLargestWindowByTitle.
+// window_find(title, min_area=1) -> hwnd of the largest visible window
+// whose title contains `title` (any case), 0 if none.
+static PyObject* method_window_find(PyObject* self, PyObject* args) {
+    std::wstring title;
+    long long min_area = 1;
+    if (!ParseTitleArgs(args, &title, &min_area)) return NULL;
+    HWND hwnd;
+    Py_BEGIN_ALLOW_THREADS
+    hwnd = FindLargestWindowByTitle(title, min_area);
+    Py_END_ALLOW_THREADS
+    return HwndToPy(hwnd);
+}
+
+// Python wrapper for FindWindowsByTitle.
+// window_find_all(title, min_area=800*600) -> [hwnd], left to right then
+// top to bottom.
+static PyObject* method_window_find_all(PyObject* self, PyObject* args) {
+    std::wstring title;
+    long long min_area = 800 * 600;
+    if (!ParseTitleArgs(args, &title, &min_area)) return NULL;
+    std::vector<HWND> found;
+    Py_BEGIN_ALLOW_THREADS
+    found = FindWindowsByTitle(title, min_area);
+    Py_END_ALLOW_THREADS
+    PyObject* out = PyList_New((Py_ssize_t)found.size());
+    if (!out) return NULL;
+    for (size_t i = 0; i < found.size(); ++i) {
+        PyObject* item = HwndToPy(found[i]);
+        if (!item) {
+            Py_DECREF(out);
+            return NULL;
+        }
+        PyList_SET_ITEM(out, (Py_ssize_t)i, item);
+    }
+    return out;
+}
+
+// Python wrapper for WindowTracker::Track; returns the state's version
+// (0: not a window).
+static PyObject* method_window_track(PyObject* self, PyObject* args) {
+    unsigned long long hwnd;
+    if (!PyArg_ParseTuple(args, "K", &hwnd)) return NULL;
+    uint64_t version;
+    Py_BEGIN_ALLOW_THREADS
+    version = GetWindowTracker().Track((HWND)(uintptr_t)hwnd);
+    Py_END_ALLOW_THREADS
+    return PyLong_FromUnsignedLongLong(version);
+}
+
+// Python wrapper for WindowTracker::Untrack
+static PyObject* method_window_untrack(PyObject* self, PyObject* args) {
+    unsigned long long hwnd;
+    if (!PyArg_ParseTuple(args, "K", &hwnd)) return NULL;
+    GetWindowTracker().Untrack((HWND)(uintptr_t)hwnd);
+    Py_RETURN_NONE;
+}
+
+// Python wrapper for WindowTracker::Version (0: not tracked)
+static PyObject* method_window_version(PyObject* self, PyObject* args) {
+    unsigned long long hwnd;
+    if (!PyArg_ParseTuple(args, "K", &hwnd)) return NULL;
+    return PyLong_FromUnsignedLongLong(GetWindowTracker().Version((HWND)(uintptr_t)hwnd));
+}
+
+// Python wrapper for WindowTracker::Get.
+// window_state(hwnd) -> (version, left, top, width, height, flags), or
+// None if the window isn't tracked.
+static PyObject* method_window_state(PyObject* self, PyObject* args) {
+    unsigned long long hwnd;
+    if (!PyArg_ParseTuple(args, "K", &hwnd)) return NULL;
+    WindowState s;
+    if (!GetWindowTracker().Get((HWND)(uintptr_t)hwnd, &s)) Py_RETURN_NONE;
+    return Py_BuildValue("(KiiiiI)", (unsigned long long)s.version, s.left, s.top, s.width, s.height, s.flags);
+}
+
+// Python wrapper for WindowTracker::Foreground (0 until something is tracked)
+static PyObject* method_window_foreground(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    return HwndToPy(GetWindowTracker().Foreground());
+}
+
+// ----------------------------------------------------------------------------
+// Scheduling
+// ----------------------------------------------------------------------------
+
+static bool ParseThreadRole(int role) {
+    if (role >= 0 && role < THREAD_ROLE_COUNT) return true;
+    PyErr_Format(PyExc_ValueError, "unknown thread role %d", role);
+    return false;
+}
+
+// Python wrapper for SetThreadPolicy.
+// thread_policy(role, affinity=0, priority=0, mmcss=None): affinity is a
+// bit mask of logical processors (0 = any), priority -2..2, mmcss an MMCSS
+// task name such as "Games" or "Capture".
+static PyObject* method_thread_policy(PyObject* self, PyObject* args) {
+    int role;
+    unsigned long long affinity = 0;
+    int priority = 0;
+    PyObject* mmcss_obj = Py_None;
+    if (!PyArg_ParseTuple(args, "i|KiO", &role, &affinity, &priority, &mmcss_obj)) return NULL;
+    if (!ParseThreadRole(role)) return NULL;
+    ThreadPolicy policy;
+    policy.affinity = affinity;
+    policy.priority = priority;
+    if (mmcss_obj != Py_None) {
+        if (!PyUnicode_Check(mmcss_obj)) {
+            PyErr_SetString(PyExc_TypeError, "thread_policy: mmcss must be a str or None");
+            return NULL;
+        }
+        const Py_ssize_t max_len = (Py_ssize_t)(sizeof(policy.mmcss) / sizeof(wchar_t)) - 1;
+        if (PyUnicode_GetLength(mmcss_obj) > max_len) {
+            PyErr_Format(PyExc_ValueError, "thread_policy: mmcss task name longer than %zd", max_len);
+            return NULL;
+        }
+        if (PyUnicode_AsWideChar(mmcss_obj, policy.mmcss, max_len) < 0) return NULL;
+    }
+    SetThreadPolicy((ThreadRole)role, policy);
+    Py_RETURN_NONE;
+}
+
+// Python wrapper for GetThreadPolicy: thread_get_policy(role)
+//   -> (affinity, priority, mmcss or None)
+static PyObject* method_thread_get_policy(PyObject* self, PyObject* args) {
+    int role;
+    if (!PyArg_ParseTuple(args, "i", &role)) return NULL;
+    if (!ParseThreadRole(role)) return NULL;
+    const ThreadPolicy p = GetThreadPolicy((ThreadRole)role);
+    if (p.mmcss[0] == L'\0') return Py_BuildValue("(KiO)", (unsigned long long)p.affinity, p.priority, Py_None);
+    return Py_BuildValue("(Kiu)", (unsigned long long)p.affinity, p.priority, p.mmcss);
+}
+
+// Python wrapper for GetCoreMasks -> (performance, efficiency, logical)
+static PyObject* method_core_masks(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    const CoreMasks m = GetCoreMasks();
+    return Py_BuildValue("(KKi)", (unsigned long long)m.performance, (unsigned long long)m.efficiency, m.logical);
+}
+
+// Python wrapper for ListNativeThreads: one dict per running native thread.
+static PyObject* method_thread_stats(PyObject* self, PyObject* args) {
+    if (!PyArg_ParseTuple(args, "")) return NULL;
+    const std::vector<NativeThreadInfo> threads = ListNativeThreads();
+    PyObject* out = PyList_New((Py_ssize_t)threads.size());
+    if (!out) return NULL;
+    for (size_t i = 0; i < threads.size(); ++i) {
+        const NativeThreadInfo& t = threads[i];
+        PyObject* item = Py_BuildValue(
+            "{s:s,s:k,s:d,s:d,s:K,s:K,s:O}",
+            "role", ThreadRoleName(t.role),
+            "id", (unsigned long)t.id,
+            "user_us", t.user_us,
+            "kernel_us", t.kernel_us,
+            "cycles", (unsigned long long)t.cycles,
+            "affinity", (unsigned long long)t.affinity,
+            "mmcss", t.mmcss ? Py_True : Py_False);
+        if (!item) {
+            Py_DECREF(out);
+            return NULL;
+        }
+        PyList_SET_ITEM(out, (Py_ssize_t)i, item);
+    }
+    return out;
+}
+
+// Module teardown: release anything still queued and join the background
+// threads (step pipelines, recorder writers, capture ring, input workers,
+// window tracker, ParallelFor pool) and unmap open replays.
+static void StopNativeThreads() {
+    CloseAllStepPipelines();      // before the ring and the pool they use
+    CloseAllRecorders();
+    CloseAllReplays();
+    GetCaptureRing().Stop();
+    StopInputWorkers();
+    GetWindowTracker().Stop();
+    StopParallelPool();
+}
+
 // Method definition table
 static PyMethodDef ClibMethods[] = {
-    {"send_key", method_send_key, METH_VARARGS, "Send a key press (VK code)."},
+    {"send_key", method_send_key, METH_VARARGS, "Send a key press (VK code, hold_ms=10)."},
     {"send_mouse_move", method_send_mouse_move, METH_VARARGS, "Move mouse relative (dx, dy)."},
-    {"jitter_move", method_jitter_move, METH_VARARGS, "Move mouse relative with jitter (dx, dy)."},
+    {"jitter_move", method_jitter_move, METH_VARARGS, "Humanized relative mouse move (dx, dy, duration_ms=150, seed=0)."},
+    {"trajectory", method_trajectory, METH_VARARGS, "Preview a humanized path: ([(dx, dy), ...], step_us, seed)."},
     {"send_mouse_click", method_send_mouse_click, METH_VARARGS, "Send a left mouse button click."},
     {"send_mouse_right_click", method_send_mouse_right_click, METH_VARARGS, "Send a right mouse button click."},
+    {"send_batch", method_send_batch, METH_VARARGS, "Send a list of (type, a, b) events in one SendInput call."},
+    {"post_key", method_post_key, METH_VARARGS, "Queue a key tap (vk, hold_ms=10, hwnd=0); returns immediately."},
+    {"post_mouse_click", method_post_mouse_click, METH_VARARGS, "Queue a left click (hold_ms=10)."},
+    {"post_mouse_right_click", method_post_mouse_right_click, METH_VARARGS, "Queue a right click (hold_ms=10)."},
+    {"post_jitter_move", method_post_jitter_move, METH_VARARGS, "Queue a humanized relative mouse move (dx, dy, duration_ms=150, seed=0)."},
+    {"post_batch", method_post_batch, METH_VARARGS, "Queue (type, a, b) events to send together, then wait delay_ms."},
+    {"key_down", method_key_down, METH_VARARGS, "Queue a key press (VK code); stays down until key_up."},
+    {"key_up", method_key_up, METH_VARARGS, "Queue a key release (VK code)."},
+    {"hold_key", method_hold_key, METH_VARARGS, "Press a key now; the worker releases it after hold_ms."},
+    {"hold_keys", method_hold_keys, METH_VARARGS, "Press several keys together; released after hold_ms."},
+    {"release_all", method_release_all, METH_VARARGS, "Release every held key and button."},
+    {"flush", method_flush, METH_VARARGS, "Block until all queued input has been sent."},
+    {"wait", method_wait, METH_VARARGS, "Wait up to timeout_ms for queued input; True if drained."},
+    {"pending", method_pending, METH_VARARGS, "Number of queued events not yet sent."},
+    {"dropped_holds", method_dropped_holds, METH_VARARGS, "Holds dropped because the held-input table was full."},
+    {"window_input_mode", method_window_input_mode, METH_VARARGS, "Probe hwnd's input route: 'window' (messages) or 'sendinput' (fallback)."},
+    {"window_input_fallback", method_window_input_fallback, METH_VARARGS, "Force hwnd's queued input through SendInput (True) or messages (False)."},
+    {"window_input_cursor", method_window_input_cursor, METH_VARARGS, "hwnd's virtual mouse cursor (x, y) in client coordinates (screen=True: screen)."},
+    {"window_input_close", method_window_input_close, METH_VARARGS, "Drain and free hwnd's input worker."},
+    {"input_null_sink", method_input_null_sink, METH_VARARGS, "Swallow all injected input (True) while keeping its timing; process-wide."},
+    {"input_null_sink_events", method_input_null_sink_events, METH_VARARGS, "Input events swallowed by the null sink so far."},
+    {"cursor_pos", method_cursor_pos, METH_VARARGS, "Cursor position (screen), predicted from injected moves between resyncs."},
+    {"set_cursor_resync", method_set_cursor_resync, METH_VARARGS, "How long (ms) a predicted cursor position is trusted; 0 = always GetCursorPos."},
+    {"cursor_resyncs", method_cursor_resyncs, METH_VARARGS, "GetCursorPos calls made by the cursor cache so far."},
+    {"set_precise_timing", method_set_precise_timing, METH_VARARGS, "Enable high-resolution timer + QPC spin for input delays (enabled, spin_us=500)."},
+    {"precise_timing", method_precise_timing, METH_VARARGS, "True if precise timing is enabled."},
+    {"precise_sleep", method_precise_sleep, METH_VARARGS, "Sleep for us microseconds; returns the measured delay in us."},
+    {"timer_stats", method_timer_stats, METH_VARARGS, "Requested vs. measured delay statistics (dict, microseconds)."},
+    {"reset_timer_stats", method_reset_timer_stats, METH_VARARGS, "Clear the delay statistics."},
+    {"qpc_us", method_qpc_us, METH_VARARGS, "Current QPC time in microseconds (capture ring clock)."},
+    {"capture_open", method_capture_open, METH_VARARGS, "Start DXGI capture of the monitor containing (x, y); returns its rect."},
+    {"capture_grab", method_capture_grab, METH_VARARGS, "Copy a BGRA region into a preallocated buffer; True if the frame is new."},
+    {"capture_close", method_capture_close, METH_VARARGS, "Stop DXGI capture."},
+    {"capture_ring_start", method_capture_ring_start, METH_VARARGS, "Start background capture of a region into a ring of slots (left, top, w, h, slots=4)."},
+    {"capture_ring_stop", method_capture_ring_stop, METH_VARARGS, "Stop background capture."},
+    {"capture_ring_latest", method_capture_ring_latest, METH_VARARGS, "Copy the newest ring frame into out; (present_us, seq) or None."},
+    {"capture_ring_at_or_after", method_capture_ring_at_or_after, METH_VARARGS, "Copy the first frame on screen at or after t_us; (present_us, seq) or None."},
+    {"replay_open", method_replay_open, METH_VARARGS, "Map a recorded replay file (pages it in); returns its handle."},
+    {"replay_info", method_replay_info, METH_VARARGS, "(width, height, frame_count, frame_interval_us) of a replay."},
+    {"replay_start", method_replay_start, METH_VARARGS, "Restart a replay's playback clock at start_us (default now)."},
+    {"replay_seq_at", method_replay_seq_at, METH_VARARGS, "Sequence number of the replay frame on screen at t_us."},
+    {"replay_read", method_replay_read, METH_VARARGS, "Copy part of replay frame seq at (x, y) into an (H, W, 4) buffer; (present_us, seq)."},
+    {"replay_close", method_replay_close, METH_VARARGS, "Unmap a replay file."},
+    {"recorder_open", method_recorder_open, METH_VARARGS, "Create a trajectory file (path, channels=3, height=224, width=224, chunk_records=64, buffers=4, codec=0); returns its handle."},
+    {"recorder_add", method_recorder_add, METH_VARARGS, "Append a step (obs CHW, action, reward, timestamp_us, features, env_id, flags, step); False if dropped."},
+    {"recorder_stats", method_recorder_stats, METH_VARARGS, "{records, dropped, chunks, bytes, write_error} of a recorder."},
+    {"recorder_close", method_recorder_close, METH_VARARGS, "Write the last chunk and the index, close the file; returns the final stats."},
+    {"preprocess_frame", method_preprocess_frame, METH_VARARGS, "Resize BGR(A) HWC to RGB CHW into a preallocated (3, out_h, out_w) buffer."},
+    {"preprocess_simd_level", method_preprocess_simd_level, METH_VARARGS, "SIMD level used by preprocess_frame: avx2, sse2 or scalar."},
+    {"delta_encode", method_delta_encode, METH_VARARGS, "Delta-encode a frame against the previous one (None: keyframe); returns the packet."},
+    {"delta_decode", method_delta_decode, METH_VARARGS, "Apply a delta packet in place to a buffer holding the previous frame."},
+    {"delta_simd_level", method_delta_simd_level, METH_VARARGS, "SIMD level used by the delta codec: avx2, sse2 or scalar."},
+    {"reward_open", method_reward_open, METH_VARARGS, "Create a reward feature extractor; returns its handle."},
+    {"reward_features", method_reward_features, METH_VARARGS, "One-pass (notif_diff, motion_diff, energy_green, cursor_diff) for a frame."},
+    {"reward_reset", method_reward_reset, METH_VARARGS, "Forget an extractor's previous frame (new episode)."},
+    {"reward_close", method_reward_close, METH_VARARGS, "Free a reward feature extractor."},
+    {"observe_batch", method_observe_batch, METH_VARARGS, "Observations + reward features for N instance rects of one frame, in parallel."},
+    {"pipeline_open", method_pipeline_open, METH_VARARGS, "Create a step pipeline (background capture + observe_batch); returns its handle."},
+    {"pipeline_submit", method_pipeline_submit, METH_VARARGS, "Queue 'capture at deadline_us, then observe_batch'; returns a job id."},
+    {"pipeline_captured", method_pipeline_captured, METH_VARARGS, "Wait until a job's frame is captured: (present_us, seq) or None."},
+    {"pipeline_result", method_pipeline_result, METH_VARARGS, "Wait until a job is done: (stamp or None, [features, ...])."},
+    {"pipeline_close", method_pipeline_close, METH_VARARGS, "Finish pending jobs and free a step pipeline."},
+    {"matcher_open", method_matcher_open, METH_VARARGS, "Create a coarse-to-fine template matcher; returns its handle."},
+    {"matcher_add", method_matcher_add, METH_VARARGS, "Add a 2-D uint8 gray template; returns its id."},
+    {"matcher_find_all", method_matcher_find_all, METH_VARARGS, "Match every template in a BGR(A) frame (threads=0: per core), near hints first: [(score, x, y), ...]."},
+    {"matcher_close", method_matcher_close, METH_VARARGS, "Free a template matcher."},
+    {"capture_frame_seq", method_capture_frame_seq, METH_VARARGS, "Number of the newest DXGI frame (0 = none yet)."},
+    {"capture_changed_since", method_capture_changed_since, METH_VARARGS, "True if a desktop rect may have changed after frame since_seq (dirty rects)."},
+    {"tile_hashes", method_tile_hashes, METH_VARARGS, "64-bit hash per tile of a BGR(A) frame into a uint64 array (tile=32)."},
+    {"profiler_enable", method_profiler_enable, METH_VARARGS, "Turn span recording on/off (trace=True also keeps spans for a trace file)."},
+    {"profiler_enabled", method_profiler_enabled, METH_VARARGS, "True if spans are being recorded."},
+    {"profiler_record", method_profiler_record, METH_VARARGS, "Record one span of a PROFILE_* stage from qpc_us() start/end times."},
+    {"profiler_stats", method_profiler_stats, METH_VARARGS, "Per-stage latency: {name: {count, mean_us, p50_us, p90_us, p99_us, max_us}}."},
+    {"profiler_dropped", method_profiler_dropped, METH_VARARGS, "Spans dropped because a thread's ring was full."},
+    {"profiler_write_trace", method_profiler_write_trace, METH_VARARGS, "Write the spans since the last write as Chrome trace JSON; returns the count."},
+    {"profiler_reset", method_profiler_reset, METH_VARARGS, "Clear histograms, trace and the dropped count."},
+    {"bus_publish", method_bus_publish, METH_VARARGS, "Publish an event (type, source=0, i0=0, i1=0, f0..f3=0.0); no-op with no subscribers."},
+    {"bus_active", method_bus_active, METH_VARARGS, "True if anyone is subscribed to the event bus."},
+    {"bus_published", method_bus_published, METH_VARARGS, "Events published so far."},
+    {"bus_subscribe", method_bus_subscribe, METH_VARARGS, "New event bus subscriber (starts at the next event); returns a handle."},
+    {"bus_unsubscribe", method_bus_unsubscribe, METH_VARARGS, "Drop an event bus subscriber."},
+    {"bus_poll", method_bus_poll, METH_VARARGS, "Copy unread events into a writable buffer of 64-byte records; returns (count, dropped)."},
+    {"window_find", method_window_find, METH_VARARGS, "Largest visible window whose title contains title (any case): (title, min_area=1) -> hwnd or 0."},
+    {"window_find_all", method_window_find_all, METH_VARARGS, "Visible windows matching title, left to right: (title, min_area=800*600) -> [hwnd]."},
+    {"window_track", method_window_track, METH_VARARGS, "Follow a window's rect/minimized/foreground state via WinEvent hooks; returns its version (0: not a window)."},
+    {"window_untrack", method_window_untrack, METH_VARARGS, "Stop following a window."},
+    {"window_version", method_window_version, METH_VARARGS, "Change counter of a tracked window (0: not tracked)."},
+    {"window_state", method_window_state, METH_VARARGS, "(version, left, top, width, height, flags) of a tracked window, or None."},
+    {"window_foreground", method_window_foreground, METH_VARARGS, "The foreground window as seen by the tracker's hook."},
+    {"thread_policy", method_thread_policy, METH_VARARGS, "Set a native thread role's affinity mask, priority (-2..2) and MMCSS task."},
+    {"thread_get_policy", method_thread_get_policy, METH_VARARGS, "A thread role's policy: (affinity, priority, mmcss)."},
+    {"core_masks", method_core_masks, METH_VARARGS, "Logical processors as (performance mask, efficiency mask, count)."},
+    {"thread_stats", method_thread_stats, METH_VARARGS, "Running native threads with their role, CPU time and affinity (list of dicts)."},
     {NULL, NULL, 0, NULL} // Sentinel
 };
 
@@ -183,6 +2210,62 @@ static PyModuleDef ClibModule = {
 // Module initialization function
 extern "C" {
     PyMODINIT_FUNC PyInit_clib(void) {
-        return PyModule_Create(&ClibModule);
+        PyObject* m = PyModule_Create(&ClibModule);
+        if (!m) return NULL;
+
+        // Event type constants for send_batch
+        PyModule_AddIntConstant(m, "EVENT_KEY_DOWN", EVENT_KEY_DOWN);
+        PyModule_AddIntConstant(m, "EVENT_KEY_UP", EVENT_KEY_UP);
+        PyModule_AddIntConstant(m, "EVENT_MOUSE_MOVE", EVENT_MOUSE_MOVE);
+        PyModule_AddIntConstant(m, "EVENT_MOUSE_WHEEL", EVENT_MOUSE_WHEEL);
+        PyModule_AddIntConstant(m, "EVENT_LEFT_DOWN", EVENT_LEFT_DOWN);
+        PyModule_AddIntConstant(m, "EVENT_LEFT_UP", EVENT_LEFT_UP);
+        PyModule_AddIntConstant(m, "EVENT_RIGHT_DOWN", EVENT_RIGHT_DOWN);
+        PyModule_AddIntConstant(m, "EVENT_RIGHT_UP", EVENT_RIGHT_UP);
+        PyModule_AddIntConstant(m, "MAX_BATCH_EVENTS", MAX_BATCH_EVENTS);
+        PyModule_AddIntConstant(m, "CAPTURE_TILE", CAPTURE_TILE);
+
+        // Step recorder flags
+        PyModule_AddIntConstant(m, "STEP_EPISODE_START", STEP_EPISODE_START);
+        PyModule_AddIntConstant(m, "STEP_TERMINATED", STEP_TERMINATED);
+        PyModule_AddIntConstant(m, "STEP_TRUNCATED", STEP_TRUNCATED);
+        PyModule_AddIntConstant(m, "RECORD_CODEC_RAW", RECORD_CODEC_RAW);
+        PyModule_AddIntConstant(m, "RECORD_CODEC_DELTA", RECORD_CODEC_DELTA);
+
+        // Profiler stages (the ones Python records itself, and the rest)
+        PyModule_AddIntConstant(m, "PROFILE_CAPTURE", PROFILE_CAPTURE);
+        PyModule_AddIntConstant(m, "PROFILE_FRAME_WAIT", PROFILE_FRAME_WAIT);
+        PyModule_AddIntConstant(m, "PROFILE_INPUT_DISPATCH", PROFILE_INPUT_DISPATCH);
+        PyModule_AddIntConstant(m, "PROFILE_SLEEP", PROFILE_SLEEP);
+        PyModule_AddIntConstant(m, "PROFILE_REWARD", PROFILE_REWARD);
+        PyModule_AddIntConstant(m, "PROFILE_PREPROCESS", PROFILE_PREPROCESS);
+        PyModule_AddIntConstant(m, "PROFILE_OBSERVE_BATCH", PROFILE_OBSERVE_BATCH);
+        PyModule_AddIntConstant(m, "PROFILE_INFERENCE", PROFILE_INFERENCE);
+        PyModule_AddIntConstant(m, "PROFILE_ENV_STEP", PROFILE_ENV_STEP);
+        PyModule_AddIntConstant(m, "PROFILE_UI_SCAN", PROFILE_UI_SCAN);
+
+        // Event bus
+        PyModule_AddIntConstant(m, "EVENT_STEP", EVENT_STEP);
+        PyModule_AddIntConstant(m, "EVENT_EPISODE", EVENT_EPISODE);
+        PyModule_AddIntConstant(m, "EVENT_FRAME", EVENT_FRAME);
+        PyModule_AddIntConstant(m, "EVENT_INPUT", EVENT_INPUT);
+        PyModule_AddIntConstant(m, "EVENT_WINDOW", EVENT_WINDOW);
+        PyModule_AddIntConstant(m, "EVENT_USER", EVENT_USER);
+        PyModule_AddIntConstant(m, "EVENT_BUS_CAPACITY", EVENT_BUS_CAPACITY);
+
+        // Window tracker flags
+        PyModule_AddIntConstant(m, "WINDOW_ALIVE", WINDOW_ALIVE);
+        PyModule_AddIntConstant(m, "WINDOW_MINIMIZED", WINDOW_MINIMIZED);
+        PyModule_AddIntConstant(m, "WINDOW_FOREGROUND", WINDOW_FOREGROUND);
+
+        // Native thread roles (scheduling)
+        PyModule_AddIntConstant(m, "THREAD_INPUT", THREAD_INPUT);
+        PyModule_AddIntConstant(m, "THREAD_CAPTURE", THREAD_CAPTURE);
+        PyModule_AddIntConstant(m, "THREAD_PIPELINE", THREAD_PIPELINE);
+        PyModule_AddIntConstant(m, "THREAD_RECORDER", THREAD_RECORDER);
+        PyModule_AddIntConstant(m, "THREAD_WINDOW", THREAD_WINDOW);
+
+        Py_AtExit(StopNativeThreads);
+        return m;
     }
 }
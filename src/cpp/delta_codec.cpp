@@ -0,0 +1,216 @@
+#include "delta_codec.h"
+
+#include <cstring>
+#include <vector>
+
+#include "simd.h"
+
+// ============================================================================
+// DELTA FRAME CODEC IMPLEMENTATION
+// ============================================================================
+
+namespace {
+    constexpr uint32_t MAX_RUN = 0xFFFF;   // a token count is a uint16
+
+    alignas(64) const uint8_t ZERO_BLOCK[DELTA_BLOCK] = {};
+
+#if !GT_X86
+    // out = cur ^ prev for one block; true if any byte differs.
+    bool XorBlockScalar(const uint8_t* cur, const uint8_t* prev, uint8_t* out) {
+        uint64_t any = 0;
+        for (int i = 0; i < DELTA_BLOCK; i += 8) {
+            uint64_t a, b;
+            std::memcpy(&a, cur + i, 8);
+            std::memcpy(&b, prev + i, 8);
+            a ^= b;
+            std::memcpy(out + i, &a, 8);
+            any |= a;
+        }
+        return any != 0;
+    }
+
+    // dst ^= lit for one block.
+    void XorIntoScalar(uint8_t* dst, const uint8_t* lit) {
+        for (int i = 0; i < DELTA_BLOCK; i += 8) {
+            uint64_t a, b;
+            std::memcpy(&a, dst + i, 8);
+            std::memcpy(&b, lit + i, 8);
+            a ^= b;
+            std::memcpy(dst + i, &a, 8);
+        }
+    }
+#else
+    bool XorBlockSse2(const uint8_t* cur, const uint8_t* prev, uint8_t* out) {
+        __m128i any = _mm_setzero_si128();
+        for (int i = 0; i < DELTA_BLOCK; i += 16) {
+            __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(cur + i)),
+                                      _mm_loadu_si128((const __m128i*)(prev + i)));
+            _mm_storeu_si128((__m128i*)(out + i), x);
+            any = _mm_or_si128(any, x);
+        }
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(any, _mm_setzero_si128())) != 0xFFFF;
+    }
+
+    void XorIntoSse2(uint8_t* dst, const uint8_t* lit) {
+        for (int i = 0; i < DELTA_BLOCK; i += 16) {
+            __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(dst + i)),
+                                      _mm_loadu_si128((const __m128i*)(lit + i)));
+            _mm_storeu_si128((__m128i*)(dst + i), x);
+        }
+    }
+
+    GT_TARGET_AVX2
+    bool XorBlockAvx2(const uint8_t* cur, const uint8_t* prev, uint8_t* out) {
+        __m256i x0 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)cur),
+                                      _mm256_loadu_si256((const __m256i*)prev));
+        __m256i x1 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(cur + 32)),
+                                      _mm256_loadu_si256((const __m256i*)(prev + 32)));
+        _mm256_storeu_si256((__m256i*)out, x0);
+        _mm256_storeu_si256((__m256i*)(out + 32), x1);
+        __m256i any = _mm256_or_si256(x0, x1);
+        return !_mm256_testz_si256(any, any);
+    }
+
+    GT_TARGET_AVX2
+    void XorIntoAvx2(uint8_t* dst, const uint8_t* lit) {
+        for (int i = 0; i < DELTA_BLOCK; i += 32) {
+            __m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(dst + i)),
+                                         _mm256_loadu_si256((const __m256i*)(lit + i)));
+            _mm256_storeu_si256((__m256i*)(dst + i), x);
+        }
+    }
+#endif
+
+    using XorBlockFn = bool (*)(const uint8_t*, const uint8_t*, uint8_t*);
+    using XorIntoFn = void (*)(uint8_t*, const uint8_t*);
+
+    XorBlockFn PickXorBlock() {
+#if GT_X86
+        if (CpuHasAvx2()) return XorBlockAvx2;
+        return XorBlockSse2;
+#else
+        return XorBlockScalar;
+#endif
+    }
+
+    XorIntoFn PickXorInto() {
+#if GT_X86
+        if (CpuHasAvx2()) return XorIntoAvx2;
+        return XorIntoSse2;
+#else
+        return XorIntoScalar;
+#endif
+    }
+
+    const XorBlockFn g_xor_block = PickXorBlock();
+    const XorIntoFn g_xor_into = PickXorInto();
+
+    std::vector<uint16_t>& GetTokenScratch() {
+        static thread_local std::vector<uint16_t> tokens;
+        return tokens;
+    }
+}
+
+size_t DeltaMaxEncodedSize(size_t raw_bytes) {
+    const size_t blocks = raw_bytes / DELTA_BLOCK;
+    // Worst case: every block literal (plus one block of slack, the kernel
+    // always stores a whole block), and alternating runs for tokens.
+    return sizeof(DeltaHeader) + raw_bytes + DELTA_BLOCK + (blocks / 2 + 2) * 2 * sizeof(uint16_t);
+}
+
+size_t DeltaEncode(const uint8_t* cur, const uint8_t* prev, size_t bytes, uint8_t* out) {
+    const size_t blocks = bytes / DELTA_BLOCK;
+    const size_t tail = bytes % DELTA_BLOCK;
+    const uint8_t* ref = prev ? prev : ZERO_BLOCK;
+    const size_t ref_step = prev ? DELTA_BLOCK : 0;
+
+    std::vector<uint16_t>& tokens = GetTokenScratch();
+    tokens.clear();
+    uint8_t* lit = out + sizeof(DeltaHeader);
+    uint32_t literal_blocks = 0;
+    uint32_t same = 0;
+    uint32_t literal = 0;
+    auto emit = [&] {
+        tokens.push_back((uint16_t)same);
+        tokens.push_back((uint16_t)literal);
+        same = 0;
+        literal = 0;
+    };
+
+    for (size_t b = 0; b < blocks; ++b, cur += DELTA_BLOCK, ref += ref_step) {
+        if (g_xor_block(cur, ref, lit)) {
+            // Changed: keep it (the residual is already in place).
+            lit += DELTA_BLOCK;
+            ++literal_blocks;
+            if (++literal == MAX_RUN) emit();
+        } else {
+            if (literal > 0) emit();
+            if (++same == MAX_RUN) emit();
+        }
+    }
+    if (same > 0 || literal > 0) emit();
+
+    // The tail (< 1 block) is always stored.
+    for (size_t i = 0; i < tail; ++i) lit[i] = (uint8_t)(cur[i] ^ (prev ? ref[i] : 0));
+    lit += tail;
+
+    const size_t token_bytes = tokens.size() * sizeof(uint16_t);
+    std::memcpy(lit, tokens.data(), token_bytes);
+
+    DeltaHeader header;
+    header.raw_bytes = (uint32_t)bytes;
+    header.flags = prev ? 0u : (uint32_t)DELTA_KEY;
+    header.literal_blocks = literal_blocks;
+    header.token_count = (uint32_t)(tokens.size() / 2);
+    std::memcpy(out, &header, sizeof(header));
+    return (size_t)(lit - out) + token_bytes;
+}
+
+bool DeltaPeek(const uint8_t* packet, size_t size, DeltaHeader* header) {
+    if (size < sizeof(DeltaHeader)) return false;
+    std::memcpy(header, packet, sizeof(DeltaHeader));
+    const uint64_t expected = sizeof(DeltaHeader) + (uint64_t)header->literal_blocks * DELTA_BLOCK +
+                              header->raw_bytes % DELTA_BLOCK + (uint64_t)header->token_count * 4;
+    return expected == size && header->literal_blocks <= header->raw_bytes / DELTA_BLOCK;
+}
+
+bool DeltaDecode(const uint8_t* packet, size_t size, uint8_t* dst, size_t bytes) {
+    DeltaHeader header;
+    if (!DeltaPeek(packet, size, &header) || header.raw_bytes != bytes) return false;
+    const size_t blocks = bytes / DELTA_BLOCK;
+    const uint8_t* lit = packet + sizeof(DeltaHeader);
+    const uint8_t* tail = lit + (size_t)header.literal_blocks * DELTA_BLOCK;
+    const uint8_t* tokens = tail + bytes % DELTA_BLOCK;
+
+    // Check the tokens before touching dst, so a bad packet changes nothing.
+    uint64_t covered = 0;
+    uint64_t literals = 0;
+    for (uint32_t t = 0; t < header.token_count; ++t) {
+        uint16_t run[2];
+        std::memcpy(run, tokens + t * 4, 4);
+        covered += run[0] + run[1];
+        literals += run[1];
+    }
+    if (covered != blocks || literals != header.literal_blocks) return false;
+
+    if (header.flags & DELTA_KEY) std::memset(dst, 0, bytes);
+    uint8_t* out = dst;
+    for (uint32_t t = 0; t < header.token_count; ++t) {
+        uint16_t run[2];
+        std::memcpy(run, tokens + t * 4, 4);
+        out += (size_t)run[0] * DELTA_BLOCK;
+        for (uint16_t i = 0; i < run[1]; ++i, out += DELTA_BLOCK, lit += DELTA_BLOCK) {
+            g_xor_into(out, lit);
+        }
+    }
+    for (size_t i = 0; i < bytes % DELTA_BLOCK; ++i) out[i] ^= tail[i];
+    return true;
+}
+
+const char* DeltaSimdLevel() {
+#if GT_X86
+    return CpuHasAvx2() ? "avx2" : "sse2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// ============================================================================
+// DELTA FRAME CODEC (consecutive frames -> the blocks that changed)
+// ============================================================================
+//
+// Teacher Note: Two consecutive Stardew frames are mostly the same bytes:
+// the HUD, the map away from the player, the menus. So instead of storing
+// a frame we store it XORed with the previous one. Unchanged bytes XOR to
+// zero, and a zero block costs nothing:
+//
+//   - The frame is cut into 64-byte blocks (one cache line).
+//   - Each block is XORed with the same block of the previous frame
+//     (SIMD: AVX2, SSE2 fallback, scalar elsewhere) and tested for zero.
+//   - Non-zero blocks are kept as-is ("literals"); runs of zero blocks
+//     ("same") are just counted.
+//
+// A keyframe is the same thing against an all-zero previous frame, so it
+// decodes on its own - readers jump to the last keyframe and decode
+// forward, which is how random access works.
+//
+// Decoding is in place: dst already holds the previous frame, and only
+// the literal blocks are XORed in. Both directions run at memory speed
+// (well under 50 us for a 224x224x3 observation), so encoding keeps up
+// with capture on one core.
+//
+// Packet layout (little-endian):
+//
+//     DeltaHeader                      16 bytes
+//     literal blocks                   literal_blocks * 64 bytes (XOR residual)
+//     tail                             raw_bytes % 64 bytes (XOR residual)
+//     tokens                           token_count * (uint16 same, uint16 literal)
+//
+// Tokens cover the blocks in order: `same` unchanged blocks, then
+// `literal` blocks taken from the literal area.
+//
+// Stored as-is, no entropy coder on top: the repo builds without external
+// libraries, and for game frames the zero runs are most of the win.
+
+constexpr int DELTA_BLOCK = 64;
+
+enum DeltaFlags : uint32_t {
+    DELTA_KEY = 1,       // encoded against zeros: decodes without a previous frame
+};
+
+#pragma pack(push, 1)
+struct DeltaHeader {
+    uint32_t raw_bytes;
+    uint32_t flags;              // DeltaFlags
+    uint32_t literal_blocks;
+    uint32_t token_count;
+};
+#pragma pack(pop)
+static_assert(sizeof(DeltaHeader) == 16, "DeltaHeader is 16 bytes on disk");
+
+// Largest packet DeltaEncode can write for a raw_bytes frame.
+size_t DeltaMaxEncodedSize(size_t raw_bytes);
+
+// Encodes cur against prev (nullptr: a keyframe) into out, which must hold
+// DeltaMaxEncodedSize(bytes). Returns the packet size.
+// Safe to call from several threads: scratch buffers are thread_local.
+size_t DeltaEncode(const uint8_t* cur, const uint8_t* prev, size_t bytes, uint8_t* out);
+
+// Reads a packet's header; false if it isn't a valid packet of `size` bytes.
+bool DeltaPeek(const uint8_t* packet, size_t size, DeltaHeader* header);
+
+// Applies a packet to dst (bytes long), which must hold the previous frame
+// unless the packet is a keyframe. False (dst untouched) if the packet is
+// malformed or for a different frame size.
+bool DeltaDecode(const uint8_t* packet, size_t size, uint8_t* dst, size_t bytes);
+
+// Which block kernel this CPU uses: "avx2", "sse2" or "scalar".
+const char* DeltaSimdLevel();
@@ -0,0 +1,116 @@
+#include "event_bus.h"
+
+#include "handle_table.h"
+#include "timing.h"
+
+// ============================================================================
+// EVENT BUS IMPLEMENTATION
+// ============================================================================
+
+namespace event_bus_detail {
+    std::atomic<int> g_subscribers{0};
+}
+
+namespace {
+    static_assert((EVENT_BUS_CAPACITY & (EVENT_BUS_CAPACITY - 1)) == 0,
+                  "EVENT_BUS_CAPACITY must be a power of two");
+    constexpr uint64_t MASK = EVENT_BUS_CAPACITY - 1;
+
+    struct Slot {
+        std::atomic<uint64_t> stamp{0};   // 2n+1 writing event n, 2n+2 holds it
+        BusEvent event;
+    };
+
+    struct Ring {
+        alignas(64) std::atomic<uint64_t> head{0};   // next event number
+        alignas(64) Slot slots[EVENT_BUS_CAPACITY];
+    };
+
+    struct Subscriber {
+        uint64_t cursor = 0;    // next event number to read
+        uint64_t dropped = 0;
+    };
+
+    Ring& GetRing() {
+        static Ring ring;
+        return ring;
+    }
+
+    HandleTable<Subscriber>& GetSubscriberTable() {
+        static HandleTable<Subscriber> table;
+        return table;
+    }
+}
+
+void EventBusPublish(uint32_t type, uint32_t source, int64_t i0, int64_t i1,
+                     double f0, double f1, double f2, double f3) {
+    if (!EventBusActive()) return;
+    Ring& ring = GetRing();
+    const uint64_t n = ring.head.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = ring.slots[n & MASK];
+
+    // Odd stamp first, so a reader that sees any of the new bytes also
+    // sees that the slot is being rewritten.
+    slot.stamp.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.event = {QpcNowUs(), type, source, {i0, i1}, {f0, f1, f2, f3}};
+    slot.stamp.store(2 * n + 2, std::memory_order_release);
+}
+
+uint64_t EventBusPublished() {
+    return GetRing().head.load(std::memory_order_acquire);
+}
+
+int EventBusSubscribe() {
+    // Counted before the handle exists, so an Unsubscribe racing with us
+    // never takes the count below zero.
+    event_bus_detail::g_subscribers.fetch_add(1, std::memory_order_relaxed);
+    const int handle = GetSubscriberTable().Open();
+    if (auto sub = GetSubscriberTable().Get(handle)) sub->cursor = EventBusPublished();
+    return handle;
+}
+
+void EventBusUnsubscribe(int handle) {
+    // Only the Close that actually removed the subscriber counts it out.
+    if (GetSubscriberTable().Close(handle)) {
+        event_bus_detail::g_subscribers.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+int EventBusPoll(int handle, BusEvent* out, int max_events, uint64_t* dropped) {
+    auto sub = GetSubscriberTable().Get(handle);
+    if (!sub) return -1;
+    Ring& ring = GetRing();
+
+    int count = 0;
+    uint64_t cursor = sub->cursor;
+    while (count < max_events) {
+        const uint64_t head = ring.head.load(std::memory_order_acquire);
+        if (cursor >= head) break;
+        if (head - cursor > EVENT_BUS_CAPACITY) {
+            // Lapped: those events are gone.
+            sub->dropped += head - EVENT_BUS_CAPACITY - cursor;
+            cursor = head - EVENT_BUS_CAPACITY;
+        }
+
+        Slot& slot = ring.slots[cursor & MASK];
+        const uint64_t want = 2 * cursor + 2;
+        const uint64_t before = slot.stamp.load(std::memory_order_acquire);
+        if (before < want) break;             // claimed, not written yet
+        if (before == want) {
+            out[count] = slot.event;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.stamp.load(std::memory_order_relaxed) == want) {
+                ++count;
+                ++cursor;
+                continue;
+            }
+        }
+        // Overwritten before or while we read it.
+        ++sub->dropped;
+        ++cursor;
+    }
+    sub->cursor = cursor;
+    *dropped = sub->dropped;
+    return count;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// ============================================================================
+// EVENT BUS (fixed-size telemetry events, many publishers, many readers)
+// ============================================================================
+//
+// Teacher Note: The env step, the capture thread and the input worker all
+// have something to tell a dashboard (a step finished, a frame arrived, a
+// batch of input went out). A callback would make the publisher wait for
+// the slowest listener. Instead every event goes into ONE broadcast ring:
+//
+//   - Publishing claims the next slot with one atomic fetch_add and copies
+//     a 64-byte BusEvent into it. No lock, no allocation, never blocks.
+//   - Each subscriber has its own cursor and reads at its own pace. The
+//     ring doesn't wait for anyone: a subscriber that falls a whole ring
+//     (EVENT_BUS_CAPACITY events) behind skips ahead and counts the events
+//     it missed as dropped.
+//
+// Every slot carries a sequence stamp (seqlock style): odd while being
+// written, 2 * (n + 1) once event n is in it. A reader compares the stamp
+// before and after copying, so it never returns a half-written event or
+// one that was overwritten while it read.
+//
+// While nobody is subscribed publishing is a single relaxed atomic load,
+// like a disabled profiler span.
+//
+// Limitation: a publisher stalled in the middle of a write for a whole lap
+// of the ring can garble that one slot for the next lap.
+
+enum BusEventType : uint32_t {
+    EVENT_STEP = 1,        // env step: i0 step, i1 action, f0 reward, f1 episode reward
+    EVENT_EPISODE = 2,     // episode end: i0 steps, f0 total reward
+    EVENT_FRAME = 3,       // capture ring frame: i0 frame seq, i1 present_us, f0 latency us
+    EVENT_INPUT = 4,       // input batch sent: i0 events, i1 target HWND (0: SendInput), f0 dispatch us
+    EVENT_WINDOW = 5,      // tracked window changed: i0 HWND, i1 WindowFlags, f0..f3 left, top, width, height
+    EVENT_USER = 256,      // first id free for scripts
+};
+
+constexpr uint32_t EVENT_BUS_CAPACITY = 4096;   // events (power of two)
+
+#pragma pack(push, 1)
+struct BusEvent {
+    int64_t time_us;       // QpcNowUs() when published
+    uint32_t type;         // BusEventType or >= EVENT_USER
+    uint32_t source;       // publisher id (an env: its window handle; 0: process-wide threads)
+    int64_t i[2];
+    double f[4];
+};
+#pragma pack(pop)
+static_assert(sizeof(BusEvent) == 64, "BusEvent is one cache line");
+
+namespace event_bus_detail {
+    extern std::atomic<int> g_subscribers;
+}
+
+inline bool EventBusActive() {
+    return event_bus_detail::g_subscribers.load(std::memory_order_relaxed) > 0;
+}
+
+// Publishes one event (time_us is filled in). Any thread; no-op while
+// nobody is subscribed.
+void EventBusPublish(uint32_t type, uint32_t source, int64_t i0, int64_t i1,
+                     double f0 = 0.0, double f1 = 0.0, double f2 = 0.0, double f3 = 0.0);
+
+// Events published so far (the next event's number).
+uint64_t EventBusPublished();
+
+// A subscriber starts at the next event. Handles are small positive ints.
+int EventBusSubscribe();
+void EventBusUnsubscribe(int handle);
+
+// Copies up to max_events of the subscriber's unread events into out and
+// returns how many (0 if none; -1 for an unknown handle). *dropped gets the
+// subscriber's total missed-event count. One thread per subscriber.
+int EventBusPoll(int handle, BusEvent* out, int max_events, uint64_t* dropped);
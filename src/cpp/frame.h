@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// ============================================================================
+// FRAME VIEW
+// ============================================================================
+//
+// Teacher Note: A non-owning look at a captured frame, shared by the native
+// vision kernels. Pixels are interleaved BGR (3 bytes) or BGRA (4 bytes);
+// both the numpy arrays from mss and the DXGI BGRA buffers (or their
+// [:, :, :3] views) can be described without copying.
+
+struct FrameView {
+    const uint8_t* data;   // first pixel (B of BGR/BGRA)
+    int width;
+    int height;
+    int row_stride;        // bytes between rows
+    int pixel_stride;      // bytes between pixels: 3 (BGR) or 4 (BGRA)
+
+    const uint8_t* Row(int y) const { return data + (size_t)y * row_stride; }
+};
+
+// Axis-aligned rectangle in frame pixels.
+struct FrameRect {
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+// Clips r to a width x height frame; the result may be empty (width/height 0).
+inline FrameRect ClipRect(FrameRect r, int width, int height) {
+    int x0 = r.x < 0 ? 0 : r.x;
+    int y0 = r.y < 0 ? 0 : r.y;
+    int x1 = r.x + r.width > width ? width : r.x + r.width;
+    int y1 = r.y + r.height > height ? height : r.y + r.height;
+    FrameRect out = {x0, y0, x1 > x0 ? x1 - x0 : 0, y1 > y0 ? y1 - y0 : 0};
+    return out;
+}
+
+// OpenCV's BGR->gray weights (0.114, 0.587, 0.299) in 14-bit fixed point.
+inline uint8_t GrayFromBgr(const uint8_t* p) {
+    return (uint8_t)((p[0] * 1868u + p[1] * 9617u + p[2] * 4899u + 8192u) >> 14);
+}
+
+// The part of frame inside r (clipped), sharing its pixels. An empty result
+// has width/height 0.
+inline FrameView SubView(const FrameView& frame, FrameRect r) {
+    r = ClipRect(r, frame.width, frame.height);
+    FrameView out = {frame.data + (size_t)r.y * frame.row_stride + (size_t)r.x * frame.pixel_stride,
+                     r.width, r.height, frame.row_stride, frame.pixel_stride};
+    return out;
+}
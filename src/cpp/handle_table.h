@@ -0,0 +1,64 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// ============================================================================
+// HANDLE TABLE
+// ============================================================================
+//
+// Teacher Note: Python code refers to native objects (one reward extractor
+// per environment, one template matcher per InterfaceManager...) by small
+// positive ints. Get() hands out a shared_ptr, so a binding can release
+// the GIL and keep using the object even if another thread closes the
+// handle meanwhile.
+
+template <typename T>
+class HandleTable {
+public:
+    int Open() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto item = std::make_shared<T>();
+        for (size_t i = 0; i < items_.size(); ++i) {
+            if (!items_[i]) {
+                items_[i] = item;
+                return (int)i + 1;
+            }
+        }
+        items_.push_back(item);
+        return (int)items_.size();
+    }
+
+    // Null if the handle was never opened or has been closed.
+    std::shared_ptr<T> Get(int handle) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (handle < 1 || handle > (int)items_.size()) return nullptr;
+        return items_[handle - 1];
+    }
+
+    // False if the handle wasn't open: of two threads closing the same
+    // handle, exactly one gets true.
+    bool Close(int handle) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (handle < 1 || handle > (int)items_.size() || !items_[handle - 1]) return false;
+        items_[handle - 1].reset();
+        return true;
+    }
+
+    // Closes every handle and hands back the objects, so the caller can
+    // shut them down without holding the table lock.
+    std::vector<std::shared_ptr<T>> CloseAll() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<std::shared_ptr<T>> items;
+        for (std::shared_ptr<T>& item : items_) {
+            if (item) items.push_back(std::move(item));
+        }
+        items_.clear();
+        return items;
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<T>> items_;   // index = handle - 1
+};
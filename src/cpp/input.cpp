@@ -0,0 +1,609 @@
+#include "input.h"
+#include "event_bus.h"
+#include "profiler.h"
+#include "scheduling.h"
+#include "timing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+
+// ============================================================================
+// NATIVE INPUT IMPLEMENTATION
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Null sink
+// ----------------------------------------------------------------------------
+
+namespace {
+    std::atomic<bool> g_null_sink{false};
+    std::atomic<uint64_t> g_null_sink_events{0};
+}
+
+void SetInputNullSink(bool enabled) {
+    g_null_sink.store(enabled, std::memory_order_relaxed);
+}
+
+bool InputNullSink() {
+    return g_null_sink.load(std::memory_order_relaxed);
+}
+
+uint64_t NullSinkEvents() {
+    return g_null_sink_events.load(std::memory_order_relaxed);
+}
+
+namespace {
+    void NoteInjectedMoves(UINT count, const INPUT* inputs);
+}
+
+UINT InjectInput(UINT count, INPUT* inputs) {
+    if (InputNullSink()) {
+        g_null_sink_events.fetch_add(count, std::memory_order_relaxed);
+        return count;
+    }
+    const UINT sent = SendInput(count, inputs, sizeof(INPUT));
+    NoteInjectedMoves(sent, inputs);
+    return sent;
+}
+
+// ----------------------------------------------------------------------------
+// Cursor cache
+// ----------------------------------------------------------------------------
+
+namespace {
+    // x in the high half, y in the low half: one atomic for both, so a
+    // reader never sees x from one move and y from another.
+    std::atomic<uint64_t> g_cursor{0};
+    std::atomic<int64_t> g_cursor_synced_us{0};      // 0 = never synced
+    std::atomic<int64_t> g_cursor_resync_us{100000};
+    std::atomic<uint64_t> g_cursor_resyncs{0};
+
+    uint64_t PackCursor(LONG x, LONG y) {
+        return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+    }
+
+    POINT UnpackCursor(uint64_t packed) {
+        return {(LONG)(int32_t)(packed >> 32), (LONG)(int32_t)(uint32_t)packed};
+    }
+
+    // SendInput sends the first `count` events; add up their relative moves.
+    void NoteInjectedMoves(UINT count, const INPUT* inputs) {
+        if (g_cursor_synced_us.load(std::memory_order_relaxed) == 0) return;
+        LONG dx = 0, dy = 0;
+        for (UINT i = 0; i < count; ++i) {
+            if (inputs[i].type != INPUT_MOUSE) continue;
+            const DWORD flags = inputs[i].mi.dwFlags;
+            if ((flags & MOUSEEVENTF_MOVE) && !(flags & MOUSEEVENTF_ABSOLUTE)) {
+                dx += inputs[i].mi.dx;
+                dy += inputs[i].mi.dy;
+            }
+        }
+        if (dx == 0 && dy == 0) return;
+        uint64_t packed = g_cursor.load(std::memory_order_relaxed);
+        for (;;) {
+            const POINT p = UnpackCursor(packed);
+            if (g_cursor.compare_exchange_weak(packed, PackCursor(p.x + dx, p.y + dy),
+                                               std::memory_order_release, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+    }
+}
+
+void SetCursorResyncInterval(int interval_ms) {
+    g_cursor_resync_us.store((int64_t)std::max(interval_ms, 0) * 1000, std::memory_order_relaxed);
+}
+
+bool CursorPosition(POINT* out) {
+    const int64_t now = QpcNowUs();
+    const int64_t synced = g_cursor_synced_us.load(std::memory_order_acquire);
+    if (synced == 0 || now - synced >= g_cursor_resync_us.load(std::memory_order_relaxed)) {
+        POINT p;
+        if (GetCursorPos(&p)) {
+            g_cursor.store(PackCursor(p.x, p.y), std::memory_order_relaxed);
+            g_cursor_synced_us.store(now, std::memory_order_release);
+            g_cursor_resyncs.fetch_add(1, std::memory_order_relaxed);
+            *out = p;
+            return true;
+        }
+        // e.g. the secure desktop is up; keep predicting if we ever synced
+        if (synced == 0) return false;
+    }
+    *out = UnpackCursor(g_cursor.load(std::memory_order_acquire));
+    return true;
+}
+
+uint64_t CursorResyncs() {
+    return g_cursor_resyncs.load(std::memory_order_relaxed);
+}
+
+// ----------------------------------------------------------------------------
+// Blocking primitives
+// ----------------------------------------------------------------------------
+
+// Wraps a relative mouse move.
+void SendMouseMove(int dx, int dy) {
+    INPUT inp = {0};
+    inp.type = INPUT_MOUSE;
+    inp.mi.dx      = dx;
+    inp.mi.dy      = dy;
+    inp.mi.dwFlags = MOUSEEVENTF_MOVE;
+    InjectInput(1, &inp);
+}
+
+// Plays a humanized trajectory back right here, sleeping between steps.
+// Every step's INPUT is built up front in a fixed stack array.
+void JitteredMouseMove(const TrajectoryParams& params) {
+    Trajectory path;
+    BuildTrajectory(params, path);
+
+    INPUT inputs[MAX_TRAJECTORY_STEPS];
+    for (int i = 0; i < path.count; ++i) {
+        BuildInput({EVENT_MOUSE_MOVE, path.dx[i], path.dy[i]}, inputs[i]);
+    }
+    for (int i = 0; i < path.count; ++i) {
+        InjectInput(1, &inputs[i]);
+        if (i + 1 < path.count) PreciseSleepUs(TrajectoryDelayUs(path, i));
+    }
+}
+
+// Sends a left mouse button click (down + up).
+// Note: Added delay between down/up to help games register the click.
+void SendMouseClick() {
+    INPUT inputs[2] = {0};
+    // Left button down
+    inputs[0].type = INPUT_MOUSE;
+    inputs[0].mi.dwFlags = MOUSEEVENTF_LEFTDOWN;
+    inputs[0].mi.dwExtraInfo = 0;
+    // Left button up
+    inputs[1].type = INPUT_MOUSE;
+    inputs[1].mi.dwFlags = MOUSEEVENTF_LEFTUP;
+    inputs[1].mi.dwExtraInfo = 0;
+    
+    // Send down
+    InjectInput(1, &inputs[0]);
+    // Small delay
+    PreciseSleepUs(DEFAULT_HOLD_US);
+    // Send up
+    InjectInput(1, &inputs[1]);
+}
+
+// Sends a right mouse button click (down + up).
+// Note: Added delay between down/up to help games register the click.
+void SendMouseRightClick() {
+    INPUT inputs[2] = {0};
+    // Right button down
+    inputs[0].type = INPUT_MOUSE;
+    inputs[0].mi.dwFlags = MOUSEEVENTF_RIGHTDOWN;
+    inputs[0].mi.dwExtraInfo = 0;
+    // Right button up
+    inputs[1].type = INPUT_MOUSE;
+    inputs[1].mi.dwFlags = MOUSEEVENTF_RIGHTUP;
+    inputs[1].mi.dwExtraInfo = 0;
+    
+    // Send down
+    InjectInput(1, &inputs[0]);
+    // Small delay
+    PreciseSleepUs(DEFAULT_HOLD_US);
+    // Send up
+    InjectInput(1, &inputs[1]);
+}
+
+// Keys whose scan code is sent with the E0 prefix. As a bare scan code an
+// arrow key is the numpad arrow (4/8/6/2 with NumLock on), Insert is
+// numpad 0, right Ctrl is left Ctrl, and so on.
+static bool IsExtendedKey(UINT vk) {
+    switch (vk) {
+    case VK_LEFT: case VK_UP: case VK_RIGHT: case VK_DOWN:
+    case VK_PRIOR: case VK_NEXT: case VK_END: case VK_HOME:
+    case VK_INSERT: case VK_DELETE: case VK_SNAPSHOT:
+    case VK_RCONTROL: case VK_RMENU: case VK_LWIN: case VK_RWIN: case VK_APPS:
+    case VK_DIVIDE: case VK_NUMLOCK:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Simple key down + key up, holding the key for hold_ms in between.
+// Teacher Note: Games using DirectInput (like Stardew Valley / MonoGame) read
+// HARDWARE SCAN CODES, not virtual key codes. We use MapVirtualKey to find them.
+void SendKey(WORD vkCode, int hold_ms) {
+    INPUT inputs[2] = {0};
+
+    // Convert virtual key to hardware scan code
+    UINT scanCode = MapVirtualKey(vkCode, MAPVK_VK_TO_VSC);
+    const DWORD extended = IsExtendedKey(vkCode) ? KEYEVENTF_EXTENDEDKEY : 0;
+
+    // Key down - using SCAN CODE (critical for games!)
+    inputs[0].type        = INPUT_KEYBOARD;
+    inputs[0].ki.wVk      = 0;  // Must be 0 when using scan codes
+    inputs[0].ki.wScan    = scanCode;
+    inputs[0].ki.dwFlags  = KEYEVENTF_SCANCODE | extended;
+    inputs[0].ki.dwExtraInfo = 0;
+
+    // Key up - also using scan code
+    inputs[1].type        = INPUT_KEYBOARD;
+    inputs[1].ki.wVk      = 0;
+    inputs[1].ki.wScan    = scanCode;
+    inputs[1].ki.dwFlags  = KEYEVENTF_SCANCODE | KEYEVENTF_KEYUP | extended;
+    inputs[1].ki.dwExtraInfo = 0;
+
+    // Send key down
+    InjectInput(1, &inputs[0]);
+
+    // Small delay - some games need this to register the key press
+    PreciseSleepUs((uint32_t)hold_ms * 1000u);
+
+    // Send key up
+    InjectInput(1, &inputs[1]);
+}
+
+// ----------------------------------------------------------------------------
+// Batched input
+// Teacher Note: Every SendInput call is a trip into the kernel. Packing a whole
+// action (key down + key up, move + click, ...) into ONE INPUT array costs one
+// trip instead of several, and Windows guarantees the events are not
+// interleaved with any other input on the desk.
+// ----------------------------------------------------------------------------
+
+// Fills one INPUT from a batch event. Returns false for an unknown type.
+bool BuildInput(const BatchEvent& ev, INPUT& inp) {
+    inp = INPUT{};
+    switch (ev.type) {
+    case EVENT_KEY_DOWN:
+    case EVENT_KEY_UP:
+        // Scan codes, same as SendKey (DirectInput games ignore VK codes).
+        // SendInput ignores wVk next to KEYEVENTF_SCANCODE; we keep the
+        // original VK there for WindowTarget, which posts it as wParam.
+        inp.type       = INPUT_KEYBOARD;
+        inp.ki.wVk     = (WORD)ev.a;
+        inp.ki.wScan   = (WORD)MapVirtualKey((UINT)ev.a, MAPVK_VK_TO_VSC);
+        inp.ki.dwFlags = KEYEVENTF_SCANCODE;
+        if (IsExtendedKey((UINT)ev.a)) inp.ki.dwFlags |= KEYEVENTF_EXTENDEDKEY;
+        if (ev.type == EVENT_KEY_UP) inp.ki.dwFlags |= KEYEVENTF_KEYUP;
+        return true;
+    case EVENT_MOUSE_MOVE:
+        inp.type       = INPUT_MOUSE;
+        inp.mi.dx      = ev.a;
+        inp.mi.dy      = ev.b;
+        inp.mi.dwFlags = MOUSEEVENTF_MOVE;
+        return true;
+    case EVENT_MOUSE_WHEEL:
+        inp.type         = INPUT_MOUSE;
+        inp.mi.mouseData = (DWORD)ev.a;
+        inp.mi.dwFlags   = MOUSEEVENTF_WHEEL;
+        return true;
+    case EVENT_LEFT_DOWN:  inp.type = INPUT_MOUSE; inp.mi.dwFlags = MOUSEEVENTF_LEFTDOWN;  return true;
+    case EVENT_LEFT_UP:    inp.type = INPUT_MOUSE; inp.mi.dwFlags = MOUSEEVENTF_LEFTUP;    return true;
+    case EVENT_RIGHT_DOWN: inp.type = INPUT_MOUSE; inp.mi.dwFlags = MOUSEEVENTF_RIGHTDOWN; return true;
+    case EVENT_RIGHT_UP:   inp.type = INPUT_MOUSE; inp.mi.dwFlags = MOUSEEVENTF_RIGHTUP;   return true;
+    default:
+        return false;
+    }
+}
+
+// Sends up to MAX_BATCH_EVENTS events with a single SendInput call.
+// Returns the number of events Windows accepted (0 if any event was invalid).
+UINT SendBatch(const BatchEvent* events, int count) {
+    INPUT inputs[MAX_BATCH_EVENTS];
+    for (int i = 0; i < count; ++i) {
+        if (!BuildInput(events[i], inputs[i])) return 0;
+    }
+    ScopedSpan span(PROFILE_INPUT_DISPATCH);
+    return InjectInput((UINT)count, inputs);
+}
+
+
+
+// ----------------------------------------------------------------------------
+// Asynchronous input worker
+// ----------------------------------------------------------------------------
+
+int MakeKeyTap(int vkCode, uint32_t hold_us, TimedEvent out[2]) {
+    out[0] = {{EVENT_KEY_DOWN, vkCode, 0}, hold_us};
+    out[1] = {{EVENT_KEY_UP, vkCode, 0}, 0};
+    return 2;
+}
+
+int MakeMouseClick(bool right, uint32_t hold_us, TimedEvent out[2]) {
+    out[0] = {{right ? EVENT_RIGHT_DOWN : EVENT_LEFT_DOWN, 0, 0}, hold_us};
+    out[1] = {{right ? EVENT_RIGHT_UP : EVENT_LEFT_UP, 0, 0}, 0};
+    return 2;
+}
+
+// Same path and timing as JitteredMouseMove, but as queued events.
+int MakeTrajectoryMove(const Trajectory& path, TimedEvent out[MAX_TRAJECTORY_STEPS]) {
+    for (int i = 0; i < path.count; ++i) {
+        out[i] = {{EVENT_MOUSE_MOVE, path.dx[i], path.dy[i]}, TrajectoryDelayUs(path, i)};
+    }
+    return path.count;
+}
+
+int MakeKeyHold(int vkCode, uint32_t hold_us, TimedEvent* out) {
+    out[0] = {{EVENT_KEY_DOWN, vkCode, 0}, 0, hold_us};
+    return 1;
+}
+
+InputWorker::InputWorker(HWND target) : target_(std::make_unique<WindowTarget>(target)) {}
+
+InputWorker::~InputWorker() {
+    Stop();
+}
+
+void InputWorker::Start() {
+    if (running_.exchange(true)) return;
+    thread_ = std::thread(&InputWorker::Run, this);
+}
+
+void InputWorker::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_.exchange(false)) return;
+    }
+    wake_cv_.notify_one();
+    if (thread_.joinable()) thread_.join();
+}
+
+bool InputWorker::TryPost(const TimedEvent& e) {
+    // Count it before the worker can see it, so completed_ never runs
+    // ahead of posted_ (Pending() would wrap, Wait() could miss it).
+    posted_.fetch_add(1, std::memory_order_relaxed);
+    if (!queue_.TryPush(e)) {
+        posted_.fetch_sub(1, std::memory_order_relaxed);
+        // A Wait() may have counted it already; let it re-check.
+        { std::lock_guard<std::mutex> lock(mutex_); }
+        done_cv_.notify_all();
+        return false;
+    }
+    // Taking the lock (even empty) closes the gap between the worker
+    // checking "queue empty?" and going to sleep, so no wake-up is lost.
+    { std::lock_guard<std::mutex> lock(mutex_); }
+    wake_cv_.notify_one();
+    return true;
+}
+
+void InputWorker::Post(const TimedEvent* events, int count) {
+    std::lock_guard<std::mutex> lock(post_mutex_);
+    for (int i = 0; i < count; ++i) {
+        while (!TryPost(events[i])) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+bool InputWorker::Wait(int timeout_ms) {
+    const uint64_t target = posted_.load(std::memory_order_relaxed);
+    auto drained = [&] {
+        // min(): target may include a post that failed and was taken back
+        const uint64_t posted = std::min(target, posted_.load(std::memory_order_relaxed));
+        return completed_.load(std::memory_order_acquire) >= posted;
+    };
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (timeout_ms < 0) {
+        done_cv_.wait(lock, drained);
+        return true;
+    }
+    return done_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), drained);
+}
+
+uint64_t InputWorker::Pending() const {
+    // completed_ first: posted_ can only have grown since.
+    const uint64_t completed = completed_.load(std::memory_order_acquire);
+    const uint64_t posted = posted_.load(std::memory_order_relaxed);
+    return posted > completed ? posted - completed : 0;
+}
+
+// The "up" event that undoes a down event, or false if ev isn't a press.
+static bool ReleaseFor(const BatchEvent& ev, BatchEvent& up) {
+    switch (ev.type) {
+    case EVENT_KEY_DOWN:   up = {EVENT_KEY_UP, ev.a, 0};  return true;
+    case EVENT_LEFT_DOWN:  up = {EVENT_LEFT_UP, 0, 0};    return true;
+    case EVENT_RIGHT_DOWN: up = {EVENT_RIGHT_UP, 0, 0};   return true;
+    default:               return false;
+    }
+}
+
+int InputWorker::FindHeld(const BatchEvent& up) const {
+    for (int i = 0; i < held_count_; ++i) {
+        if (held_[i].up.type == up.type && held_[i].up.a == up.a) return i;
+    }
+    return -1;
+}
+
+void InputWorker::ForgetHeld(int index) {
+    held_[index] = held_[--held_count_];
+}
+
+// Turns one queued event into INPUTs appended to batch[n], updating the
+// table of held inputs. Returns the new n.
+int InputWorker::Dispatch(const TimedEvent& e, INPUT* batch, int n) {
+    if (e.ev.type == EVENT_RELEASE_ALL) {
+        for (int i = 0; i < held_count_; ++i) BuildInput(held_[i].up, batch[n++]);
+        held_count_ = 0;
+        return n;
+    }
+
+    BatchEvent up;
+    if (ReleaseFor(e.ev, up)) {
+        int held = FindHeld(up);
+        if (e.hold_us > 0) {
+            auto release_at = Clock::now() + std::chrono::microseconds(e.hold_us);
+            if (held >= 0) {
+                // Already down: just move the release, don't press again.
+                held_[held].release_at = release_at;
+                return n;
+            }
+            // Table full: drop the press rather than leave a key stuck down.
+            if (held_count_ == MAX_HELD_INPUTS) {
+                dropped_holds_.fetch_add(1, std::memory_order_relaxed);
+                return n;
+            }
+            held_[held_count_++] = {up, release_at};
+        } else if (held >= 0) {
+            // Plain press of a held key: it now stays down until key_up.
+            ForgetHeld(held);
+        }
+    } else {
+        // An explicit release cancels any scheduled one.
+        int held = FindHeld(e.ev);
+        if (held >= 0) ForgetHeld(held);
+    }
+
+    BuildInput(e.ev, batch[n++]);
+    return n;
+}
+
+// Sends a batch to our target: the window, or the global input stream.
+void InputWorker::Deliver(INPUT* batch, int n) {
+    ScopedSpan span(PROFILE_INPUT_DISPATCH);
+    const int64_t start_us = EventBusActive() ? QpcNowUs() : 0;
+    if (target_ && !InputNullSink()) target_->Deliver(batch, n);
+    else InjectInput((UINT)n, batch);
+    if (start_us != 0) {
+        const int64_t hwnd = target_ ? (int64_t)(intptr_t)target_->Handle() : 0;
+        EventBusPublish(EVENT_INPUT, 0, n, hwnd, (double)(QpcNowUs() - start_us));
+    }
+}
+
+// Sends the "up" for every hold whose time has come.
+void InputWorker::ReleaseDue() {
+    INPUT batch[MAX_HELD_INPUTS];
+    int n = 0;
+    auto now = Clock::now();
+    for (int i = 0; i < held_count_;) {
+        if (held_[i].release_at <= now) {
+            BuildInput(held_[i].up, batch[n++]);
+            ForgetHeld(i);
+        } else {
+            ++i;
+        }
+    }
+    if (n > 0) Deliver(batch, n);
+}
+
+InputWorker::Clock::time_point InputWorker::NextRelease() const {
+    auto next = Clock::time_point::max();
+    for (int i = 0; i < held_count_; ++i) {
+        if (held_[i].release_at < next) next = held_[i].release_at;
+    }
+    return next;
+}
+
+// How early the idle worker wakes before a scheduled release in precise mode.
+static constexpr std::chrono::milliseconds RELEASE_LEAD(2);
+
+// Sleeps until `until`, waking early to release holds that expire first.
+void InputWorker::SleepUntil(Clock::time_point until) {
+    while (true) {
+        auto wake = std::min(until, NextRelease());
+        PreciseSleepUntil(wake);
+        ReleaseDue();
+        if (wake >= until) return;
+    }
+}
+
+void InputWorker::Run() {
+    ScopedNativeThread scheduling(THREAD_INPUT);
+    // Room for a full batch plus a release-all of every held input.
+    INPUT batch[MAX_BATCH_EVENTS + MAX_HELD_INPUTS];
+
+    while (true) {
+        TimedEvent e;
+        if (!queue_.TryPop(e)) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                auto has_work = [&] { return !running_ || !queue_.Empty(); };
+                if (held_count_ == 0) {
+                    wake_cv_.wait(lock, has_work);
+                } else {
+                    // A condition-variable timeout is only tick-accurate, so in
+                    // precise mode wake up early and time the release ourselves.
+                    auto lead = PreciseTimingEnabled() ? RELEASE_LEAD : Clock::duration::zero();
+                    wake_cv_.wait_until(lock, NextRelease() - lead, has_work);
+                }
+            }
+            if (held_count_ > 0 && queue_.Empty()) {
+                auto next = NextRelease();
+                if (next - Clock::now() <= RELEASE_LEAD) PreciseSleepUntil(next);
+            }
+            ReleaseDue();
+            if (!running_ && queue_.Empty()) break;
+            continue;
+        }
+
+        // Coalesce back-to-back zero-delay events into one SendInput call.
+        // Event types were validated when posted, so BuildInput can't fail.
+        int n = Dispatch(e, batch, 0);
+        uint64_t popped = 1;
+        while (e.delay_us == 0 && n < MAX_BATCH_EVENTS && queue_.TryPop(e)) {
+            n = Dispatch(e, batch, n);
+            ++popped;
+        }
+        if (n > 0) Deliver(batch, n);
+
+        if (e.delay_us > 0) {
+            SleepUntil(Clock::now() + std::chrono::microseconds(e.delay_us));
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            completed_.fetch_add(popped, std::memory_order_release);
+        }
+        done_cv_.notify_all();
+    }
+
+    // Never leave a key stuck down when the process exits.
+    INPUT ups[MAX_HELD_INPUTS];
+    for (int i = 0; i < held_count_; ++i) BuildInput(held_[i].up, ups[i]);
+    if (held_count_ > 0) Deliver(ups, held_count_);
+    held_count_ = 0;
+}
+
+InputWorker& GetInputWorker() {
+    static InputWorker worker;
+    return worker;
+}
+
+namespace {
+    struct WindowWorkers {
+        std::mutex mutex;
+        std::map<HWND, std::shared_ptr<InputWorker>> workers;
+    };
+
+    WindowWorkers& GetWindowWorkers() {
+        static WindowWorkers table;
+        return table;
+    }
+}
+
+std::shared_ptr<InputWorker> GetWindowInputWorker(HWND hwnd) {
+    WindowWorkers& table = GetWindowWorkers();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    std::shared_ptr<InputWorker>& worker = table.workers[hwnd];
+    if (!worker) {
+        worker = std::make_shared<InputWorker>(hwnd);
+        worker->Start();
+    }
+    return worker;
+}
+
+void CloseWindowInputWorker(HWND hwnd) {
+    std::shared_ptr<InputWorker> worker;
+    {
+        WindowWorkers& table = GetWindowWorkers();
+        std::lock_guard<std::mutex> lock(table.mutex);
+        auto it = table.workers.find(hwnd);
+        if (it == table.workers.end()) return;
+        worker = std::move(it->second);
+        table.workers.erase(it);
+    }
+    worker->Stop();
+}
+
+void StopInputWorkers() {
+    GetInputWorker().Stop();
+    WindowWorkers& table = GetWindowWorkers();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    for (auto& entry : table.workers) entry.second->Stop();
+}
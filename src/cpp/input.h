@@ -0,0 +1,213 @@
+#pragma once
+
+#include <Windows.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "spsc_queue.h"
+#include "trajectory.h"
+#include "window_input.h"
+
+// ============================================================================
+// NATIVE INPUT ("the hands")
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Null sink (replay benchmarks)
+// ----------------------------------------------------------------------------
+
+// Teacher Note: Every SendInput in the input engine goes through
+// InjectInput. With the null sink on (process-wide), the events are only
+// counted - nothing reaches the desktop - but everything around them runs
+// unchanged: holds, trajectory steps, the worker's queue and release
+// schedule, precise sleeps. A benchmark against a replay (replay.h) then
+// pays exactly the input timing a real run would. Window-targeted workers
+// drop their PostMessages the same way.
+void SetInputNullSink(bool enabled);
+bool InputNullSink();
+uint64_t NullSinkEvents();     // events swallowed so far
+
+// SendInput, or the null sink. Returns the number of events "sent".
+UINT InjectInput(UINT count, INPUT* inputs);
+
+// ----------------------------------------------------------------------------
+// Cursor cache
+// ----------------------------------------------------------------------------
+
+// Teacher Note: The reward wants to know where the mouse is after every
+// click. Asking Windows from Python (win32gui.GetCursorInfo) costs an
+// import lookup and a pywin32 round trip per step - but every move the
+// agent makes goes through InjectInput anyway, so we already know how far
+// the cursor went. The cache keeps a predicted position: the last real one
+// (GetCursorPos) plus every relative move injected since.
+//
+// The prediction drifts when the user moves the mouse or when pointer
+// acceleration scales our deltas, so it is only trusted for
+// resync_interval_ms; the first query after that asks Windows again. Right
+// after a SendInput the prediction is actually *more* current than
+// GetCursorPos, which only moves once Windows has processed the event.
+void SetCursorResyncInterval(int interval_ms);   // 0 = always ask Windows
+bool CursorPosition(POINT* out);                 // false if Windows won't say
+uint64_t CursorResyncs();                        // GetCursorPos calls so far
+
+// ----------------------------------------------------------------------------
+// Blocking primitives - one call = one finished action
+// ----------------------------------------------------------------------------
+void SendMouseMove(int dx, int dy);
+void JitteredMouseMove(const TrajectoryParams& params);
+void SendMouseClick();
+void SendMouseRightClick();
+void SendKey(WORD vkCode, int hold_ms = 10);
+
+// ----------------------------------------------------------------------------
+// Batched input
+// ----------------------------------------------------------------------------
+
+// Event kinds understood by send_batch. Mirrored as module constants
+// (clib.EVENT_*) and in input.py - keep all three in sync.
+enum BatchEventType {
+    EVENT_KEY_DOWN = 0,   // a = VK code
+    EVENT_KEY_UP,         // a = VK code
+    EVENT_MOUSE_MOVE,     // a = dx, b = dy (relative)
+    EVENT_MOUSE_WHEEL,    // a = wheel delta (WHEEL_DELTA = one notch)
+    EVENT_LEFT_DOWN,
+    EVENT_LEFT_UP,
+    EVENT_RIGHT_DOWN,
+    EVENT_RIGHT_UP,
+    EVENT_TYPE_COUNT,
+
+    // Worker-only command (not accepted by send_batch): release every
+    // input the worker is currently holding.
+    EVENT_RELEASE_ALL = 100
+};
+
+struct BatchEvent {
+    int type;
+    int a;
+    int b;
+};
+
+// Largest batch accepted in one call. Keeps the INPUT array on the stack.
+constexpr int MAX_BATCH_EVENTS = 64;
+
+// Fills one INPUT from a batch event. Returns false for an unknown type.
+bool BuildInput(const BatchEvent& ev, INPUT& inp);
+
+// Sends up to MAX_BATCH_EVENTS events with a single SendInput call.
+// Returns the number of events Windows accepted (0 if any event was invalid).
+UINT SendBatch(const BatchEvent* events, int count);
+
+// ----------------------------------------------------------------------------
+// Asynchronous input worker
+// ----------------------------------------------------------------------------
+
+// One queued event plus how long to wait after sending it.
+// Consecutive events with delay_us == 0 go out in the same SendInput call.
+// hold_us > 0 on a press (key/left/right down) makes the worker send the
+// matching release that much later, without blocking the queue meanwhile.
+struct TimedEvent {
+    BatchEvent ev;
+    uint32_t delay_us;
+    uint32_t hold_us = 0;
+};
+
+// Default hold between down and up, same as the blocking primitives.
+constexpr uint32_t DEFAULT_HOLD_US = 10000;
+
+// Most presses the worker can hold (with a scheduled release) at once.
+constexpr int MAX_HELD_INPUTS = 16;
+
+// Command builders. Each fills `out` and returns how many events it wrote.
+int MakeKeyTap(int vkCode, uint32_t hold_us, TimedEvent out[2]);
+int MakeMouseClick(bool right, uint32_t hold_us, TimedEvent out[2]);
+int MakeTrajectoryMove(const Trajectory& path, TimedEvent out[MAX_TRAJECTORY_STEPS]);
+int MakeKeyHold(int vkCode, uint32_t hold_us, TimedEvent* out);
+
+// Teacher Note: The worker is a native thread that owns all input timing.
+// Python pushes TimedEvents into a lock-free queue and returns immediately;
+// the worker sends them and does the sleeping, so the sleeps never hold the
+// Python GIL. Wait() is the sync point: "block until everything I posted
+// so far has actually been sent".
+//
+// Holds: a press posted with hold_us goes into a small table of held inputs
+// and the worker releases it on time, even while it is busy with other
+// events. Several keys can be held at once (e.g. W + D for a diagonal), and
+// re-holding a held key just pushes its release later. Wait() does NOT wait
+// for held keys to be released. A hold that finds the table full is dropped
+// (never pressed) and counted in DroppedHolds().
+//
+// Threading: TryPost must only be called from one thread at a time. Post()
+// serializes its callers, so the events of one command always go out
+// together, never interleaved with another thread's.
+//
+// Target: the process-wide worker sends with SendInput. A worker built with
+// a window handle posts to that window instead (see window_input.h), so each
+// game instance gets its own queue, holds and timing.
+class InputWorker {
+public:
+    static constexpr size_t QUEUE_CAPACITY = 1024;
+
+    InputWorker() = default;
+    explicit InputWorker(HWND target);
+    ~InputWorker();
+
+    WindowTarget* Target() { return target_.get(); }   // null = SendInput
+
+    void Start();                      // idempotent
+    void Stop();                       // drains the queue, then joins
+
+    bool TryPost(const TimedEvent& e); // false if the queue is full
+    void Post(const TimedEvent* events, int count);  // blocks while full
+    bool Wait(int timeout_ms);         // true once drained; -1 = no timeout
+    uint64_t Pending() const;
+    uint64_t DroppedHolds() const { return dropped_holds_.load(std::memory_order_relaxed); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct HeldInput {
+        BatchEvent up;               // event that releases it
+        Clock::time_point release_at;
+    };
+
+    void Run();
+    void Deliver(INPUT* batch, int n);
+    int Dispatch(const TimedEvent& e, INPUT* batch, int n);
+    int FindHeld(const BatchEvent& up) const;
+    void ForgetHeld(int index);
+    void ReleaseDue();
+    Clock::time_point NextRelease() const;
+    void SleepUntil(Clock::time_point until);
+
+    SpscQueue<TimedEvent, QUEUE_CAPACITY> queue_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::mutex post_mutex_;            // one Post() at a time
+    std::condition_variable wake_cv_;  // worker waits here for work
+    std::condition_variable done_cv_;  // Wait() waits here for progress
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> posted_{0};
+    std::atomic<uint64_t> completed_{0};
+    std::atomic<uint64_t> dropped_holds_{0};
+    std::unique_ptr<WindowTarget> target_;
+
+    // Touched only by the worker thread.
+    HeldInput held_[MAX_HELD_INPUTS];
+    int held_count_ = 0;
+};
+
+// Process-wide worker (started lazily by the bindings).
+InputWorker& GetInputWorker();
+
+// Worker for one window, created and started on first use. shared_ptr so a
+// binding can wait on it without the GIL while another thread closes it.
+std::shared_ptr<InputWorker> GetWindowInputWorker(HWND hwnd);
+// Drains and forgets the window's worker (no-op if it has none).
+void CloseWindowInputWorker(HWND hwnd);
+// Stops the process-wide worker and every window worker (at exit).
+void StopInputWorkers();
@@ -0,0 +1,115 @@
+#include "parallel.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "scheduling.h"
+
+// ============================================================================
+// PARALLEL FOR IMPLEMENTATION
+// ============================================================================
+
+namespace {
+    class WorkerPool {
+    public:
+        ~WorkerPool() { Stop(); }
+
+        void Run(int count, int threads, ParallelTask task, const void* context) {
+            std::unique_lock<std::mutex> batch(batch_mutex_, std::try_to_lock);
+            if (!batch.owns_lock()) {
+                // Busy (another thread's batch, or we're inside one): alone.
+                for (int i = 0; i < count; ++i) task(context, i);
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (workers_.empty()) {
+                    for (int t = 1; t < MAX_PARALLEL_THREADS; ++t) {
+                        workers_.emplace_back(&WorkerPool::WorkerLoop, this);
+                    }
+                }
+                task_ = task;
+                context_ = context;
+                count_ = count;
+                next_.store(0, std::memory_order_relaxed);
+                wanted_ = std::min(threads - 1, (int)workers_.size());
+                ++generation_;
+            }
+            wake_cv_.notify_all();
+            Drain();
+
+            // Every index is claimed: workers that haven't joined yet don't
+            // need to, and we wait for the ones still running theirs.
+            std::unique_lock<std::mutex> lock(mutex_);
+            wanted_ = 0;
+            done_cv_.wait(lock, [&] { return active_ == 0; });
+        }
+
+        void Stop() {
+            std::lock_guard<std::mutex> batch(batch_mutex_);
+            std::vector<std::thread> workers;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopping_ = true;
+                workers.swap(workers_);
+            }
+            wake_cv_.notify_all();
+            for (std::thread& worker : workers) worker.join();
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = false;
+        }
+
+    private:
+        void Drain() {
+            for (int i = next_.fetch_add(1); i < count_; i = next_.fetch_add(1)) task_(context_, i);
+        }
+
+        void WorkerLoop() {
+            ScopedNativeThread scheduling(THREAD_PIPELINE);
+            uint64_t seen = 0;
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (true) {
+                wake_cv_.wait(lock, [&] { return stopping_ || (generation_ != seen && wanted_ > 0); });
+                if (stopping_) return;
+                seen = generation_;
+                --wanted_;
+                ++active_;
+                lock.unlock();
+                Drain();
+                lock.lock();
+                if (--active_ == 0) done_cv_.notify_all();
+            }
+        }
+
+        std::mutex batch_mutex_;              // one batch at a time
+        std::mutex mutex_;
+        std::condition_variable wake_cv_;
+        std::condition_variable done_cv_;
+        std::vector<std::thread> workers_;
+        bool stopping_ = false;
+
+        // The current batch. Set under mutex_ before workers are woken.
+        uint64_t generation_ = 0;
+        int wanted_ = 0;                     // workers still to join it
+        int active_ = 0;                     // joined and still working
+        ParallelTask task_ = nullptr;
+        const void* context_ = nullptr;
+        int count_ = 0;
+        std::atomic<int> next_{0};
+    };
+
+    WorkerPool& GetWorkerPool() {
+        static WorkerPool pool;
+        return pool;
+    }
+}
+
+void ParallelRun(int count, int threads, ParallelTask task, const void* context) {
+    GetWorkerPool().Run(count, threads, task, context);
+}
+
+void StopParallelPool() {
+    GetWorkerPool().Stop();
+}
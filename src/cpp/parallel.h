@@ -0,0 +1,50 @@
+#pragma once
+
+#include <algorithm>
+#include <thread>
+
+// ============================================================================
+// PARALLEL FOR
+// ============================================================================
+//
+// Teacher Note: The native kernels that handle many independent items (one
+// template each, one game instance each...) spread them over a few threads
+// for the duration of one call. Items can differ a lot in cost, so threads
+// pull the next index from a shared counter instead of getting a fixed
+// share. The calling thread works too, so threads = 1 runs inline.
+//
+// The helper threads are a pool started on first use and parked between
+// calls, never created per call: creating threads every step costs more
+// than the work on small batches, and per-thread caches (preprocess
+// scratch and filter tables, profiler rings) only pay off on threads that
+// live on. One batch runs at a time; a call made while the pool is busy
+// (from another thread, or from inside a ParallelFor) runs on the calling
+// thread alone.
+
+constexpr int MAX_PARALLEL_THREADS = 8;
+
+// threads <= 0 means one per core; the result is 1..MAX_PARALLEL_THREADS.
+inline int ResolveThreads(int threads) {
+    if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+    return std::clamp(threads, 1, MAX_PARALLEL_THREADS);
+}
+
+using ParallelTask = void (*)(const void* context, int index);
+
+// task(context, i) for every i in [0, count) on the caller and up to
+// threads - 1 pool threads. Returns when every call has returned.
+void ParallelRun(int count, int threads, ParallelTask task, const void* context);
+
+// Joins the pool's threads (at interpreter exit); the next call restarts them.
+void StopParallelPool();
+
+// Runs fn(i) for every i in [0, count) on up to `threads` threads.
+template <typename Fn>
+void ParallelFor(int count, int threads, const Fn& fn) {
+    threads = std::min(ResolveThreads(threads), count);
+    if (threads <= 1) {
+        for (int i = 0; i < count; ++i) fn(i);
+        return;
+    }
+    ParallelRun(count, threads, [](const void* context, int i) { (*(const Fn*)context)(i); }, &fn);
+}
@@ -0,0 +1,179 @@
+#include "preprocess.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "profiler.h"
+#include "simd.h"
+
+// ============================================================================
+// FUSED FRAME PREPROCESSING IMPLEMENTATION
+// ============================================================================
+
+namespace {
+    // Area-filter taps for one axis: output index i averages source indices
+    // start[i] .. start[i] + count[i] - 1 with weights summing to 256.
+    struct AreaFilter {
+        int src_n = 0;
+        int dst_n = 0;
+        std::vector<int> start;
+        std::vector<int> count;
+        std::vector<int> offset;        // into weights
+        std::vector<uint16_t> weights;
+
+        void Build(int src, int dst) {
+            src_n = src;
+            dst_n = dst;
+            start.assign(dst, 0);
+            count.assign(dst, 0);
+            offset.assign(dst, 0);
+            weights.clear();
+
+            const double scale = (double)src / dst;
+            for (int i = 0; i < dst; ++i) {
+                const double f0 = i * scale;
+                const double f1 = std::min((i + 1) * scale, (double)src);
+                const int j0 = std::min((int)f0, src - 1);
+                const int j1 = std::max(j0 + 1, std::min((int)std::ceil(f1), src));
+
+                start[i] = j0;
+                count[i] = j1 - j0;
+                offset[i] = (int)weights.size();
+
+                // Coverage of each source pixel, rounded to 1/256ths. Any
+                // rounding leftover goes to the biggest tap so the sum is exact.
+                int total = 0;
+                int biggest = 0;
+                for (int j = j0; j < j1; ++j) {
+                    const double cover = std::min(j + 1.0, f1) - std::max((double)j, f0);
+                    const int w = (int)std::lround(cover / (f1 - f0) * 256.0);
+                    weights.push_back((uint16_t)w);
+                    total += w;
+                    if (w > weights[offset[i] + biggest]) biggest = j - j0;
+                }
+                weights[offset[i] + biggest] = (uint16_t)(weights[offset[i] + biggest] + 256 - total);
+            }
+        }
+    };
+
+    // Per-thread scratch, rebuilt only when the frame geometry changes.
+    struct PreprocessScratch {
+        AreaFilter horizontal;
+        AreaFilter vertical;
+        std::vector<uint16_t> acc;      // one accumulated source row
+    };
+
+    PreprocessScratch& GetScratch() {
+        static thread_local PreprocessScratch scratch;
+        return scratch;
+    }
+
+    // acc[i] += src[i] * w, for n bytes.
+    void AccumulateRowScalar(uint16_t* acc, const uint8_t* src, int n, uint16_t w) {
+        for (int i = 0; i < n; ++i) acc[i] = (uint16_t)(acc[i] + src[i] * w);
+    }
+
+#if GT_X86
+    void AccumulateRowSse2(uint16_t* acc, const uint8_t* src, int n, uint16_t w) {
+        const __m128i vw = _mm_set1_epi16((short)w);
+        const __m128i zero = _mm_setzero_si128();
+        int i = 0;
+        for (; i + 16 <= n; i += 16) {
+            __m128i b = _mm_loadu_si128((const __m128i*)(src + i));
+            __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), vw);
+            __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), vw);
+            __m128i a0 = _mm_loadu_si128((const __m128i*)(acc + i));
+            __m128i a1 = _mm_loadu_si128((const __m128i*)(acc + i + 8));
+            _mm_storeu_si128((__m128i*)(acc + i), _mm_add_epi16(a0, lo));
+            _mm_storeu_si128((__m128i*)(acc + i + 8), _mm_add_epi16(a1, hi));
+        }
+        AccumulateRowScalar(acc + i, src + i, n - i, w);
+    }
+
+    GT_TARGET_AVX2
+    void AccumulateRowAvx2(uint16_t* acc, const uint8_t* src, int n, uint16_t w) {
+        const __m256i vw = _mm256_set1_epi16((short)w);
+        int i = 0;
+        for (; i + 32 <= n; i += 32) {
+            __m256i b = _mm256_loadu_si256((const __m256i*)(src + i));
+            __m256i lo = _mm256_mullo_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(b)), vw);
+            __m256i hi = _mm256_mullo_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(b, 1)), vw);
+            __m256i a0 = _mm256_loadu_si256((const __m256i*)(acc + i));
+            __m256i a1 = _mm256_loadu_si256((const __m256i*)(acc + i + 16));
+            _mm256_storeu_si256((__m256i*)(acc + i), _mm256_add_epi16(a0, lo));
+            _mm256_storeu_si256((__m256i*)(acc + i + 16), _mm256_add_epi16(a1, hi));
+        }
+        AccumulateRowScalar(acc + i, src + i, n - i, w);
+    }
+#endif
+
+    using AccumulateRowFn = void (*)(uint16_t*, const uint8_t*, int, uint16_t);
+
+    AccumulateRowFn PickAccumulateRow() {
+#if GT_X86
+        if (CpuHasAvx2()) return AccumulateRowAvx2;
+        return AccumulateRowSse2;
+#else
+        return AccumulateRowScalar;
+#endif
+    }
+
+    const AccumulateRowFn g_accumulate_row = PickAccumulateRow();
+}
+
+void PreprocessFrame(const FrameView& src, uint8_t* out, int out_w, int out_h) {
+    ScopedSpan span(PROFILE_PREPROCESS);
+    PreprocessScratch& s = GetScratch();
+    if (s.horizontal.src_n != src.width || s.horizontal.dst_n != out_w) {
+        s.horizontal.Build(src.width, out_w);
+    }
+    if (s.vertical.src_n != src.height || s.vertical.dst_n != out_h) {
+        s.vertical.Build(src.height, out_h);
+    }
+
+    const int row_bytes = src.width * src.pixel_stride;
+    if ((int)s.acc.size() < row_bytes) s.acc.resize(row_bytes);
+    uint16_t* acc = s.acc.data();
+
+    const int plane = out_w * out_h;
+    uint8_t* out_r = out;
+    uint8_t* out_g = out + plane;
+    uint8_t* out_b = out + 2 * plane;
+    const int ps = src.pixel_stride;
+
+    for (int oy = 0; oy < out_h; ++oy) {
+        // 1. Vertical: weighted sum of the covered source rows.
+        memset(acc, 0, (size_t)row_bytes * sizeof(uint16_t));
+        const int vy0 = s.vertical.start[oy];
+        const uint16_t* vw = &s.vertical.weights[s.vertical.offset[oy]];
+        for (int k = 0; k < s.vertical.count[oy]; ++k) {
+            g_accumulate_row(acc, src.data + (size_t)(vy0 + k) * src.row_stride, row_bytes, vw[k]);
+        }
+
+        // 2. Horizontal: weighted sum of covered columns, BGR -> RGB planes.
+        const int row = oy * out_w;
+        for (int ox = 0; ox < out_w; ++ox) {
+            const uint16_t* hw = &s.horizontal.weights[s.horizontal.offset[ox]];
+            const uint16_t* p = acc + (size_t)s.horizontal.start[ox] * ps;
+            uint32_t sb = 0, sg = 0, sr = 0;
+            for (int k = 0; k < s.horizontal.count[ox]; ++k, p += ps) {
+                sb += (uint32_t)hw[k] * p[0];
+                sg += (uint32_t)hw[k] * p[1];
+                sr += (uint32_t)hw[k] * p[2];
+            }
+            out_r[row + ox] = (uint8_t)((sr + 32768u) >> 16);
+            out_g[row + ox] = (uint8_t)((sg + 32768u) >> 16);
+            out_b[row + ox] = (uint8_t)((sb + 32768u) >> 16);
+        }
+    }
+}
+
+const char* PreprocessSimdLevel() {
+#if GT_X86
+    return CpuHasAvx2() ? "avx2" : "sse2";
+#else
+    return "scalar";
+#endif
+}
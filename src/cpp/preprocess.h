@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+#include "frame.h"
+
+// ============================================================================
+// FUSED FRAME PREPROCESSING
+// ============================================================================
+//
+// Teacher Note: The Python version of StardewViTEnv._preprocess_frame makes
+// four passes over the image (resize, BGR->RGB, HWC->CHW, astype) and three
+// full-size temporary arrays. This kernel does all of it in ONE sweep over
+// the captured frame and writes straight into the observation buffer:
+//
+//   BGR(A) interleaved, any size  ->  RGB planar (CHW), out_w x out_h
+//
+// The resize is an "area" filter (like cv2.INTER_AREA): every output pixel
+// is the average of the source pixels it covers, with partially covered
+// edge pixels weighted by how much of them is covered. It is done in two
+// separable steps per output row:
+//   1. VERTICAL: add up the source rows it covers (weighted) into one
+//      accumulator row. This touches every source byte, so it is SIMD
+//      (AVX2, SSE2 fallback, scalar elsewhere).
+//   2. HORIZONTAL: for each output pixel, weighted sum of accumulator
+//      columns, swizzled to RGB and stored in the three planes.
+//
+// Weights are 8-bit fixed point summing to 256 per direction, so the
+// accumulator fits in uint16 (255 * 256 < 65536) and the final value is
+// (sum + 2^15) >> 16.
+
+// out must hold 3 * out_w * out_h bytes (planes R, G, B).
+// Safe to call from several threads: scratch buffers are thread_local.
+void PreprocessFrame(const FrameView& src, uint8_t* out, int out_w, int out_h);
+
+// Which vertical-pass implementation this CPU uses: "avx2", "sse2" or "scalar".
+const char* PreprocessSimdLevel();
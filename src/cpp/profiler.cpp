@@ -0,0 +1,235 @@
+#include "profiler.h"
+
+#include <Windows.h>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+
+#include "spsc_queue.h"
+
+// ============================================================================
+// STEP PROFILER IMPLEMENTATION
+// ============================================================================
+
+namespace profiler_detail {
+    std::atomic<bool> g_enabled{false};
+}
+
+namespace {
+    const char* const STAGE_NAMES[PROFILE_STAGE_COUNT] = {
+        "capture", "frame_wait", "input_dispatch", "sleep", "reward",
+        "preprocess", "observe_batch", "inference", "env_step", "ui_scan",
+    };
+
+    struct Span {
+        int64_t start_qpc;
+        int64_t end_qpc;
+        int32_t stage;
+        uint32_t tid;
+    };
+
+    // One per recording thread; only that thread pushes.
+    struct ThreadRing {
+        uint32_t tid = 0;
+        SpscQueue<Span, PROFILE_RING_SPANS> spans;
+    };
+
+    // ------------------------------------------------------------------------
+    // Log-linear latency histogram (nanoseconds)
+    // ------------------------------------------------------------------------
+
+    constexpr int SUB_BITS = 5;                 // 32 linear buckets per power of two
+    constexpr uint64_t SUB = 1ull << SUB_BITS;
+    constexpr int BUCKETS = 2048;               // enough for any uint64
+
+    int BucketIndex(uint64_t v) {
+        if (v < 2 * SUB) return (int)v;
+        int shift = 1;
+        while ((v >> shift) >= 2 * SUB) ++shift;
+        return (int)(shift * SUB + (v >> shift));
+    }
+
+    // Middle of bucket i, in the same units.
+    double BucketValue(int i) {
+        if (i < (int)(2 * SUB)) return (double)i;
+        const int shift = i / (int)SUB - 1;
+        const uint64_t sub = (uint64_t)i - (uint64_t)shift * SUB;
+        return (double)(sub << shift) + (double)(1ull << shift) / 2.0;
+    }
+
+    struct Histogram {
+        uint64_t counts[BUCKETS] = {};
+        uint64_t total = 0;
+        double sum_ns = 0.0;
+        uint64_t max_ns = 0;
+
+        void Add(uint64_t ns) {
+            counts[BucketIndex(ns)]++;
+            total++;
+            sum_ns += (double)ns;
+            if (ns > max_ns) max_ns = ns;
+        }
+
+        double PercentileNs(double q) const {
+            if (total == 0) return 0.0;
+            uint64_t rank = (uint64_t)(q * (double)total + 0.5);
+            if (rank < 1) rank = 1;
+            uint64_t seen = 0;
+            for (int i = 0; i < BUCKETS; ++i) {
+                seen += counts[i];
+                if (seen >= rank) {
+                    const double v = BucketValue(i);
+                    return v < (double)max_ns ? v : (double)max_ns;
+                }
+            }
+            return (double)max_ns;
+        }
+    };
+
+    // ------------------------------------------------------------------------
+    // Global state
+    // ------------------------------------------------------------------------
+
+    std::atomic<bool> g_trace{false};
+    std::atomic<uint64_t> g_dropped{0};
+
+    std::mutex g_rings_mutex;                        // registration only
+    std::vector<std::shared_ptr<ThreadRing>> g_rings;
+
+    std::mutex g_collect_mutex;                      // the one consumer
+    Histogram g_histograms[PROFILE_STAGE_COUNT];
+    std::vector<Span> g_trace_events;
+
+    uint64_t TicksToNs(int64_t ticks) {
+        if (ticks <= 0) return 0;
+        return (uint64_t)((double)ticks * 1e9 / (double)QpcFrequency());
+    }
+
+    // Moves a ring's spans into the histograms (and the trace). Caller
+    // holds g_collect_mutex, which makes it the ring's one consumer.
+    void DrainRing(ThreadRing& ring, bool trace) {
+        Span span;
+        while (ring.spans.TryPop(span)) {
+            g_histograms[span.stage].Add(TicksToNs(span.end_qpc - span.start_qpc));
+            if (!trace) continue;
+            if (g_trace_events.size() < PROFILE_MAX_TRACE_EVENTS) g_trace_events.push_back(span);
+            else g_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // A thread's ring lives as long as the thread: when it exits, what it
+    // recorded is collected and the ring unregistered, so short-lived
+    // threads don't pile up rings in g_rings.
+    struct ThreadRingOwner {
+        std::shared_ptr<ThreadRing> ring;
+
+        ThreadRingOwner() : ring(std::make_shared<ThreadRing>()) {
+            ring->tid = (uint32_t)GetCurrentThreadId();
+            std::lock_guard<std::mutex> lock(g_rings_mutex);
+            g_rings.push_back(ring);
+        }
+
+        ~ThreadRingOwner() {
+            {
+                std::lock_guard<std::mutex> lock(g_collect_mutex);
+                DrainRing(*ring, g_trace.load(std::memory_order_relaxed));
+            }
+            std::lock_guard<std::mutex> lock(g_rings_mutex);
+            g_rings.erase(std::remove(g_rings.begin(), g_rings.end(), ring), g_rings.end());
+        }
+    };
+
+    ThreadRing& GetThreadRing() {
+        static thread_local ThreadRingOwner owner;
+        return *owner.ring;
+    }
+
+    StageLatency Summarize(const Histogram& h) {
+        StageLatency s = {};
+        s.count = h.total;
+        if (h.total == 0) return s;
+        s.mean_us = h.sum_ns / (double)h.total / 1000.0;
+        s.p50_us = h.PercentileNs(0.50) / 1000.0;
+        s.p90_us = h.PercentileNs(0.90) / 1000.0;
+        s.p99_us = h.PercentileNs(0.99) / 1000.0;
+        s.max_us = (double)h.max_ns / 1000.0;
+        return s;
+    }
+}
+
+const char* ProfileStageName(int stage) {
+    return stage >= 0 && stage < PROFILE_STAGE_COUNT ? STAGE_NAMES[stage] : nullptr;
+}
+
+void SetProfilerEnabled(bool enabled, bool trace) {
+    g_trace.store(trace, std::memory_order_relaxed);
+    profiler_detail::g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool ProfilerTracing() {
+    return g_trace.load(std::memory_order_relaxed);
+}
+
+void ProfileRecord(int stage, int64_t start_qpc, int64_t end_qpc) {
+    if (!ProfilerEnabled() || stage < 0 || stage >= PROFILE_STAGE_COUNT) return;
+    ThreadRing& ring = GetThreadRing();
+    if (!ring.spans.TryPush({start_qpc, end_qpc, stage, ring.tid})) {
+        g_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void ProfilerCollect() {
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+    {
+        std::lock_guard<std::mutex> lock(g_rings_mutex);
+        rings = g_rings;
+    }
+    const bool trace = ProfilerTracing();
+
+    std::lock_guard<std::mutex> lock(g_collect_mutex);
+    for (auto& ring : rings) DrainRing(*ring, trace);
+}
+
+std::vector<StageLatency> ProfilerStats() {
+    ProfilerCollect();
+    std::lock_guard<std::mutex> lock(g_collect_mutex);
+    std::vector<StageLatency> out(PROFILE_STAGE_COUNT);
+    for (int i = 0; i < PROFILE_STAGE_COUNT; ++i) out[i] = Summarize(g_histograms[i]);
+    return out;
+}
+
+uint64_t ProfilerDropped() {
+    return g_dropped.load(std::memory_order_relaxed);
+}
+
+int64_t ProfilerWriteTrace(const std::string& path) {
+    ProfilerCollect();
+    std::lock_guard<std::mutex> lock(g_collect_mutex);
+
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return -1;
+    const unsigned long pid = GetCurrentProcessId();
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (size_t i = 0; i < g_trace_events.size(); ++i) {
+        const Span& s = g_trace_events[i];
+        fprintf(f, "%s{\"name\":\"%s\",\"cat\":\"gametrainer\",\"ph\":\"X\",\"pid\":%lu,\"tid\":%u,"
+                   "\"ts\":%.3f,\"dur\":%.3f}",
+                i ? ",\n" : "", STAGE_NAMES[s.stage], pid, s.tid,
+                QpcToUs(s.start_qpc), QpcToUs(s.end_qpc - s.start_qpc));
+    }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+
+    const int64_t written = (int64_t)g_trace_events.size();
+    g_trace_events.clear();
+    return written;
+}
+
+void ProfilerReset() {
+    ProfilerCollect();
+    std::lock_guard<std::mutex> lock(g_collect_mutex);
+    for (Histogram& h : g_histograms) h = Histogram();
+    g_trace_events.clear();
+    g_dropped.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "timing.h"
+
+// ============================================================================
+// STEP PROFILER (scoped spans -> per-stage latency histograms)
+// ============================================================================
+//
+// Teacher Note: To know where a step's time goes, every interesting stage
+// (capture, input, sleeps, reward features, preprocessing...) is wrapped in
+// a ScopedSpan: two QPC reads and one push into a ring, nothing else. When
+// profiling is off a span is a single relaxed atomic load.
+//
+// Each thread pushes into its OWN ring (an SpscQueue), so recording never
+// takes a lock or makes threads wait for each other. The rings are drained
+// when someone asks for results (ProfilerStats / ProfilerWriteTrace) or
+// calls ProfilerCollect:
+//
+//     thread A --span--> [ring A] --+
+//     thread B --span--> [ring B] --+--> Collect -> histogram per stage
+//     Python   --span--> [ring P] --+            -> trace events (optional)
+//
+// The histograms are "HDR-style": log-linear buckets - 32 linear steps
+// inside every power of two - so p50/p99 are within ~3% at any scale,
+// from microseconds to seconds, in a fixed 16 KB per stage.
+//
+// A ring holds PROFILE_RING_SPANS spans; if nobody collects for that long,
+// newer spans are dropped (and counted) rather than blocking.
+
+enum ProfileStage : int {
+    PROFILE_CAPTURE = 0,       // desktop duplication: map + copy of a frame
+    PROFILE_FRAME_WAIT,        // waiting for (and copying) a capture ring frame
+    PROFILE_INPUT_DISPATCH,    // one SendInput / PostMessage batch
+    PROFILE_SLEEP,             // timed waits: key/mouse holds, step delays
+    PROFILE_REWARD,            // reward pixel features
+    PROFILE_PREPROCESS,        // resize + BGR -> RGB CHW
+    PROFILE_OBSERVE_BATCH,     // one whole batch observe (all instances)
+    PROFILE_INFERENCE,         // Python: policy forward pass
+    PROFILE_ENV_STEP,          // Python: one whole env step
+    PROFILE_UI_SCAN,           // Python: interface template scan
+    PROFILE_STAGE_COUNT
+};
+
+constexpr size_t PROFILE_RING_SPANS = 8192;
+constexpr size_t PROFILE_MAX_TRACE_EVENTS = 1 << 20;
+
+// Short lowercase name ("capture", "inference", ...), or null if out of range.
+const char* ProfileStageName(int stage);
+
+// Recording.
+void SetProfilerEnabled(bool enabled, bool trace);
+bool ProfilerTracing();
+
+namespace profiler_detail {
+    extern std::atomic<bool> g_enabled;
+}
+
+inline bool ProfilerEnabled() {
+    return profiler_detail::g_enabled.load(std::memory_order_relaxed);
+}
+
+// A span measured elsewhere (QPC ticks), e.g. from Python.
+void ProfileRecord(int stage, int64_t start_qpc, int64_t end_qpc);
+
+// Times its own lifetime as one span of `stage`.
+class ScopedSpan {
+public:
+    explicit ScopedSpan(ProfileStage stage)
+        : stage_(stage), start_(ProfilerEnabled() ? QpcNow() : 0) {}
+    ~ScopedSpan() {
+        if (start_ != 0) ProfileRecord(stage_, start_, QpcNow());
+    }
+    ScopedSpan(const ScopedSpan&) = delete;
+    ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+private:
+    ProfileStage stage_;
+    int64_t start_;
+};
+
+// Results.
+struct StageLatency {
+    uint64_t count;
+    double mean_us;
+    double p50_us;
+    double p90_us;
+    double p99_us;
+    double max_us;
+};
+
+// Drains every thread's ring into the histograms (and the trace).
+void ProfilerCollect();
+
+// Collects, then the latency summary of every stage (count 0 if none).
+std::vector<StageLatency> ProfilerStats();
+
+// Spans dropped because a ring was full.
+uint64_t ProfilerDropped();
+
+// Collects, then writes the trace events gathered so far (since the last
+// write / reset) as Chrome trace JSON (chrome://tracing, Perfetto).
+// Returns the number of events written, -1 if the file can't be opened.
+int64_t ProfilerWriteTrace(const std::string& path);
+
+// Clears histograms, trace and the dropped count.
+void ProfilerReset();
@@ -0,0 +1,309 @@
+#include "recorder.h"
+
+#include <cstring>
+
+#include "delta_codec.h"
+#include "handle_table.h"
+#include "scheduling.h"
+
+// ============================================================================
+// STEP RECORDER IMPLEMENTATION
+// ============================================================================
+
+namespace {
+    constexpr uint64_t CHUNK_ALIGN = 64;
+
+    HandleTable<StepRecorder>& GetRecorderTable() {
+        static HandleTable<StepRecorder> table;
+        return table;
+    }
+}
+
+StepRecorder::~StepRecorder() {
+    Close();
+}
+
+bool StepRecorder::Open(const std::string& path, int channels, int height, int width,
+                        int chunk_records, int buffers, int codec, std::string* error) {
+    Close();
+    if (channels <= 0 || height <= 0 || width <= 0 || chunk_records <= 0) {
+        *error = "recorder: observation shape and chunk_records must be positive";
+        return false;
+    }
+    if (buffers < 2 || buffers > RECORDER_MAX_BUFFERS) {
+        *error = "recorder: buffers must be 2.." + std::to_string(RECORDER_MAX_BUFFERS);
+        return false;
+    }
+    if (codec != RECORD_CODEC_RAW && codec != RECORD_CODEC_DELTA) {
+        *error = "recorder: unknown codec " + std::to_string(codec);
+        return false;
+    }
+    if (codec == RECORD_CODEC_DELTA) {
+        // RecordObsEntry offsets are 32-bit: a whole encoded observation
+        // block, at its worst case, has to fit below 4 GiB.
+        const uint64_t worst = (uint64_t)chunk_records *
+            (sizeof(RecordObsEntry) + DeltaMaxEncodedSize((size_t)channels * height * width));
+        if (worst > UINT32_MAX) {
+            *error = "recorder: chunk_records too large for delta-coded chunks "
+                     "(the encoded block could exceed 4 GiB)";
+            return false;
+        }
+    }
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        *error = path + ": can't create file";
+        return false;
+    }
+
+    obs_bytes_ = (size_t)channels * height * width;
+    chunk_records_ = (uint32_t)chunk_records;
+    codec_ = (uint32_t)codec;
+    header_ = {};
+    std::memcpy(header_.magic, RECORD_MAGIC, sizeof(RECORD_MAGIC));
+    header_.version = RECORD_VERSION;
+    header_.obs_channels = (uint32_t)channels;
+    header_.obs_height = (uint32_t)height;
+    header_.obs_width = (uint32_t)width;
+    header_.meta_size = sizeof(StepMeta);
+    header_.chunk_records = chunk_records_;
+
+    // The header goes in again on Close(); until then index_offset == 0
+    // tells readers to walk the chunks.
+    if (!WriteAll(&header_, sizeof(header_)) || std::fflush(file_) != 0) {
+        *error = path + ": can't write file";
+        std::fclose(file_);
+        file_ = nullptr;
+        return false;
+    }
+    offset_ = sizeof(header_);
+
+    pool_.clear();
+    for (int i = 0; i < buffers; ++i) {
+        auto chunk = std::make_unique<Chunk>();
+        chunk->obs.resize(obs_bytes_ * chunk_records_);
+        chunk->meta.resize(chunk_records_);
+        free_.TryPush(chunk.get());
+        pool_.push_back(std::move(chunk));
+    }
+    current_ = nullptr;
+    next_record_ = 0;
+    sealed_ = false;
+    index_.clear();
+    records_ = 0;
+    dropped_ = 0;
+    chunks_ = 0;
+    bytes_ = 0;
+    write_error_ = false;
+
+    running_ = true;
+    thread_ = std::thread(&StepRecorder::Run, this);
+    return true;
+}
+
+bool StepRecorder::Add(const uint8_t* obs, const StepMeta& meta) {
+    if (!file_ || sealed_) return false;
+    if (!current_) {
+        // Every buffer is waiting for the disk: drop, never block the env.
+        if (!free_.TryPop(current_)) {
+            current_ = nullptr;
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        current_->count = 0;
+        current_->first_record = next_record_;
+    }
+
+    std::memcpy(current_->obs.data() + (size_t)current_->count * obs_bytes_, obs, obs_bytes_);
+    current_->meta[current_->count] = meta;
+    ++current_->count;
+    ++next_record_;
+    records_.fetch_add(1, std::memory_order_relaxed);
+
+    if (current_->count == chunk_records_) {
+        // Can't fail: there are only as many chunks as slots.
+        full_.TryPush(current_);
+        current_ = nullptr;
+        // Same lost-wake-up guard as InputWorker::TryPost.
+        { std::lock_guard<std::mutex> lock(mutex_); }
+        wake_cv_.notify_one();
+    }
+    return true;
+}
+
+void StepRecorder::Seal() {
+    if (!file_ || sealed_) return;
+    sealed_ = true;
+    // current_ always holds at least one record (it's taken on demand).
+    if (current_) full_.TryPush(current_);
+    current_ = nullptr;
+}
+
+void StepRecorder::Close() {
+    if (!file_) return;
+    Seal();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    wake_cv_.notify_one();
+    if (thread_.joinable()) thread_.join();
+
+    // The writer is gone: index_ and offset_ are ours now.
+    bool ok = !write_error_;
+    header_.record_count = 0;
+    for (const RecordChunkEntry& e : index_) header_.record_count += e.count;
+    header_.chunk_count = (uint32_t)index_.size();
+    if (ok) {
+        header_.index_offset = offset_;
+        ok = WriteAll(index_.data(), index_.size() * sizeof(RecordChunkEntry));
+    }
+    if (ok) {
+        ok = std::fseek(file_, 0, SEEK_SET) == 0 && WriteAll(&header_, sizeof(header_));
+    }
+    // fclose flushes what is still buffered: the index and the header.
+    if (std::fclose(file_) != 0) ok = false;
+    if (!ok) write_error_ = true;
+    file_ = nullptr;
+
+    Chunk* chunk;
+    while (full_.TryPop(chunk)) {}
+    while (free_.TryPop(chunk)) {}
+    pool_.clear();
+}
+
+RecorderStats StepRecorder::Stats() const {
+    RecorderStats s;
+    s.records = records_.load(std::memory_order_relaxed);
+    s.dropped = dropped_.load(std::memory_order_relaxed);
+    s.chunks = chunks_.load(std::memory_order_relaxed);
+    s.bytes = bytes_.load(std::memory_order_relaxed);
+    s.write_error = write_error_.load(std::memory_order_relaxed);
+    return s;
+}
+
+bool StepRecorder::WriteAll(const void* data, size_t bytes) {
+    return bytes == 0 || std::fwrite(data, 1, bytes, file_) == bytes;
+}
+
+// The delta-coded observation block of a chunk (in encoded_): the
+// RecordObsEntry table, then one packet per record. Each record is a delta
+// of the env's previous record, restarting with a keyframe every
+// RECORD_KEY_INTERVAL records.
+const uint8_t* StepRecorder::EncodeChunk(const Chunk& chunk, uint64_t* bytes) {
+    struct Chain {
+        uint16_t env_id;
+        int last;      // record index of the env's previous observation
+        int length;    // packets since (and including) its keyframe
+    };
+    std::vector<Chain> chains;
+
+    const size_t table_bytes = (size_t)chunk.count * sizeof(RecordObsEntry);
+    const size_t max_packet = DeltaMaxEncodedSize(obs_bytes_);
+    if (encoded_.size() < table_bytes + (size_t)chunk.count * max_packet) {
+        encoded_.resize(table_bytes + (size_t)chunk.count * max_packet);
+    }
+    RecordObsEntry* table = (RecordObsEntry*)encoded_.data();
+    size_t offset = table_bytes;
+
+    for (uint32_t i = 0; i < chunk.count; ++i) {
+        const uint16_t env_id = chunk.meta[i].env_id;
+        Chain* chain = nullptr;
+        for (Chain& c : chains) {
+            if (c.env_id == env_id) chain = &c;
+        }
+        int ref = -1;
+        if (chain && chain->length < RECORD_KEY_INTERVAL) {
+            ref = chain->last;
+            ++chain->length;
+        } else if (chain) {
+            chain->length = 1;
+        } else {
+            chains.push_back({env_id, 0, 1});
+            chain = &chains.back();
+        }
+        chain->last = (int)i;
+
+        const uint8_t* cur = chunk.obs.data() + (size_t)i * obs_bytes_;
+        const uint8_t* prev = ref >= 0 ? chunk.obs.data() + (size_t)ref * obs_bytes_ : nullptr;
+        const size_t size = DeltaEncode(cur, prev, obs_bytes_, encoded_.data() + offset);
+        table[i] = {(uint32_t)offset, (uint32_t)size, ref, 0};
+        offset += size;
+    }
+    *bytes = offset;
+    return encoded_.data();
+}
+
+// Appends one chunk and flushes it, so a crash loses at most the chunks
+// still in memory.
+void StepRecorder::WriteChunk(const Chunk& chunk) {
+    static const uint8_t zeros[CHUNK_ALIGN] = {};
+
+    RecordChunkHeader ch = {};
+    std::memcpy(ch.magic, RECORD_CHUNK_MAGIC, sizeof(RECORD_CHUNK_MAGIC));
+    ch.first_record = chunk.first_record;
+    ch.count = chunk.count;
+    ch.codec = codec_;
+    const uint8_t* obs = chunk.obs.data();
+    ch.obs_bytes = (uint64_t)chunk.count * obs_bytes_;
+    if (codec_ == RECORD_CODEC_DELTA) obs = EncodeChunk(chunk, &ch.obs_bytes);
+    ch.meta_bytes = (uint64_t)chunk.count * sizeof(StepMeta);
+    const uint64_t body = sizeof(ch) + ch.obs_bytes + ch.meta_bytes;
+    const uint64_t pad = (CHUNK_ALIGN - body % CHUNK_ALIGN) % CHUNK_ALIGN;
+
+    bool ok = WriteAll(&ch, sizeof(ch)) &&
+              WriteAll(obs, (size_t)ch.obs_bytes) &&
+              WriteAll(chunk.meta.data(), (size_t)ch.meta_bytes) &&
+              WriteAll(zeros, (size_t)pad) &&
+              std::fflush(file_) == 0;
+    if (!ok) {
+        // Full disk or similar: stop writing, keep the file readable up to
+        // the last good chunk. Add() keeps accepting (and recycling) records.
+        write_error_ = true;
+        return;
+    }
+    index_.push_back({offset_, chunk.first_record, chunk.count, codec_, body + pad});
+    offset_ += body + pad;
+    chunks_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(body + pad, std::memory_order_relaxed);
+}
+
+void StepRecorder::Run() {
+    ScopedNativeThread scheduling(THREAD_RECORDER);
+    while (true) {
+        Chunk* chunk;
+        if (!full_.TryPop(chunk)) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_cv_.wait(lock, [&] { return !running_ || !full_.Empty(); });
+            if (!running_ && full_.Empty()) break;
+            continue;
+        }
+        if (!write_error_) WriteChunk(*chunk);
+        free_.TryPush(chunk);
+    }
+}
+
+int OpenRecorder(const std::string& path, int channels, int height, int width,
+                 int chunk_records, int buffers, int codec, std::string* error) {
+    HandleTable<StepRecorder>& table = GetRecorderTable();
+    const int handle = table.Open();
+    if (!table.Get(handle)->Open(path, channels, height, width, chunk_records, buffers, codec, error)) {
+        table.Close(handle);
+        return 0;
+    }
+    return handle;
+}
+
+std::shared_ptr<StepRecorder> GetRecorder(int handle) {
+    return GetRecorderTable().Get(handle);
+}
+
+void CloseRecorder(int handle) {
+    if (auto recorder = GetRecorderTable().Get(handle)) recorder->Close();
+    GetRecorderTable().Close(handle);
+}
+
+void CloseAllRecorders() {
+    // Close() joins the writer and writes the index, so a run still
+    // recording at exit leaves a complete file.
+    for (const std::shared_ptr<StepRecorder>& recorder : GetRecorderTable().CloseAll()) recorder->Close();
+}
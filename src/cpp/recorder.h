@@ -0,0 +1,229 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spsc_queue.h"
+
+// ============================================================================
+// STEP RECORDER (every env step -> a chunked file, written off-thread)
+// ============================================================================
+//
+// Teacher Note: Offline training (behavior cloning, re-training a new
+// policy on old sessions) needs every step that was ever played: the
+// observation, the action, the reward and the pixel statistics behind it.
+// Saving PNGs from the step loop is far too slow, so the recorder works
+// like the input worker: Add() only copies the observation into a chunk
+// buffer in memory (~20 us for 224x224x3) and returns. When a chunk is
+// full it is handed to a writer thread, which does all the file I/O.
+//
+//     env step --Add--> [chunk] --full--> writer thread --> file
+//                          ^                  |
+//                          +------ free ------+
+//
+// Chunks travel between the two threads through two SpscQueues (full and
+// free), so neither side ever takes a lock. If the disk falls behind and
+// every buffer is full, Add() drops the record and counts it - the env
+// never waits for the disk.
+//
+// File layout (little-endian), read zero-copy by recorder.py (np.memmap):
+//
+//     RecordFileHeader                    64 bytes
+//     chunk: RecordChunkHeader            64 bytes
+//            observations                 count * C*H*W uint8 (CHW)
+//            StepMeta[count]              48 bytes each
+//            padding to 64 bytes
+//     chunk ...
+//     RecordChunkEntry[chunk_count]       the index, at header.index_offset
+//
+// The index is written on Close(). A file whose writer died has
+// index_offset == 0; every chunk is flushed whole, so readers rebuild the
+// index by walking the chunk headers.
+//
+// With RECORD_CODEC_DELTA (delta_codec.h) the writer thread encodes each
+// observation against the env's previous one in the same chunk, and the
+// observation block becomes:
+//
+//            RecordObsEntry[count]        16 bytes each
+//            delta packets ...
+//
+// Every chunk starts each env's chain with a keyframe (and again every
+// RECORD_KEY_INTERVAL records), so any record decodes from at most that
+// many packets, all in its own chunk. An unchanged screen costs almost
+// nothing; the encode runs on the writer thread, never in Add().
+
+constexpr char RECORD_MAGIC[8] = {'G', 'T', 'R', 'E', 'C', 'O', 'R', 'D'};
+constexpr char RECORD_CHUNK_MAGIC[8] = {'G', 'T', 'C', 'H', 'U', 'N', 'K', '\0'};
+constexpr uint32_t RECORD_VERSION = 1;
+
+// Most chunk buffers a recorder may rotate through.
+constexpr int RECORDER_MAX_BUFFERS = 16;
+
+// Longest delta chain (keyframe included) per env in a delta-coded chunk.
+constexpr int RECORD_KEY_INTERVAL = 16;
+
+enum RecordCodec : uint32_t {
+    RECORD_CODEC_RAW = 0,     // observations stored as-is
+    RECORD_CODEC_DELTA = 1,   // RecordObsEntry table + delta packets
+};
+
+// StepMeta::flags
+enum StepFlags : uint16_t {
+    STEP_EPISODE_START = 1,   // first observation after a reset
+    STEP_TERMINATED = 2,      // the action ended the episode
+    STEP_TRUNCATED = 4,       // ...by the step limit
+};
+
+#pragma pack(push, 1)
+struct RecordFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t obs_channels;
+    uint32_t obs_height;
+    uint32_t obs_width;
+    uint32_t meta_size;          // sizeof(StepMeta)
+    uint32_t chunk_records;      // records per full chunk
+    uint64_t record_count;       // filled in on Close()
+    uint64_t index_offset;       // 0 until Close()
+    uint32_t chunk_count;
+    uint8_t reserved[12];
+};
+
+struct RecordChunkHeader {
+    char magic[8];
+    uint64_t first_record;
+    uint32_t count;
+    uint32_t codec;              // RecordCodec of the observation block
+    uint64_t obs_bytes;          // encoded observation block size
+    uint64_t meta_bytes;
+    uint8_t reserved[24];
+};
+
+// Where one delta-coded observation is, in its chunk's observation block.
+struct RecordObsEntry {
+    uint32_t offset;             // of the packet, from the start of the block
+    uint32_t size;               // packet bytes
+    int32_t ref;                 // record (in this chunk) it is a delta of; -1 = keyframe
+    uint32_t reserved;
+};
+
+struct RecordChunkEntry {
+    uint64_t offset;             // of the RecordChunkHeader
+    uint64_t first_record;
+    uint32_t count;
+    uint32_t codec;
+    uint64_t bytes;              // whole chunk, header and padding included
+};
+
+// What is known about one step besides its observation.
+struct StepMeta {
+    int64_t timestamp_us;        // when the observation was taken (qpc_us clock)
+    uint64_t step;               // caller's step counter
+    int32_t action;              // the action taken on this observation
+    float reward;                // what it earned
+    float features[4];           // notif, motion, energy, cursor (< 0 = none)
+    uint16_t env_id;
+    uint16_t flags;              // StepFlags
+    uint32_t reserved;
+};
+#pragma pack(pop)
+static_assert(sizeof(RecordFileHeader) == 64, "RecordFileHeader is 64 bytes on disk");
+static_assert(sizeof(RecordChunkHeader) == 64, "RecordChunkHeader is 64 bytes on disk");
+static_assert(sizeof(RecordObsEntry) == 16, "RecordObsEntry is 16 bytes on disk");
+static_assert(sizeof(RecordChunkEntry) == 32, "RecordChunkEntry is 32 bytes on disk");
+static_assert(sizeof(StepMeta) == 48, "StepMeta is 48 bytes on disk");
+
+struct RecorderStats {
+    uint64_t records;            // accepted by Add()
+    uint64_t dropped;            // rejected: every buffer was waiting for the disk
+    uint64_t chunks;             // written
+    uint64_t bytes;              // written
+    bool write_error;
+};
+
+class StepRecorder {
+public:
+    StepRecorder() = default;
+    ~StepRecorder();
+    StepRecorder(const StepRecorder&) = delete;
+    StepRecorder& operator=(const StepRecorder&) = delete;
+
+    // Creates the file and starts the writer thread. chunk_records records
+    // per chunk, `buffers` chunks in memory (2..RECORDER_MAX_BUFFERS),
+    // observations stored with `codec` (RecordCodec).
+    bool Open(const std::string& path, int channels, int height, int width,
+              int chunk_records, int buffers, int codec, std::string* error);
+
+    // Copies one observation (ObsBytes() of CHW uint8) and its meta into
+    // the current chunk. False if the record was dropped. One thread only.
+    bool Add(const uint8_t* obs, const StepMeta& meta);
+
+    // Producer side of closing: no Add() after this, and the partial chunk
+    // is queued for the writer. Call it from the Add() thread.
+    void Seal();
+
+    // Seal()s if needed, waits for the writer to finish every chunk, then
+    // writes the index. Idempotent.
+    void Close();
+
+    bool IsOpen() const { return file_ != nullptr; }
+    size_t ObsBytes() const { return obs_bytes_; }
+    RecorderStats Stats() const;
+
+private:
+    struct Chunk {
+        std::vector<uint8_t> obs;
+        std::vector<StepMeta> meta;
+        uint32_t count = 0;
+        uint64_t first_record = 0;
+    };
+
+    void Run();
+    void WriteChunk(const Chunk& chunk);
+    const uint8_t* EncodeChunk(const Chunk& chunk, uint64_t* bytes);
+    bool WriteAll(const void* data, size_t bytes);
+
+    FILE* file_ = nullptr;
+    RecordFileHeader header_ = {};
+    size_t obs_bytes_ = 0;
+    uint32_t chunk_records_ = 0;
+    uint32_t codec_ = RECORD_CODEC_RAW;
+
+    std::vector<std::unique_ptr<Chunk>> pool_;
+    SpscQueue<Chunk*, RECORDER_MAX_BUFFERS> full_;   // Add -> writer
+    SpscQueue<Chunk*, RECORDER_MAX_BUFFERS> free_;   // writer -> Add
+    Chunk* current_ = nullptr;                       // touched only by Add / Seal
+    uint64_t next_record_ = 0;
+    bool sealed_ = false;
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable wake_cv_;
+    std::atomic<bool> running_{false};
+
+    // Touched only by the writer thread (and Close, after joining it).
+    std::vector<RecordChunkEntry> index_;
+    uint64_t offset_ = 0;
+    std::vector<uint8_t> encoded_;                   // a delta-coded observation block
+
+    std::atomic<uint64_t> records_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> chunks_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<bool> write_error_{false};
+};
+
+// Handle table, like the reward extractors. OpenRecorder returns 0 (and
+// sets *error) if the file can't be created.
+int OpenRecorder(const std::string& path, int channels, int height, int width,
+                 int chunk_records, int buffers, int codec, std::string* error);
+std::shared_ptr<StepRecorder> GetRecorder(int handle);   // null if closed
+void CloseRecorder(int handle);                           // Close() + free
+void CloseAllRecorders();                                 // at interpreter exit
@@ -0,0 +1,190 @@
+#include "replay.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "delta_codec.h"
+#include "handle_table.h"
+#include "profiler.h"
+
+// ============================================================================
+// REPLAY CAPTURE IMPLEMENTATION
+// ============================================================================
+
+namespace {
+    constexpr uint64_t PAGE_BYTES = 4096;
+
+    HandleTable<ReplaySource>& GetReplayTable() {
+        static HandleTable<ReplaySource> table;
+        return table;
+    }
+}
+
+ReplaySource::~ReplaySource() {
+    Close();
+}
+
+bool ReplaySource::Open(const std::string& path, std::string* error) {
+    Close();
+    auto fail = [&](const char* why) {
+        *error = path + ": " + why;
+        Close();
+        return false;
+    };
+
+    file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) return fail("can't open file");
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file_, &size) || size.QuadPart < (LONGLONG)sizeof(ReplayHeader)) {
+        return fail("not a replay file (too small)");
+    }
+    size_ = (uint64_t)size.QuadPart;
+
+    mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_) return fail("can't map file");
+    view_ = (const uint8_t*)MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+    if (!view_) return fail("can't map file (out of address space?)");
+
+    std::memcpy(&header_, view_, sizeof(header_));
+    if (std::memcmp(header_.magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0) return fail("not a replay file");
+    if (header_.version != REPLAY_VERSION) return fail("unsupported replay version");
+    if (header_.width == 0 || header_.height == 0 || header_.frame_count == 0 || header_.frame_interval_us == 0) {
+        return fail("empty replay");
+    }
+    const uint64_t index_bytes = (uint64_t)header_.frame_count * sizeof(ReplayIndexEntry);
+    if (header_.index_offset < sizeof(ReplayHeader) || header_.index_offset > size_ ||
+        index_bytes > size_ - header_.index_offset) {
+        return fail("truncated replay (index out of range)");
+    }
+    index_ = (const ReplayIndexEntry*)(view_ + header_.index_offset);
+
+    const uint64_t raw_bytes = (uint64_t)header_.width * header_.height * 4;
+    key_of_.resize(header_.frame_count);
+    bool has_delta = false;
+    for (uint32_t i = 0; i < header_.frame_count; ++i) {
+        const ReplayIndexEntry& e = index_[i];
+        if (e.offset > size_ || e.size > size_ - e.offset) return fail("truncated replay (frame out of range)");
+        if (e.codec == REPLAY_CODEC_RAW) {
+            if (e.size != raw_bytes) return fail("truncated replay (frame out of range)");
+            key_of_[i] = i;
+        } else if (e.codec == REPLAY_CODEC_DELTA) {
+            DeltaHeader packet;
+            if (!DeltaPeek(view_ + e.offset, e.size, &packet) || packet.raw_bytes != raw_bytes) {
+                return fail("corrupt delta frame");
+            }
+            if (packet.flags & DELTA_KEY) key_of_[i] = i;
+            else if (i == 0) return fail("first frame is not a keyframe");
+            else key_of_[i] = key_of_[i - 1];
+            has_delta = true;
+        } else {
+            return fail("unknown frame codec");
+        }
+    }
+    if (has_delta) decoded_.resize((size_t)raw_bytes);
+
+    // Teacher Note: A fresh mapping is only address space - the first read
+    // of every page would go to disk. Touch each page once now, so playback
+    // never waits on I/O and the benchmark numbers are about our code.
+    volatile uint8_t sink = 0;
+    for (uint64_t off = 0; off < size_; off += PAGE_BYTES) sink = sink + view_[off];
+    (void)sink;
+
+    Start(QpcNowUs());
+    return true;
+}
+
+void ReplaySource::Close() {
+    if (view_) UnmapViewOfFile(view_);
+    if (mapping_) CloseHandle(mapping_);
+    if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+    view_ = nullptr;
+    mapping_ = nullptr;
+    file_ = INVALID_HANDLE_VALUE;
+    index_ = nullptr;
+    size_ = 0;
+    header_ = {};
+    key_of_.clear();
+    decoded_.clear();
+    decoded_index_ = -1;
+}
+
+void ReplaySource::Start(int64_t start_us) {
+    start_us_ = start_us;
+}
+
+uint64_t ReplaySource::SeqAt(int64_t t_us) const {
+    if (t_us <= start_us_ || header_.frame_interval_us == 0) return 1;
+    return (uint64_t)(t_us - start_us_) / header_.frame_interval_us + 1;
+}
+
+int64_t ReplaySource::PresentUs(uint64_t seq) const {
+    return start_us_ + (int64_t)((seq ? seq - 1 : 0) * header_.frame_interval_us);
+}
+
+const uint8_t* ReplaySource::FramePixels(uint32_t index) const {
+    const ReplayIndexEntry& e = index_[index];
+    if (e.codec == REPLAY_CODEC_RAW) return view_ + e.offset;
+
+    // Decode forward from the keyframe - or from the frame we already
+    // have, if it's on the way.
+    uint32_t from = key_of_[index];
+    if (decoded_index_ >= (int64_t)from && decoded_index_ <= (int64_t)index) from = (uint32_t)decoded_index_ + 1;
+    for (uint32_t i = from; i <= index; ++i) {
+        const ReplayIndexEntry& f = index_[i];
+        if (f.codec == REPLAY_CODEC_RAW) {
+            std::memcpy(decoded_.data(), view_ + f.offset, decoded_.size());
+        } else {
+            // A corrupt packet (false) leaves the previous frame in place.
+            DeltaDecode(view_ + f.offset, f.size, decoded_.data(), decoded_.size());
+        }
+    }
+    decoded_index_ = index;
+    return decoded_.data();
+}
+
+bool ReplaySource::Read(uint64_t seq, int x, int y, int width, int height, uint8_t* dst, int dst_stride) const {
+    if (!view_) return false;
+    ScopedSpan span(PROFILE_CAPTURE);
+    std::lock_guard<std::mutex> lock(read_mutex_);
+
+    const uint8_t* frame = FramePixels((uint32_t)((seq ? seq - 1 : 0) % header_.frame_count));
+    const int src_stride = Width() * 4;
+
+    // Clip to the frame; pixels of dst outside it are left untouched.
+    const int x0 = std::max(x, 0);
+    const int y0 = std::max(y, 0);
+    const int x1 = std::min(x + width, Width());
+    const int y1 = std::min(y + height, Height());
+    if (x0 >= x1 || y0 >= y1) return true;
+    const size_t row_bytes = (size_t)(x1 - x0) * 4;
+    for (int row = y0; row < y1; ++row) {
+        std::memcpy(dst + (size_t)(row - y) * dst_stride + (size_t)(x0 - x) * 4,
+                    frame + (size_t)row * src_stride + (size_t)x0 * 4, row_bytes);
+    }
+    return true;
+}
+
+int OpenReplay(const std::string& path, std::string* error) {
+    HandleTable<ReplaySource>& table = GetReplayTable();
+    const int handle = table.Open();
+    if (!table.Get(handle)->Open(path, error)) {
+        table.Close(handle);
+        return 0;
+    }
+    return handle;
+}
+
+std::shared_ptr<ReplaySource> GetReplay(int handle) {
+    return GetReplayTable().Get(handle);
+}
+
+void CloseReplay(int handle) {
+    GetReplayTable().Close(handle);
+}
+
+void CloseAllReplays() {
+    // Each file is unmapped when the last reference (a read in flight
+    // included) goes away.
+    GetReplayTable().CloseAll();
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <Windows.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// REPLAY CAPTURE (recorded frames instead of the desktop)
+// ============================================================================
+//
+// Teacher Note: Benchmarking the env against a live game measures the game
+// as much as our code: whatever is on screen decides how many frames DXGI
+// delivers, and two runs never see the same pixels. A replay file is a
+// recorded frame sequence that plays back on its own clock, one frame every
+// frame_interval_us, looping - so every run sees exactly the same frames at
+// exactly the same times, on any machine, game or no game.
+//
+// The file is memory-mapped and every page is touched once on Open, so
+// playback copies from RAM and the benchmark measures the pipeline, not the
+// disk. Written by src/gametrainer/replay.py.
+//
+// File layout (little-endian):
+//
+//     ReplayHeader                       64 bytes
+//     frame data ...                     each frame 64-byte aligned
+//     ReplayIndexEntry[frame_count]      at header.index_offset
+//
+// An index entry says where a frame's bytes are and how they are encoded
+// (codec). REPLAY_CODEC_RAW is frame_width * frame_height BGRA pixels.
+// REPLAY_CODEC_DELTA is a delta_codec.h packet against the previous frame
+// (or a keyframe): a replay of a mostly static screen shrinks to a
+// fraction, and Read() decodes forward from the nearest keyframe.
+
+constexpr char REPLAY_MAGIC[8] = {'G', 'T', 'R', 'E', 'P', 'L', 'A', 'Y'};
+constexpr uint32_t REPLAY_VERSION = 1;
+
+enum ReplayCodec : uint32_t {
+    REPLAY_CODEC_RAW = 0,     // BGRA rows, width * 4 bytes each
+    REPLAY_CODEC_DELTA = 1,   // delta packet (delta_codec.h) of those rows
+};
+
+#pragma pack(push, 1)
+struct ReplayHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t frame_count;
+    uint32_t frame_interval_us;
+    uint32_t reserved0;
+    uint64_t index_offset;
+    uint8_t reserved[24];
+};
+
+struct ReplayIndexEntry {
+    uint64_t offset;        // from the start of the file
+    uint32_t size;          // encoded bytes
+    uint32_t codec;         // ReplayCodec
+};
+#pragma pack(pop)
+static_assert(sizeof(ReplayHeader) == 64, "ReplayHeader is 64 bytes on disk");
+static_assert(sizeof(ReplayIndexEntry) == 16, "ReplayIndexEntry is 16 bytes on disk");
+
+class ReplaySource {
+public:
+    ReplaySource() = default;
+    ~ReplaySource();
+    ReplaySource(const ReplaySource&) = delete;
+    ReplaySource& operator=(const ReplaySource&) = delete;
+
+    // Maps a replay file, checks its header and index, and pages it in.
+    // On failure returns false with a message in *error.
+    bool Open(const std::string& path, std::string* error);
+    void Close();
+    bool IsOpen() const { return view_ != nullptr; }
+
+    int Width() const { return (int)header_.width; }
+    int Height() const { return (int)header_.height; }
+    uint32_t FrameCount() const { return header_.frame_count; }
+    uint32_t FrameIntervalUs() const { return header_.frame_interval_us; }
+
+    // Playback clock: frame seq 1 is presented at start_us, seq n at
+    // start_us + (n - 1) * interval; seq n shows frame (n - 1) % count.
+    void Start(int64_t start_us);
+    uint64_t SeqAt(int64_t t_us) const;          // the frame on screen at t_us
+    int64_t PresentUs(uint64_t seq) const;
+
+    // Copies the (x, y, width, height) part of frame `seq` (clipped to the
+    // frame) into dst as BGRA rows of dst_stride bytes. Safe from several
+    // threads: delta-coded frames decode into a shared buffer, so reads
+    // take turns (read_mutex_).
+    bool Read(uint64_t seq, int x, int y, int width, int height, uint8_t* dst, int dst_stride) const;
+
+private:
+    // BGRA pixels of frame `index`: into the mapping (raw) or decoded_.
+    const uint8_t* FramePixels(uint32_t index) const;
+
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+    const uint8_t* view_ = nullptr;
+    uint64_t size_ = 0;
+    ReplayHeader header_ = {};
+    const ReplayIndexEntry* index_ = nullptr;
+    int64_t start_us_ = 0;
+
+    // Delta-coded replays: the keyframe each frame decodes from, and the
+    // last frame decoded (playback is sequential, so usually one packet).
+    std::vector<uint32_t> key_of_;
+    mutable std::mutex read_mutex_;              // guards decoded_ and decoded_index_
+    mutable std::vector<uint8_t> decoded_;
+    mutable int64_t decoded_index_ = -1;
+};
+
+// Handle table, like the reward extractors. OpenReplay returns 0 (and sets
+// *error) if the file can't be used.
+int OpenReplay(const std::string& path, std::string* error);
+std::shared_ptr<ReplaySource> GetReplay(int handle);   // null if closed
+void CloseReplay(int handle);
+void CloseAllReplays();   // at interpreter exit
@@ -0,0 +1,170 @@
+#include "reward.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "handle_table.h"
+#include "profiler.h"
+
+// ============================================================================
+// REWARD FEATURES IMPLEMENTATION
+// ============================================================================
+
+namespace {
+    // Same test as cv2.inRange(cv2.cvtColor(px, COLOR_BGR2HSV), (35, 50, 50), (85, 255, 255)).
+    // OpenCV's 8-bit HSV: V = max, S = 255 * (max - min) / max, H = degrees / 2.
+    bool IsEnergyGreen(const uint8_t* p) {
+        const int b = p[0], g = p[1], r = p[2];
+        const int v = std::max({b, g, r});
+        if (v < 50) return false;
+        const int delta = v - std::min({b, g, r});
+        if ((delta * 255 + v / 2) / v < 50) return false;
+
+        double hue;
+        if (v == r)      hue = 60.0 * (g - b) / delta;
+        else if (v == g) hue = 120.0 + 60.0 * (b - r) / delta;
+        else             hue = 240.0 + 60.0 * (r - g) / delta;
+        if (hue < 0) hue += 360.0;
+        const long h = std::lround(hue * 0.5);
+        return h >= 35 && h <= 85;
+    }
+}
+
+void RewardFeatureExtractor::Grid::Configure(const FrameRect& r) {
+    area = r;
+    cols = std::min(REWARD_GRID, r.width);
+    rows = std::min(REWARD_GRID, r.height);
+    col_cell.resize(r.width);
+    row_cell.resize(r.height);
+    for (int x = 0; x < r.width; ++x) col_cell[x] = (uint8_t)((long long)x * cols / r.width);
+    for (int y = 0; y < r.height; ++y) row_cell[y] = (uint8_t)((long long)y * rows / r.height);
+
+    std::vector<uint32_t> col_count(cols, 0), row_count(rows, 0);
+    for (int x = 0; x < r.width; ++x) col_count[col_cell[x]]++;
+    for (int y = 0; y < r.height; ++y) row_count[row_cell[y]]++;
+    cell_count.resize((size_t)cols * rows);
+    for (int cy = 0; cy < rows; ++cy) {
+        for (int cx = 0; cx < cols; ++cx) cell_count[cy * cols + cx] = row_count[cy] * col_count[cx];
+    }
+
+    sum.assign((size_t)cols * rows, 0);
+    prev.assign((size_t)cols * rows, 0);
+    has_prev = false;
+}
+
+float RewardFeatureExtractor::Grid::Finish() {
+    if (cols == 0 || rows == 0) return -1.0f;
+    uint64_t total = 0;
+    for (size_t i = 0; i < sum.size(); ++i) {
+        const uint8_t cell = (uint8_t)((sum[i] + cell_count[i] / 2) / cell_count[i]);
+        total += (uint64_t)std::abs((int)cell - (int)prev[i]);
+        prev[i] = cell;
+    }
+    const float diff = has_prev ? (float)((double)total / sum.size()) : -1.0f;
+    has_prev = true;
+    return diff;
+}
+
+void RewardFeatureExtractor::Configure(int width, int height) {
+    width_ = width;
+    height_ = height;
+    motion_.Configure({0, 0, width, height});
+
+    // Bottom-left notification area: rows 70%..100%, columns 0%..30%.
+    const int notif_top = (int)(height * 0.7);
+    notif_.Configure({0, notif_top, (int)(width * 0.3), height - notif_top});
+}
+
+void RewardFeatureExtractor::Reset() {
+    motion_.has_prev = false;
+    notif_.has_prev = false;
+}
+
+RewardFeatures RewardFeatureExtractor::Compute(const FrameView& frame, const FrameView* before,
+                                               const RewardRegions& regions) {
+    ScopedSpan span(PROFILE_REWARD);
+    if (frame.width != width_ || frame.height != height_) Configure(frame.width, frame.height);
+    std::fill(motion_.sum.begin(), motion_.sum.end(), 0u);
+    std::fill(notif_.sum.begin(), notif_.sum.end(), 0u);
+
+    const FrameRect energy = ClipRect(regions.energy, frame.width, frame.height);
+    const FrameRect cursor = before ? ClipRect(regions.cursor, frame.width, frame.height) : FrameRect{0, 0, 0, 0};
+    const FrameRect& na = notif_.area;
+    const bool has_notif = notif_.cols > 0 && notif_.rows > 0;
+    const int ps = frame.pixel_stride;
+
+    uint64_t green = 0;
+    uint64_t cursor_total = 0;
+
+    for (int y = 0; y < frame.height; ++y) {
+        const uint8_t* row = frame.Row(y);
+
+        // Gray grids: every pixel feeds the motion grid, the bottom-left
+        // ones also feed the notification grid.
+        uint32_t* msum = &motion_.sum[(size_t)motion_.row_cell[y] * motion_.cols];
+        uint32_t* nsum = nullptr;
+        if (has_notif && y >= na.y && y < na.y + na.height) {
+            nsum = &notif_.sum[(size_t)notif_.row_cell[y - na.y] * notif_.cols];
+        }
+        const uint8_t* mcol = motion_.col_cell.data();
+        if (nsum) {
+            const uint8_t* ncol = notif_.col_cell.data();
+            int x = 0;
+            for (; x < na.width; ++x) {
+                const uint32_t g = GrayFromBgr(row + x * ps);
+                msum[mcol[x]] += g;
+                nsum[ncol[x]] += g;
+            }
+            for (; x < frame.width; ++x) msum[mcol[x]] += GrayFromBgr(row + x * ps);
+        } else {
+            for (int x = 0; x < frame.width; ++x) msum[mcol[x]] += GrayFromBgr(row + x * ps);
+        }
+
+        // Energy bar: HSV green test, only inside its (small) rectangle.
+        if (y >= energy.y && y < energy.y + energy.height) {
+            for (int x = energy.x; x < energy.x + energy.width; ++x) green += IsEnergyGreen(row + x * ps);
+        }
+
+        // Cursor box: gray difference against the frame before the click.
+        if (y >= cursor.y && y < cursor.y + cursor.height) {
+            const uint8_t* brow = before->Row(y);
+            const int bps = before->pixel_stride;
+            for (int x = cursor.x; x < cursor.x + cursor.width; ++x) {
+                cursor_total += (uint64_t)std::abs((int)GrayFromBgr(row + x * ps) - (int)GrayFromBgr(brow + x * bps));
+            }
+        }
+    }
+
+    RewardFeatures out;
+    out.motion_diff = motion_.Finish();
+    out.notif_diff = notif_.Finish();
+    out.energy_green = energy.width > 0 && energy.height > 0
+        ? (float)((double)green / ((double)energy.width * energy.height)) : -1.0f;
+    out.cursor_diff = cursor.width > 0 && cursor.height > 0
+        ? (float)((double)cursor_total / ((double)cursor.width * cursor.height)) : -1.0f;
+    return out;
+}
+
+// ----------------------------------------------------------------------------
+// Handles
+// ----------------------------------------------------------------------------
+
+namespace {
+    HandleTable<RewardFeatureExtractor>& GetRewardTable() {
+        static HandleTable<RewardFeatureExtractor> table;
+        return table;
+    }
+}
+
+int OpenRewardExtractor() {
+    return GetRewardTable().Open();
+}
+
+std::shared_ptr<RewardFeatureExtractor> GetRewardExtractor(int handle) {
+    return GetRewardTable().Get(handle);
+}
+
+void CloseRewardExtractor(int handle) {
+    GetRewardTable().Close(handle);
+}
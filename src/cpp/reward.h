@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "frame.h"
+
+// ============================================================================
+// REWARD FEATURES
+// ============================================================================
+//
+// Teacher Note: StardewViTEnv._calculate_reward looks at the frame through
+// about ten OpenCV calls (two resizes, three grayscale conversions, two
+// absdiffs, HSV + inRange...), each with its own temporary array. Every
+// number it needs is a simple sum over some pixels, so we get them all in
+// ONE sweep over the frame, row by row, while each row is still in cache:
+//
+//   - motion diff:   whole frame box-averaged to a 64x64 gray grid,
+//                    mean |grid - previous grid|
+//   - notif diff:    same, for the bottom-left notification area
+//   - energy green:  fraction of energy-bar pixels in OpenCV's HSV range
+//                    H 35..85, S >= 50, V >= 50
+//   - cursor diff:   mean gray |after - before| around the cursor
+//
+// The previous 64x64 grids live inside the extractor, so Python keeps no
+// per-frame state for these.
+
+constexpr int REWARD_GRID = 64;
+
+struct RewardRegions {
+    FrameRect energy;     // empty (width 0) = skip
+    FrameRect cursor;     // empty = skip (also skipped without a before frame)
+};
+
+// Diffs are on the 0-255 gray scale. A field is negative when it could not be
+// computed: no previous grid yet, empty region, or no before frame.
+struct RewardFeatures {
+    float notif_diff;
+    float motion_diff;
+    float energy_green;   // 0..1
+    float cursor_diff;
+};
+
+class RewardFeatureExtractor {
+public:
+    // `before` may be null; it is only read inside regions.cursor.
+    RewardFeatures Compute(const FrameView& frame, const FrameView* before, const RewardRegions& regions);
+
+    // Forget the previous grids (new episode).
+    void Reset();
+
+private:
+    // Box-average grid over one frame area, with its column/row -> cell tables.
+    struct Grid {
+        FrameRect area = {};
+        int cols = 0;
+        int rows = 0;
+        std::vector<uint8_t> col_cell;    // per pixel column in area
+        std::vector<uint8_t> row_cell;    // per pixel row in area
+        std::vector<uint32_t> cell_count;
+        std::vector<uint32_t> sum;
+        std::vector<uint8_t> prev;
+        bool has_prev = false;
+
+        void Configure(const FrameRect& r);
+        float Finish();   // averages sum into cells, diffs with prev, stores
+    };
+
+    void Configure(int width, int height);
+
+    int width_ = 0;
+    int height_ = 0;
+    Grid motion_;
+    Grid notif_;
+};
+
+// Handles for Python: one extractor per environment, so vectorized envs do
+// not share "previous frame" state. Handles are small positive ints.
+int OpenRewardExtractor();
+std::shared_ptr<RewardFeatureExtractor> GetRewardExtractor(int handle);   // null if closed
+void CloseRewardExtractor(int handle);
@@ -0,0 +1,171 @@
+#include "scheduling.h"
+
+#include <avrt.h>
+#include <algorithm>
+#include <mutex>
+
+// ============================================================================
+// SCHEDULING IMPLEMENTATION
+// ============================================================================
+
+namespace {
+    constexpr int MAX_NATIVE_THREADS = 64;
+
+    struct ThreadEntry {
+        bool used = false;
+        ThreadRole role = THREAD_INPUT;
+        DWORD id = 0;
+        HANDLE handle = nullptr;   // THREAD_SET_INFORMATION | THREAD_QUERY_INFORMATION
+        uint64_t affinity = 0;
+        bool mmcss = false;
+    };
+
+    std::mutex g_mutex;
+    ThreadPolicy g_policies[THREAD_ROLE_COUNT];
+    ThreadEntry g_threads[MAX_NATIVE_THREADS];
+
+    const char* const kRoleNames[THREAD_ROLE_COUNT] = {
+        "input", "capture", "pipeline", "recorder", "window",
+    };
+
+    uint64_t ProcessMask() {
+        DWORD_PTR process = 0, system = 0;
+        if (!GetProcessAffinityMask(GetCurrentProcess(), &process, &system)) return 0;
+        return (uint64_t)process;
+    }
+
+    double FileTimeToUs(const FILETIME& t) {
+        const uint64_t ticks = ((uint64_t)t.dwHighDateTime << 32) | t.dwLowDateTime;
+        return ticks / 10.0;                // 100 ns units
+    }
+
+    // Affinity (and, outside MMCSS, priority) for a registered thread.
+    // Caller holds g_mutex.
+    void Apply(ThreadEntry& entry, const ThreadPolicy& policy) {
+        const uint64_t allowed = ProcessMask();
+        uint64_t mask = policy.affinity & allowed;
+        if (mask == 0) mask = allowed;      // "any", or nothing we may use
+        entry.affinity = SetThreadAffinityMask(entry.handle, (DWORD_PTR)mask) != 0 ? mask : 0;
+        if (!entry.mmcss) SetThreadPriority(entry.handle, policy.priority);
+    }
+}
+
+const char* ThreadRoleName(ThreadRole role) {
+    return (role >= 0 && role < THREAD_ROLE_COUNT) ? kRoleNames[role] : "unknown";
+}
+
+bool SetThreadPolicy(ThreadRole role, const ThreadPolicy& policy) {
+    if (role < 0 || role >= THREAD_ROLE_COUNT) return false;
+    std::lock_guard<std::mutex> lock(g_mutex);
+    ThreadPolicy& p = g_policies[role];
+    p = policy;
+    p.priority = std::clamp(p.priority, -2, 2);
+    p.mmcss[31] = L'\0';
+    for (ThreadEntry& entry : g_threads) {
+        if (entry.used && entry.role == role) Apply(entry, p);
+    }
+    return true;
+}
+
+ThreadPolicy GetThreadPolicy(ThreadRole role) {
+    if (role < 0 || role >= THREAD_ROLE_COUNT) return {};
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_policies[role];
+}
+
+CoreMasks GetCoreMasks() {
+    static const CoreMasks masks = [] {
+        CoreMasks m = {0, 0, 0};
+        // EfficiencyClass: higher = faster. All equal = not a hybrid chip.
+        ULONG length = 0;
+        GetSystemCpuSetInformation(nullptr, 0, &length, GetCurrentProcess(), 0);
+        std::vector<uint8_t> buffer(length);
+        if (length > 0 && GetSystemCpuSetInformation((PSYSTEM_CPU_SET_INFORMATION)buffer.data(), length,
+                                                     &length, GetCurrentProcess(), 0)) {
+            uint64_t by_class[256] = {};
+            int top = -1;
+            for (ULONG offset = 0; offset < length;) {
+                const auto* info = (const SYSTEM_CPU_SET_INFORMATION*)(buffer.data() + offset);
+                offset += info->Size;
+                if (info->Type != CpuSetInformation || info->CpuSet.Group != 0) continue;
+                if (info->CpuSet.LogicalProcessorIndex >= 64) continue;
+                const int cls = info->CpuSet.EfficiencyClass;
+                by_class[cls] |= 1ull << info->CpuSet.LogicalProcessorIndex;
+                top = std::max(top, cls);
+                ++m.logical;
+            }
+            for (int cls = 0; cls <= top; ++cls) {
+                if (cls == top) m.performance |= by_class[cls];
+                else m.efficiency |= by_class[cls];
+            }
+        }
+        if (m.logical == 0) {
+            // No CPU set information (pre-Windows 10): every processor we may use.
+            DWORD_PTR process = 0, system = 0;
+            GetProcessAffinityMask(GetCurrentProcess(), &process, &system);
+            m.performance = (uint64_t)system;
+            for (uint64_t bits = m.performance; bits; bits &= bits - 1) ++m.logical;
+        }
+        return m;
+    }();
+    return masks;
+}
+
+std::vector<NativeThreadInfo> ListNativeThreads() {
+    std::vector<NativeThreadInfo> out;
+    std::lock_guard<std::mutex> lock(g_mutex);
+    for (const ThreadEntry& entry : g_threads) {
+        if (!entry.used) continue;
+        NativeThreadInfo info = {entry.role, entry.id, 0.0, 0.0, 0, entry.affinity, entry.mmcss};
+        FILETIME created, exited, kernel, user;
+        if (GetThreadTimes(entry.handle, &created, &exited, &kernel, &user)) {
+            info.user_us = FileTimeToUs(user);
+            info.kernel_us = FileTimeToUs(kernel);
+        }
+        ULONG64 cycles = 0;
+        if (QueryThreadCycleTime(entry.handle, &cycles)) info.cycles = cycles;
+        out.push_back(info);
+    }
+    return out;
+}
+
+ScopedNativeThread::ScopedNativeThread(ThreadRole role) : slot_(-1) {
+    if (role < 0 || role >= THREAD_ROLE_COUNT) return;
+    const ThreadPolicy policy = GetThreadPolicy(role);
+
+    // Only the thread itself can join an MMCSS task.
+    if (policy.mmcss[0] != L'\0') {
+        DWORD task_index = 0;
+        mmcss_ = AvSetMmThreadCharacteristicsW(policy.mmcss, &task_index);
+        if (mmcss_) AvSetMmThreadPriority(mmcss_, (AVRT_PRIORITY)policy.priority);
+    }
+
+    HANDLE handle = nullptr;
+    if (!DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(), &handle,
+                         THREAD_SET_INFORMATION | THREAD_QUERY_INFORMATION, FALSE, 0)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(g_mutex);
+    for (int i = 0; i < MAX_NATIVE_THREADS; ++i) {
+        if (g_threads[i].used) continue;
+        ThreadEntry& entry = g_threads[i];
+        entry.used = true;
+        entry.role = role;
+        entry.id = GetCurrentThreadId();
+        entry.handle = handle;
+        entry.mmcss = mmcss_ != nullptr;
+        Apply(entry, g_policies[role]);
+        slot_ = i;
+        return;
+    }
+    CloseHandle(handle);                    // registry full: run unmanaged
+}
+
+ScopedNativeThread::~ScopedNativeThread() {
+    if (slot_ >= 0) {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        CloseHandle(g_threads[slot_].handle);
+        g_threads[slot_] = ThreadEntry{};
+    }
+    if (mmcss_) AvRevertMmThreadCharacteristics(mmcss_);
+}
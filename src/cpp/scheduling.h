@@ -0,0 +1,96 @@
+#pragma once
+
+#include <Windows.h>
+#include <cstdint>
+#include <vector>
+
+// ============================================================================
+// SCHEDULING (which cores the native threads run on, and how urgently)
+// ============================================================================
+//
+// Teacher Note: Capture, input, the step pipeline, the recorder and the
+// window tracker each run on their own native thread - next to the game
+// itself and PyTorch's thread pool, all on the same 8 cores. Left alone,
+// Windows moves our threads around freely and now and then parks the input
+// or capture thread behind a busy game thread: that is a late frame or a
+// late key, which shows up as a p99 step-latency spike.
+//
+// Every native thread has a ROLE, and each role has a ThreadPolicy:
+//
+//   - affinity: the logical processors it may run on. On hybrid Intel
+//     chips GetCoreMasks() tells performance cores (P) from efficiency
+//     cores (E), so input/capture can stay on P-cores and the recorder on
+//     E-cores.
+//   - mmcss: a Multimedia Class Scheduler task ("Games", "Capture", ...).
+//     MMCSS raises the thread's priority while it is busy, and Windows
+//     keeps background work from starving it.
+//   - priority: -2 .. 2, lowest .. highest. For an MMCSS thread this is
+//     its priority within the task (AvSetMmThreadPriority). Otherwise it is
+//     SetThreadPriority.
+//
+// A thread puts ScopedNativeThread at the top of its Run(), which applies
+// its role's policy and makes it show up in ListNativeThreads() with its
+// CPU time.
+//
+// Changing a policy re-applies affinity and priority to running threads
+// right away. MMCSS can only be joined by the thread itself, so a new
+// mmcss task applies to threads started afterwards (set policies before
+// creating the env).
+
+enum ThreadRole : int {
+    THREAD_INPUT = 0,          // input workers (process-wide and per window)
+    THREAD_CAPTURE,            // capture ring
+    THREAD_PIPELINE,           // step pipeline and the ParallelFor pool
+    THREAD_RECORDER,           // trajectory writer
+    THREAD_WINDOW,             // window tracker
+    THREAD_ROLE_COUNT
+};
+
+const char* ThreadRoleName(ThreadRole role);
+
+struct ThreadPolicy {
+    uint64_t affinity = 0;     // logical processors (group 0) as bits; 0 = any
+    int priority = 0;          // -2 .. 2
+    wchar_t mmcss[32] = {};    // MMCSS task name, empty = none
+};
+
+// Policy for role (clamped priority). Returns false for an unknown role.
+bool SetThreadPolicy(ThreadRole role, const ThreadPolicy& policy);
+ThreadPolicy GetThreadPolicy(ThreadRole role);
+
+// Logical processors (group 0) by kind. Without hybrid cores every
+// processor counts as a performance core and efficiency is 0.
+struct CoreMasks {
+    uint64_t performance;
+    uint64_t efficiency;
+    int logical;               // logical processors in group 0
+};
+
+CoreMasks GetCoreMasks();
+
+struct NativeThreadInfo {
+    ThreadRole role;
+    DWORD id;
+    double user_us;            // CPU time (GetThreadTimes)
+    double kernel_us;
+    uint64_t cycles;           // QueryThreadCycleTime
+    uint64_t affinity;         // as applied (0: the system refused)
+    bool mmcss;                // joined its MMCSS task
+};
+
+// The native threads running right now.
+std::vector<NativeThreadInfo> ListNativeThreads();
+
+// Registers the calling thread under `role` for as long as it lives.
+class ScopedNativeThread {
+public:
+    explicit ScopedNativeThread(ThreadRole role);
+    ~ScopedNativeThread();
+
+    ScopedNativeThread(const ScopedNativeThread&) = delete;
+    ScopedNativeThread& operator=(const ScopedNativeThread&) = delete;
+
+private:
+    int slot_;                 // -1: the registry was full
+    HANDLE mmcss_ = nullptr;
+};
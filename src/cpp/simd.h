@@ -0,0 +1,51 @@
+#pragma once
+
+// ============================================================================
+// SIMD HELPERS
+// ============================================================================
+//
+// Teacher Note: Every x86-64 CPU has SSE2, so that is our baseline. AVX2
+// (32 bytes per instruction instead of 16) is on almost every CPU since
+// 2013, but not all, so we compile AVX2 functions separately and pick one
+// at runtime. That way a single build works on every machine.
+//
+// Mark AVX2 functions with GT_TARGET_AVX2 and only call them when
+// CpuHasAvx2() returns true. MSVC allows AVX2 intrinsics anywhere, GCC and
+// Clang need the per-function target attribute.
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define GT_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#else
+#define GT_X86 0
+#endif
+
+#if GT_X86 && (defined(__GNUC__) || defined(__clang__))
+#define GT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define GT_TARGET_AVX2
+#endif
+
+// True if both the CPU and the OS (saves YMM registers) support AVX2.
+inline bool CpuHasAvx2() {
+#if !GT_X86
+    return false;
+#elif defined(_MSC_VER)
+    static const bool has = [] {
+        int info[4];
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }();
+    return has;
+#else
+    static const bool has = __builtin_cpu_supports("avx2");
+    return has;
+#endif
+}
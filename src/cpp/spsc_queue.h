@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// ============================================================================
+// SINGLE-PRODUCER / SINGLE-CONSUMER RING BUFFER
+// ============================================================================
+//
+// Teacher Note: A "lock-free" queue lets one thread push and another thread
+// pop at the same time without a mutex. It works because each side only ever
+// WRITES its own index (head for the consumer, tail for the producer) and only
+// READS the other one. std::atomic with acquire/release ordering makes sure
+// the slot contents are visible before the index that publishes them.
+//
+// Rules:
+//   - Exactly one thread may call TryPush, exactly one may call TryPop.
+//   - Capacity must be a power of two (so "index % Capacity" is a cheap mask).
+//   - No heap allocation: the slots live inside the object.
+
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscQueue capacity must be a power of two");
+
+public:
+    // Producer side. Returns false if the queue is full.
+    bool TryPush(const T& item) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == Capacity) return false;
+        slots_[tail & (Capacity - 1)] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false if the queue is empty.
+    bool TryPop(T& item) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) return false;
+        item = slots_[head & (Capacity - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Looks at the next item without removing it.
+    const T* Peek() const {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) return nullptr;
+        return &slots_[head & (Capacity - 1)];
+    }
+
+    // Either side; only a snapshot while the other side is running.
+    bool Empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    size_t SizeApprox() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    // Separate cache lines so producer and consumer don't fight over one line.
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    alignas(64) T slots_[Capacity];
+};
@@ -0,0 +1,130 @@
+#include "step_pipeline.h"
+
+#include <algorithm>
+
+#include "handle_table.h"
+#include "scheduling.h"
+#include "timing.h"
+
+// ============================================================================
+// STEP PIPELINE IMPLEMENTATION
+// ============================================================================
+
+StepPipeline::StepPipeline() : thread_(&StepPipeline::Run, this) {}
+
+StepPipeline::~StepPipeline() {
+    Stop();
+}
+
+void StepPipeline::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+uint64_t StepPipeline::Submit(std::unique_ptr<PipelineJob> job) {
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        id = next_id_++;
+        jobs_[id].job = std::move(job);
+    }
+    cv_.notify_all();
+    return id;
+}
+
+bool StepPipeline::WaitCaptured(uint64_t id, FrameStamp* stamp) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = jobs_.find(id);
+    if (it == jobs_.end()) return false;
+    // Entries stay put until Take(), so the iterator remains valid.
+    cv_.wait(lock, [&] { return it->second.stage != Stage::Queued || stop_; });
+    const PipelineJob& job = *it->second.job;
+    if (it->second.stage == Stage::Queued || !job.captured) return false;
+    *stamp = job.stamp;
+    return true;
+}
+
+std::unique_ptr<PipelineJob> StepPipeline::Take(uint64_t id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = jobs_.find(id);
+    if (it == jobs_.end()) return nullptr;
+    cv_.wait(lock, [&] { return it->second.stage == Stage::Done || stop_; });
+    std::unique_ptr<PipelineJob> job = std::move(it->second.job);
+    jobs_.erase(it);
+    return job;
+}
+
+void StepPipeline::Run() {
+    ScopedNativeThread scheduling(THREAD_PIPELINE);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [&] { return stop_ || jobs_.count(next_run_) != 0; });
+        if (stop_) break;
+        const uint64_t id = next_run_++;
+        PipelineJob* job = jobs_[id].job.get();
+
+        lock.unlock();
+        Process(*job, id);
+        lock.lock();
+
+        jobs_[id].stage = Stage::Done;
+        cv_.notify_all();
+    }
+}
+
+void StepPipeline::Process(PipelineJob& job, uint64_t id) {
+    // 1. The frame at the deadline (waiting for it, like at_or_after)
+    CaptureRing& ring = GetCaptureRing();
+    const int64_t ahead_ms = std::max<int64_t>(0, (job.deadline_us - QpcNowUs()) / 1000);
+    // Fails if the ring was restarted on another region since the job was
+    // queued (the copy would overflow our buffer).
+    job.captured = ring.ReadAtOrAfter(job.deadline_us, job.frame, job.frame_width, job.frame_height,
+                                      job.frame_stride, (int)ahead_ms + job.timeout_ms, &job.stamp);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_[id].stage = Stage::Captured;
+    }
+    cv_.notify_all();
+
+    // 2. Observations + reward features for every instance in it
+    const size_t count = job.instances.size();
+    job.features.assign(count, RewardFeatures{-1.0f, -1.0f, -1.0f, -1.0f});
+    if (!job.captured) return;
+    const FrameView frame = {job.frame, job.frame_width, job.frame_height, job.frame_stride, 4};
+    const FrameView before = {job.before, job.frame_width, job.frame_height, job.frame_stride, 4};
+    ObserveBatch(frame, job.before ? &before : nullptr, job.instances.data(), (int)count,
+                 job.obs, job.out_w, job.out_h, job.threads, job.features.data());
+}
+
+// ----------------------------------------------------------------------------
+// Handles
+// ----------------------------------------------------------------------------
+
+namespace {
+    HandleTable<StepPipeline>& GetPipelineTable() {
+        static HandleTable<StepPipeline> table;
+        return table;
+    }
+}
+
+int OpenStepPipeline() {
+    return GetPipelineTable().Open();
+}
+
+std::shared_ptr<StepPipeline> GetStepPipeline(int handle) {
+    return GetPipelineTable().Get(handle);
+}
+
+void CloseStepPipeline(int handle) {
+    GetPipelineTable().Close(handle);
+}
+
+void CloseAllStepPipelines() {
+    // A binding may still hold one of these (with the GIL released), so
+    // stop them here rather than wait for the last reference.
+    for (const std::shared_ptr<StepPipeline>& pipeline : GetPipelineTable().CloseAll()) pipeline->Stop();
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "batch_observe.h"
+#include "capture_ring.h"
+
+// ============================================================================
+// STEP PIPELINE (capture + reward + preprocess on a background thread)
+// ============================================================================
+//
+// Teacher Note: A synchronous env step looks like
+//
+//     act -> wait 30 ms -> capture -> reward features -> preprocess -> return
+//
+// and the Python thread does all of it, one stage after the other. With a
+// pipeline, Python only acts and SUBMITS a job; the job says "the frame on
+// screen at time T (now + 30 ms), then its reward features / observation".
+// One native thread runs the jobs in order:
+//
+//     1. wait for the deadline, copy that frame from the capture ring
+//        -> the job is CAPTURED (Python may send the next action now)
+//     2. ObserveBatch on it (see batch_observe.h)
+//        -> the job is DONE (features and observation are ready)
+//
+// So the fixed 30 ms becomes a deadline on this thread instead of a sleep
+// on the Python thread, and the pixel work of one frame-skip repeat runs
+// while the next repeat's action and wait are already under way.
+//
+// Jobs write into buffers owned by the caller, which must keep them alive
+// (and leave them alone) until Take() returned the job.
+
+struct PipelineJob {
+    int64_t deadline_us = 0;     // capture the first frame shown at or after this
+    int timeout_ms = 100;        // ...waiting at most this long past the deadline
+
+    uint8_t* frame = nullptr;    // capture ring region, BGRA rows of frame_stride
+    int frame_width = 0;         // must still match the ring's region when the job runs
+    int frame_height = 0;
+    int frame_stride = 0;
+    const uint8_t* before = nullptr;   // same layout, or null (cursor diffs)
+
+    std::vector<BatchInstance> instances;
+    std::vector<std::shared_ptr<RewardFeatureExtractor>> extractors;   // keeps instances[i].reward alive
+    uint8_t* obs = nullptr;      // instances.size() * 3 * out_h * out_w bytes, or null
+    int out_w = 0;
+    int out_h = 0;
+    int threads = 0;             // for ObserveBatch; 0 = one per core
+
+    // Filled in by the pipeline thread
+    bool captured = false;       // false: no frame before the timeout
+    FrameStamp stamp = {0, 0};
+    std::vector<RewardFeatures> features;
+};
+
+class StepPipeline {
+public:
+    StepPipeline();
+    ~StepPipeline();
+
+    // Queues a job; returns its id (ids increase by one per job).
+    uint64_t Submit(std::unique_ptr<PipelineJob> job);
+
+    // Waits until job `id` is captured. False if it found no frame (or the
+    // id is unknown); stamp is set otherwise.
+    bool WaitCaptured(uint64_t id, FrameStamp* stamp);
+
+    // Waits until job `id` is done and hands it back (null if unknown).
+    std::unique_ptr<PipelineJob> Take(uint64_t id);
+
+    // Wakes every waiter and joins the thread; queued jobs never run.
+    // Idempotent; the destructor calls it.
+    void Stop();
+
+private:
+    enum class Stage { Queued, Captured, Done };
+    struct Entry {
+        std::unique_ptr<PipelineJob> job;
+        Stage stage = Stage::Queued;
+    };
+
+    void Run();
+    void Process(PipelineJob& job, uint64_t id);
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::map<uint64_t, Entry> jobs_;   // submitted and not taken yet
+    uint64_t next_id_ = 1;
+    uint64_t next_run_ = 1;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+// Handles for Python (one pipeline per env).
+int OpenStepPipeline();
+std::shared_ptr<StepPipeline> GetStepPipeline(int handle);   // null if closed
+void CloseStepPipeline(int handle);
+void CloseAllStepPipelines();   // Stop() each one (at interpreter exit)
@@ -0,0 +1,345 @@
+#include "template_match.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "handle_table.h"
+#include "parallel.h"
+
+// ============================================================================
+// COARSE-TO-FINE TEMPLATE MATCHING IMPLEMENTATION
+// ============================================================================
+
+namespace {
+    // Coarse scales must leave at least this many template pixels per side.
+    constexpr int MIN_COARSE_SIDE = 6;
+    // How many coarse candidates get refined at full resolution.
+    constexpr int REFINE_CANDIDATES = 8;
+    // Only the best coarse scores are considered for the candidates.
+    constexpr int CANDIDATE_POOL = 64;
+
+    struct Candidate {
+        float score;
+        int x;
+        int y;
+    };
+}
+
+void TemplateMatcher::MakeLevel(const uint8_t* gray, int width, int height, int stride, Level& out) {
+    out.width = width;
+    out.height = height;
+    out.pixels.resize((size_t)width * height);
+
+    uint64_t sum = 0;
+    uint64_t sum_sq = 0;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const uint32_t v = gray[(size_t)y * stride + x];
+            out.pixels[(size_t)y * width + x] = (uint8_t)v;
+            sum += v;
+            sum_sq += v * v;
+        }
+    }
+    const double n = (double)width * height;
+    out.sum = (double)sum;
+    out.norm2 = (double)sum_sq - (double)sum * sum / n;
+}
+
+void TemplateMatcher::Downsample(const Image& src, int factor, Image& out) {
+    out.width = src.width / factor;
+    out.height = src.height / factor;
+    out.pixels.resize((size_t)out.width * out.height);
+    const int area = factor * factor;
+    for (int y = 0; y < out.height; ++y) {
+        for (int x = 0; x < out.width; ++x) {
+            int sum = 0;
+            for (int j = 0; j < factor; ++j) {
+                const uint8_t* row = &src.pixels[(size_t)(y * factor + j) * src.width + x * factor];
+                for (int i = 0; i < factor; ++i) sum += row[i];
+            }
+            out.pixels[(size_t)y * out.width + x] = (uint8_t)((sum + area / 2) / area);
+        }
+    }
+}
+
+int TemplateMatcher::AddTemplate(const uint8_t* gray, int width, int height, int stride) {
+    Template t;
+    MakeLevel(gray, width, height, stride, t.full);
+
+    // Coarsest scale that still leaves a recognizable template.
+    t.factor = 1;
+    for (int f = 4; f >= 2; f /= 2) {
+        if (width / f >= MIN_COARSE_SIDE && height / f >= MIN_COARSE_SIDE) {
+            t.factor = f;
+            break;
+        }
+    }
+    if (t.factor > 1) {
+        Image img;
+        img.width = width;
+        img.height = height;
+        img.pixels.resize((size_t)width * height);
+        for (int y = 0; y < height; ++y) {
+            std::copy(gray + (size_t)y * stride, gray + (size_t)y * stride + width, &img.pixels[(size_t)y * width]);
+        }
+        Image small;
+        Downsample(img, t.factor, small);
+        MakeLevel(small.pixels.data(), small.width, small.height, small.width, t.coarse);
+    }
+
+    templates_.push_back(std::move(t));
+    return (int)templates_.size() - 1;
+}
+
+void TemplateMatcher::SetScene(const FrameView& frame) {
+    scene_.width = frame.width;
+    scene_.height = frame.height;
+    scene_.pixels.resize((size_t)frame.width * frame.height);
+    for (int y = 0; y < frame.height; ++y) {
+        const uint8_t* row = frame.Row(y);
+        uint8_t* out = &scene_.pixels[(size_t)y * frame.width];
+        for (int x = 0; x < frame.width; ++x) out[x] = GrayFromBgr(row + x * frame.pixel_stride);
+    }
+    Downsample(scene_, 2, scene_half_);
+    Downsample(scene_half_, 2, scene_quarter_);
+
+    // Stale until rebuilt for this frame (clear keeps the allocation).
+    for (Image* img : {&scene_, &scene_half_, &scene_quarter_}) {
+        img->integral.clear();
+        img->integral_sq.clear();
+    }
+}
+
+void TemplateMatcher::BuildSceneIntegrals() {
+    scene_.BuildIntegrals();
+    scene_half_.BuildIntegrals();
+    scene_quarter_.BuildIntegrals();
+}
+
+const TemplateMatcher::Image& TemplateMatcher::SceneAt(int factor) const {
+    if (factor == 4) return scene_quarter_;
+    if (factor == 2) return scene_half_;
+    return scene_;
+}
+
+void TemplateMatcher::Image::BuildIntegrals() {
+    const int iw = width + 1;
+    integral.assign((size_t)iw * (height + 1), 0);
+    integral_sq.assign((size_t)iw * (height + 1), 0);
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* row = &pixels[(size_t)y * width];
+        const uint32_t* above = &integral[(size_t)y * iw];
+        const uint32_t* above_sq = &integral_sq[(size_t)y * iw];
+        uint32_t* cur = &integral[(size_t)(y + 1) * iw];
+        uint32_t* cur_sq = &integral_sq[(size_t)(y + 1) * iw];
+        uint32_t run = 0;
+        uint32_t run_sq = 0;
+        for (int x = 0; x < width; ++x) {
+            const uint32_t v = row[x];
+            run += v;
+            run_sq += v * v;
+            cur[x + 1] = above[x + 1] + run;
+            cur_sq[x + 1] = above_sq[x + 1] + run_sq;
+        }
+    }
+}
+
+// The corner sums overflow on big scenes, but unsigned arithmetic wraps, so
+// the difference is still exact whenever the window's own sum fits.
+void TemplateMatcher::Image::WindowSums(int x, int y, int w, int h, uint32_t* sum, uint32_t* sum_sq) const {
+    const size_t iw = (size_t)width + 1;
+    const size_t a = (size_t)y * iw + x;         // top-left
+    const size_t b = a + w;                      // top-right
+    const size_t c = a + (size_t)h * iw;         // bottom-left
+    const size_t d = c + w;                      // bottom-right
+    *sum = integral[d] - integral[b] - integral[c] + integral[a];
+    *sum_sq = integral_sq[d] - integral_sq[b] - integral_sq[c] + integral_sq[a];
+}
+
+// TM_CCOEFF_NORMED at one position:
+//   sum((T - mean T)(I - mean I)) = sum(T * I) - sum(T) * sum(I) / n
+// Only sum(T * I) needs the template; the window sums come from the integral
+// images when they are built. Per-row sums are integers, so the compiler can
+// vectorize the loops.
+float TemplateMatcher::Score(const Image& scene, const Level& t, int x, int y) {
+    uint64_t dot = 0;
+    uint64_t sum = 0;
+    uint64_t sum_sq = 0;
+    if (scene.HasIntegrals() && t.width * t.height <= MAX_INTEGRAL_AREA) {
+        for (int j = 0; j < t.height; ++j) {
+            const uint8_t* row = &scene.pixels[(size_t)(y + j) * scene.width + x];
+            const uint8_t* trow = &t.pixels[(size_t)j * t.width];
+            uint32_t row_dot = 0;
+            for (int i = 0; i < t.width; ++i) row_dot += (uint32_t)row[i] * trow[i];
+            dot += row_dot;
+        }
+        uint32_t wsum, wsum_sq;
+        scene.WindowSums(x, y, t.width, t.height, &wsum, &wsum_sq);
+        sum = wsum;
+        sum_sq = wsum_sq;
+    } else {
+        for (int j = 0; j < t.height; ++j) {
+            const uint8_t* row = &scene.pixels[(size_t)(y + j) * scene.width + x];
+            const uint8_t* trow = &t.pixels[(size_t)j * t.width];
+            uint32_t row_dot = 0, row_sum = 0, row_sq = 0;
+            for (int i = 0; i < t.width; ++i) {
+                const uint32_t v = row[i];
+                row_dot += v * trow[i];
+                row_sum += v;
+                row_sq += v * v;
+            }
+            dot += row_dot;
+            sum += row_sum;
+            sum_sq += row_sq;
+        }
+    }
+
+    const double n = (double)t.width * t.height;
+    const double var = (double)sum_sq - (double)sum * sum / n;
+    const double denom = std::sqrt(var * t.norm2);
+    if (denom < 1e-6) return 0.0f;   // flat window or flat template
+    return (float)(((double)dot - t.sum * (double)sum / n) / denom);
+}
+
+MatchResult TemplateMatcher::Search(const Template& t, int x0, int y0, int x1, int y1) const {
+    MatchResult best = {-1.0f, x0, y0};
+
+    // Full-resolution scan of a (small) rectangle of positions.
+    auto refine = [&](int rx0, int ry0, int rx1, int ry1) {
+        rx0 = std::max(rx0, x0);
+        ry0 = std::max(ry0, y0);
+        rx1 = std::min(rx1, x1);
+        ry1 = std::min(ry1, y1);
+        for (int y = ry0; y <= ry1; ++y) {
+            for (int x = rx0; x <= rx1; ++x) {
+                const float s = Score(scene_, t.full, x, y);
+                if (s > best.score) best = {s, x, y};
+            }
+        }
+    };
+
+    const int f = t.factor;
+    const Image& coarse_scene = SceneAt(f);
+    const int cx0 = x0 / f;
+    const int cy0 = y0 / f;
+    const int cx1 = std::min(x1 / f, coarse_scene.width - t.coarse.width);
+    const int cy1 = std::min(y1 / f, coarse_scene.height - t.coarse.height);
+    if (f == 1 || cx1 < cx0 || cy1 < cy0) {
+        refine(x0, y0, x1, y1);
+        return best;
+    }
+
+    // 1. Coarse: score every position at 1/f scale.
+    std::vector<Candidate> candidates;
+    candidates.reserve((size_t)(cx1 - cx0 + 1) * (cy1 - cy0 + 1));
+    for (int y = cy0; y <= cy1; ++y) {
+        for (int x = cx0; x <= cx1; ++x) candidates.push_back({Score(coarse_scene, t.coarse, x, y), x, y});
+    }
+    const size_t pool = std::min(candidates.size(), (size_t)CANDIDATE_POOL);
+    std::partial_sort(candidates.begin(), candidates.begin() + pool, candidates.end(),
+                      [](const Candidate& a, const Candidate& b) { return a.score > b.score; });
+
+    // 2. Keep a few well-separated peaks (neighbours of a peak score high too).
+    const int min_dist = std::max(1, std::max(t.coarse.width, t.coarse.height) / 2);
+    Candidate picked[REFINE_CANDIDATES];
+    int num_picked = 0;
+    for (size_t i = 0; i < pool && num_picked < REFINE_CANDIDATES; ++i) {
+        bool separate = true;
+        for (int k = 0; k < num_picked; ++k) {
+            if (std::abs(candidates[i].x - picked[k].x) < min_dist &&
+                std::abs(candidates[i].y - picked[k].y) < min_dist) {
+                separate = false;
+                break;
+            }
+        }
+        if (separate) picked[num_picked++] = candidates[i];
+    }
+
+    // 3. Fine: full resolution around each peak (+- one coarse pixel).
+    for (int k = 0; k < num_picked; ++k) {
+        const int fx = picked[k].x * f;
+        const int fy = picked[k].y * f;
+        refine(fx - f, fy - f, fx + f, fy + f);
+    }
+    return best;
+}
+
+MatchResult TemplateMatcher::SearchAll(const Template& t) const {
+    return Search(t, 0, 0, scene_.width - t.full.width, scene_.height - t.full.height);
+}
+
+MatchResult TemplateMatcher::SearchNear(const Template& t, const int* hint_xy, int margin) const {
+    const int max_x = scene_.width - t.full.width;
+    const int max_y = scene_.height - t.full.height;
+    const int hx = std::clamp(hint_xy[0], 0, max_x);
+    const int hy = std::clamp(hint_xy[1], 0, max_y);
+    return Search(t, std::max(0, hx - margin), std::max(0, hy - margin),
+                  std::min(max_x, hx + margin), std::min(max_y, hy + margin));
+}
+
+MatchResult TemplateMatcher::Find(int id, const int* hint_xy, int margin, float threshold) const {
+    const Template& t = templates_[id];
+    if (t.full.width > scene_.width || t.full.height > scene_.height) return {-1.0f, 0, 0};
+
+    if (hint_xy) {
+        MatchResult local = SearchNear(t, hint_xy, margin);
+        if (local.score >= threshold) return local;
+    }
+    return SearchAll(t);
+}
+
+void TemplateMatcher::FindAll(const int* hint_xy, const char* has_hint, int margin, float threshold,
+                              int threads, MatchResult* out) {
+    const int count = TemplateCount();
+
+    // 1. Hinted templates: a small window around the last position. Direct
+    //    sums are cheaper here than building integrals for the whole frame.
+    std::vector<int> hinted;
+    for (int i = 0; i < count; ++i) {
+        out[i] = {-1.0f, 0, 0};
+        if (has_hint[i]) hinted.push_back(i);
+    }
+    ParallelFor((int)hinted.size(), threads, [&](int k) {
+        const int i = hinted[k];
+        const Template& t = templates_[i];
+        if (t.full.width <= scene_.width && t.full.height <= scene_.height) {
+            out[i] = SearchNear(t, &hint_xy[2 * i], margin);
+        }
+    });
+
+    // 2. Everything without a hint, or that missed it: whole screen.
+    std::vector<int> global;
+    for (int i = 0; i < count; ++i) {
+        const Template& t = templates_[i];
+        if (t.full.width > scene_.width || t.full.height > scene_.height) continue;
+        if (!has_hint[i] || out[i].score < threshold) global.push_back(i);
+    }
+    if (global.empty()) return;
+    if (!scene_.HasIntegrals()) BuildSceneIntegrals();
+    ParallelFor((int)global.size(), threads, [&](int k) {
+        out[global[k]] = SearchAll(templates_[global[k]]);
+    });
+}
+
+// ----------------------------------------------------------------------------
+// Handles
+// ----------------------------------------------------------------------------
+
+namespace {
+    HandleTable<TemplateMatcher>& GetMatcherTable() {
+        static HandleTable<TemplateMatcher> table;
+        return table;
+    }
+}
+
+int OpenTemplateMatcher() {
+    return GetMatcherTable().Open();
+}
+
+std::shared_ptr<TemplateMatcher> GetTemplateMatcher(int handle) {
+    return GetMatcherTable().Get(handle);
+}
+
+void CloseTemplateMatcher(int handle) {
+    GetMatcherTable().Close(handle);
+}
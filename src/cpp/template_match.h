@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "frame.h"
+
+// ============================================================================
+// COARSE-TO-FINE TEMPLATE MATCHING
+// ============================================================================
+//
+// Teacher Note: InterfaceManager.find_all used cv2.matchTemplate on the
+// full-resolution window for every template, which stalls the step it runs
+// in. Three tricks make it cheap enough to run every step:
+//
+//   1. PYRAMID: search a 1/4-size copy of the screen with a 1/4-size
+//      template first (16x fewer positions, 16x fewer pixels per position),
+//      keep the few best spots, and only check those at full resolution.
+//   2. HINTS: UI elements rarely move. Search around where the template was
+//      last found first, and only scan the whole screen if that misses.
+//   3. SHARED WORK: the normalization needs the sum and sum of squares of
+//      the scene under every candidate window. When some template needs a
+//      whole-screen search, FindAll builds "integral images" once for the
+//      frame (each entry = sum of everything above-left of it), so any
+//      window's sums are 4 lookups, for every template. Templates are
+//      scored in parallel, one per thread.
+//
+// The score is the same as cv2.TM_CCOEFF_NORMED (zero-mean normalized cross
+// correlation, 1.0 = perfect match). Each template's downsampled copy, sum
+// and norm are computed once, when it is added.
+
+// Largest template (in pixels) whose window sums come from the integral
+// images; bigger ones sum their windows directly. 255^2 * area < 2^32.
+constexpr int MAX_INTEGRAL_AREA = 66048;
+
+struct MatchResult {
+    float score;   // TM_CCOEFF_NORMED, -1..1
+    int x;         // top-left of the best match, scene pixels
+    int y;
+};
+
+class TemplateMatcher {
+public:
+    // Adds a grayscale template; returns its id (0, 1, 2...).
+    int AddTemplate(const uint8_t* gray, int width, int height, int stride);
+    int TemplateCount() const { return (int)templates_.size(); }
+
+    // Grayscales (and downsamples) the frame to search. Call once per scan.
+    void SetScene(const FrameView& frame);
+    // Builds the scene's integral images; Find() uses them once built.
+    void BuildSceneIntegrals();
+
+    // Best match of template `id` in the scene. With a hint (last known
+    // top-left), searches hint +- margin first and falls back to the whole
+    // scene when that scores below threshold. score is -1 if the template
+    // does not fit in the scene.
+    MatchResult Find(int id, const int* hint_xy, int margin, float threshold) const;
+
+    // Find() for every template, spread over up to `threads` threads
+    // (0 = one per core, see parallel.h). hint_xy holds an (x, y)
+    // pair per template, used where has_hint is non-zero. Hinted searches run
+    // first; the integrals are only built if a whole-screen search follows.
+    void FindAll(const int* hint_xy, const char* has_hint, int margin, float threshold,
+                 int threads, MatchResult* out);
+
+private:
+    // Template at one scale, with the sums the score needs.
+    struct Level {
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> pixels;
+        double sum = 0;     // sum of pixels
+        double norm2 = 0;   // sum of squared zero-mean pixels
+    };
+    struct Template {
+        int factor = 1;     // coarse scale: 4, 2 or 1 (small templates)
+        Level full;
+        Level coarse;
+    };
+    struct Image {
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> pixels;
+        // (width + 1) x (height + 1): sums of pixels / squared pixels
+        // above-left, kept modulo 2^32 (see WindowSums).
+        std::vector<uint32_t> integral;
+        std::vector<uint32_t> integral_sq;
+
+        bool HasIntegrals() const { return !integral.empty(); }
+        void BuildIntegrals();
+        // Exact while w * h <= MAX_INTEGRAL_AREA, so the true sums fit in 32 bits.
+        void WindowSums(int x, int y, int w, int h, uint32_t* sum, uint32_t* sum_sq) const;
+    };
+
+    static void MakeLevel(const uint8_t* gray, int width, int height, int stride, Level& out);
+    static void Downsample(const Image& src, int factor, Image& out);
+    static float Score(const Image& scene, const Level& t, int x, int y);
+
+    const Image& SceneAt(int factor) const;
+    // Coarse-to-fine search over top-left positions [x0, x1] x [y0, y1].
+    MatchResult Search(const Template& t, int x0, int y0, int x1, int y1) const;
+    MatchResult SearchAll(const Template& t) const;
+    MatchResult SearchNear(const Template& t, const int* hint_xy, int margin) const;
+
+    std::vector<Template> templates_;
+    Image scene_;          // full resolution gray
+    Image scene_half_;
+    Image scene_quarter_;
+};
+
+// Handles for Python (one matcher per InterfaceManager).
+int OpenTemplateMatcher();
+std::shared_ptr<TemplateMatcher> GetTemplateMatcher(int handle);   // null if closed
+void CloseTemplateMatcher(int handle);
@@ -0,0 +1,55 @@
+#include "tile_hash.h"
+
+#include <cstring>
+
+// ============================================================================
+// TILE HASHES IMPLEMENTATION
+// ============================================================================
+
+namespace {
+    constexpr uint64_t HASH_SEED = 0x9E3779B97F4A7C15ull;
+    constexpr uint64_t HASH_MUL = 0xFF51AFD7ED558CCDull;
+
+    inline uint64_t Mix(uint64_t h, uint64_t v) {
+        h ^= v;
+        h *= HASH_MUL;
+        return h ^ (h >> 29);
+    }
+
+    // Folds n bytes into h.
+    uint64_t HashBytes(uint64_t h, const uint8_t* p, int n) {
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            uint64_t v;
+            memcpy(&v, p + i, 8);
+            h = Mix(h, v);
+        }
+        if (i < n) {
+            uint64_t v = 0;
+            memcpy(&v, p + i, n - i);
+            h = Mix(h, v ^ ((uint64_t)(n - i) << 56));
+        }
+        return h;
+    }
+}
+
+void ComputeTileHashes(const FrameView& frame, int tile, uint64_t* out) {
+    const int tiles_x = TileCount(frame.width, tile);
+    const int tiles_y = TileCount(frame.height, tile);
+    const int ps = frame.pixel_stride;
+
+    for (int ty = 0; ty < tiles_y; ++ty) {
+        uint64_t* hashes = out + (size_t)ty * tiles_x;
+        for (int tx = 0; tx < tiles_x; ++tx) hashes[tx] = HASH_SEED;
+
+        const int y1 = ty * tile + tile < frame.height ? ty * tile + tile : frame.height;
+        for (int y = ty * tile; y < y1; ++y) {
+            const uint8_t* row = frame.Row(y);
+            for (int tx = 0; tx < tiles_x; ++tx) {
+                const int x0 = tx * tile;
+                const int w = x0 + tile < frame.width ? tile : frame.width - x0;
+                hashes[tx] = HashBytes(hashes[tx], row + (size_t)x0 * ps, w * ps);
+            }
+        }
+    }
+}
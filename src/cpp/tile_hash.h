@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+#include "frame.h"
+
+// ============================================================================
+// TILE HASHES (change detection without DXGI)
+// ============================================================================
+//
+// Teacher Note: The GDI/mss path gets no dirty rectangles, so we find out
+// what changed ourselves: the frame is cut into tile x tile squares and each
+// square gets a 64-bit hash of its pixels. Comparing two hash grids (a few
+// thousand numbers) tells us which tiles changed - far cheaper than diffing
+// millions of pixels twice.
+//
+// One pass, row by row; each row segment is folded 8 bytes at a time.
+
+// Tiles per axis for a given frame size.
+inline int TileCount(int pixels, int tile) { return (pixels + tile - 1) / tile; }
+
+// out must hold TileCount(height) * TileCount(width) hashes, row-major.
+void ComputeTileHashes(const FrameView& frame, int tile, uint64_t* out);
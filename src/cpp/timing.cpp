@@ -0,0 +1,137 @@
+#include "timing.h"
+
+#include <Windows.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "profiler.h"
+
+// ============================================================================
+// PRECISE TIMING IMPLEMENTATION
+// ============================================================================
+
+namespace {
+    std::atomic<bool> g_precise{false};
+    std::atomic<uint32_t> g_spin_us{500};
+
+    std::mutex g_stats_mutex;
+    DelayStats g_stats = {};
+
+    // One high-resolution timer per thread (a waitable timer handle must not
+    // be shared by threads waiting at the same time). Falls back to a normal
+    // waitable timer on Windows versions older than 10 1803.
+    struct ThreadTimer {
+        HANDLE handle = nullptr;
+
+        ThreadTimer() {
+            handle = CreateWaitableTimerExW(nullptr, nullptr,
+                                            CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+                                            TIMER_ALL_ACCESS);
+            if (!handle) {
+                handle = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+            }
+        }
+        ~ThreadTimer() {
+            if (handle) CloseHandle(handle);
+        }
+    };
+
+    ThreadTimer& GetThreadTimer() {
+        static thread_local ThreadTimer timer;
+        return timer;
+    }
+
+    void RecordDelay(double requested_us, double actual_us) {
+        std::lock_guard<std::mutex> lock(g_stats_mutex);
+        g_stats.count++;
+        g_stats.requested_total_us += requested_us;
+        g_stats.actual_total_us += actual_us;
+        if (actual_us - requested_us > g_stats.max_late_us) {
+            g_stats.max_late_us = actual_us - requested_us;
+        }
+        g_stats.last_requested_us = requested_us;
+        g_stats.last_actual_us = actual_us;
+    }
+
+    // Stage 1 + 2 of precise mode: timer sleep, then QPC spin.
+    void HighResWait(int64_t remaining_us) {
+        const int64_t spin_us = g_spin_us.load(std::memory_order_relaxed);
+        const int64_t spin_end = QpcNow() + remaining_us * QpcFrequency() / 1000000;
+
+        HANDLE timer = GetThreadTimer().handle;
+        if (timer && remaining_us > spin_us) {
+            LARGE_INTEGER due;
+            // Negative = relative time, in 100 ns units.
+            due.QuadPart = -(remaining_us - spin_us) * 10;
+            if (SetWaitableTimerEx(timer, &due, 0, nullptr, nullptr, nullptr, 0)) {
+                WaitForSingleObject(timer, INFINITE);
+            }
+        }
+        while (QpcNow() < spin_end) {
+            YieldProcessor();
+        }
+    }
+}
+
+int64_t QpcNow() {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return now.QuadPart;
+}
+
+int64_t QpcFrequency() {
+    static const int64_t freq = [] {
+        LARGE_INTEGER f;
+        QueryPerformanceFrequency(&f);
+        return f.QuadPart;
+    }();
+    return freq;
+}
+
+double QpcToUs(int64_t ticks) {
+    return (double)ticks * 1e6 / (double)QpcFrequency();
+}
+
+int64_t QpcNowUs() {
+    return (int64_t)QpcToUs(QpcNow());
+}
+
+void SetPreciseTiming(bool enabled, uint32_t spin_us) {
+    g_spin_us.store(spin_us, std::memory_order_relaxed);
+    g_precise.store(enabled, std::memory_order_relaxed);
+}
+
+bool PreciseTimingEnabled() {
+    return g_precise.load(std::memory_order_relaxed);
+}
+
+void PreciseSleepUntil(TimingClock::time_point deadline) {
+    const int64_t start = QpcNow();
+    const int64_t requested_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(deadline - TimingClock::now()).count();
+    if (requested_us <= 0) return;
+    ScopedSpan span(PROFILE_SLEEP);
+
+    if (PreciseTimingEnabled()) {
+        HighResWait(requested_us);
+    } else {
+        std::this_thread::sleep_until(deadline);
+    }
+
+    RecordDelay((double)requested_us, QpcToUs(QpcNow() - start));
+}
+
+void PreciseSleepUs(uint32_t us) {
+    PreciseSleepUntil(TimingClock::now() + std::chrono::microseconds(us));
+}
+
+DelayStats GetDelayStats() {
+    std::lock_guard<std::mutex> lock(g_stats_mutex);
+    return g_stats;
+}
+
+void ResetDelayStats() {
+    std::lock_guard<std::mutex> lock(g_stats_mutex);
+    g_stats = {};
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// ============================================================================
+// PRECISE TIMING
+// ============================================================================
+//
+// Teacher Note: std::this_thread::sleep_for on Windows rounds up to the
+// scheduler "tick" (~15.6 ms by default), so a 10 ms key hold really lasts
+// ~15.6 ms and a 60 ms step anything up to ~78 ms.
+//
+// Precise mode (opt-in) fixes that in two stages:
+//   1. Sleep on a HIGH-RESOLUTION waitable timer until shortly before the
+//      deadline. The thread really sleeps, so this costs no CPU.
+//   2. Spin on QueryPerformanceCounter (QPC) for the last `spin_us`.
+//      Burns a little CPU but lands within a few microseconds.
+//
+// Every sleep - in either mode - is recorded so the bindings can report
+// requested vs. measured delays (clib.timer_stats()).
+
+using TimingClock = std::chrono::steady_clock;
+
+// Raw QPC ticks and conversions.
+int64_t QpcNow();
+int64_t QpcFrequency();
+double QpcToUs(int64_t ticks);
+int64_t QpcNowUs();     // QpcNow() in microseconds: the timestamp clock for frames
+
+// Mode switch. spin_us is how long before the deadline we stop sleeping
+// and start spinning (only used in precise mode).
+void SetPreciseTiming(bool enabled, uint32_t spin_us = 500);
+bool PreciseTimingEnabled();
+
+// Sleep until / for. Safe to call from any thread.
+void PreciseSleepUntil(TimingClock::time_point deadline);
+void PreciseSleepUs(uint32_t us);
+
+// Requested vs. measured sleep statistics (all in microseconds).
+struct DelayStats {
+    uint64_t count;
+    double requested_total_us;
+    double actual_total_us;
+    double max_late_us;     // worst overshoot (actual - requested)
+    double last_requested_us;
+    double last_actual_us;
+};
+
+DelayStats GetDelayStats();
+void ResetDelayStats();
@@ -0,0 +1,96 @@
+#include "trajectory.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+// ============================================================================
+// HUMANIZED MOUSE TRAJECTORY IMPLEMENTATION
+// ============================================================================
+
+namespace {
+    // SplitMix64: tiny, fast and identical on every platform.
+    struct SplitMix64 {
+        uint64_t state;
+
+        uint64_t Next() {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        // Uniform in [-1, 1].
+        double NextSigned() {
+            return (double)(Next() >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+        }
+
+        // Uniform integer in [-k, k].
+        int NextInt(int k) {
+            if (k <= 0) return 0;
+            return (int)(Next() % (uint64_t)(2 * k + 1)) - k;
+        }
+    };
+
+    // Minimum-jerk position profile: 0 -> 1 with zero velocity and
+    // acceleration at both ends.
+    double MinJerk(double t) {
+        double t3 = t * t * t;
+        return t3 * (10.0 - 15.0 * t + 6.0 * t * t);
+    }
+}
+
+void BuildTrajectory(const TrajectoryParams& params, Trajectory& out) {
+    uint64_t seed = params.seed;
+    if (seed == 0) {
+        seed = ((uint64_t)std::random_device{}() << 32) | std::random_device{}();
+    }
+    SplitMix64 rng{seed};
+
+    // MAX_TRAJECTORY_MS * 1000 still fits 32 bits
+    const uint32_t duration_us = std::min(params.duration_ms, MAX_TRAJECTORY_MS) * 1000u;
+    // The first step goes out right away, so the duration is spread over
+    // the steps - 1 waits between steps (about TRAJECTORY_STEP_US each).
+    int steps = (int)((duration_us + TRAJECTORY_STEP_US / 2) / TRAJECTORY_STEP_US) + 1;
+    steps = std::clamp(steps, 1, MAX_TRAJECTORY_STEPS);
+
+    out.count = steps;
+    out.duration_us = steps > 1 ? duration_us : 0;
+    out.step_us = steps > 1 ? duration_us / (uint32_t)(steps - 1) : 0;
+    out.seed = seed;
+
+    // Control point: midpoint, pushed along the perpendicular.
+    const double ex = params.dx;
+    const double ey = params.dy;
+    const double bend = params.curvature * rng.NextSigned();
+    const double cx = ex * 0.5 - ey * bend;
+    const double cy = ey * 0.5 + ex * bend;
+
+    int prev_x = 0;
+    int prev_y = 0;
+    for (int i = 1; i <= steps; ++i) {
+        int x = params.dx;
+        int y = params.dy;
+        if (i < steps) {
+            // Quadratic Bezier: B(s) = 2(1-s)s*C + s^2*E  (start is the origin)
+            double s = MinJerk((double)i / steps);
+            double a = 2.0 * (1.0 - s) * s;
+            double b = s * s;
+            x = (int)std::lround(a * cx + b * ex) + rng.NextInt(params.jitter_px);
+            y = (int)std::lround(a * cy + b * ey) + rng.NextInt(params.jitter_px);
+        }
+        out.dx[i - 1] = x - prev_x;
+        out.dy[i - 1] = y - prev_y;
+        prev_x = x;
+        prev_y = y;
+    }
+}
+
+uint32_t TrajectoryDelayUs(const Trajectory& path, int i) {
+    if (i < 0 || i + 1 >= path.count) return 0;
+    // Wait i ends at floor((i + 1) * D / gaps): the sum telescopes to D.
+    const uint64_t gaps = (uint64_t)(path.count - 1);
+    const uint64_t end = (uint64_t)(i + 1) * path.duration_us / gaps;
+    const uint64_t start = (uint64_t)i * path.duration_us / gaps;
+    return (uint32_t)(end - start);
+}
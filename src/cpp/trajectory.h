@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+
+// ============================================================================
+// HUMANIZED MOUSE TRAJECTORIES
+// ============================================================================
+//
+// Teacher Note: A person moving a mouse doesn't travel in a straight line at
+// constant speed. The hand follows a gentle curve, speeds up in the middle
+// and slows down at the end. We model both parts:
+//
+//   - PATH: a quadratic Bezier curve from (0, 0) to (dx, dy). Its single
+//     control point sits beside the midpoint, pushed sideways by a seeded
+//     random amount, so every path bends a little differently.
+//   - TIMING: the "minimum-jerk" profile s(t) = 10t^3 - 15t^4 + 6t^5, the
+//     smoothest way to get from standing still to standing still. Samples
+//     are evenly spaced in time, so steps are short at both ends and long
+//     in the middle.
+//
+// Each step's relative delta is round(P(i)) - round(P(i-1)), so the deltas
+// always add up to EXACTLY (dx, dy) - no drift, no overshoot.
+//
+// Everything lives in a fixed-size struct (no heap). The same seed always
+// gives the same path, on any compiler (we use our own SplitMix64 RNG).
+
+constexpr int MAX_TRAJECTORY_STEPS = 64;
+
+// One step is played back every this many microseconds (~125 Hz).
+constexpr uint32_t TRAJECTORY_STEP_US = 8000;
+
+// Duration used when the caller doesn't ask for one, and the longest we
+// accept (longer requests are clamped).
+constexpr uint32_t DEFAULT_TRAJECTORY_MS = 150;
+constexpr uint32_t MAX_TRAJECTORY_MS = 60000;
+
+struct TrajectoryParams {
+    int dx;
+    int dy;
+    uint32_t duration_ms = DEFAULT_TRAJECTORY_MS;
+    uint64_t seed = 0;          // 0 = pick a random seed
+    float curvature = 0.1f;     // max sideways bend, as a fraction of the distance
+    int jitter_px = 1;          // +/- noise on intermediate points (endpoint exact)
+};
+
+struct Trajectory {
+    int count;                              // number of steps used
+    int dx[MAX_TRAJECTORY_STEPS];           // relative move for each step
+    int dy[MAX_TRAJECTORY_STEPS];
+    uint32_t step_us;                       // nominal wait after each step
+    uint32_t duration_us;                   // first step to last step
+    uint64_t seed;                          // seed actually used
+};
+
+// Fills `out` with the path described by `params`.
+void BuildTrajectory(const TrajectoryParams& params, Trajectory& out);
+
+// Wait after step i (0 after the last). step_us rounded so that the waits
+// add up to exactly duration_us: the last step lands on duration_ms.
+uint32_t TrajectoryDelayUs(const Trajectory& path, int i);
@@ -0,0 +1,101 @@
+#include "window_input.h"
+#include "input.h"
+
+#include <algorithm>
+
+// ============================================================================
+// WINDOW-TARGETED INPUT IMPLEMENTATION
+// ============================================================================
+
+namespace {
+    // How long the WM_NULL probe waits for the window to answer.
+    constexpr UINT PROBE_TIMEOUT_MS = 250;
+}
+
+WindowTarget::WindowTarget(HWND hwnd) : hwnd_(hwnd) {
+    RECT client;
+    if (GetClientRect(hwnd_, &client)) {
+        cursor_x_.store((client.right - client.left) / 2, std::memory_order_relaxed);
+        cursor_y_.store((client.bottom - client.top) / 2, std::memory_order_relaxed);
+    }
+    Probe();
+}
+
+bool WindowTarget::Probe() {
+    DWORD_PTR result;
+    const bool alive = IsWindow(hwnd_) &&
+        SendMessageTimeout(hwnd_, WM_NULL, 0, 0, SMTO_ABORTIFHUNG, PROBE_TIMEOUT_MS, &result) != 0;
+    if (!alive) SetFallback(true);
+    return alive;
+}
+
+LPARAM WindowTarget::CursorLParam() const {
+    const POINT p = Cursor();
+    return MAKELPARAM(p.x, p.y);
+}
+
+// Translates one INPUT (as built by BuildInput) into the matching message.
+bool WindowTarget::Post(const INPUT& input) {
+    if (input.type == INPUT_KEYBOARD) {
+        const UINT scan = input.ki.wScan;
+        // BuildInput keeps the caller's VK: mapping the scan code back
+        // would turn an arrow key into its numpad twin.
+        const UINT vk = input.ki.wVk ? input.ki.wVk : MapVirtualKey(scan, MAPVK_VSC_TO_VK);
+        const bool up = (input.ki.dwFlags & KEYEVENTF_KEYUP) != 0;
+        // lParam: repeat count 1, scan code, the extended-key bit (24), and
+        // for key up the "previous state" + "transition" bits.
+        LPARAM lparam = 1 | ((LPARAM)scan << 16);
+        if (input.ki.dwFlags & KEYEVENTF_EXTENDEDKEY) lparam |= (LPARAM)1 << 24;
+        if (up) lparam |= (LPARAM)0xC0000000u;
+        return PostMessage(hwnd_, up ? WM_KEYUP : WM_KEYDOWN, vk, lparam) != 0;
+    }
+
+    const DWORD flags = input.mi.dwFlags;
+    if (flags & MOUSEEVENTF_MOVE) {
+        RECT client;
+        GetClientRect(hwnd_, &client);
+        const POINT p = Cursor();
+        cursor_x_.store(std::clamp<LONG>(p.x + input.mi.dx, 0, std::max<LONG>(0, client.right - 1)), std::memory_order_relaxed);
+        cursor_y_.store(std::clamp<LONG>(p.y + input.mi.dy, 0, std::max<LONG>(0, client.bottom - 1)), std::memory_order_relaxed);
+        return PostMessage(hwnd_, WM_MOUSEMOVE, buttons_, CursorLParam()) != 0;
+    }
+    if (flags & MOUSEEVENTF_WHEEL) {
+        // The wheel message is the odd one out: screen coordinates.
+        POINT screen = Cursor();
+        ClientToScreen(hwnd_, &screen);
+        return PostMessage(hwnd_, WM_MOUSEWHEEL, MAKEWPARAM(buttons_, (WORD)input.mi.mouseData),
+                           MAKELPARAM(screen.x, screen.y)) != 0;
+    }
+
+    UINT msg;
+    if (flags & MOUSEEVENTF_LEFTDOWN)       { msg = WM_LBUTTONDOWN; buttons_ |= MK_LBUTTON; }
+    else if (flags & MOUSEEVENTF_LEFTUP)    { msg = WM_LBUTTONUP;   buttons_ &= ~(WPARAM)MK_LBUTTON; }
+    else if (flags & MOUSEEVENTF_RIGHTDOWN) { msg = WM_RBUTTONDOWN; buttons_ |= MK_RBUTTON; }
+    else if (flags & MOUSEEVENTF_RIGHTUP)   { msg = WM_RBUTTONUP;   buttons_ &= ~(WPARAM)MK_RBUTTON; }
+    else return true;   // nothing to post
+    return PostMessage(hwnd_, msg, buttons_, CursorLParam()) != 0;
+}
+
+void WindowTarget::SendForeground(const INPUT* inputs, int count) {
+    std::lock_guard<std::mutex> lock(GetForegroundInputMutex());
+    if (GetForegroundWindow() != hwnd_) SetForegroundWindow(hwnd_);
+    // Through InjectInput like every other SendInput, so relative moves
+    // reach the cursor cache (and the null sink applies).
+    InjectInput((UINT)count, const_cast<INPUT*>(inputs));
+}
+
+void WindowTarget::Deliver(const INPUT* inputs, int count) {
+    int sent = 0;
+    if (!UsingFallback()) {
+        while (sent < count && Post(inputs[sent])) ++sent;
+        // The first failure switches this window to SendInput for good
+        // (the rest of this batch included), rather than retrying each time.
+        if (sent < count) SetFallback(true);
+    }
+    if (sent < count) SendForeground(inputs + sent, count - sent);
+}
+
+std::mutex& GetForegroundInputMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
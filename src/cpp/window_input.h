@@ -0,0 +1,73 @@
+#pragma once
+
+#include <Windows.h>
+#include <atomic>
+#include <mutex>
+
+// ============================================================================
+// WINDOW-TARGETED INPUT (PostMessage to one HWND)
+// ============================================================================
+//
+// Teacher Note: SendInput injects into the ONE global input stream: whatever
+// window is in the foreground gets the keys, and the mouse moves the real
+// cursor. That means one game per machine, and the env has to keep forcing
+// it to the front. Posting WM_KEYDOWN / WM_MOUSEMOVE / ... straight into a
+// window's message queue instead targets that window only, even when it is
+// in the background - so several game instances can each get their own input.
+//
+// Messages carry what the window would normally receive:
+//   - keys:  VK code in wParam, scan code + repeat/transition bits in lParam
+//   - mouse: a position in CLIENT coordinates. Our events are relative
+//            (dx, dy), so each target keeps a virtual cursor, starting at the
+//            client-area center and clamped to it.
+//
+// Not every game listens to window messages (some poll the keyboard/mouse
+// state directly). A target falls back to SendInput - bringing its window
+// to the front first - when:
+//   - PostMessage fails (window gone, or blocked by UIPI because the game
+//     runs elevated),
+//   - the window doesn't answer a WM_NULL probe (hung / not pumping), or
+//   - the caller says so (SetFallback), e.g. after noticing the game ignores us.
+//
+// Only the first two are detected here. A game that polls GetAsyncKeyState
+// or DirectInput accepts every message and simply never sees it, and posted
+// messages don't touch that state, so there is nothing for us to probe:
+// such games need SetFallback(true) from the start (train.py --sendinput).
+
+class WindowTarget {
+public:
+    explicit WindowTarget(HWND hwnd);
+
+    HWND Handle() const { return hwnd_; }
+
+    // Delivers inputs to the window. Whatever can't be posted goes through
+    // SendInput (with the window in the foreground).
+    void Deliver(const INPUT* inputs, int count);
+
+    // True once input for this window goes through SendInput.
+    bool UsingFallback() const { return fallback_.load(std::memory_order_acquire); }
+    void SetFallback(bool fallback) { fallback_.store(fallback, std::memory_order_release); }
+
+    // Checks the window exists and answers messages; falls back if not.
+    bool Probe();
+
+    // The virtual cursor, in client coordinates (safe from any thread).
+    POINT Cursor() const { return {cursor_x_.load(std::memory_order_relaxed), cursor_y_.load(std::memory_order_relaxed)}; }
+
+private:
+    bool Post(const INPUT& input);               // false if PostMessage failed
+    void SendForeground(const INPUT* inputs, int count);
+    LPARAM CursorLParam() const;
+
+    HWND hwnd_;
+    std::atomic<bool> fallback_{false};
+
+    // Written only by the owning input worker's thread.
+    std::atomic<LONG> cursor_x_{0};              // client coordinates
+    std::atomic<LONG> cursor_y_{0};
+    WPARAM buttons_ = 0;                         // MK_LBUTTON | MK_RBUTTON held
+};
+
+// SendInput + SetForegroundWindow must not interleave between targets that
+// fell back (each would steal the foreground from the other).
+std::mutex& GetForegroundInputMutex();
@@ -0,0 +1,252 @@
+#include "window_tracker.h"
+
+#include <algorithm>
+#include <cwctype>
+
+#include "event_bus.h"
+#include "scheduling.h"
+
+// ============================================================================
+// WINDOW TRACKER IMPLEMENTATION
+// ============================================================================
+
+namespace {
+    // Thread message asking the tracker to hook a process (lParam = pid)
+    constexpr UINT WM_TRACKER_HOOK = WM_APP + 1;
+
+    struct FindContext {
+        std::wstring partial;     // lower case
+        int64_t min_area;
+        std::vector<std::pair<RECT, HWND>> found;
+    };
+
+    std::wstring Lower(std::wstring s) {
+        for (wchar_t& c : s) c = (wchar_t)std::towlower(c);
+        return s;
+    }
+
+    BOOL CALLBACK FindCallback(HWND hwnd, LPARAM lparam) {
+        FindContext* ctx = (FindContext*)lparam;
+        if (!IsWindowVisible(hwnd)) return TRUE;
+        wchar_t title[256];
+        const int len = GetWindowTextW(hwnd, title, 256);
+        if (len <= 0) return TRUE;
+        if (Lower(std::wstring(title, len)).find(ctx->partial) == std::wstring::npos) return TRUE;
+        RECT rect;
+        if (!GetWindowRect(hwnd, &rect)) return TRUE;
+        const int64_t area = (int64_t)(rect.right - rect.left) * (rect.bottom - rect.top);
+        if (area > 0 && area >= ctx->min_area) ctx->found.push_back({rect, hwnd});
+        return TRUE;
+    }
+
+    void CALLBACK WinEventProc(HWINEVENTHOOK, DWORD event, HWND hwnd, LONG id_object,
+                               LONG id_child, DWORD, DWORD) {
+        if (event == EVENT_SYSTEM_FOREGROUND) {
+            GetWindowTracker().OnForeground(hwnd);
+            return;
+        }
+        // Only the window itself, not its caret, scroll bars, ...
+        if (id_object != OBJID_WINDOW || id_child != CHILDID_SELF || !hwnd) return;
+        GetWindowTracker().OnWindowEvent(event, hwnd);
+    }
+
+    void PublishState(HWND hwnd, const WindowState& s) {
+        EventBusPublish(EVENT_WINDOW, 0, (int64_t)(intptr_t)hwnd, s.flags,
+                        s.left, s.top, s.width, s.height);
+    }
+}
+
+std::vector<HWND> FindWindowsByTitle(const std::wstring& partial, int64_t min_area) {
+    FindContext ctx{Lower(partial), min_area, {}};
+    EnumWindows(FindCallback, (LPARAM)&ctx);
+    std::sort(ctx.found.begin(), ctx.found.end(), [](const auto& a, const auto& b) {
+        if (a.first.left != b.first.left) return a.first.left < b.first.left;
+        return a.first.top < b.first.top;
+    });
+    std::vector<HWND> out;
+    for (const auto& f : ctx.found) out.push_back(f.second);
+    return out;
+}
+
+HWND FindLargestWindowByTitle(const std::wstring& partial, int64_t min_area) {
+    FindContext ctx{Lower(partial), min_area, {}};
+    EnumWindows(FindCallback, (LPARAM)&ctx);
+    HWND best = nullptr;
+    int64_t best_area = 0;
+    for (const auto& f : ctx.found) {
+        const int64_t area = (int64_t)(f.first.right - f.first.left) * (f.first.bottom - f.first.top);
+        if (area > best_area) {
+            best_area = area;
+            best = f.second;
+        }
+    }
+    return best;
+}
+
+// Re-reads the window; the rect is kept as-is while it's minimized
+// (Windows parks minimized windows at -32000).
+bool WindowTracker::Refresh(HWND hwnd, WindowState* state) {
+    WindowState next = *state;
+    next.flags &= WINDOW_FOREGROUND;
+    if (IsWindow(hwnd)) {
+        next.flags |= WINDOW_ALIVE;
+        if (IsIconic(hwnd)) {
+            next.flags |= WINDOW_MINIMIZED;
+        } else {
+            RECT rect;
+            if (GetWindowRect(hwnd, &rect)) {
+                next.left = rect.left;
+                next.top = rect.top;
+                next.width = rect.right - rect.left;
+                next.height = rect.bottom - rect.top;
+            }
+        }
+    }
+    if (next.left == state->left && next.top == state->top && next.width == state->width &&
+        next.height == state->height && next.flags == state->flags) {
+        return false;
+    }
+    next.version = state->version + 1;
+    *state = next;
+    return true;
+}
+
+uint64_t WindowTracker::Track(HWND hwnd) {
+    if (!hwnd || !IsWindow(hwnd)) return 0;
+    DWORD pid = 0;
+    GetWindowThreadProcessId(hwnd, &pid);
+
+    uint64_t version;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find_if(windows_.begin(), windows_.end(), [&](const Entry& e) { return e.hwnd == hwnd; });
+        if (it != windows_.end()) {
+            version = it->state.version;
+        } else {
+            Entry entry = {hwnd, {0, 0, 0, 0, 0, 0}};
+            if (GetForegroundWindow() == hwnd) entry.state.flags = WINDOW_FOREGROUND;
+            Refresh(hwnd, &entry.state);      // version 1
+            windows_.push_back(entry);
+            version = entry.state.version;
+        }
+    }
+    // Already hooked processes are skipped by the tracker thread.
+    if (Start()) PostThreadMessageW(thread_id_, WM_TRACKER_HOOK, 0, (LPARAM)pid);
+    return version;
+}
+
+void WindowTracker::Untrack(HWND hwnd) {
+    // The process hook stays: it's cheap, and the window may come back.
+    std::lock_guard<std::mutex> lock(mutex_);
+    windows_.erase(std::remove_if(windows_.begin(), windows_.end(), [&](const Entry& e) { return e.hwnd == hwnd; }),
+                   windows_.end());
+}
+
+bool WindowTracker::Get(HWND hwnd, WindowState* state) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Entry& e : windows_) {
+        if (e.hwnd == hwnd) {
+            *state = e.state;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t WindowTracker::Version(HWND hwnd) const {
+    WindowState state;
+    return Get(hwnd, &state) ? state.version : 0;
+}
+
+void WindowTracker::OnWindowEvent(DWORD event, HWND hwnd) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Entry& e : windows_) {
+        if (e.hwnd != hwnd) continue;
+        bool changed;
+        if (event == EVENT_OBJECT_DESTROY) {
+            changed = (e.state.flags & WINDOW_ALIVE) != 0;
+            e.state.flags &= ~(uint32_t)WINDOW_ALIVE;
+            if (changed) ++e.state.version;
+        } else {
+            changed = Refresh(hwnd, &e.state);
+        }
+        if (changed) PublishState(hwnd, e.state);
+        return;
+    }
+}
+
+void WindowTracker::OnForeground(HWND hwnd) {
+    foreground_.store((intptr_t)hwnd, std::memory_order_release);
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Entry& e : windows_) {
+        const uint32_t flags = e.hwnd == hwnd ? (e.state.flags | WINDOW_FOREGROUND)
+                                              : (e.state.flags & ~(uint32_t)WINDOW_FOREGROUND);
+        if (flags == e.state.flags) continue;
+        e.state.flags = flags;
+        ++e.state.version;
+        PublishState(e.hwnd, e.state);
+    }
+}
+
+bool WindowTracker::Start() {
+    std::unique_lock<std::mutex> lock(start_mutex_);
+    if (thread_.joinable()) return thread_id_ != 0;
+    foreground_.store((intptr_t)GetForegroundWindow(), std::memory_order_release);
+    thread_ = std::thread(&WindowTracker::Run, this);
+    started_cv_.wait(lock, [&] { return thread_id_ != 0; });
+    return true;
+}
+
+void WindowTracker::Stop() {
+    std::lock_guard<std::mutex> lock(start_mutex_);
+    if (!thread_.joinable()) return;
+    PostThreadMessageW(thread_id_, WM_QUIT, 0, 0);
+    thread_.join();
+    thread_id_ = 0;
+}
+
+void WindowTracker::Run() {
+    ScopedNativeThread scheduling(THREAD_WINDOW);
+    // The first Peek creates this thread's message queue; only then can
+    // PostThreadMessage reach it.
+    MSG msg;
+    PeekMessageW(&msg, nullptr, WM_USER, WM_USER, PM_NOREMOVE);
+    const DWORD flags = WINEVENT_OUTOFCONTEXT;
+    HWINEVENTHOOK foreground = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND,
+                                               nullptr, WinEventProc, 0, 0, flags);
+    {
+        std::lock_guard<std::mutex> lock(start_mutex_);
+        thread_id_ = GetCurrentThreadId();
+    }
+    started_cv_.notify_all();
+
+    while (GetMessageW(&msg, nullptr, 0, 0) > 0) {
+        if (msg.message == WM_TRACKER_HOOK) {
+            const DWORD pid = (DWORD)msg.lParam;
+            if (process_hooks_.count(pid)) continue;
+            // DESTROY .. LOCATIONCHANGE also covers show/hide/reorder; the
+            // callback filters to OBJID_WINDOW.
+            process_hooks_[pid] = {
+                SetWinEventHook(EVENT_OBJECT_DESTROY, EVENT_OBJECT_LOCATIONCHANGE,
+                                nullptr, WinEventProc, pid, 0, flags),
+                SetWinEventHook(EVENT_SYSTEM_MINIMIZESTART, EVENT_SYSTEM_MINIMIZEEND,
+                                nullptr, WinEventProc, pid, 0, flags),
+            };
+            continue;
+        }
+        DispatchMessageW(&msg);
+    }
+
+    for (auto& entry : process_hooks_) {
+        for (HWINEVENTHOOK hook : entry.second) {
+            if (hook) UnhookWinEvent(hook);
+        }
+    }
+    process_hooks_.clear();
+    if (foreground) UnhookWinEvent(foreground);
+}
+
+WindowTracker& GetWindowTracker() {
+    static WindowTracker tracker;
+    return tracker;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <Windows.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// WINDOW TRACKER (find the game window once, then let Windows tell us)
+// ============================================================================
+//
+// Teacher Note: Finding "the Stardew window" means walking every top-level
+// window (EnumWindows), and doing that from Python means a Python callback
+// per window - hundreds of them, every time. Worse, once found, nobody
+// noticed when the window moved, so capture kept grabbing the old spot.
+//
+// So the search is native (FindWindowsByTitle, a plain C++ loop) and only
+// happens once. After that the window is *tracked*: a background thread
+// registers SetWinEventHook callbacks and Windows calls us when
+//
+//   - the window moves or is resized      (EVENT_OBJECT_LOCATIONCHANGE)
+//   - it is minimized / restored          (EVENT_SYSTEM_MINIMIZESTART/END)
+//   - it is destroyed                     (EVENT_OBJECT_DESTROY)
+//   - any window comes to the foreground  (EVENT_SYSTEM_FOREGROUND)
+//
+// Each tracked window keeps its rectangle and a version counter bumped on
+// every change, so "did anything change?" is one lookup - no polling.
+//
+// WinEvent hooks are delivered through the installing thread's message
+// queue, which is why the tracker owns a thread with a message loop. The
+// location/destroy hooks are per process (only the game's events reach us);
+// the foreground hook is global, since losing the foreground is announced
+// by the window that gains it.
+
+enum WindowFlags : uint32_t {
+    WINDOW_ALIVE = 1,          // the window still exists
+    WINDOW_MINIMIZED = 2,      // rect is the last one before minimizing
+    WINDOW_FOREGROUND = 4,     // it is the foreground window
+};
+
+struct WindowState {
+    int left;                  // GetWindowRect, screen pixels
+    int top;
+    int width;
+    int height;
+    uint32_t flags;            // WindowFlags
+    uint64_t version;          // bumped on every change (1 = as found)
+};
+
+// Visible top-level windows whose title contains `partial` (any case) and
+// that cover at least min_area pixels, left to right then top to bottom.
+std::vector<HWND> FindWindowsByTitle(const std::wstring& partial, int64_t min_area);
+
+// The largest of them, or null.
+HWND FindLargestWindowByTitle(const std::wstring& partial, int64_t min_area);
+
+class WindowTracker {
+public:
+    ~WindowTracker() { Stop(); }
+
+    // Starts tracking (and the thread, on first use). Returns the state's
+    // version, 0 if hwnd is not a window.
+    uint64_t Track(HWND hwnd);
+    void Untrack(HWND hwnd);
+
+    // False if hwnd isn't tracked.
+    bool Get(HWND hwnd, WindowState* state) const;
+    uint64_t Version(HWND hwnd) const;         // 0 if not tracked
+
+    HWND Foreground() const { return (HWND)foreground_.load(std::memory_order_acquire); }
+
+    void Stop();
+
+    // From the hook callback (tracker thread).
+    void OnWindowEvent(DWORD event, HWND hwnd);
+    void OnForeground(HWND hwnd);
+
+private:
+    struct Entry {
+        HWND hwnd;
+        WindowState state;
+    };
+
+    bool Start();
+    void Run();
+    static bool Refresh(HWND hwnd, WindowState* state);   // true if it changed
+
+    mutable std::mutex mutex_;
+    std::vector<Entry> windows_;
+    std::atomic<intptr_t> foreground_{0};
+
+    std::mutex start_mutex_;                  // Start / Stop
+    std::condition_variable started_cv_;
+    std::thread thread_;
+    DWORD thread_id_ = 0;                     // 0 until its message queue exists
+
+    // Touched only by the tracker thread.
+    std::map<DWORD, std::vector<HWINEVENTHOOK>> process_hooks_;
+};
+
+// Process-wide tracker (WinEvent callbacks carry no user pointer).
+WindowTracker& GetWindowTracker();
@@ -0,0 +1,136 @@
+"""
+Delta Frame Codec - Store Only What Changed
+
+Teacher Note: A raw 224x224x3 observation is 150 KB, so recording every
+step of a session costs tens of GB a day - yet two consecutive Stardew
+frames are mostly the same bytes. The codec XORs a frame with the previous
+one (unchanged bytes become zero) in 64-byte blocks, keeps the blocks that
+changed and counts the runs of blocks that didn't. A keyframe is the same
+thing against an all-zero frame, and decodes on its own.
+
+    packet = encode(frame, prev)     # prev=None: keyframe
+    decode(packet, buf)              # buf holds prev; becomes frame (in place)
+
+The packet format is documented in src/cpp/delta_codec.h. The native codec
+(clib.delta_*, SIMD) runs at memory speed; the numpy version below makes
+(and reads) the same packets, only slower.
+"""
+
+import struct
+from typing import Optional
+
+import numpy as np
+
+try:
+    from . import clib
+    HAS_NATIVE_DELTA = hasattr(clib, "delta_encode")
+except ImportError:
+    clib = None
+    HAS_NATIVE_DELTA = False
+
+# Must match DeltaHeader in src/cpp/delta_codec.h
+BLOCK = 64
+HEADER = struct.Struct("<IIII")     # raw_bytes, flags, literal_blocks, token_count
+KEY = 1
+MAX_RUN = 0xFFFF
+
+
+def _flat(a: np.ndarray) -> np.ndarray:
+    return np.ascontiguousarray(a).reshape(-1).view(np.uint8)
+
+
+def max_encoded_size(raw_bytes: int) -> int:
+    """Largest packet encode() can return for a raw_bytes frame (DeltaMaxEncodedSize)."""
+    return HEADER.size + raw_bytes + BLOCK + (raw_bytes // BLOCK // 2 + 2) * 4
+
+
+def is_key(packet) -> bool:
+    """True if the packet decodes without a previous frame."""
+    return bool(HEADER.unpack_from(packet)[1] & KEY)
+
+
+def _tokens(changed: np.ndarray) -> np.ndarray:
+    """(same, literal) run pairs covering the changed-block mask."""
+    pairs = []
+    if changed.size:
+        starts = np.concatenate(([0], np.flatnonzero(changed[1:] != changed[:-1]) + 1))
+        lengths = np.diff(np.concatenate((starts, [changed.size])))
+        same = 0
+        for kind, length in zip(changed[starts], lengths):
+            length = int(length)
+            if not kind:
+                same = length
+                continue
+            # A full run of same blocks is a token of its own, as in
+            # DeltaEncode - so both make the same bytes.
+            while same >= MAX_RUN:
+                pairs.append((MAX_RUN, 0))
+                same -= MAX_RUN
+            while length > MAX_RUN:
+                pairs.append((same, MAX_RUN))
+                same, length = 0, length - MAX_RUN
+            pairs.append((same, length))
+            same = 0
+        while same > 0:
+            pairs.append((min(same, MAX_RUN), 0))
+            same -= min(same, MAX_RUN)
+    return np.array(pairs, dtype="<u2").reshape(-1, 2)
+
+
+def encode(cur: np.ndarray, prev: Optional[np.ndarray] = None) -> bytes:
+    """
+    Packet for `cur` against `prev` (same size; None for a keyframe).
+    Any shape and dtype - the codec only sees bytes.
+    """
+    if HAS_NATIVE_DELTA:
+        return clib.delta_encode(np.ascontiguousarray(cur),
+                                 None if prev is None else np.ascontiguousarray(prev))
+    cur = _flat(cur)
+    residual = cur if prev is None else cur ^ _flat(prev)
+    blocks = cur.size // BLOCK
+    body = residual[:blocks * BLOCK].reshape(blocks, BLOCK)
+    changed = body.any(axis=1)
+    tokens = _tokens(changed)
+    literal = body[changed]
+    header = HEADER.pack(cur.size, KEY if prev is None else 0, len(literal), len(tokens))
+    return b"".join((header, literal.tobytes(), residual[blocks * BLOCK:].tobytes(), tokens.tobytes()))
+
+
+def decode(packet, dst: np.ndarray) -> np.ndarray:
+    """
+    Applies a packet in place to dst (C-contiguous, holding the previous
+    frame unless the packet is a keyframe) and returns dst.
+    """
+    if not dst.flags.c_contiguous:
+        # reshape would decode into a copy and leave dst untouched
+        raise ValueError("delta decode needs a C-contiguous dst")
+    if HAS_NATIVE_DELTA:
+        clib.delta_decode(packet, dst)
+        return dst
+    raw_bytes, flags, literal_blocks, token_count = HEADER.unpack_from(packet)
+    flat = dst.reshape(-1).view(np.uint8)
+    blocks, tail = divmod(raw_bytes, BLOCK)
+    lit_offset = HEADER.size
+    tail_offset = lit_offset + literal_blocks * BLOCK
+    token_offset = tail_offset + tail
+    if raw_bytes != flat.size or token_offset + token_count * 4 != len(packet):
+        raise ValueError("malformed delta packet (or not for a frame this size)")
+    tokens = np.frombuffer(packet, dtype="<u2", count=2 * token_count,
+                           offset=token_offset).reshape(-1, 2).astype(np.int64)
+    same, lit = tokens[:, 0], tokens[:, 1]
+    if same.sum() + lit.sum() != blocks or lit.sum() != literal_blocks:
+        raise ValueError("malformed delta packet")
+
+    if flags & KEY:
+        flat[:] = 0
+    # Block index of every literal: each run starts after the blocks before it
+    run_start = np.cumsum(same + lit) - lit
+    first_literal = np.cumsum(lit) - lit
+    index = np.repeat(run_start - first_literal, lit) + np.arange(literal_blocks)
+    literals = np.frombuffer(packet, dtype=np.uint8, count=literal_blocks * BLOCK,
+                             offset=lit_offset).reshape(-1, BLOCK)
+    body = flat[:blocks * BLOCK].reshape(blocks, BLOCK)
+    body[index] ^= literals
+    if tail:
+        flat[blocks * BLOCK:] ^= np.frombuffer(packet, dtype=np.uint8, count=tail, offset=tail_offset)
+    return dst
@@ -30,7 +30,8 @@ You CAN use other sizes (like 384x384 for more detail), but:
 - May not improve results much
 """
 
-import time
+from concurrent.futures import ThreadPoolExecutor
+
 import gymnasium as gym
 import numpy as np
 import cv2
@@ -39,6 +40,21 @@ from gymnasium import spaces
 from src.gametrainer.screen import ScreenCapture
 from src.gametrainer.input import InputController
 from src.gametrainer.logger import Logger
+from src.gametrainer.pipeline import StepPipeline
+from src.gametrainer import events, profiler
+
+# Teacher Note: With the C++ extension built, _preprocess_frame uses one fused
+# native pass (resize + BGR->RGB + HWC->CHW, see src/cpp/preprocess.cpp)
+# instead of four numpy/OpenCV passes, and the reward's pixel statistics come
+# from one sweep too (src/cpp/reward.cpp). Without it we fall back to cv2.
+try:
+    import src.gametrainer.clib as clib
+    HAS_NATIVE_PREPROCESS = hasattr(clib, "preprocess_frame")
+    HAS_NATIVE_REWARD = hasattr(clib, "reward_features")
+except ImportError:
+    clib = None
+    HAS_NATIVE_PREPROCESS = False
+    HAS_NATIVE_REWARD = False
 
 
 class StardewViTEnv(gym.Env):
@@ -56,10 +72,34 @@ class StardewViTEnv(gym.Env):
     # The model sees more unique frames this way
     FRAME_SKIP = 2
 
-    def __init__(self, render_mode=None):
+    def __init__(self, render_mode=None, window_title="Stardew Valley", hwnd=None, stream=True,
+                 pipelined=False, replay=None, sendinput=False):
+        """
+        Args:
+            render_mode: gymnasium render mode
+            window_title: game window to capture and send input to
+            hwnd: one specific window (several game instances share a title);
+                  overrides window_title
+            stream: start the background capture stream. StardewVecEnv turns
+                    this off: the stream is process-wide and it captures all
+                    instances at once itself.
+            pipelined: run capture, reward features and preprocessing on the
+                       C++ step pipeline (see step_async); needs the stream.
+            replay: benchmark against a recorded frame file (replay.py)
+                    instead of the game: frames come from the replay, input
+                    goes to the native null sink with its real timing. No
+                    window is needed. Steps are synchronous (the stream and
+                    the pipeline capture the desktop).
+            sendinput: with hwnd, send input through SendInput (focusing the
+                       window) instead of posting messages to it - for games
+                       that read the keyboard state directly and ignore
+                       window messages, which we can't detect.
+        """
         super().__init__()
 
-        self.logger = Logger()
+        # Teacher Note: background=True - the step loop only queues log
+        # lines; a writer thread batches them to disk (see logger.py).
+        self.logger = Logger(background=True)
         self.render_mode = render_mode
 
         # =====================================================================
@@ -107,23 +147,63 @@ class StardewViTEnv(gym.Env):
         # =====================================================================
         # INITIALIZE COMPONENTS
         # =====================================================================
-        self.cap = ScreenCapture()
-        self.input = InputController()
+        # Pipelined steps keep every frame of a step (the "before" frame and
+        # one per repeat) plus the previous step's last one in use at once.
+        self._replay = replay
+        if replay is not None:
+            stream = pipelined = False
+            self.cap = ScreenCapture(backend="replay", replay=replay)
+            self.input = InputController(null_sink=True)
+        else:
+            self.cap = ScreenCapture(buffers=self.FRAME_SKIP + 2 if pipelined else 2)
+            # With a window handle, input is posted to that window only, so
+            # several instances can play at once without fighting over focus.
+            self.input = InputController(hwnd=hwnd)
+            if sendinput:
+                self.input.use_sendinput(True)
         
         # [NEW] Interface Manager for robust UI detection
         from src.gametrainer.interface import InterfaceManager
-        self.interface = InterfaceManager()
+        self.interface = InterfaceManager(logger=self.logger)
 
         # Find game window
-        found = self.cap.set_region_from_window("Stardew Valley")
-        if not found:
-            self.logger.log("WARNING: Stardew Valley window not found!")
-            self.logger.log("  Using full screen capture as fallback.")
-            self.cap.set_region_fullscreen()
+        self._window_title = window_title
+        self._hwnd = hwnd
+        # Event bus source id of this env (see events.py)
+        self._event_source = (hwnd or 0) & 0xFFFFFFFF
+        if replay is not None:
+            self.logger.log(f"REPLAY: {replay} (input -> null sink)")
         else:
-            self._focus_game_window("Stardew Valley")
-            region = self.cap.region
-            self.logger.log(f"WINDOW FOUND: {region['width']}x{region['height']}")
+            if hwnd is not None:
+                found = self.cap.set_region_from_hwnd(hwnd)
+            else:
+                found = self.cap.set_region_from_window(window_title)
+            if not found:
+                self.logger.log(f"WARNING: {window_title} window not found!")
+                self.logger.log("  Using full screen capture as fallback.")
+                self.cap.set_region_fullscreen()
+            else:
+                self._focus_game_window()
+                region = self.cap.region
+                self.logger.log(f"WINDOW FOUND: {region['width']}x{region['height']}")
+
+        # Background capture: frames are picked by timestamp instead of grabbed
+        if stream and self.cap.start_stream():
+            self.logger.log("CAPTURE: DXGI background stream")
+
+        # Step pipeline (step_async/step_wait), and the thread that runs the
+        # UI template scan while the policy works on the next action
+        self._pipeline = StepPipeline(self.cap) if pipelined else None
+        self._step_jobs = None
+        self._scan_executor = None   # started by the first deferred scan
+        self._scan_future = None
+
+        # Where the next observation goes: None = a fresh array each time,
+        # or a (3, 224, 224) uint8 view set by the owner (ShmSubprocVecEnv
+        # points it into shared memory, so nothing is copied afterwards)
+        self.obs_out = None
+        if self._pipeline is not None and self._pipeline.available:
+            self.logger.log("STEP: pipelined (native capture + reward thread)")
 
         # Internal state
         self._steps_alive = 0
@@ -132,6 +212,14 @@ class StardewViTEnv(gym.Env):
         self._prev_energy_pct = None
         self._prev_notification_region = None  # For loot/notification detection
         self._episode_reward = 0.0
+        self._last_features = None  # Last frame's reward features (info["reward_features"])
+        # Native reward extractor keeps its own previous-frame state
+        self._reward_handle = clib.reward_open() if HAS_NATIVE_REWARD else None
+
+        # Change detection: frame_seq of the last frame the reward code and
+        # the UI template scan looked at (see ScreenCapture.changed_since)
+        self._reward_seq = None
+        self._scan_seq = None
 
         # Anti-spam tracking
         # Teacher Note: The agent will exploit any "safe" action that doesn't get
@@ -169,6 +257,11 @@ class StardewViTEnv(gym.Env):
         if frame is None:
             return np.zeros((3, 224, 224), dtype=np.uint8)
 
+        if HAS_NATIVE_PREPROCESS and frame.dtype == np.uint8:
+            obs = self._obs_buffer()
+            clib.preprocess_frame(frame, obs, 224, 224)
+            return obs
+
         # Resize to 224x224
         # Teacher Note: INTER_AREA is best for shrinking (anti-aliased)
         resized = cv2.resize(frame, (224, 224), interpolation=cv2.INTER_AREA)
@@ -181,8 +274,23 @@ class StardewViTEnv(gym.Env):
         # PyTorch/SB3 expects (channels, height, width)
         chw = np.transpose(rgb, (2, 0, 1))
 
+        if self.obs_out is not None:
+            self.obs_out[...] = chw
+            return self.obs_out
         return chw.astype(np.uint8)
 
+    def _obs_buffer(self):
+        """
+        The array the next observation is written into.
+
+        Teacher Note: Without obs_out it's a fresh array each call:
+        observations are kept by SB3's rollout buffer, so reusing one
+        buffer would overwrite earlier steps.
+        """
+        if self.obs_out is not None:
+            return self.obs_out
+        return np.empty((3, 224, 224), dtype=np.uint8)
+
     def step(self, action):
         """
         Execute one environment step.
@@ -194,23 +302,119 @@ class StardewViTEnv(gym.Env):
             truncated: Whether max steps reached
             info: Additional information dict
         """
+        with profiler.span(profiler.ENV_STEP):
+            if self._pipeline_ready():
+                self.step_async(action)
+                return self.step_wait()
+            return self._step_sync(self._clip_action(action))
+
+    def _clip_action(self, action):
         # Validate action: SB3 Discrete(12) yields 0-11; clamp for safety (e.g. loaded model mismatch)
-        action = int(np.clip(action, 0, self.action_space.n - 1))
+        return int(np.clip(action, 0, self.action_space.n - 1))
+
+    def _pipeline_ready(self):
+        """True if this env steps through the native step pipeline."""
+        return (self._pipeline is not None and self._pipeline.available
+                and self._reward_handle is not None)
+
+    def step_async(self, action):
+        """
+        Start a step: send the action (every frame-skip repeat of it) and
+        queue each repeat's capture + reward features on the step pipeline.
+        Returns once the last repeat's action has been sent; step_wait()
+        collects the result.
+
+        Teacher Note: Each repeat still waits for the previous repeat's
+        frame before acting again (that frame is the next "before"), but
+        only for the CAPTURE - its pixel work runs on the pipeline thread
+        while the next action and its 30 ms are under way. Between
+        step_async and step_wait the Python thread is entirely free.
+        Without the pipeline this just remembers the action.
+        """
+        action = self._clip_action(action)
+        self._join_scan()
+        self.cap.follow_window()
+        if not self._pipeline_ready():
+            self._step_jobs = (action, None, None)
+            return
+
+        jobs = []
+        obs = None
+        handles = [self._reward_handle]
+        frame_before = self.cap.latest()
+        for repeat in range(self.FRAME_SKIP):
+            if jobs:
+                # the previous repeat's "after" is this repeat's "before"
+                frame_before = self._pipeline.captured(jobs[-1][0])
+                if frame_before is None:
+                    break   # capture lost; step_wait ends the episode
+
+            self._take_action(action)
+
+            clicked = action in [5, 6] and frame_before is not None
+            energy = self.interface.get_energy_rect(frame_before) if frame_before is not None else None
+            cursor = self._cursor_rect(frame_before) if clicked else None
+            if repeat == self.FRAME_SKIP - 1:
+                obs = self._obs_buffer()[None]   # (1, 3, 224, 224) view
+            job = self._pipeline.submit(self.cap.now_us() + 30_000,
+                                        frame_before if cursor is not None else None,
+                                        obs=obs, reward_handles=handles,
+                                        energy_rects=[energy], cursor_rects=[cursor])
+            jobs.append((job, frame_before is not None))
+        self._step_jobs = (action, jobs, obs)
+
+    def step_wait(self):
+        """Finish the step started by step_async(); same return as step()."""
+        action, jobs, obs = self._step_jobs
+        self._step_jobs = None
+        if jobs is None:
+            return self._step_sync(action)
 
         total_reward = 0.0
         raw_frame = None
+        frame_seq = None
+        lost = len(jobs) < self.FRAME_SKIP
+        for job, has_before in jobs:
+            features = self._pipeline.result(job)
+            if features is None:
+                lost = True
+                break
+            total_reward += self._reward_from_features(features[0], action, has_before)
+            raw_frame, frame_seq = job.frame, job.frame_seq
+        if lost:
+            # Window lost - return empty observation
+            self._pipeline.drain()
+            return np.zeros((3, 224, 224), dtype=np.uint8), 0.0, True, False, {}
+
+        terminated, truncated, info = self._finish_step(raw_frame, action, total_reward,
+                                                        frame_seq, defer_scan=True)
+        return obs[0], total_reward, terminated, truncated, info
+
+    def _join_scan(self):
+        """Wait for a UI scan deferred by _finish_step (if any)."""
+        if self._scan_future is not None:
+            self._scan_future.result()
+            self._scan_future = None
+
+    def _step_sync(self, action):
+        """step() without the pipeline, for a validated action."""
+        total_reward = 0.0
+        raw_frame = None
+        self.cap.follow_window()
 
         # Execute action multiple times (frame skipping)
         for _ in range(self.FRAME_SKIP):
             # Capture state BEFORE action for interaction checking
             # We need this to see if our click actually changed anything
-            frame_before = self.cap.grab()
+            # Teacher Note: from the 2nd repeat on, the previous "after" frame
+            # IS the "before" frame - no need to capture it again.
+            frame_before = raw_frame if raw_frame is not None else self.cap.latest()
 
             self._take_action(action)
-            time.sleep(0.03)  # 30ms between frames
 
-            # Capture state AFTER action
-            raw_frame = self.cap.grab()
+            # Capture state AFTER action: the frame on screen 30ms later
+            # (with a capture stream this is picked from the ring by timestamp)
+            raw_frame = self.cap.at_or_after(self.cap.now_us() + 30_000)
             if raw_frame is None:
                 # Window lost - return empty observation
                 return np.zeros((3, 224, 224), dtype=np.uint8), 0.0, True, False, {}
@@ -220,23 +424,55 @@ class StardewViTEnv(gym.Env):
 
         # Get processed observation
         obs = self._preprocess_frame(raw_frame)
+        terminated, truncated, info = self._finish_step(raw_frame, action, total_reward)
+        return obs, total_reward, terminated, truncated, info
+
+    def _finish_step(self, raw_frame, action, total_reward, frame_seq=None, defer_scan=False):
+        """
+        Per-step bookkeeping after the frame-skip loop: counters, UI scan,
+        logging. Returns (terminated, truncated, info).
+
+        frame_seq: capture sequence number of raw_frame (default: our own
+        capture's). StardewVecEnv passes the shared capture's.
+        defer_scan: run the UI scan on the scan thread and return without
+        waiting for it (the next step_async waits). raw_frame must stay
+        untouched until then.
 
+        Teacher Note: Split out of step() so StardewVecEnv can run it for
+        each instance after computing all their frames/rewards in one batch.
+        """
+        if frame_seq is None:
+            frame_seq = self.cap.frame_seq
         self._steps_alive += 1
         self._episode_reward += total_reward
+        events.publish(events.STEP, self._event_source, self._steps_alive, int(action),
+                       total_reward, self._episode_reward)
 
         # Periodic logging and Interface Scan (once per step, not per frame)
-        if self._steps_alive % 30 == 0:
-            # Scan for UI templates (Energy Icon, etc) every 3 seconds (assuming 10 FPS)
-            self.interface.find_all(raw_frame)
+        # Scan for UI templates (Energy Icon, etc): every step with the native
+        # matcher, else every 3 seconds (assuming 10 FPS). Skipped when the
+        # screen hasn't changed since the last scan.
+        scan_every = 1 if self.interface.has_native_matcher else 30
+        if self._steps_alive % scan_every == 0 and self.cap.changed_since(self._scan_seq):
+            if defer_scan:
+                # Teacher Note: The scan only matters for the NEXT step's
+                # energy box, so it can overlap the policy's forward pass.
+                self._join_scan()
+                if self._scan_executor is None:
+                    self._scan_executor = ThreadPoolExecutor(max_workers=1)
+                self._scan_future = self._scan_executor.submit(
+                    profiler.traced(profiler.UI_SCAN, self.interface.find_all), raw_frame)
+            else:
+                with profiler.span(profiler.UI_SCAN):
+                    self.interface.find_all(raw_frame)
+            self._scan_seq = frame_seq
 
         if self._steps_alive % 100 == 0:
             energy_str = f"{self._prev_energy_pct:.0%}" if self._prev_energy_pct else "?"
-            self.logger.log(
-                f"[STEP {self._steps_alive:5d}] "
-                f"Action: {self._action_names[action]:8s} | "
-                f"Reward: {total_reward:+.3f} | "
-                f"Energy: {energy_str} | "
-                f"Passive: {self._consecutive_passive}"
+            self.logger.event(
+                "[STEP]", "%5d Action: %-8s | Reward: %+.3f | Energy: %s | Passive: %d",
+                self._steps_alive, self._action_names[action], total_reward,
+                energy_str, self._consecutive_passive,
             )
 
         terminated = False
@@ -246,22 +482,35 @@ class StardewViTEnv(gym.Env):
             "step": self._steps_alive,
             "reward": total_reward,
             "episode_reward": self._episode_reward,
+            # (notif, motion, energy, cursor) of the last frame; recorder.py saves them
+            "reward_features": self._last_features,
         }
 
-        return obs, total_reward, terminated, truncated, info
+        return terminated, truncated, info
 
     def _calculate_reward(self, frame, action, frame_before=None):
         """
         Calculate reward based on game state.
         """
+        # All pixel statistics for this frame, in one go
+        features = self._reward_features(frame, action, frame_before)
+        return self._reward_from_features(features, action, frame_before is not None)
+
+    def _reward_from_features(self, features, action, has_before):
+        """
+        The reward for one frame, from its pixel statistics (see
+        _reward_features). has_before: a frame from before the action exists.
+        """
         reward = 0.0
+        self._last_features = features
+        notif_diff, motion_diff, energy_pct, cursor_diff = features
 
         # -----------------------------------------------------------------
         # A. INTERACTION CHECK (Did clicking do anything?)
         # -----------------------------------------------------------------
         # Actions 5 (Left Click) and 6 (Right Click)
-        if action in [5, 6] and frame_before is not None:
-            interact_reward = self._calculate_interaction_reward(frame_before, frame)
+        if action in [5, 6] and has_before:
+            interact_reward = self._calculate_interaction_reward(cursor_diff)
             reward += interact_reward
 
         # -----------------------------------------------------------------
@@ -269,40 +518,21 @@ class StardewViTEnv(gym.Env):
         # -----------------------------------------------------------------
         # Teacher Note: Stardew pops up "+1 Wood" or "Quest Complete" in the 
         # bottom-left. We watch this area for sudden pixel changes.
-        h, w = frame.shape[:2]
-        # Bottom-left 25% area
-        notif_y_start = int(h * 0.7)
-        notif_x_end = int(w * 0.3)
-        notif_region = frame[notif_y_start:h, 0:notif_x_end]
-        
-        # Shrink and grayscale for robust comparison
-        notif_small = cv2.resize(notif_region, (64, 64))
-        notif_gray = cv2.cvtColor(notif_small, cv2.COLOR_BGR2GRAY)
-
-        if self._prev_notification_region is not None:
-            # Check for sudden appearance of text/icons
-            notif_diff = cv2.absdiff(notif_gray, self._prev_notification_region).mean()
-
+        if notif_diff is not None:
             # Threshold raised to 15.0 to reduce false positives from UI animations
             # Only log occasionally to reduce spam (every 500 steps or on big changes)
             if notif_diff > 15.0:
                 reward += 1.0
                 if notif_diff > 30.0 or self._steps_alive % 500 == 0:
-                    self.logger.log(f"[LOOT/NOTIF] Diff: {notif_diff:.1f}")
-
-        self._prev_notification_region = notif_gray.copy()
+                    self.logger.event("[LOOT/NOTIF]", "Diff: %.1f", notif_diff)
 
         # -----------------------------------------------------------------
         # C. MOVEMENT DETECTION
         # -----------------------------------------------------------------
-        # Shrink frame for fast comparison
-        frame_small = cv2.resize(frame, (64, 64))
-        frame_gray = cv2.cvtColor(frame_small, cv2.COLOR_BGR2GRAY)
-
         is_movement_action = action in [1, 2, 3, 4]  # WASD
 
-        if self._prev_frame_small is not None and is_movement_action:
-            diff = cv2.absdiff(frame_gray, self._prev_frame_small).mean()
+        if motion_diff is not None and is_movement_action:
+            diff = motion_diff
 
             if diff < 2.0:  # Very little changed - probably stuck
                 self._stuck_counter += 1
@@ -310,40 +540,29 @@ class StardewViTEnv(gym.Env):
                 reward += penalty
 
                 if self._stuck_counter % 20 == 0:
-                    self.logger.log(
-                        f"[STUCK] Action: {self._action_names[action]} | "
-                        f"Count: {self._stuck_counter} | Diff: {diff:.2f}"
+                    self.logger.event(
+                        "[STUCK]", "Action: %s | Count: %d | Diff: %.2f",
+                        self._action_names[action], self._stuck_counter, diff,
                     )
             else:
                 # Movement detected!
                 if self._stuck_counter > 0:
-                    self.logger.log(
-                        f"[UNSTUCK] After {self._stuck_counter} steps"
-                    )
+                    self.logger.event("[UNSTUCK]", "After %d steps", self._stuck_counter)
                 self._stuck_counter = 0
                 reward += 0.05  # Small reward for successful movement
 
-        self._prev_frame_small = frame_gray.copy()
-
         # -----------------------------------------------------------------
         # D. ENERGY DETECTION (Robust via InterfaceManager)
         # -----------------------------------------------------------------
-        # Use our new Template Matching system to find the bar
-        energy_region = self.interface.get_energy_region(frame)
-
-        if energy_region.size > 0:
-            hsv = cv2.cvtColor(energy_region, cv2.COLOR_BGR2HSV)
-            # Green hue range for energy bar
-            green_mask = cv2.inRange(hsv, (35, 50, 50), (85, 255, 255))
-            energy_pct = green_mask.mean() / 255.0
-
+        if energy_pct is not None:
             if self._prev_energy_pct is not None:
                 energy_change = energy_pct - self._prev_energy_pct
 
                 if energy_change < -0.05:  # Lost significant energy
                     reward -= 0.1
-                    self.logger.log(
-                        f"[ENERGY] Lost: {self._prev_energy_pct:.1%} → {energy_pct:.1%}"
+                    self.logger.event(
+                        "[ENERGY]", "Lost: %.1f%% → %.1f%%",
+                        100 * self._prev_energy_pct, 100 * energy_pct,
                     )
 
             self._prev_energy_pct = energy_pct
@@ -377,13 +596,14 @@ class StardewViTEnv(gym.Env):
 
             # Log when it's getting bad
             if self._consecutive_passive == 10:
-                self.logger.log(f"[PASSIVE] Warning: {self._consecutive_passive} passive actions in a row!")
+                self.logger.event("[PASSIVE]", "Warning: %d passive actions in a row!", self._consecutive_passive)
             elif self._consecutive_passive % 25 == 0 and self._consecutive_passive > 0:
-                self.logger.log(f"[PASSIVE] Critical: {self._consecutive_passive} passive actions! Penalty: {passive_penalty:.2f}")
+                self.logger.event("[PASSIVE]", "Critical: %d passive actions! Penalty: %.2f",
+                                  self._consecutive_passive, passive_penalty)
         else:
             # Active action taken - reset counter
             if self._consecutive_passive > 5:
-                self.logger.log(f"[ACTIVE] Broke passive streak of {self._consecutive_passive}")
+                self.logger.event("[ACTIVE]", "Broke passive streak of %d", self._consecutive_passive)
             self._consecutive_passive = 0
 
         # Track action history for repetition detection (last 10 actions)
@@ -412,31 +632,112 @@ class StardewViTEnv(gym.Env):
         # Logging moved to step() to avoid duplicates from FRAME_SKIP loop
         return reward
 
-    def _calculate_interaction_reward(self, frame_before, frame_after):
+    def _reward_features(self, frame, action, frame_before=None):
         """
-        Check if pixels around the cursor changed after a click.
-        Returns positive reward if changed, small penalty if not.
+        Pixel statistics used by _calculate_reward.
+
+        Returns (notif_diff, motion_diff, energy_pct, cursor_diff); each is
+        None when it can't be computed (no previous frame yet, no click...).
+
+        Teacher Note: With the C++ extension this is ONE pass over the frame
+        (see src/cpp/reward.cpp). The OpenCV version below computes the same
+        numbers with about ten separate calls.
+        """
+        cursor_rect = None
+        if action in [5, 6] and frame_before is not None:
+            cursor_rect = self._cursor_rect(frame_before)
+        energy_rect = self.interface.get_energy_rect(frame)
+
+        # Teacher Note: If the capture layer says nothing changed since the
+        # last reward frame, every diff is 0 and the energy bar reads the
+        # same - no need to look at a single pixel. (frame_before was
+        # captured in between, so it's identical too.)
+        since = self._reward_seq
+        self._reward_seq = self.cap.frame_seq
+        if since is not None and not self.cap.changed_since(since):
+            return 0.0, 0.0, self._prev_energy_pct, 0.0 if cursor_rect is not None else None
+
+        if self._reward_handle is not None and frame.dtype == np.uint8:
+            before = frame_before if cursor_rect is not None else None
+            return clib.reward_features(self._reward_handle, frame, energy_rect, before, cursor_rect)
+        return self._reward_features_cv2(frame, frame_before, energy_rect, cursor_rect, since)
+
+    def _reward_features_cv2(self, frame, frame_before, energy_rect, cursor_rect, since=None):
+        """
+        OpenCV fallback for _reward_features.
+
+        `since` is the frame_seq of the previous reward frame: regions that
+        haven't changed after it keep their previous result.
+        """
+        # Notification area: bottom-left, shrunk and grayscaled for robust comparison
+        notif_rect = self.interface.get_notification_rect(frame)
+        if self._prev_notification_region is not None and not self.cap.changed_since(since, notif_rect):
+            notif_diff = 0.0
+        else:
+            notif_region = self.interface.get_notification_region(frame)
+            notif_small = cv2.resize(notif_region, (64, 64))
+            notif_gray = cv2.cvtColor(notif_small, cv2.COLOR_BGR2GRAY)
+            notif_diff = None
+            if self._prev_notification_region is not None:
+                notif_diff = cv2.absdiff(notif_gray, self._prev_notification_region).mean()
+            self._prev_notification_region = notif_gray.copy()
+
+        # Whole frame, shrunk for fast comparison
+        frame_small = cv2.resize(frame, (64, 64))
+        frame_gray = cv2.cvtColor(frame_small, cv2.COLOR_BGR2GRAY)
+        motion_diff = None
+        if self._prev_frame_small is not None:
+            motion_diff = cv2.absdiff(frame_gray, self._prev_frame_small).mean()
+        self._prev_frame_small = frame_gray.copy()
+
+        # Energy bar: fraction of green pixels
+        energy_pct = None
+        x, y, w, h = energy_rect
+        energy_region = frame[max(0, y):y + h, max(0, x):x + w]
+        if self._prev_energy_pct is not None and not self.cap.changed_since(since, energy_rect):
+            energy_pct = self._prev_energy_pct
+        elif energy_region.size > 0:
+            hsv = cv2.cvtColor(energy_region, cv2.COLOR_BGR2HSV)
+            # Green hue range for energy bar
+            green_mask = cv2.inRange(hsv, (35, 50, 50), (85, 255, 255))
+            energy_pct = green_mask.mean() / 255.0
+
+        # Pixels around the cursor, before vs after the click
+        cursor_diff = None
+        if cursor_rect is not None:
+            x, y, w, h = cursor_rect
+            roi_before = cv2.cvtColor(frame_before[y:y + h, x:x + w], cv2.COLOR_BGR2GRAY)
+            roi_after = cv2.cvtColor(frame[y:y + h, x:x + w], cv2.COLOR_BGR2GRAY)
+            cursor_diff = cv2.absdiff(roi_before, roi_after).mean()
+
+        return notif_diff, motion_diff, energy_pct, cursor_diff
+
+    def _cursor_rect(self, frame):
+        """
+        Box around the mouse cursor in frame coordinates: (x, y, w, h),
+        or None if the cursor is outside the captured window.
         """
         try:
-            import win32gui
-            
-            # 1. Get Global Cursor Pos
-            flags, hcursor, (cx, cy) = win32gui.GetCursorInfo()
+            # 1. Get Global Cursor Pos (or our window's virtual cursor)
+            pos = self.input.cursor_pos()
+            if pos is None:
+                return None
+            cx, cy = pos
             
             # 2. Get Window Region
             region = self.cap.region
             if not region:
-                return 0.0
+                return None
                 
             # 3. Convert to Local Coordinates relative to the frame we captured
-            # Note: frame_before/after are BGR numpy arrays of the captured region
+            # Note: frames are BGR numpy arrays of the captured region
             lx = cx - region["left"]
             ly = cy - region["top"]
             
             # Check bounds
-            h, w = frame_before.shape[:2]
+            h, w = frame.shape[:2]
             if lx < 0 or lx >= w or ly < 0 or ly >= h:
-                return 0.0 # Cursor outside game window
+                return None # Cursor outside game window
                 
             # 4. Define ROI (Region of Interest) around cursor
             # 40x40 box (20px radius)
@@ -445,65 +746,87 @@ class StardewViTEnv(gym.Env):
             y1 = max(0, ly - radius)
             x2 = min(w, lx + radius)
             y2 = min(h, ly + radius)
-            
-            # 5. Extract and Compare
-            # Use Grayscale for simpler comparison
-            roi_before = cv2.cvtColor(frame_before[y1:y2, x1:x2], cv2.COLOR_BGR2GRAY)
-            roi_after = cv2.cvtColor(frame_after[y1:y2, x1:x2], cv2.COLOR_BGR2GRAY)
-            
-            diff = cv2.absdiff(roi_before, roi_after).mean()
-            
-            # 6. Reward Logic
-            # Threshold: How much pixel change constitutes a "hit"?
-            # A swinging tool animation is a large change. A menu button press is a small change.
-            # 5.0 is a conservative threshold (0-255 scale).
-            if diff > 5.0:
-                # Significant change! We hit something or clicked a button.
-                # Log it occasionally so we know it's working
-                if self._steps_alive % 50 == 0:
-                    self.logger.log(f"[INTERACT] Successful click! Diff: {diff:.1f}")
-                return 0.5
-            else:
-                # No change. We clicked on static background or thin air.
-                # Small penalty to discourage spamming clicks on nothing.
-                return -0.05
-                
+            return (x1, y1, x2 - x1, y2 - y1)
+
         except Exception:
-            # Fallback if win32gui fails or other issues
+            # Fallback if the cursor query fails or other issues
+            return None
+
+    def _calculate_interaction_reward(self, cursor_diff):
+        """
+        Did pixels around the cursor change after a click?
+        Returns positive reward if changed, small penalty if not.
+        """
+        if cursor_diff is None:
             return 0.0
 
+        # Threshold: How much pixel change constitutes a "hit"?
+        # A swinging tool animation is a large change. A menu button press is a small change.
+        # 5.0 is a conservative threshold (0-255 scale).
+        if cursor_diff > 5.0:
+            # Significant change! We hit something or clicked a button.
+            # Log it occasionally so we know it's working
+            if self._steps_alive % 50 == 0:
+                self.logger.event("[INTERACT]", "Successful click! Diff: %.1f", cursor_diff)
+            return 0.5
+        else:
+            # No change. We clicked on static background or thin air.
+            # Small penalty to discourage spamming clicks on nothing.
+            return -0.05
+
     def reset(self, seed=None, options=None):
         """Reset environment for new episode."""
         super().reset(seed=seed)
+        self._join_scan()
+        if self._pipeline is not None:
+            self._pipeline.drain()
+            self._step_jobs = None
+        self._reset_state()
 
+        # Grab initial frame
+        frame = self.cap.grab()
+        obs = self._preprocess_frame(frame)
+
+        return obs, {}
+
+    def _reset_state(self):
+        """Forget the episode (counters, previous frames, reward state)."""
         if self._steps_alive > 0:
             self.logger.log(
                 f"\n[EPISODE END] Steps: {self._steps_alive} | "
                 f"Total Reward: {self._episode_reward:.2f}\n"
             )
+            events.publish(events.EPISODE, self._event_source, self._steps_alive, 0,
+                           self._episode_reward)
 
         self._steps_alive = 0
         self._stuck_counter = 0
         self._prev_frame_small = None
         self._prev_energy_pct = None
         self._prev_notification_region = None
+        self._last_features = None
+        if self._reward_handle is not None:
+            clib.reward_reset(self._reward_handle)
+        self._reward_seq = None
         self._episode_reward = 0.0
         self._last_actions = []
         self._consecutive_passive = 0
 
-        # Grab initial frame
-        frame = self.cap.grab()
-        obs = self._preprocess_frame(frame)
-
-        return obs, {}
-
     def _take_action(self, action):
         """Execute the given action."""
         MOUSE_STEP = 30
 
-        # Periodically refocus game window
-        if self._steps_alive % 100 == 0:
-            self._focus_game_window("Stardew Valley")
+        # Refocus the game window (window-targeted input doesn't need it;
+        # its SendInput fallback focuses the window itself). With the native
+        # window tracker "are we still in front?" is one atomic read, so we
+        # check every step and only act when focus was actually lost.
+        if self.input.hwnd is None and self._replay is None:
+            window = self.cap.window
+            if window is not None:
+                if clib.window_foreground() != window:
+                    self._focus_game_window()
+            elif self._steps_alive % 100 == 0:
+                self._focus_game_window()
 
         if action == 0:    # NO-OP
             pass
@@ -530,9 +853,11 @@ class StardewViTEnv(gym.Env):
         elif action == 11: # ESCAPE
             self.input.escape()
 
-    def _focus_game_window(self, title):
+    def _focus_game_window(self, title=None):
         """
         Focus the game window to ensure it receives input.
+        (Our own window if we were given a handle, else the largest one
+        whose title contains `title`, default: the window_title we capture.)
         
         Teacher Note: This is critical but dangerous. If we hang here,
         training stops. We use a safe implementation that tries to find
@@ -544,9 +869,9 @@ class StardewViTEnv(gym.Env):
 
             # Find the largest window with the title (same logic as ScreenCapture)
             # This avoids grabbing tooltips or hidden windows
-            target_hwnd = None
+            target_hwnd = (self._hwnd or self.cap.window) if title is None else None
             max_area = 0
-            partial_lower = title.lower()
+            partial_lower = (title or self._window_title).lower()
 
             def callback(hwnd, _):
                 nonlocal target_hwnd, max_area
@@ -565,7 +890,8 @@ class StardewViTEnv(gym.Env):
                             pass
                 return True
 
-            win32gui.EnumWindows(callback, None)
+            if target_hwnd is None:
+                win32gui.EnumWindows(callback, None)
 
             if target_hwnd:
                 # If it's not the foreground window, try to switch
@@ -592,4 +918,15 @@ class StardewViTEnv(gym.Env):
 
     def close(self):
         """Clean up resources."""
-        pass
+        self._join_scan()
+        if self._scan_executor is not None:
+            self._scan_executor.shutdown()
+        if self._pipeline is not None:
+            self._pipeline.close()
+        self.cap.close()
+        self.interface.close()
+        self.input.close()
+        if self._reward_handle is not None:
+            clib.reward_close(self._reward_handle)
+            self._reward_handle = None
+        self.logger.flush()
@@ -4,8 +4,176 @@ EventBus - Simple event system for component communication
 Teacher Note: This module provides a simple publish/subscribe pattern
 for components to communicate without tight coupling.
 
-Currently a placeholder for future use.
+Publishers (the env step, and natively the capture thread, the input
+worker and the window tracker) post small fixed-size events; subscribers
+(a dashboard, the TUI, a recorder...) poll them whenever they like:
+
+    sub = events.subscribe()
+    ...
+    for e in sub.poll():                       # numpy records, EVENT_DTYPE
+        if e["type"] == events.STEP:
+            print(e["i"][0], e["f"][0])        # step, reward
+
+Nobody ever waits for anybody. The events live in one ring of
+CAPACITY slots (src/cpp/event_bus.h); publishing is a slot claim and a
+64-byte copy, and a subscriber that falls a whole ring behind just loses
+the oldest events - counted in sub.dropped - instead of slowing the
+publisher down. With no subscribers publish() returns right away.
+
+Without the C++ extension the same ring is kept in Python (env events
+only: there are no native threads to publish).
 """
 
-# Placeholder for event bus implementation
-# Will be implemented when needed for GUI/component communication
+import itertools
+import time
+from typing import Optional
+
+import numpy as np
+
+try:
+    from . import clib
+    HAS_NATIVE_BUS = hasattr(clib, "bus_publish")
+except ImportError:
+    clib = None
+    HAS_NATIVE_BUS = False
+
+# Event types (BusEventType in src/cpp/event_bus.h)
+STEP = getattr(clib, "EVENT_STEP", 1)          # i: step, action       f: reward, episode reward
+EPISODE = getattr(clib, "EVENT_EPISODE", 2)    # i: steps              f: total reward
+FRAME = getattr(clib, "EVENT_FRAME", 3)        # i: frame seq, present_us  f: latency us
+INPUT = getattr(clib, "EVENT_INPUT", 4)        # i: events, target hwnd    f: dispatch us
+WINDOW = getattr(clib, "EVENT_WINDOW", 5)      # i: hwnd, flags            f: left, top, width, height
+USER = getattr(clib, "EVENT_USER", 256)        # first id free for scripts
+
+CAPACITY = getattr(clib, "EVENT_BUS_CAPACITY", 4096)
+
+# Must match BusEvent (64 bytes)
+EVENT_DTYPE = np.dtype([
+    ("time_us", "<i8"),
+    ("type", "<u4"),
+    ("source", "<u4"),
+    ("i", "<i8", (2,)),
+    ("f", "<f8", (4,)),
+])
+assert EVENT_DTYPE.itemsize == 64
+
+
+class _PyBus:
+    """
+    The native ring's semantics in Python. next() on an itertools.count is
+    atomic, so each publisher gets its own slot without a lock.
+    """
+
+    def __init__(self, capacity: int):
+        self.capacity = capacity
+        self.slots = [None] * capacity        # (n, record tuple)
+        self._counter = itertools.count()
+        self.head = 0                         # events published (approx. while publishing)
+        self.subscribers = 0
+
+    def publish(self, record: tuple) -> None:
+        n = next(self._counter)
+        self.slots[n % self.capacity] = (n, record)
+        if n >= self.head:
+            self.head = n + 1
+
+    def poll(self, cursor: int, out: np.ndarray):
+        """(count, new cursor, events missed) reading from cursor."""
+        head = self.head
+        missed = 0
+        if head - cursor > self.capacity:
+            missed = head - self.capacity - cursor
+            cursor = head - self.capacity
+        count = 0
+        while cursor < head and count < len(out):
+            slot = self.slots[cursor % self.capacity]
+            if slot is None or slot[0] < cursor:
+                break                          # claimed, not written yet
+            if slot[0] == cursor:
+                out[count] = slot[1]
+                count += 1
+            else:
+                missed += 1                    # overwritten
+            cursor += 1
+        return count, cursor, missed
+
+
+_py_bus = None if HAS_NATIVE_BUS else _PyBus(CAPACITY)
+
+
+def active() -> bool:
+    """True if anyone is subscribed (publishing is free otherwise)."""
+    return clib.bus_active() if HAS_NATIVE_BUS else _py_bus.subscribers > 0
+
+
+def publish(type: int, source: int = 0, i0: int = 0, i1: int = 0,
+            f0: float = 0.0, f1: float = 0.0, f2: float = 0.0, f3: float = 0.0) -> None:
+    """Posts one event. Never blocks; a no-op while nobody is subscribed."""
+    if HAS_NATIVE_BUS:
+        clib.bus_publish(type, source, i0, i1, f0, f1, f2, f3)
+    elif _py_bus.subscribers > 0:
+        _py_bus.publish((time.perf_counter_ns() // 1000, type, source, (i0, i1), (f0, f1, f2, f3)))
+
+
+def published() -> int:
+    """Events published so far."""
+    return clib.bus_published() if HAS_NATIVE_BUS else _py_bus.head
+
+
+class Subscriber:
+    """
+    Reads the events published after it was created, at its own pace.
+    Poll from one thread per subscriber.
+    """
+
+    def __init__(self, max_batch: int = 1024):
+        self._buffer = np.zeros(max_batch, dtype=EVENT_DTYPE)
+        self.dropped = 0
+        if HAS_NATIVE_BUS:
+            self._handle = clib.bus_subscribe()
+        else:
+            self._handle = None
+            self._cursor = _py_bus.head
+            _py_bus.subscribers += 1
+        self._closed = False
+
+    def poll(self, max_events: Optional[int] = None) -> np.ndarray:
+        """
+        Unread events, oldest first (at most max_events, default max_batch).
+        The array is reused by the next poll - copy what you keep.
+        """
+        out = self._buffer if max_events is None else self._buffer[:max_events]
+        if self._closed:
+            return out[:0]
+        if HAS_NATIVE_BUS:
+            count, self.dropped = clib.bus_poll(self._handle, out)
+        else:
+            count, self._cursor, missed = _py_bus.poll(self._cursor, out)
+            self.dropped += missed
+        return out[:count]
+
+    def close(self) -> None:
+        if self._closed:
+            return
+        self._closed = True
+        if HAS_NATIVE_BUS:
+            clib.bus_unsubscribe(self._handle)
+        else:
+            _py_bus.subscribers -= 1
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        try:
+            self.close()
+        except Exception:
+            pass
+
+
+def subscribe(max_batch: int = 1024) -> Subscriber:
+    """A new subscriber, starting at the next event."""
+    return Subscriber(max_batch)
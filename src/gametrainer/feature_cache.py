@@ -0,0 +1,75 @@
+"""
+FeatureCacheRolloutBuffer - Store ViT Features, Not Frames (Frozen Backbone)
+
+Teacher Note: With freeze_backbone=True the ViT never changes during
+training, so it gives the same CLS features for the same frame every time.
+Yet PPO's update phase feeds every stored frame through the full ViT again
+in each of its n_epochs passes - n_epochs identical answers per frame, and
+by far the most expensive part of the update.
+
+This buffer stores the features instead of the frame:
+
+    collect:  frame -> ViT -> features  (the policy does this anyway to act;
+                                         we keep its answer, as float16)
+    update:   features -> policy/value heads   (the ViT is skipped entirely)
+
+    per stored step:  3 x 224 x 224 uint8 = 150 KB  ->  768 float16 = 1.5 KB
+
+ViTFeaturesExtractor passes (batch, features_dim) inputs straight through,
+so SB3's policy code needs no changes. Only valid while the backbone stays
+frozen - attach() refuses otherwise.
+
+Use:
+    model = PPO(..., rollout_buffer_class=FeatureCacheRolloutBuffer,
+                rollout_buffer_kwargs=dict(features_dim=768))
+    model.rollout_buffer.attach(model.policy)
+"""
+
+import numpy as np
+import torch
+from stable_baselines3.common.buffers import RolloutBuffer
+
+
+class FeatureCacheRolloutBuffer(RolloutBuffer):
+    """RolloutBuffer holding float16 backbone features instead of observations."""
+
+    def __init__(self, *args, features_dim: int = 768, **kwargs):
+        """
+        Args:
+            features_dim: output size of the features extractor
+            (everything else as for RolloutBuffer)
+        """
+        self.features_dim = features_dim
+        self.extractor = None
+        super().__init__(*args, **kwargs)
+
+    def attach(self, policy) -> None:
+        """Use `policy`'s (frozen) features extractor to encode observations."""
+        extractor = getattr(policy, "features_extractor", None)
+        if not getattr(extractor, "freeze_backbone", False) or not hasattr(extractor, "cached_features"):
+            raise ValueError("feature caching needs a ViTFeaturesExtractor with freeze_backbone=True")
+        if not getattr(policy, "share_features_extractor", True):
+            raise ValueError("feature caching needs share_features_extractor=True")
+        if getattr(policy, "normalize_images", False):
+            # SB3 would divide the cached features by 255 as if they were pixels
+            raise ValueError("feature caching needs policy_kwargs normalize_images=False")
+        if extractor.features_dim != self.features_dim:
+            raise ValueError(f"extractor outputs {extractor.features_dim} features, "
+                             f"buffer was built for {self.features_dim}")
+        self.extractor = extractor
+        extractor.remember_features = True
+
+    def reset(self) -> None:
+        # One stored "observation" is one feature vector (so RolloutBuffer
+        # never allocates its (buffer_size, n_envs, 3, 224, 224) float32)
+        self.obs_shape = (self.features_dim,)
+        super().reset()
+        self.observations = np.zeros((self.buffer_size, self.n_envs, self.features_dim), dtype=np.float16)
+
+    def add(self, obs: np.ndarray, *args, **kwargs) -> None:
+        if self.extractor is None:
+            raise RuntimeError("FeatureCacheRolloutBuffer.attach(policy) was not called")
+        # The same float tensor the policy saw (normalize_images=False)
+        batch = torch.as_tensor(np.asarray(obs), device=self.device).float()
+        features = self.extractor.cached_features(batch)
+        super().add(features.to(torch.float16).cpu().numpy(), *args, **kwargs)
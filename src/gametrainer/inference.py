@@ -0,0 +1,231 @@
+"""
+Inference Engine - Fast Forward Pass for a Trained ViT Policy
+
+Teacher Note: When the agent only PLAYS, no gradients, optimizer or value
+head are needed - just "frame in, best action out". Eager PyTorch still
+pays for all of its flexibility on every call (Python dispatch per layer,
+float32 everywhere), which on a CPU-only box holds ViT-Base to a few
+actions per second.
+
+So the playing path is exported once and run by an optimized runtime:
+
+    frame (uint8) -> extractor -> policy MLP -> action logits -> argmax
+    \\______________________ one graph, GreedyPolicy _____________________/
+
+Backends, best first (engine="auto" takes the first one that works):
+    onnx     ONNX Runtime. GPU: TensorRT (FP16) or CUDA provider; CPU: the
+             graph with its weights quantized to INT8
+    compile  torch.compile. GPU: FP16 autocast; CPU: INT8 dynamic
+             quantization of the Linear layers
+    eager    plain PyTorch (what model.predict does)
+
+The device comes from hardware.detect_accelerator (CPU if no GPU).
+Exported graphs are cached next to the model (.onnx) and redone when the
+model file is newer.
+
+Use:
+    engine = InferenceEngine(model, model_path, accel.chosen)
+    action, _ = engine.predict(obs)    # same as model.predict(obs, deterministic=True)
+"""
+
+import copy
+import os
+from typing import Optional, Tuple
+
+import numpy as np
+import torch
+import torch.nn as nn
+
+from src.gametrainer import profiler
+
+try:
+    import onnxruntime as ort
+    HAS_ONNXRUNTIME = True
+except ImportError:
+    ort = None
+    HAS_ONNXRUNTIME = False
+
+ENGINES = ("auto", "onnx", "compile", "eager")
+
+
+class GreedyPolicy(nn.Module):
+    """
+    The playing half of an SB3 ActorCriticPolicy with a Discrete action
+    space: uint8 observations -> argmax action (int64).
+    """
+
+    def __init__(self, policy):
+        super().__init__()
+        self.features_extractor = policy.pi_features_extractor
+        self.mlp_extractor = policy.mlp_extractor
+        self.action_net = policy.action_net
+        self.normalize_images = policy.normalize_images
+        # Follows .half()/.float(), so forward() knows the input precision
+        self.register_buffer("dtype_probe", torch.zeros(()), persistent=False)
+
+    def forward(self, observations: torch.Tensor) -> torch.Tensor:
+        # uint8 -> the precision the weights are in (float32, or FP16 exports)
+        x = observations.to(self.dtype_probe.dtype)
+        if self.normalize_images:
+            x = x / 255.0
+        latent_pi = self.mlp_extractor.forward_actor(self.features_extractor(x))
+        return self.action_net(latent_pi).argmax(dim=1)
+
+
+class InferenceEngine:
+    """Runs a trained PPO policy's deterministic forward pass, as fast as this machine allows."""
+
+    def __init__(self, model, model_path: Optional[str] = None, device: str = "cpu",
+                 engine: str = "auto"):
+        """
+        Args:
+            model: the loaded PPO model (only its policy is used)
+            model_path: the .zip it came from (exports are cached beside it;
+                        None = export to a temporary file each time)
+            device: from detect_accelerator ("cuda", "mps" or "cpu")
+            engine: one of ENGINES
+        """
+        if engine not in ENGINES:
+            raise ValueError(f"engine must be one of {ENGINES}")
+        self.device = device
+        self.model_path = model_path
+        self.net = GreedyPolicy(model.policy).to(device).eval()
+        self.obs_shape = tuple(model.observation_space.shape)
+        self._session = None
+        self._runner = None
+
+        order = ["onnx", "compile", "eager"] if engine == "auto" else [engine]
+        self.backend = None
+        for name in order:
+            try:
+                getattr(self, f"_setup_{name}")()
+                self.backend = name
+                break
+            except Exception as e:
+                print(f"  [!] {name} inference unavailable: {e}")
+        if self.backend is None:
+            raise RuntimeError(f"no inference backend could be set up ({engine})")
+        print(f"  Inference engine: {self.describe()}")
+
+    # =========================================================================
+    # Backends
+    # =========================================================================
+
+    def _setup_onnx(self) -> None:
+        if not HAS_ONNXRUNTIME:
+            raise RuntimeError("pip install onnxruntime (or onnxruntime-gpu)")
+        available = ort.get_available_providers()
+        gpu = self.device == "cuda"
+        path = self._export_onnx(half=gpu)
+
+        if gpu and "TensorrtExecutionProvider" in available:
+            providers = [("TensorrtExecutionProvider", {
+                "trt_fp16_enable": True,
+                "trt_engine_cache_enable": True,
+                "trt_engine_cache_path": os.path.dirname(os.path.abspath(path)),
+            }), "CUDAExecutionProvider", "CPUExecutionProvider"]
+        elif gpu and "CUDAExecutionProvider" in available:
+            providers = ["CUDAExecutionProvider", "CPUExecutionProvider"]
+        else:
+            # Teacher Note: INT8 weights are 4x smaller than float32 and use
+            # the CPU's integer dot-product instructions - the biggest win
+            # on the CPU-only play boxes.
+            path = self._quantize_onnx(path)
+            providers = ["CPUExecutionProvider"]
+
+        options = ort.SessionOptions()
+        options.graph_optimization_level = ort.GraphOptimizationLevel.ORT_ENABLE_ALL
+        self._session = ort.InferenceSession(path, options, providers=providers)
+        self._input_name = self._session.get_inputs()[0].name
+        self._onnx_path = path
+
+    def _setup_compile(self) -> None:
+        net = self.net
+        if self.device == "cpu":
+            # Linear layers are nearly all of a ViT's work; quantized
+            # dynamic INT8 matmuls run on CPU only
+            net = torch.ao.quantization.quantize_dynamic(net, {nn.Linear}, dtype=torch.qint8)
+        compiled = torch.compile(net, mode="reduce-overhead" if self.device == "cuda" else "default")
+        half = self.device == "cuda"
+
+        def run(obs: torch.Tensor) -> torch.Tensor:
+            with torch.autocast("cuda", dtype=torch.float16, enabled=half):
+                return compiled(obs)
+
+        self._runner = run
+        # Compile now (first call), not in the middle of the first episode
+        self._runner(torch.zeros((1,) + self.obs_shape, dtype=torch.uint8, device=self.device))
+
+    def _setup_eager(self) -> None:
+        self._runner = self.net
+
+    # =========================================================================
+    # ONNX export
+    # =========================================================================
+
+    def _export_path(self, suffix: str) -> str:
+        if self.model_path is None:
+            import tempfile
+            return os.path.join(tempfile.gettempdir(), f"gametrainer_policy{suffix}")
+        return os.path.splitext(self.model_path)[0] + suffix
+
+    def _fresh(self, path: str, source: Optional[str]) -> bool:
+        """True if `path` exists and is newer than `source`."""
+        if not os.path.exists(path):
+            return False
+        return source is None or not os.path.exists(source) or os.path.getmtime(path) >= os.path.getmtime(source)
+
+    def _export_onnx(self, half: bool) -> str:
+        path = self._export_path(".fp16.onnx" if half else ".onnx")
+        if self.model_path is not None and self._fresh(path, self.model_path):
+            return path
+        print(f"  Exporting policy to ONNX: {path}")
+        # Teacher Note: .half() converts modules in place, and self.net
+        # shares its modules with the caller's model.policy. Halving a copy
+        # keeps the live weights at full precision.
+        net = copy.deepcopy(self.net).half() if half else self.net
+        dummy = torch.zeros((1,) + self.obs_shape, dtype=torch.uint8, device=self.device)
+        torch.onnx.export(
+            net, dummy, path,
+            input_names=["observation"], output_names=["action"],
+            dynamic_axes={"observation": {0: "batch"}, "action": {0: "batch"}},
+            opset_version=17,
+        )
+        return path
+
+    def _quantize_onnx(self, path: str) -> str:
+        from onnxruntime.quantization import QuantType, quantize_dynamic
+        out = os.path.splitext(path)[0] + ".int8.onnx"
+        if not self._fresh(out, path):
+            print(f"  Quantizing to INT8: {out}")
+            quantize_dynamic(path, out, weight_type=QuantType.QInt8)
+        return out
+
+    # =========================================================================
+    # Inference
+    # =========================================================================
+
+    def describe(self) -> str:
+        if self.backend == "onnx":
+            return f"ONNX Runtime ({self._session.get_providers()[0]}, {os.path.basename(self._onnx_path)})"
+        if self.backend == "compile":
+            return f"torch.compile ({'FP16' if self.device == 'cuda' else 'INT8 dynamic' if self.device == 'cpu' else 'FP32'}, {self.device})"
+        return f"eager PyTorch ({self.device})"
+
+    def predict(self, observation: np.ndarray, deterministic: bool = True) -> Tuple[np.ndarray, None]:
+        """
+        Best action for one observation (or a batch of them), like
+        model.predict(observation, deterministic=True).
+        """
+        obs = np.asarray(observation, dtype=np.uint8)
+        single = obs.shape == self.obs_shape
+        if single:
+            obs = obs[None]
+        with profiler.span(profiler.INFERENCE):
+            if self._session is not None:
+                actions = self._session.run(None, {self._input_name: np.ascontiguousarray(obs)})[0]
+            else:
+                with torch.inference_mode():
+                    actions = self._runner(torch.as_tensor(obs, device=self.device)).cpu().numpy()
+        return (actions[0] if single else actions), None
+
@@ -8,12 +8,14 @@ reliable for games than Python libraries like pyautogui.
 
 import time
 import random
-from typing import Tuple
+from typing import Optional, Tuple
 
 # Import our custom C++ "hands" extension (only built at M5; see setup.py).
 try:
     import src.gametrainer.clib as clib
+    HAS_NATIVE_CURSOR = hasattr(clib, "cursor_pos")
 except ImportError:
+    HAS_NATIVE_CURSOR = False
     # No compiled extension found. Expected for M0–M2 (CartPole/GridWorld).
     import warnings
     warnings.warn(
@@ -22,14 +24,52 @@ except ImportError:
         stacklevel=2,
     )
     class MockClib:
-        def send_key(self, code): pass
+        def send_key(self, code, hold_ms=10): pass
         def send_mouse_move(self, x, y): pass
-        def jitter_move(self, x, y): pass
+        def jitter_move(self, x, y, duration_ms=150, seed=0): pass
+        def trajectory(self, x, y, duration_ms=150, seed=0): return [(x, y)], 0, seed
         def send_mouse_click(self): pass
         def send_mouse_right_click(self): pass
+        def send_batch(self, events): return len(events)
+        def post_key(self, code, hold_ms=10, hwnd=0): pass
+        def key_down(self, code, hwnd=0): pass
+        def key_up(self, code, hwnd=0): pass
+        def hold_key(self, code, hold_ms, hwnd=0): pass
+        def hold_keys(self, codes, hold_ms, hwnd=0): pass
+        def release_all(self, hwnd=0): pass
+        def post_mouse_click(self, hold_ms=10, hwnd=0): pass
+        def post_mouse_right_click(self, hold_ms=10, hwnd=0): pass
+        def post_jitter_move(self, x, y, duration_ms=150, seed=0, hwnd=0): pass
+        def post_batch(self, events, delay_ms=0, hwnd=0): pass
+        def flush(self, hwnd=0): pass
+        def wait(self, timeout_ms=-1, hwnd=0): return True
+        def pending(self, hwnd=0): return 0
+        def dropped_holds(self, hwnd=0): return 0
+        def window_input_mode(self, hwnd, probe=False): return "window"
+        def window_input_fallback(self, hwnd, enabled): pass
+        def window_input_cursor(self, hwnd, screen=False): return None
+        def window_input_close(self, hwnd): pass
+        def set_precise_timing(self, enabled, spin_us=500): pass
+        def precise_timing(self): return False
+        def precise_sleep(self, us): time.sleep(us / 1e6); return float(us)
+        def timer_stats(self): return {}
+        def reset_timer_stats(self): pass
+        def input_null_sink(self, enabled): pass
+        def input_null_sink_events(self): return 0
     clib = MockClib()
 
 
+# Event types for InputController.send_batch (must match BatchEventType in clib.cpp).
+EVENT_KEY_DOWN = 0     # (EVENT_KEY_DOWN, vk)
+EVENT_KEY_UP = 1       # (EVENT_KEY_UP, vk)
+EVENT_MOUSE_MOVE = 2   # (EVENT_MOUSE_MOVE, dx, dy)
+EVENT_MOUSE_WHEEL = 3  # (EVENT_MOUSE_WHEEL, delta) - 120 = one notch
+EVENT_LEFT_DOWN = 4
+EVENT_LEFT_UP = 5
+EVENT_RIGHT_DOWN = 6
+EVENT_RIGHT_UP = 7
+
+
 class InputController:
     """
     High-level interface for game input.
@@ -49,19 +89,215 @@ class InputController:
     VK_E = 0x45  # Menu
     VK_ESC = 0x1B
 
-    def __init__(self):
-        pass
+    def __init__(self, batch_taps: bool = False, async_input: bool = False,
+                 precise_timing: bool = False, hwnd: Optional[int] = None,
+                 null_sink: bool = False):
+        """
+        Args:
+            batch_taps: If True, taps and clicks send down+up together in one
+                        send_batch call (no hold). Faster, but only use it for
+                        games that don't need to see the key held for a frame.
+            async_input: If True, taps and clicks are queued on the C++ input
+                         thread and return immediately. Call flush() when you
+                         need them to have actually happened.
+            precise_timing: If True, switch the C++ extension (process-wide) to
+                            high-resolution timers for every hold and step
+                            delay. See timer_stats() to check the precision.
+            hwnd: Send input to this window only (PostMessage, works in the
+                  background) instead of the foreground window. See
+                  input_mode for whether the game actually accepts it.
+            null_sink: If True, switch the C++ extension (process-wide) to
+                       swallowing every event instead of sending it. Holds,
+                       sleeps and the input thread's timing stay exactly the
+                       same - for benchmarks against a replay (replay.py).
+
+        Teacher Note on async_input: A key tap holds the key for 10 ms.
+        In blocking mode Python waits out that hold; in async mode the
+        native worker thread waits instead, and Python can capture the
+        screen or run the network in the meantime.
+        """
+        self.batch_taps = batch_taps
+        self.async_input = async_input
+        self.hwnd = hwnd
+        # 0 = the global (SendInput) worker; anything else is that window's own
+        self._target = hwnd or 0
+        if precise_timing:
+            clib.set_precise_timing(True)
+        if null_sink:
+            clib.input_null_sink(True)
+
+    @property
+    def _queued(self) -> bool:
+        """Window input always goes through that window's input thread."""
+        return self.async_input or self.hwnd is not None
+
+    def _settle(self):
+        """Blocking mode on a window: wait until its queued input went out."""
+        if self.hwnd is not None and not self.async_input:
+            clib.flush(self._target)
+
+    @property
+    def input_mode(self) -> str:
+        """
+        "window" while input is posted to our window, "sendinput" when it
+        goes to the foreground window (no hwnd, or the window rejected
+        messages and the C++ side fell back).
+        """
+        if self.hwnd is None:
+            return "sendinput"
+        return clib.window_input_mode(self._target)
+
+    def use_sendinput(self, enabled: bool = True):
+        """
+        Force (or stop forcing) the SendInput fallback for our window.
+
+        Teacher Note: A window can accept every message and still ignore
+        them, because some games read the keyboard state directly. Messages
+        can't tell us that - if the agent's actions have no effect, call this.
+        """
+        if self.hwnd is not None:
+            clib.window_input_fallback(self._target, enabled)
+
+    def cursor_pos(self):
+        """
+        Mouse cursor in screen coordinates: the real one, or with an hwnd
+        our window's virtual cursor. None if unknown.
+
+        Teacher Note: With the extension this never leaves C++: the real
+        cursor comes from the input engine's cache (our own moves added to
+        the last GetCursorPos, see input.h), so a click step costs no
+        pywin32 call.
+        """
+        if HAS_NATIVE_CURSOR:
+            if self.hwnd is not None and self.input_mode == "window":
+                return clib.window_input_cursor(self._target, True)
+            return clib.cursor_pos()
+        try:
+            import win32gui
+            if self.hwnd is not None and self.input_mode == "window":
+                pos = clib.window_input_cursor(self._target)
+                return None if pos is None else win32gui.ClientToScreen(self.hwnd, pos)
+            flags, hcursor, pos = win32gui.GetCursorInfo()
+            return pos
+        except Exception:
+            return None
+
+    def close(self):
+        """Release held input and stop our window's input thread."""
+        if self.hwnd is not None:
+            clib.window_input_close(self._target)
 
     def tap_key(self, key_code: int, duration: float = 0.1):
         """
-        Press and release a key.
+        Press and release a key, holding it for `duration` seconds.
         Time complexity: O(1) - single system call.
+
+        (batch_taps mode ignores duration: down and up go out together.)
         """
+        if self.batch_taps:
+            self.send_batch([(EVENT_KEY_DOWN, key_code), (EVENT_KEY_UP, key_code)])
+            return
+        hold_ms = int(duration * 1000)
         try:
-            clib.send_key(key_code)
+            if self._queued:
+                clib.post_key(key_code, hold_ms, self._target)
+                self._settle()
+            else:
+                clib.send_key(key_code, hold_ms)
         except Exception as e:
             print(f"ERROR: Failed to send key {key_code}: {e}")
 
+    def timer_stats(self) -> dict:
+        """
+        Requested vs. measured input delays, in microseconds.
+
+        Teacher Note: Windows' default sleep rounds up to ~15.6 ms, so a
+        "10 ms" hold really lasts longer. Compare mean_requested_us with
+        mean_actual_us to see how far off we are - and how much precise
+        timing helps.
+        """
+        return clib.timer_stats()
+
+    def key_down(self, key_code: int):
+        """Press a key and leave it down until key_up() or release_all()."""
+        clib.key_down(key_code, self._target)
+
+    def key_up(self, key_code: int):
+        """Release a key pressed with key_down() or hold_key()."""
+        clib.key_up(key_code, self._target)
+
+    def hold_key(self, key_code: int, duration: float):
+        """
+        Press a key now and let the C++ input thread release it after
+        `duration` seconds. Returns immediately.
+
+        Teacher Note: Calling hold_key again on a key that is still held
+        just pushes its release later - that's how a movement key stays
+        down across several frame-skip iterations with no Python sleeps.
+
+        duration must be at least 1 ms (ValueError otherwise): a hold with
+        no release time would leave the key down.
+        """
+        clib.hold_key(key_code, int(duration * 1000), self._target)
+
+    def hold_keys(self, key_codes, duration: float):
+        """
+        Hold several keys at once (e.g. [VK_W, VK_D] to walk diagonally).
+        All presses go out in one SendInput call. Same duration rule as
+        hold_key().
+        """
+        clib.hold_keys(list(key_codes), int(duration * 1000), self._target)
+
+    def release_all(self):
+        """Release every key/button the input thread is holding."""
+        clib.release_all(self._target)
+
+    def send_batch(self, events) -> int:
+        """
+        Send several input events with ONE SendInput call.
+
+        Args:
+            events: Sequence of (type, a, b) tuples using the EVENT_* constants,
+                    e.g. [(EVENT_MOUSE_MOVE, 30, 0), (EVENT_LEFT_DOWN,), (EVENT_LEFT_UP,)]
+
+        Returns:
+            Number of events Windows accepted (0 on failure).
+
+        Teacher Note: Each system call into the kernel has a fixed cost.
+        Batching a whole action means we pay that cost once per action.
+        """
+        try:
+            if self.hwnd is not None:
+                clib.post_batch(events, 0, self._target)
+                self._settle()
+                return len(events)
+            return clib.send_batch(events)
+        except Exception as e:
+            print(f"ERROR: Failed to send input batch: {e}")
+            return 0
+
+    def flush(self):
+        """
+        Block until every queued (async) input event has been sent.
+        Cheap no-op when nothing is queued.
+        """
+        clib.flush(self._target)
+
+    def wait(self, timeout: float) -> bool:
+        """
+        Like flush(), but give up after `timeout` seconds.
+        Returns True if the queue drained in time.
+        """
+        return clib.wait(int(timeout * 1000), self._target)
+
+    def dropped_holds(self) -> int:
+        """
+        Holds the input thread dropped because too many keys were already
+        held (16). Should stay 0; if it grows, something holds keys without
+        letting them go.
+        """
+        return clib.dropped_holds(self._target)
+
     # Movement keys
     def move_up(self): self.tap_key(self.VK_W)
     def move_down(self): self.tap_key(self.VK_S)
@@ -79,15 +315,47 @@ class InputController:
         Move mouse relative to current position.
         Time complexity: O(1) - single system call.
         """
+        if self.hwnd is not None:
+            self.send_batch([(EVENT_MOUSE_MOVE, dx, dy)])
+            return
         clib.send_mouse_move(dx, dy)
 
+    def mouse_glide(self, dx: int, dy: int, duration: float = 0.15, seed: int = 0):
+        """
+        Move the mouse along a humanized curve (Bezier path, minimum-jerk timing).
+
+        Args:
+            dx, dy: Total relative move in pixels (the path ends exactly there)
+            duration: How long the move takes, in seconds
+            seed: Same seed = same path (0 = random)
+
+        In async_input mode this returns immediately and the C++ input
+        thread plays the path back; otherwise it blocks for `duration`.
+        """
+        duration_ms = int(duration * 1000)
+        try:
+            if self._queued:
+                clib.post_jitter_move(dx, dy, duration_ms, seed, self._target)
+                self._settle()
+            else:
+                clib.jitter_move(dx, dy, duration_ms, seed)
+        except Exception as e:
+            print(f"ERROR: Failed to glide mouse: {e}")
+
     def mouse_click(self):
         """
         Send a left mouse button click.
         Time complexity: O(1) - single system call.
         """
+        if self.batch_taps:
+            self.send_batch([(EVENT_LEFT_DOWN,), (EVENT_LEFT_UP,)])
+            return
         try:
-            clib.send_mouse_click()
+            if self._queued:
+                clib.post_mouse_click(10, self._target)
+                self._settle()
+            else:
+                clib.send_mouse_click()
         except Exception as e:
             print(f"ERROR: Failed to send mouse click: {e}")
 
@@ -96,8 +364,15 @@ class InputController:
         Send a right mouse button click.
         Time complexity: O(1) - single system call.
         """
+        if self.batch_taps:
+            self.send_batch([(EVENT_RIGHT_DOWN,), (EVENT_RIGHT_UP,)])
+            return
         try:
-            clib.send_mouse_right_click()
+            if self._queued:
+                clib.post_mouse_right_click(10, self._target)
+                self._settle()
+            else:
+                clib.send_mouse_right_click()
         except Exception as e:
             print(f"ERROR: Failed to send right mouse click: {e}")
 
@@ -114,6 +389,12 @@ class NullInput(InputController):
         """No-op key press."""
         pass
 
+    def key_down(self, key_code: int): pass
+    def key_up(self, key_code: int): pass
+    def hold_key(self, key_code: int, duration: float): pass
+    def hold_keys(self, key_codes, duration: float): pass
+    def release_all(self): pass
+
     def move_up(self): pass
     def move_down(self): pass
     def move_left(self): pass
@@ -127,6 +408,10 @@ class NullInput(InputController):
         """No-op mouse move."""
         pass
 
+    def mouse_glide(self, dx: int, dy: int, duration: float = 0.15, seed: int = 0):
+        """No-op humanized mouse move."""
+        pass
+
     def mouse_click(self):
         """No-op left mouse click."""
         pass
@@ -134,3 +419,18 @@ class NullInput(InputController):
     def mouse_right_click(self):
         """No-op right mouse click."""
         pass
+
+    def send_batch(self, events) -> int:
+        """No-op batch; reports every event as sent."""
+        return len(events)
+
+    def flush(self):
+        """Nothing is ever queued."""
+        pass
+
+    def wait(self, timeout: float) -> bool:
+        """Nothing is ever queued."""
+        return True
+
+    def use_sendinput(self, enabled: bool = True): pass
+    def close(self): pass
@@ -3,6 +3,21 @@ import numpy as np
 import os
 from typing import Optional, Tuple, Dict
 
+# Teacher Note: With the C++ extension built, find_all uses a coarse-to-fine
+# matcher (src/cpp/template_match.cpp) that searches near each template's last
+# location first. It's cheap enough to run every step.
+try:
+    import src.gametrainer.clib as clib
+    HAS_NATIVE_MATCHER = hasattr(clib, "matcher_find_all")
+except ImportError:
+    clib = None
+    HAS_NATIVE_MATCHER = False
+
+# Match threshold: 0.8 means 80% match
+MATCH_THRESHOLD = 0.8
+# Native matcher: how far (px) around the last location to look first
+SEARCH_MARGIN = 32
+
 class InterfaceManager:
     """
     Handles detection of UI elements using Template Matching.
@@ -12,10 +27,17 @@ class InterfaceManager:
     and find where it actually is.
     """
     
-    def __init__(self, template_dir: str = "src/gametrainer/templates"):
+    def __init__(self, template_dir: str = "src/gametrainer/templates", logger=None):
         self.template_dir = template_dir
+        # A Logger (see logger.py) keeps scan messages off the step loop;
+        # without one they go to stdout
+        self._logger = logger
         self.templates: Dict[str, np.ndarray] = {}
         self.locations: Dict[str, Tuple[int, int, int, int]] = {}
+
+        # Native matcher handle; template ids are positions in _template_names
+        self._matcher = clib.matcher_open() if HAS_NATIVE_MATCHER else None
+        self._template_names = []
         
         # Load all templates on startup
         self._load_templates()
@@ -23,7 +45,7 @@ class InterfaceManager:
     def _load_templates(self):
         """Load all .png files from the template directory."""
         if not os.path.exists(self.template_dir):
-            print(f"[INTERFACE] Warning: Template directory not found: {self.template_dir}")
+            self._log("Warning: Template directory not found: %s", self.template_dir)
             return
 
         for f in os.listdir(self.template_dir):
@@ -34,18 +56,34 @@ class InterfaceManager:
                 if img is not None:
                     name = f.replace(".png", "")
                     self.templates[name] = img
-                    print(f"[INTERFACE] Loaded template: {name} ({img.shape})")
+                    if self._matcher is not None:
+                        # Precomputes the downsampled copy and sums once
+                        clib.matcher_add(self._matcher, img)
+                        self._template_names.append(name)
+                    self._log("Loaded template: %s (%s)", name, img.shape)
                 else:
-                    print(f"[INTERFACE] Failed to load: {path}")
+                    self._log("Failed to load: %s", path)
 
     def find_all(self, frame_bgr: np.ndarray) -> None:
         """
         Scan the frame for all loaded templates and update locations.
-        Call this periodically (e.g. once per second), not every frame.
+        With the native matcher this is cheap enough for every frame;
+        otherwise call it periodically (e.g. once per second).
         """
         if not self.templates:
             return
 
+        if self._matcher is not None:
+            hints = [self.locations[name][:2] if name in self.locations else None
+                     for name in self._template_names]
+            results = clib.matcher_find_all(self._matcher, frame_bgr, hints,
+                                            MATCH_THRESHOLD, SEARCH_MARGIN)
+            for name, (score, x, y) in zip(self._template_names, results):
+                if score >= MATCH_THRESHOLD:
+                    h, w = self.templates[name].shape
+                    self._set_location(name, (x, y, w, h))
+            return
+
         gray = cv2.cvtColor(frame_bgr, cv2.COLOR_BGR2GRAY)
         
         for name, template in self.templates.items():
@@ -54,15 +92,39 @@ class InterfaceManager:
             min_val, max_val, min_loc, max_loc = cv2.minMaxLoc(res)
             
             # Threshold: 0.8 means 80% match
-            if max_val >= 0.8:
+            if max_val >= MATCH_THRESHOLD:
                 h, w = template.shape
                 x, y = max_loc
-                self.locations[name] = (x, y, w, h)
-                print(f"[INTERFACE] Found {name} at ({x}, {y})")
+                self._set_location(name, (x, y, w, h))
 
-    def get_energy_region(self, frame_bgr: np.ndarray) -> Optional[np.ndarray]:
+    def _set_location(self, name: str, location: Tuple[int, int, int, int]) -> None:
+        """Store a template location; only announce it when it moved."""
+        if self.locations.get(name) != location:
+            x, y = location[:2]
+            self._log("Found %s at (%d, %d)", name, x, y)
+        self.locations[name] = location
+
+    def _log(self, fmt: str, *args) -> None:
+        if self._logger is not None:
+            self._logger.event("[INTERFACE]", fmt, *args)
+        else:
+            print("[INTERFACE] " + fmt % args)
+
+    @property
+    def has_native_matcher(self) -> bool:
+        """True if find_all uses the fast C++ matcher."""
+        return self._matcher is not None
+
+    def close(self) -> None:
+        """Free the native matcher."""
+        if self._matcher is not None:
+            clib.matcher_close(self._matcher)
+            self._matcher = None
+
+    def get_energy_rect(self, frame_bgr: np.ndarray) -> Tuple[int, int, int, int]:
         """
-        Return the cropped energy bar region based on the 'energy_icon' location.
+        Return the energy bar rectangle (x, y, w, h) based on the 'energy_icon'
+        location. It may extend past the frame edge; crop with get_energy_region.
         """
         # 1. Try to find dynamic location
         if "energy_icon" in self.locations:
@@ -83,18 +145,34 @@ class InterfaceManager:
             roi_x = max(0, x - 10) # Roughly aligned with icon
             roi_y = max(0, y - bar_h) 
             
-            return frame_bgr[roi_y:y, roi_x:roi_x+bar_w]
+            return (roi_x, roi_y, bar_w, y - roi_y)
             
         # 2. Fallback to hardcoded (Logic derived from env_vit.py)
         h, w = frame_bgr.shape[:2]
         # env_vit.py used: frame[int(h*0.75):h, int(w*0.9):w]
-        return frame_bgr[int(h*0.75):h, int(w*0.9):w]
+        x0, y0 = int(w*0.9), int(h*0.75)
+        return (x0, y0, w - x0, h - y0)
 
-    def get_notification_region(self, frame_bgr: np.ndarray) -> np.ndarray:
+    def get_energy_region(self, frame_bgr: np.ndarray) -> Optional[np.ndarray]:
         """
-        Return the notification area (bottom-left).
+        Return the cropped energy bar region based on the 'energy_icon' location.
+        """
+        x, y, w, h = self.get_energy_rect(frame_bgr)
+        return frame_bgr[y:y+h, x:x+w]
+
+    def get_notification_rect(self, frame_bgr: np.ndarray) -> Tuple[int, int, int, int]:
+        """
+        Return the notification area (bottom-left) as (x, y, w, h).
         Since this is usually fixed to screen corners, hardcoding is safer
         unless we have a specific anchor template.
         """
         h, w = frame_bgr.shape[:2]
-        return frame_bgr[int(h*0.7):h, 0:int(w*0.3)]
+        y0 = int(h*0.7)
+        return (0, y0, int(w*0.3), h - y0)
+
+    def get_notification_region(self, frame_bgr: np.ndarray) -> np.ndarray:
+        """
+        Return the notification area (bottom-left).
+        """
+        x, y, w, h = self.get_notification_rect(frame_bgr)
+        return frame_bgr[y:y+h, x:x+w]
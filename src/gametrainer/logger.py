@@ -5,49 +5,302 @@ Teacher Note: This module creates timestamped log files for each training sessio
 This helps you understand what the agent was "thinking" and debug issues.
 
 All logs are saved to the logs/ directory with timestamps.
+
+With background=True the env's step loop never waits on the disk: log()
+only appends a record to a queue, and a writer thread formats, batches and
+writes them (one write + flush per batch, every flush_interval seconds).
+Two things keep a busy loop from flooding the file:
+
+    - Rate limit: at most max_per_second lines per tag ("[STUCK]", ...)
+      per second; the rest are counted and the count is appended to the
+      next line that gets through.
+    - Dedupe: a line identical to the previous one is folded into
+      "(last message repeated Nx)".
+
+For high-rate messages use event(): the arguments are stored and only
+formatted on the writer thread (and not at all if the line is dropped).
+
+    logger.event("[STUCK]", "Count: %d | Diff: %.2f", count, diff)
 """
 
-import logging
+import atexit
 import os
+import threading
+import time
+from collections import deque
 from datetime import datetime
+from typing import Callable, Dict, List, Optional
 
 
-class Logger:
+class _SessionWriter:
     """
-    Creates timestamped session logs for training analysis.
+    One session file and the thread that writes it. Every Logger with the
+    same log_dir shares it (vectorized envs log into one file).
 
-    Usage:
-        logger = Logger()
-        logger.log("Agent started training")
-        logger.log("Reward: +1.0 for picking up item")
+    Teacher Note: deque.append and popleft are atomic, so any number of
+    threads can log without taking a lock - a multi-producer,
+    single-consumer queue for free.
     """
 
-    def __init__(self, log_dir="logs"):
+    def __init__(self, log_dir: str, flush_interval: float):
         os.makedirs(log_dir, exist_ok=True)
         timestamp = datetime.now().strftime("%Y-%m-%d_%H-%M-%S")
-        log_file = os.path.join(log_dir, f"session_{timestamp}.log")
+        self.path = os.path.join(log_dir, f"session_{timestamp}.log")
+        self._file = open(self.path, "a", encoding="utf-8")
+        self._flush_interval = flush_interval
+
+        # (time, text), (time, tag, fmt, args, suppressed) or a flush() marker
+        self._queue = deque()
+        self._wake = threading.Event()
+        self._lock = threading.Lock()        # one batch at a time on the file
+        self._callbacks: List[tuple] = []    # (callback, batched)
+        self._last_text = None
+        self._repeats = 0
+        self._thread = None
+        self._closed = False
+
+    # --- producer side ---------------------------------------------------
+
+    def put(self, record: tuple, background: bool) -> None:
+        if not background:
+            self._write([record])
+            return
+        self._queue.append(record)
+        if self._thread is None:
+            self._start()
+
+    def _start(self) -> None:
+        with self._lock:
+            if self._thread is None and not self._closed:
+                self._thread = threading.Thread(target=self._run, name="GameTrainerLog", daemon=True)
+                self._thread.start()
+
+    # --- consumer side ---------------------------------------------------
+
+    def _run(self) -> None:
+        while not self._closed:
+            self._wake.wait(self._flush_interval)
+            self._wake.clear()
+            self._drain()
+
+    def _drain(self) -> None:
+        batch = []
+        try:
+            while True:
+                batch.append(self._queue.popleft())
+        except IndexError:
+            pass
+        if batch:
+            self._write(batch)
+
+    def _write(self, batch: List[tuple]) -> None:
+        done = []
+        with self._lock:
+            if self._closed:
+                return
+            lines = []
+            for record in batch:
+                if isinstance(record, threading.Event):
+                    done.append(record)     # a flush() marker
+                    continue
+                text = record[1] if len(record) == 2 else self._format(record)
+                if text == self._last_text:
+                    self._repeats += 1
+                    continue
+                self._flush_repeats(lines)
+                self._last_text = text
+                lines.append(self._stamp(record[0], text))
+            self._emit(lines)
+        for marker in done:
+            marker.set()
+
+    @staticmethod
+    def _format(record: tuple) -> str:
+        _, tag, fmt, args, suppressed = record
+        try:
+            text = f"{tag} {fmt % args}" if args else f"{tag} {fmt}"
+        except (TypeError, ValueError) as e:
+            text = f"{tag} {fmt} {args!r} (bad format: {e})"
+        if suppressed:
+            text += f" (+{suppressed} suppressed)"
+        return text
+
+    @staticmethod
+    def _stamp(t: float, text: str) -> str:
+        return f"[{time.strftime('%H:%M:%S', time.localtime(t))}] {text}"
+
+    def _flush_repeats(self, lines: List[str]) -> None:
+        if self._repeats:
+            lines.append(self._stamp(time.time(), f"(last message repeated {self._repeats}x)"))
+            self._repeats = 0
+
+    def _emit(self, lines: List[str]) -> None:
+        if not lines:
+            return
+        self._file.write("\n".join(lines) + "\n")
+        self._file.flush()
+        for callback, batched in self._callbacks:
+            try:
+                if batched:
+                    callback(lines)
+                else:
+                    for line in lines:
+                        callback(line)
+            except Exception:
+                pass  # a broken GUI must not stop the log
+
+    def add_callback(self, callback: Callable, batched: bool) -> None:
+        self._callbacks.append((callback, batched))
 
-        self._logger = logging.getLogger("GameTrainer")
-        self._logger.setLevel(logging.DEBUG)
+    def remove_callback(self, callback: Callable) -> None:
+        self._callbacks = [c for c in self._callbacks if c[0] is not callback]
 
-        # Prevent duplicate handlers if Logger is instantiated multiple times
-        if not self._logger.handlers:
-            file_handler = logging.FileHandler(log_file, encoding='utf-8')
-            file_handler.setLevel(logging.DEBUG)
+    def flush(self, timeout: float = 5.0) -> None:
+        """Writes everything logged so far (blocks up to timeout seconds)."""
+        if self._thread is not None and self._thread.is_alive():
+            # The marker is written after everything queued before it
+            marker = threading.Event()
+            self._queue.append(marker)
+            self._wake.set()
+            marker.wait(timeout)
+        else:
+            self._drain()
 
-            formatter = logging.Formatter('[%(asctime)s] %(message)s', datefmt='%H:%M:%S')
-            file_handler.setFormatter(formatter)
+    def close(self) -> None:
+        self.flush()
+        with self._lock:
+            if self._closed:
+                return
+            lines = []
+            self._flush_repeats(lines)
+            self._emit(lines)
+            self._last_text = None
+            self._closed = True
+            self._file.close()
+        self._wake.set()
+        if self._thread is not None and self._thread is not threading.current_thread():
+            self._thread.join(timeout=1.0)
 
-            self._logger.addHandler(file_handler)
 
+_writers: Dict[str, _SessionWriter] = {}
+_writers_lock = threading.Lock()
+
+
+def _get_writer(log_dir: str, flush_interval: float) -> _SessionWriter:
+    key = os.path.abspath(log_dir)
+    with _writers_lock:
+        writer = _writers.get(key)
+        if writer is None or writer._closed:
+            writer = _writers[key] = _SessionWriter(log_dir, flush_interval)
+        return writer
+
+
+@atexit.register
+def _close_writers() -> None:
+    with _writers_lock:
+        writers = list(_writers.values())
+    for writer in writers:
+        writer.close()
+
+
+class Logger:
+    """
+    Creates timestamped session logs for training analysis.
+
+    Usage:
+        logger = Logger()
+        logger.log("Agent started training")
+        logger.log("Reward: +1.0 for picking up item")
+
+    background: queue lines for the writer thread instead of writing them
+    on the calling thread (what the env uses). flush() and close() write
+    out anything still queued; so does interpreter exit.
+    max_per_second: per-tag rate limit (0: none). Only tagged lines
+    ("[TAG] ...") are limited, so banners always get through.
+
+    Every Logger with the same log_dir writes to ONE session file (one
+    writer, see _SessionWriter) - a vectorized env's instances log into a
+    single file instead of one each. So:
+      - dedupe works across them: the same line from two envs in a row is
+        folded into "(last message repeated 1x)";
+      - the rate limit is still per Logger (each env has its own budget);
+      - close() closes the file for all of them. A Logger created after
+        that starts a new writer.
+    """
+
+    def __init__(self, log_dir="logs", background: bool = False,
+                 max_per_second: float = 20.0, flush_interval: float = 0.25):
+        self._writer = _get_writer(log_dir, flush_interval)
+        self.log_file = self._writer.path
+        self._background = background
+        self._max_per_second = max_per_second
+        # tag -> [window start, lines in window, suppressed since last line]
+        self._rates: Dict[str, list] = {}
         self._gui_callback = None
 
-    def set_gui_logger(self, callback):
-        """Connects GUI window to logger output."""
+    def set_gui_logger(self, callback, batched: bool = False):
+        """
+        Connects GUI window to logger output. The callback runs on the
+        thread that writes the file (the writer thread in background mode):
+        once per line, or with batched=True once per batch with the list
+        of lines - the cheap way to feed a log panel.
+        """
+        if self._gui_callback is not None:
+            self._writer.remove_callback(self._gui_callback)
         self._gui_callback = callback
+        if callback is not None:
+            self._writer.add_callback(callback, batched)
+
+    def _admit(self, tag: Optional[str]) -> Optional[int]:
+        """None if the tag is over its rate; else the lines it dropped since."""
+        if tag is None or self._max_per_second <= 0:
+            return 0
+        now = time.monotonic()
+        rate = self._rates.get(tag)
+        if rate is None:
+            rate = self._rates[tag] = [now, 0, 0]
+        if now - rate[0] >= 1.0:
+            rate[0], rate[1] = now, 0
+        if rate[1] >= self._max_per_second:
+            rate[2] += 1
+            return None
+        rate[1] += 1
+        suppressed, rate[2] = rate[2], 0
+        return suppressed
+
+    @staticmethod
+    def _tag_of(message: str) -> Optional[str]:
+        if not message.startswith("["):
+            return None
+        end = message.find("]")
+        space = message.find(" ")
+        if end < 0:
+            return None
+        return message[:end + 1] if space < 0 or end < space else message[:space]
 
     def log(self, message: str):
         """Log a message to file and optionally to GUI."""
-        self._logger.info(message)
-        if self._gui_callback:
-            self._gui_callback(message)
+        suppressed = self._admit(self._tag_of(message))
+        if suppressed is None:
+            return
+        if suppressed:
+            message = f"{message} (+{suppressed} suppressed)"
+        self._writer.put((time.time(), message), self._background)
+
+    def event(self, tag: str, fmt: str, *args):
+        """
+        Structured log line "tag fmt % args"; formatting happens on the
+        writer thread, so this costs a tuple and a queue append.
+        """
+        suppressed = self._admit(tag)
+        if suppressed is None:
+            return
+        self._writer.put((time.time(), tag, fmt, args, suppressed), self._background)
+
+    def flush(self):
+        """Writes out everything logged so far."""
+        self._writer.flush()
+
+    def close(self):
+        """Flushes and closes the session file (shared by Loggers with this log_dir)."""
+        self._writer.close()
@@ -0,0 +1,78 @@
+"""
+PinnedRolloutBuffer - uint8 Observations, One Pinned Upload per Rollout
+
+Teacher Note: SB3's RolloutBuffer stores image observations as float32 (4x
+the size of our uint8 frames) in ordinary "pageable" host memory, and every
+minibatch of every PPO epoch is gathered on the CPU and copied to the GPU
+again. A pageable copy can't overlap anything: the driver first copies it
+into a pinned (page-locked) staging area, then transfers it.
+
+This buffer instead:
+    1. keeps observations as uint8, in pinned memory from the start
+    2. uploads the whole rollout ONCE when training starts (non_blocking,
+       straight from the pinned memory)
+    3. gathers minibatches on the GPU by index
+
+The ViT extractor then turns the uint8 batch into floats on the GPU and
+normalizes it with one fused op (see vit_extractor.py).
+
+Only takes effect on CUDA with uint8 observations; otherwise it behaves
+exactly like RolloutBuffer. Use: PPO(..., rollout_buffer_class=PinnedRolloutBuffer)
+"""
+
+from typing import Optional
+
+import numpy as np
+import torch
+from stable_baselines3.common.buffers import RolloutBuffer
+from stable_baselines3.common.type_aliases import RolloutBufferSamples
+
+
+class PinnedRolloutBuffer(RolloutBuffer):
+    """RolloutBuffer with pinned uint8 observations, uploaded once per rollout."""
+
+    def __init__(self, *args, **kwargs):
+        self._pinned_obs: Optional[torch.Tensor] = None
+        self._upload_done: Optional[torch.cuda.Event] = None
+        super().__init__(*args, **kwargs)
+
+    @property
+    def _use_pinned(self) -> bool:
+        return (torch.device(self.device).type == "cuda"
+                and getattr(self.observation_space, "dtype", None) == np.uint8)
+
+    def reset(self) -> None:
+        super().reset()
+        if not self._use_pinned:
+            return
+        if self._pinned_obs is None:
+            shape = (self.buffer_size, self.n_envs) + tuple(self.obs_shape)
+            self._pinned_obs = torch.empty(shape, dtype=torch.uint8).pin_memory()
+        if self._upload_done is not None:
+            # The last upload may still be reading the pinned memory
+            self._upload_done.synchronize()
+            self._upload_done = None
+        # numpy view of the pinned tensor: add() writes straight into it
+        self.observations = self._pinned_obs.numpy()
+
+    def get(self, batch_size: Optional[int] = None):
+        if self._use_pinned and not self.generator_ready:
+            # One async transfer for the whole rollout; get() then flattens
+            # it (swap_and_flatten works on tensors too) on the GPU
+            self.observations = self._pinned_obs.to(self.device, non_blocking=True)
+            self._upload_done = torch.cuda.Event()
+            self._upload_done.record()
+        yield from super().get(batch_size)
+
+    def _get_samples(self, batch_inds: np.ndarray, env=None) -> RolloutBufferSamples:
+        if not torch.is_tensor(self.observations):
+            return super()._get_samples(batch_inds, env)
+        observations = self.observations[torch.as_tensor(batch_inds, device=self.observations.device)]
+        data = (
+            self.actions[batch_inds],
+            self.values[batch_inds].flatten(),
+            self.log_probs[batch_inds].flatten(),
+            self.advantages[batch_inds].flatten(),
+            self.returns[batch_inds].flatten(),
+        )
+        return RolloutBufferSamples(observations, *tuple(map(self.to_torch, data)))
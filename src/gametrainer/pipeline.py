@@ -0,0 +1,127 @@
+"""
+StepPipeline - Capture, Reward and Preprocessing Off the Python Thread
+
+Teacher Note: In a synchronous step the Python thread sleeps through the
+30 ms after every action, then grabs the frame, computes the reward pixel
+statistics and the 224x224 observation itself. This wraps the C++ step
+pipeline (src/cpp/step_pipeline.cpp): Python submits a job - "the frame
+at time T, then its observation and reward features" - and a native
+thread does the waiting and the pixel work while Python moves on.
+
+    job = pipeline.submit(cap.now_us() + 30_000, ...)   # returns at once
+    frame = pipeline.captured(job)     # the frame is in (act again now)
+    features = pipeline.result(job)    # its pixel work is done too
+
+Jobs run in submission order. Needs the C++ extension and a running DXGI
+capture stream (ScreenCapture.start_stream); check `available`.
+"""
+
+from typing import List, Optional
+
+import numpy as np
+
+try:
+    import src.gametrainer.clib as clib
+    HAS_NATIVE_PIPELINE = hasattr(clib, "pipeline_open")
+except ImportError:
+    clib = None
+    HAS_NATIVE_PIPELINE = False
+
+
+class PipelineJob:
+    """One submitted job: its id, and the frame buffer it captures into."""
+
+    def __init__(self, job_id: int, buffer: np.ndarray):
+        self.id = job_id
+        self.buffer = buffer
+        self.frame: Optional[np.ndarray] = None   # BGR view, once captured
+        self.frame_seq: Optional[int] = None
+
+
+class StepPipeline:
+    """
+    Python side of one native step pipeline, capturing through `cap`
+    (whose stream must be running).
+    """
+
+    def __init__(self, cap, threads: int = 0):
+        """
+        Args:
+            cap: the ScreenCapture whose stream and frame buffers we use
+                 (give it enough buffers: every frame of a step that is
+                 still needed must be in a different one)
+            threads: C++ worker threads per job (0 = one per core)
+        """
+        self.cap = cap
+        self._threads = threads
+        self._handle = clib.pipeline_open() if HAS_NATIVE_PIPELINE else None
+        self._pending: List[PipelineJob] = []
+
+    @property
+    def available(self) -> bool:
+        """True if jobs can be submitted (native pipeline + capture stream)."""
+        return self._handle is not None and self.cap.streaming
+
+    def submit(self, deadline_us: int, before: Optional[np.ndarray] = None, rects=None,
+               obs: Optional[np.ndarray] = None, reward_handles=None, energy_rects=None,
+               cursor_rects=None, timeout: float = 0.1) -> PipelineJob:
+        """
+        Queue "capture the frame on screen at deadline_us, then observe it".
+
+        Args:
+            deadline_us: capture time, in cap.now_us() time
+            before: an earlier frame from this pipeline or the same capture
+                    (BGR view), for cursor diffs; None if not needed
+            rects: one (x, y, w, h) per instance (None = the whole frame)
+            obs: (N, 3, H, W) uint8 array to preprocess into, or None
+            reward_handles, energy_rects, cursor_rects: per instance, as
+                    for clib.observe_batch
+            timeout: give up this many seconds past the deadline
+
+        Nothing passed here may be changed until result() returned.
+        """
+        buf = self.cap.stream_buffer()
+        if rects is None:
+            rects = [(0, 0, buf.shape[1], buf.shape[0])]
+        job_id = clib.pipeline_submit(self._handle, int(deadline_us), buf, before, rects, obs,
+                                      reward_handles, energy_rects, cursor_rects,
+                                      self._threads, int(timeout * 1000))
+        job = PipelineJob(job_id, buf)
+        self._pending.append(job)
+        return job
+
+    def captured(self, job: PipelineJob) -> Optional[np.ndarray]:
+        """Wait until the job's frame is in; its BGR view, or None if none came."""
+        if job.frame is None:
+            stamp = clib.pipeline_captured(self._handle, job.id)
+            if stamp is None:
+                return None
+            job.frame = self.cap.stream_frame(job.buffer, stamp)
+            job.frame_seq = stamp[1]
+        return job.frame
+
+    def result(self, job: PipelineJob) -> Optional[list]:
+        """
+        Wait until the job is done. Returns one reward feature tuple (or
+        None) per instance, or None if no frame came.
+        """
+        stamp, features = clib.pipeline_result(self._handle, job.id)
+        self._pending.remove(job)
+        if stamp is None:
+            return None
+        if job.frame is None:
+            job.frame = self.cap.stream_frame(job.buffer, stamp)
+            job.frame_seq = stamp[1]
+        return features
+
+    def drain(self) -> None:
+        """Finish every pending job, discarding the results."""
+        for job in list(self._pending):
+            self.result(job)
+
+    def close(self) -> None:
+        """Finish pending jobs and stop the native thread."""
+        if self._handle is not None:
+            clib.pipeline_close(self._handle)
+            self._handle = None
+        self._pending = []
@@ -0,0 +1,161 @@
+"""
+Step Profiler - Where Does a Step's Time Go?
+
+Teacher Note: The C++ extension times its own stages (capture, frame
+waits, input dispatch, holds/sleeps, reward features, preprocessing) with
+scoped spans in per-thread lock-free rings (src/cpp/profiler.h). This
+module adds the Python-side stages to the same rings - policy inference,
+the whole env step, the UI scan - and reads the results back as per-stage
+latency histograms:
+
+    profiler.enable(trace=True)
+    ...train / play...
+    print(profiler.report())              # p50 / p90 / p99 / max per stage
+    profiler.write_trace("logs/step_trace.json")   # chrome://tracing, Perfetto
+
+When profiling is off, span() costs one attribute check. Without the C++
+extension nothing is recorded (stats() is empty).
+
+Limitation: the profiler is per process - ShmSubprocVecEnv workers each
+keep their own and the trainer doesn't see them.
+"""
+
+from typing import Dict, Optional
+
+try:
+    import src.gametrainer.clib as clib
+    HAS_NATIVE_PROFILER = hasattr(clib, "profiler_enable")
+except ImportError:
+    clib = None
+    HAS_NATIVE_PROFILER = False
+
+# Stage ids (the native enum), for the stages Python records
+INFERENCE = getattr(clib, "PROFILE_INFERENCE", 7)
+ENV_STEP = getattr(clib, "PROFILE_ENV_STEP", 8)
+UI_SCAN = getattr(clib, "PROFILE_UI_SCAN", 9)
+
+_enabled = False
+
+
+def enable(trace: bool = False) -> bool:
+    """
+    Start recording spans (trace=True also keeps every span for
+    write_trace). False if there is no native profiler.
+    """
+    global _enabled
+    if not HAS_NATIVE_PROFILER:
+        return False
+    clib.profiler_enable(True, trace)
+    _enabled = True
+    return True
+
+
+def disable() -> None:
+    global _enabled
+    if HAS_NATIVE_PROFILER:
+        clib.profiler_enable(False)
+    _enabled = False
+
+
+def enabled() -> bool:
+    return _enabled
+
+
+class span:
+    """
+    Times a `with` block as one span of a stage:
+
+        with profiler.span(profiler.INFERENCE):
+            action = policy(obs)
+    """
+
+    __slots__ = ("stage", "start")
+
+    def __init__(self, stage: int):
+        self.stage = stage
+        self.start = None
+
+    def __enter__(self):
+        if _enabled:
+            self.start = clib.qpc_us()
+        return self
+
+    def __exit__(self, *exc):
+        if self.start is not None:
+            clib.profiler_record(self.stage, self.start, clib.qpc_us())
+        return False
+
+
+def traced(stage: int, fn):
+    """fn wrapped in a span (for work handed to another thread)."""
+    def run(*args, **kwargs):
+        with span(stage):
+            return fn(*args, **kwargs)
+    return run
+
+
+def instrument_policy(policy) -> None:
+    """
+    Record every forward pass of an SB3 policy as an INFERENCE span.
+
+    Teacher Note: On a GPU the forward call returns before the kernels
+    finish, so while profiling we wait for them (torch.cuda.synchronize) -
+    otherwise the time would show up in whatever copies the result next.
+    """
+    import torch
+
+    def before(module, inputs):
+        module._profile_span = span(INFERENCE).__enter__()
+
+    def after(module, inputs, output):
+        s = getattr(module, "_profile_span", None)
+        if s is None:
+            return
+        if s.start is not None and torch.cuda.is_available():
+            torch.cuda.synchronize()
+        s.__exit__(None, None, None)
+        module._profile_span = None
+
+    policy.register_forward_pre_hook(before)
+    policy.register_forward_hook(after)
+
+
+def stats() -> Dict[str, dict]:
+    """{stage: {count, mean_us, p50_us, p90_us, p99_us, max_us}} so far."""
+    if not HAS_NATIVE_PROFILER:
+        return {}
+    return clib.profiler_stats()
+
+
+def report(title: Optional[str] = "STEP PROFILE") -> str:
+    """stats() as a table, slowest p99 first."""
+    rows = sorted(stats().items(), key=lambda kv: kv[1]["p99_us"], reverse=True)
+    lines = []
+    if title:
+        lines += ["=" * 72, title, "=" * 72]
+    if not rows:
+        lines.append("  (no spans recorded)")
+        return "\n".join(lines)
+    lines.append(f"  {'stage':16s} {'count':>8s} {'mean':>9s} {'p50':>9s} {'p90':>9s} {'p99':>9s} {'max':>9s}  (ms)")
+    for name, s in rows:
+        lines.append(
+            f"  {name:16s} {s['count']:8d} "
+            f"{s['mean_us'] / 1000:9.3f} {s['p50_us'] / 1000:9.3f} {s['p90_us'] / 1000:9.3f} "
+            f"{s['p99_us'] / 1000:9.3f} {s['max_us'] / 1000:9.3f}"
+        )
+    dropped = clib.profiler_dropped()
+    if dropped:
+        lines.append(f"  ({dropped:,} spans dropped: rings full)")
+    return "\n".join(lines)
+
+
+def write_trace(path: str) -> int:
+    """Chrome trace JSON of the spans since the last write; returns the count."""
+    if not HAS_NATIVE_PROFILER:
+        return 0
+    return clib.profiler_write_trace(path)
+
+
+def reset() -> None:
+    if HAS_NATIVE_PROFILER:
+        clib.profiler_reset()
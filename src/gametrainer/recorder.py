@@ -0,0 +1,540 @@
+"""
+Trajectory Recording - Every Step, Saved for Offline Training
+
+Teacher Note: PPO throws its experience away after each update, and the
+game only runs at game speed. To re-train a new policy (or a bigger ViT,
+or a behavior-cloning model) on old sessions at GPU speed, we need every
+step that was played on disk: the observation, the action, the reward and
+the pixel statistics behind the reward.
+
+Saving PNGs (ScreenCapture.grab_and_save) from the step loop is far too
+slow, so the native recorder (src/cpp/recorder.h) only copies each
+observation into a chunk buffer and returns; a writer thread appends full
+chunks to the file. Wrap any env to record it:
+
+    env = RecordingVecEnv(env, "logs/trajectories/run1.gtt")   # VecEnv (train.py)
+    env = RecordingEnv(env, "logs/trajectories/play.gtt")      # gym.Env (play.py)
+
+Observations are stored raw or, with codec="delta" (the default for the
+wrappers), as delta_codec.py packets against the same env's previous
+step - a mostly static screen then costs a few KB per step instead of
+150 KB. The writer thread does the encoding.
+
+Read it back - observations are memory-mapped, nothing is loaded until used:
+
+    traj = TrajectoryReader("logs/trajectories/run1.gtt")
+    obs = traj.obs(1234)                   # (3, 224, 224) uint8 (a view, if raw)
+    traj.meta["action"], traj.meta["reward"]
+    loader = DataLoader(traj.torch_dataset(), batch_size=256, shuffle=True)
+
+Without the C++ extension a Python writer thread produces the same files.
+"""
+
+import os
+import queue
+import struct
+import threading
+import time
+from typing import Optional, Sequence
+
+import gymnasium as gym
+import numpy as np
+from stable_baselines3.common.vec_env import VecEnvWrapper
+
+from . import delta_codec
+
+try:
+    from . import clib
+    HAS_NATIVE_RECORDER = hasattr(clib, "recorder_open")
+except ImportError:
+    clib = None
+    HAS_NATIVE_RECORDER = False
+
+# Must match RecordFileHeader / RecordChunkHeader / RecordChunkEntry /
+# RecordObsEntry / StepMeta in src/cpp/recorder.h
+MAGIC = b"GTRECORD"
+CHUNK_MAGIC = b"GTCHUNK\0"
+VERSION = 1
+HEADER = struct.Struct("<8sIIIIIIQQI12x")       # 64 bytes
+CHUNK_HEADER = struct.Struct("<8sQIIQQ24x")     # 64 bytes
+INDEX_DTYPE = np.dtype([("offset", "<u8"), ("first_record", "<u8"), ("count", "<u4"),
+                        ("codec", "<u4"), ("bytes", "<u8")])
+OBS_ENTRY_DTYPE = np.dtype([("offset", "<u4"), ("size", "<u4"), ("ref", "<i4"), ("reserved", "<u4")])
+META_DTYPE = np.dtype([("timestamp_us", "<i8"), ("step", "<u8"), ("action", "<i4"),
+                       ("reward", "<f4"), ("features", "<f4", (4,)), ("env_id", "<u2"),
+                       ("flags", "<u2"), ("reserved", "<u4")])
+CODEC_RAW = 0
+CODEC_DELTA = 1
+CODECS = {"raw": CODEC_RAW, "delta": CODEC_DELTA}
+KEY_INTERVAL = 16       # RECORD_KEY_INTERVAL
+CHUNK_ALIGN = 64
+
+# StepMeta flags
+EPISODE_START = 1
+TERMINATED = 2
+TRUNCATED = 4
+
+
+def now_us() -> int:
+    """Microseconds on the capture clock (ScreenCapture.now_us)."""
+    if clib is not None and hasattr(clib, "qpc_us"):
+        return clib.qpc_us()
+    return int(time.perf_counter() * 1e6)
+
+
+def _features_list(features) -> Optional[list]:
+    """info["reward_features"] as floats, -1 for the ones not measured."""
+    if features is None:
+        return None
+    return [-1.0 if f is None else float(f) for f in features]
+
+
+# =============================================================================
+# WRITING
+# =============================================================================
+
+class _PyRecorder:
+    """
+    Python fallback for the native StepRecorder: same chunks, same file,
+    a Python writer thread. Chunk buffers circulate through two queues.
+    """
+
+    def __init__(self, path: str, obs_shape: Sequence[int], chunk_records: int, buffers: int,
+                 codec: int = CODEC_RAW):
+        self._obs_shape = tuple(obs_shape)
+        self._chunk_records = chunk_records
+        self._codec = codec
+        if codec == CODEC_DELTA:
+            # RecordObsEntry offsets are 32-bit (as StepRecorder::Open checks)
+            worst = chunk_records * (OBS_ENTRY_DTYPE.itemsize +
+                                     delta_codec.max_encoded_size(int(np.prod(self._obs_shape))))
+            if worst > 0xFFFFFFFF:
+                raise OSError("recorder: chunk_records too large for delta-coded chunks "
+                              "(the encoded block could exceed 4 GiB)")
+        self._file = open(path, "wb")
+        self._file.write(HEADER.pack(MAGIC, VERSION, *self._obs_shape, META_DTYPE.itemsize,
+                                     chunk_records, 0, 0, 0))
+        self._file.flush()
+        self._offset = HEADER.size
+        self._index = []
+        self._free = queue.Queue()
+        self._full = queue.Queue()
+        for _ in range(buffers):
+            self._free.put({"obs": np.empty((chunk_records,) + self._obs_shape, dtype=np.uint8),
+                            "meta": np.zeros(chunk_records, dtype=META_DTYPE),
+                            "count": 0, "first": 0})
+        self._current = None
+        self._next_record = 0
+        self._stats = {"records": 0, "dropped": 0, "chunks": 0, "bytes": 0, "write_error": False}
+        self._thread = threading.Thread(target=self._run, name="trajectory-writer", daemon=True)
+        self._thread.start()
+
+    def add(self, obs, action, reward, timestamp_us, features, env_id, flags, step) -> bool:
+        if self._file is None:
+            return False
+        if self._current is None:
+            try:
+                self._current = self._free.get_nowait()
+            except queue.Empty:
+                self._stats["dropped"] += 1   # the disk is behind: drop, don't wait
+                return False
+            self._current["count"] = 0
+            self._current["first"] = self._next_record
+        chunk = self._current
+        i = chunk["count"]
+        chunk["obs"][i] = obs
+        chunk["meta"][i] = (timestamp_us, step, action, reward,
+                            features if features is not None else (-1.0,) * 4, env_id, flags, 0)
+        chunk["count"] = i + 1
+        self._next_record += 1
+        self._stats["records"] += 1
+        if chunk["count"] == self._chunk_records:
+            self._full.put(chunk)
+            self._current = None
+        return True
+
+    def _run(self):
+        while True:
+            chunk = self._full.get()
+            if chunk is None:
+                return
+            if not self._stats["write_error"]:
+                self._write_chunk(chunk)
+            self._free.put(chunk)
+
+    @staticmethod
+    def _encode_chunk(obs: np.ndarray, meta: np.ndarray) -> bytes:
+        """StepRecorder::EncodeChunk: RecordObsEntry table + delta packets."""
+        refs = np.full(len(obs), -1, dtype=np.int32)
+        chains = {}   # env_id -> (record index of its last obs, chain length)
+        for i, env_id in enumerate(meta["env_id"].tolist()):
+            last, length = chains.get(env_id, (-1, KEY_INTERVAL))
+            if length < KEY_INTERVAL:
+                refs[i], length = last, length + 1
+            else:
+                length = 1
+            chains[env_id] = (i, length)
+        packets = [delta_codec.encode(obs[i], obs[refs[i]] if refs[i] >= 0 else None)
+                   for i in range(len(obs))]
+        table = np.zeros(len(obs), dtype=OBS_ENTRY_DTYPE)
+        table["size"] = [len(p) for p in packets]
+        table["offset"] = table.nbytes + np.concatenate(([0], np.cumsum(table["size"])[:-1]))
+        table["ref"] = refs
+        return table.tobytes() + b"".join(packets)
+
+    def _write_chunk(self, chunk):
+        count = chunk["count"]
+        obs = chunk["obs"][:count]
+        meta = chunk["meta"][:count]
+        obs_data = self._encode_chunk(obs, meta) if self._codec == CODEC_DELTA else obs.tobytes()
+        body = CHUNK_HEADER.size + len(obs_data) + meta.nbytes
+        pad = -body % CHUNK_ALIGN
+        try:
+            self._file.write(CHUNK_HEADER.pack(CHUNK_MAGIC, chunk["first"], count, self._codec,
+                                               len(obs_data), meta.nbytes))
+            self._file.write(obs_data)
+            self._file.write(meta.tobytes())
+            self._file.write(b"\0" * pad)
+            self._file.flush()
+        except OSError:
+            self._stats["write_error"] = True
+            return
+        self._index.append((self._offset, chunk["first"], count, self._codec, body + pad))
+        self._offset += body + pad
+        self._stats["chunks"] += 1
+        self._stats["bytes"] += body + pad
+
+    def stats(self) -> dict:
+        return dict(self._stats)
+
+    def close(self):
+        if self._file is None:
+            return
+        if self._current is not None:
+            self._full.put(self._current)
+            self._current = None
+        self._full.put(None)
+        self._thread.join()
+        try:
+            if not self._stats["write_error"]:
+                record_count = sum(entry[2] for entry in self._index)
+                self._file.write(np.array(self._index, dtype=INDEX_DTYPE).tobytes())
+                self._file.seek(0)
+                self._file.write(HEADER.pack(MAGIC, VERSION, *self._obs_shape, META_DTYPE.itemsize,
+                                             self._chunk_records, record_count, self._offset,
+                                             len(self._index)))
+        except OSError:
+            self._stats["write_error"] = True
+        try:
+            self._file.close()   # flushes the index and the header
+        except OSError:
+            self._stats["write_error"] = True
+        self._file = None
+
+
+class TrajectoryRecorder:
+    """
+    Appends steps to a trajectory file without blocking the caller:
+
+        with TrajectoryRecorder("logs/trajectories/run.gtt") as rec:
+            rec.add(obs, action, reward, timestamp_us, features, flags=EPISODE_START)
+
+    add() copies obs (uint8 CHW, obs_shape) into the current chunk; a
+    writer thread appends full chunks (delta-coding them, with
+    codec="delta"). If all `buffers` chunks are waiting for the disk,
+    add() drops the step and returns False.
+    """
+
+    def __init__(self, path: str, obs_shape: Sequence[int] = (3, 224, 224),
+                 chunk_records: int = 64, buffers: int = 4, codec: str = "raw"):
+        os.makedirs(os.path.dirname(os.path.abspath(path)), exist_ok=True)
+        self.path = path
+        self.obs_shape = tuple(obs_shape)
+        self._final_stats = {"records": 0, "dropped": 0, "chunks": 0, "bytes": 0, "write_error": False}
+        if HAS_NATIVE_RECORDER:
+            self._handle = clib.recorder_open(path, *self.obs_shape, chunk_records, buffers, CODECS[codec])
+            self._py = None
+        else:
+            self._handle = None
+            self._py = _PyRecorder(path, self.obs_shape, chunk_records, buffers, CODECS[codec])
+
+    @property
+    def is_native(self) -> bool:
+        return self._handle is not None
+
+    def add(self, obs: np.ndarray, action: int, reward: float, timestamp_us: Optional[int] = None,
+            features=None, env_id: int = 0, flags: int = 0, step: int = 0) -> bool:
+        obs = np.ascontiguousarray(obs, dtype=np.uint8)
+        if timestamp_us is None:
+            timestamp_us = now_us()
+        features = _features_list(features)
+        if self._handle is not None:
+            return clib.recorder_add(self._handle, obs, int(action), float(reward), int(timestamp_us),
+                                     features, env_id, flags, step)
+        if self._py is not None:
+            return self._py.add(obs, int(action), float(reward), int(timestamp_us),
+                                features, env_id, flags, step)
+        return False
+
+    def stats(self) -> dict:
+        """{records, dropped, chunks, bytes, write_error} so far."""
+        if self._handle is not None:
+            return clib.recorder_stats(self._handle)
+        if self._py is not None:
+            return self._py.stats()
+        return dict(self._final_stats)
+
+    def close(self) -> dict:
+        """Writes what's left and the index; returns the final stats."""
+        if self._handle is not None:
+            self._final_stats = clib.recorder_close(self._handle) or self._final_stats
+            self._handle = None
+        elif self._py is not None:
+            self._py.close()
+            self._final_stats = self._py.stats()
+            self._py = None
+        return dict(self._final_stats)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+        return False
+
+
+class RecordingVecEnv(VecEnvWrapper):
+    """
+    Records every step of a VecEnv: each env's observation, the action
+    taken on it, the reward, and info["reward_features"].
+
+    Teacher Note: A step record pairs an action with the observation it was
+    chosen from, so we keep our own copy of the last observations (some
+    VecEnvs, like ShmSubprocVecEnv, overwrite theirs in place) and write
+    the record when the step result comes back.
+    """
+
+    def __init__(self, venv, path: str, chunk_records: int = 64, buffers: int = 4, codec: str = "delta"):
+        super().__init__(venv)
+        self.recorder = TrajectoryRecorder(path, venv.observation_space.shape, chunk_records, buffers, codec)
+        self._obs = None
+        self._obs_us = np.zeros(self.num_envs, dtype=np.int64)
+        self._flags = np.full(self.num_envs, EPISODE_START, dtype=np.uint16)
+        self._actions = None
+
+    def reset(self):
+        obs = self.venv.reset()
+        self._obs = np.array(obs, dtype=np.uint8, copy=True)
+        self._obs_us[:] = now_us()
+        self._flags[:] = EPISODE_START
+        return obs
+
+    def step_async(self, actions):
+        self._actions = np.asarray(actions).reshape(self.num_envs)
+        self.venv.step_async(actions)
+
+    def step_wait(self):
+        obs, rewards, dones, infos = self.venv.step_wait()
+        if self._obs is not None:
+            for i in range(self.num_envs):
+                flags = int(self._flags[i])
+                if dones[i]:
+                    flags |= TRUNCATED if infos[i].get("TimeLimit.truncated") else TERMINATED
+                self.recorder.add(self._obs[i], int(self._actions[i]), float(rewards[i]),
+                                  int(self._obs_us[i]), infos[i].get("reward_features"),
+                                  env_id=i, flags=flags, step=int(infos[i].get("step", 0)))
+            np.copyto(self._obs, obs, casting="unsafe")
+            self._obs_us[:] = now_us()
+            self._flags[:] = np.where(dones, EPISODE_START, 0)
+        return obs, rewards, dones, infos
+
+    def close(self):
+        stats = self.recorder.close()
+        print(f"  Recorded {stats.get('records', 0):,} steps -> {self.recorder.path}"
+              f" ({stats.get('dropped', 0):,} dropped)")
+        self.venv.close()
+
+
+class RecordingEnv(gym.Wrapper):
+    """RecordingVecEnv for a single gym.Env (play.py)."""
+
+    def __init__(self, env, path: str, chunk_records: int = 64, buffers: int = 4, codec: str = "delta"):
+        super().__init__(env)
+        self.recorder = TrajectoryRecorder(path, env.observation_space.shape, chunk_records, buffers, codec)
+        self._obs = None
+        self._obs_us = 0
+        self._flags = EPISODE_START
+
+    def reset(self, **kwargs):
+        obs, info = self.env.reset(**kwargs)
+        self._obs = np.array(obs, dtype=np.uint8, copy=True)
+        self._obs_us = now_us()
+        self._flags = EPISODE_START
+        return obs, info
+
+    def step(self, action):
+        obs, reward, terminated, truncated, info = self.env.step(action)
+        if self._obs is not None:
+            flags = self._flags | (TERMINATED if terminated else 0) | (TRUNCATED if truncated else 0)
+            self.recorder.add(self._obs, int(action), float(reward), self._obs_us,
+                              info.get("reward_features"), flags=flags, step=int(info.get("step", 0)))
+            np.copyto(self._obs, obs, casting="unsafe")
+            self._obs_us = now_us()
+            self._flags = 0
+        return obs, reward, terminated, truncated, info
+
+    def close(self):
+        stats = self.recorder.close()
+        print(f"  Recorded {stats.get('records', 0):,} steps -> {self.recorder.path}"
+              f" ({stats.get('dropped', 0):,} dropped)")
+        self.env.close()
+
+
+# =============================================================================
+# READING
+# =============================================================================
+
+class TrajectoryReader:
+    """
+    Random access to a trajectory file, memory-mapped (nothing is read
+    until used). obs(i) is a zero-copy (C, H, W) uint8 view; meta is every
+    record's StepMeta as one numpy structured array (action, reward,
+    timestamp_us, features, env_id, flags, step).
+
+    Files whose writer died have no index; it is rebuilt from the chunk
+    headers, up to the last complete chunk.
+    """
+
+    def __init__(self, path: str):
+        self.path = path
+        self._map = np.memmap(path, dtype=np.uint8, mode="r")
+        if self._map.size < HEADER.size:
+            raise ValueError(f"{path}: not a trajectory file (too small)")
+        (magic, version, c, h, w, meta_size, self.chunk_records, _record_count,
+         index_offset, chunk_count) = HEADER.unpack(bytes(self._map[:HEADER.size]))
+        if magic != MAGIC or version != VERSION or meta_size != META_DTYPE.itemsize:
+            raise ValueError(f"{path}: not a version {VERSION} trajectory file")
+        self.obs_shape = (c, h, w)
+        self._obs_bytes = c * h * w
+
+        if index_offset:
+            index = np.frombuffer(self._map, dtype=INDEX_DTYPE, count=chunk_count, offset=index_offset)
+        else:
+            index = self._scan()
+        if not np.all(np.isin(index["codec"], list(CODECS.values()))):
+            raise ValueError(f"{path}: unknown observation codec")
+        self.index = index
+
+        # Per chunk: a (count, C, H, W) view (raw) or the RecordObsEntry
+        # table and where its packets start (delta); and where each chunk ends
+        self._chunks = []
+        metas = []
+        for entry in index:
+            offset, count = int(entry["offset"]), int(entry["count"])
+            obs_bytes = CHUNK_HEADER.unpack(bytes(self._map[offset:offset + CHUNK_HEADER.size]))[4]
+            block = offset + CHUNK_HEADER.size
+            if entry["codec"] == CODEC_RAW:
+                self._chunks.append(np.frombuffer(self._map, dtype=np.uint8, count=count * self._obs_bytes,
+                                                  offset=block).reshape((count,) + self.obs_shape))
+            else:
+                self._chunks.append((np.frombuffer(self._map, dtype=OBS_ENTRY_DTYPE, count=count,
+                                                   offset=block), block))
+            metas.append(np.frombuffer(self._map, dtype=META_DTYPE, count=count, offset=block + obs_bytes))
+        self._counts = index["count"].astype(np.int64)
+        self._ends = np.cumsum(self._counts)
+        self.meta = np.concatenate(metas) if metas else np.zeros(0, dtype=META_DTYPE)
+        self._decoded = {}   # env_id -> (chunk, record in chunk, decoded obs)
+
+    def _scan(self) -> np.ndarray:
+        """Rebuild the index by walking the chunk headers."""
+        entries = []
+        offset = HEADER.size
+        size = self._map.size
+        while offset + CHUNK_HEADER.size <= size:
+            magic, first, count, codec, obs_bytes, meta_bytes = CHUNK_HEADER.unpack(
+                bytes(self._map[offset:offset + CHUNK_HEADER.size]))
+            body = CHUNK_HEADER.size + obs_bytes + meta_bytes
+            total = body + (-body % CHUNK_ALIGN)
+            raw_ok = codec != CODEC_RAW or obs_bytes == count * self._obs_bytes
+            if (magic != CHUNK_MAGIC or not raw_ok or
+                    meta_bytes != count * META_DTYPE.itemsize or offset + body > size):
+                break
+            entries.append((offset, first, count, codec, total))
+            offset += total
+        return np.array(entries, dtype=INDEX_DTYPE)
+
+    def __len__(self) -> int:
+        return int(self._ends[-1]) if len(self._ends) else 0
+
+    def _locate(self, i: int):
+        if i < 0:
+            i += len(self)
+        if not 0 <= i < len(self):
+            raise IndexError(f"record {i} out of range ({len(self)} records)")
+        chunk = int(np.searchsorted(self._ends, i, side="right"))
+        start = int(self._ends[chunk] - self._counts[chunk])
+        return chunk, i - start
+
+    def obs(self, i: int) -> np.ndarray:
+        """
+        Observation of record i, (C, H, W) uint8: a view into the file if
+        its chunk is raw, else decoded (from the last decode of the same
+        env's chain when possible, so reading in order is one packet each).
+        """
+        chunk, j = self._locate(i)
+        data = self._chunks[chunk]
+        if isinstance(data, np.ndarray):
+            return data[j]
+        table, block = data
+        env_id = int(self.meta["env_id"][i])
+        cached_chunk, cached_j, frame = self._decoded.get(env_id, (-1, -1, None))
+        if cached_chunk != chunk:
+            cached_j = -1
+
+        # Walk back to the keyframe (or to what we already decoded)...
+        path = []
+        k = j
+        while k >= 0 and k != cached_j:
+            path.append(k)
+            k = int(table["ref"][k])
+        if k < 0 or frame is None:
+            frame = np.zeros(self.obs_shape, dtype=np.uint8)
+        # ...then forward
+        for k in reversed(path):
+            start = block + int(table["offset"][k])
+            delta_codec.decode(self._map[start:start + int(table["size"][k])], frame)
+        self._decoded[env_id] = (chunk, j, frame)
+        return frame.copy()
+
+    def __getitem__(self, i: int):
+        """(obs, meta) of record i."""
+        return self.obs(i), self.meta[i]
+
+    def batch(self, indices) -> tuple:
+        """(obs (N, C, H, W) uint8, meta (N,)) for a batch of record indices."""
+        indices = np.asarray(indices, dtype=np.int64)
+        out = np.empty((len(indices),) + self.obs_shape, dtype=np.uint8)
+        for k, i in enumerate(indices):
+            out[k] = self.obs(int(i))
+        return out, self.meta[indices]
+
+    def torch_dataset(self):
+        """
+        A torch Dataset of (obs uint8 tensor, action, reward) - for a
+        DataLoader (behavior cloning, pre-training the feature extractor).
+        """
+        import torch
+        from torch.utils.data import Dataset
+
+        reader = self
+
+        class TrajectoryDataset(Dataset):
+            def __len__(self):
+                return len(reader)
+
+            def __getitem__(self, i):
+                meta = reader.meta[i]
+                return (torch.from_numpy(np.array(reader.obs(i))),
+                        int(meta["action"]), float(meta["reward"]))
+
+        return TrajectoryDataset()
@@ -0,0 +1,226 @@
+"""
+Replay Files - A Recorded "Game" for Benchmarks
+
+Teacher Note: Measuring StardewViTEnv against the live game mixes our
+speed with the game's: what's on screen decides how many frames capture
+delivers, and no two runs see the same pixels. A replay file is a recorded
+frame sequence that plays back on its own clock (one frame every
+frame_interval_us, looping). ScreenCapture(backend="replay") serves frames
+from it and InputController(null_sink=True) swallows the actions with the
+real timing, so the env runs exactly as it would against the game - on any
+machine, no game installed:
+
+    python scripts/train.py tiny --replay logs/replay.gtr --steps 4096
+
+Make a replay by recording the game (record()) or, for CI, by generating
+one (write_synthetic()). The format is documented in src/cpp/replay.h; the
+C++ extension maps and plays it (clib.replay_*), and ReplayReader below is
+a numpy fallback for machines without it.
+
+Frames are stored raw or, with codec="delta", as delta_codec.py packets
+(a keyframe every key_interval frames): a recording of the game shrinks to
+a fraction, and playback decodes one packet per frame.
+"""
+
+import struct
+import time
+from typing import Optional
+
+import numpy as np
+
+from . import delta_codec
+
+# Must match ReplayHeader / ReplayIndexEntry in src/cpp/replay.h
+MAGIC = b"GTREPLAY"
+VERSION = 1
+HEADER = struct.Struct("<8sIIIIIIQ24x")    # 64 bytes
+INDEX_DTYPE = np.dtype([("offset", "<u8"), ("size", "<u4"), ("codec", "<u4")])
+CODEC_RAW = 0
+CODEC_DELTA = 1
+CODECS = {"raw": CODEC_RAW, "delta": CODEC_DELTA}
+FRAME_ALIGN = 64
+
+
+class ReplayWriter:
+    """
+    Appends frames to a replay file:
+
+        with ReplayWriter("logs/replay.gtr", fps=30) as w:
+            for frame in frames:
+                w.add(frame)      # (H, W, 3|4) uint8 BGR(A)
+
+    codec: "raw" or "delta" (keyframe every key_interval frames).
+    """
+
+    def __init__(self, path: str, fps: float = 30.0, codec: str = "raw", key_interval: int = 30):
+        self.path = path
+        self.frame_interval_us = max(1, int(round(1e6 / fps)))
+        self.codec = CODECS[codec]
+        self.key_interval = max(1, key_interval)
+        self._prev = None
+        self.width = None
+        self.height = None
+        self._index = []
+        self._bgra = None
+        self._file = open(path, "wb")
+        self._file.write(b"\0" * HEADER.size)   # header goes in on close()
+
+    def add(self, frame: np.ndarray) -> None:
+        h, w = frame.shape[:2]
+        if self.width is None:
+            self.width, self.height = w, h
+            self._bgra = np.full((h, w, 4), 255, dtype=np.uint8)
+        elif (w, h) != (self.width, self.height):
+            raise ValueError(f"frame is {w}x{h}, replay is {self.width}x{self.height}")
+        self._bgra[:, :, :frame.shape[2]] = frame
+
+        if self.codec == CODEC_DELTA:
+            key = len(self._index) % self.key_interval == 0
+            data = delta_codec.encode(self._bgra, None if key else self._prev)
+            if self._prev is None:
+                self._prev = np.empty_like(self._bgra)
+            self._prev[:] = self._bgra
+        else:
+            data = self._bgra.tobytes()
+
+        pad = -self._file.tell() % FRAME_ALIGN
+        if pad:
+            self._file.write(b"\0" * pad)
+        self._index.append((self._file.tell(), len(data), self.codec))
+        self._file.write(data)
+
+    @property
+    def frame_count(self) -> int:
+        return len(self._index)
+
+    def close(self) -> None:
+        if self._file.closed:
+            return
+        index_offset = self._file.tell()
+        self._file.write(np.array(self._index, dtype=INDEX_DTYPE).tobytes())
+        self._file.seek(0)
+        self._file.write(HEADER.pack(MAGIC, VERSION, self.width or 0, self.height or 0,
+                                     len(self._index), self.frame_interval_us, 0, index_offset))
+        self._file.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+        return False
+
+
+class ReplayReader:
+    """
+    Zero-copy numpy view of a replay file (np.memmap), for machines
+    without the C++ extension. frame(i) is an (H, W, 4) BGRA view.
+    """
+
+    def __init__(self, path: str):
+        self._map = np.memmap(path, dtype=np.uint8, mode="r")
+        if self._map.size < HEADER.size:
+            raise ValueError(f"{path}: not a replay file (too small)")
+        (magic, version, self.width, self.height, self.frame_count,
+         self.frame_interval_us, _, index_offset) = HEADER.unpack(bytes(self._map[:HEADER.size]))
+        if magic != MAGIC or version != VERSION:
+            raise ValueError(f"{path}: not a version {VERSION} replay file")
+        if self.frame_count == 0:
+            raise ValueError(f"{path}: empty replay")
+        self._index = np.frombuffer(self._map, dtype=INDEX_DTYPE, count=self.frame_count,
+                                    offset=index_offset)
+        if not np.all(np.isin(self._index["codec"], list(CODECS.values()))):
+            raise ValueError(f"{path}: unknown frame codec")
+
+        # Delta-coded frames decode forward from their keyframe
+        self._key_of = np.arange(self.frame_count)
+        for i in range(1, self.frame_count):
+            if self._index["codec"][i] == CODEC_DELTA and not delta_codec.is_key(self._packet(i)):
+                self._key_of[i] = self._key_of[i - 1]
+        self._decoded = None
+        self._decoded_index = -1
+
+    def _packet(self, i: int) -> np.ndarray:
+        offset, size = int(self._index["offset"][i]), int(self._index["size"][i])
+        return self._map[offset:offset + size]
+
+    def frame(self, i: int) -> np.ndarray:
+        """(H, W, 4) BGRA frame i: a view into the file, or (delta) a decoded buffer."""
+        i %= self.frame_count
+        if self._index["codec"][i] == CODEC_RAW:
+            return self._packet(i).reshape(self.height, self.width, 4)
+        if self._decoded is None:
+            self._decoded = np.zeros((self.height, self.width, 4), dtype=np.uint8)
+        start = int(self._key_of[i])
+        if start <= self._decoded_index <= i:
+            start = self._decoded_index + 1
+        for j in range(start, i + 1):
+            if self._index["codec"][j] == CODEC_RAW:
+                self._decoded[:] = self._packet(j).reshape(self.height, self.width, 4)
+            else:
+                delta_codec.decode(self._packet(j), self._decoded)
+        self._decoded_index = i
+        return self._decoded
+
+
+def record(cap, path: str, seconds: float, fps: float = 30.0, codec: str = "raw") -> int:
+    """
+    Record `seconds` of a live ScreenCapture (region already set) into a
+    replay file at `fps`; returns the number of frames written.
+    """
+    interval = 1.0 / fps
+    with ReplayWriter(path, fps, codec=codec) as writer:
+        end = time.perf_counter() + seconds
+        next_frame = time.perf_counter()
+        while next_frame < end:
+            frame = cap.grab()
+            if frame is not None:
+                writer.add(frame)
+            next_frame += interval
+            time.sleep(max(0.0, next_frame - time.perf_counter()))
+        return writer.frame_count
+
+
+def write_synthetic(path: str, width: int = 1280, height: int = 720, frames: int = 120,
+                    fps: float = 30.0, seed: int = 0, codec: str = "raw") -> int:
+    """
+    Generate a replay with game-like content: a scrolling textured "map",
+    a HUD that stays put (an energy bar that slowly drains, a notification
+    box that sometimes pops up) and noise. Deterministic for a given seed.
+    """
+    rng = np.random.default_rng(seed)
+    tile = rng.integers(0, 256, size=(64, 64, 3), dtype=np.uint8)
+    world = np.tile(tile, (height // 64 + 2, width // 64 + 2, 1))
+    xs = np.arange(width)
+    with ReplayWriter(path, fps, codec=codec) as writer:
+        for i in range(frames):
+            dx, dy = (3 * i) % 64, (2 * i) % 64
+            frame = world[dy:dy + height, dx:dx + width].copy()
+            frame[..., 0] = (frame[..., 0] // 2 + (xs + 4 * i) % 128).astype(np.uint8)
+            frame ^= rng.integers(0, 8, size=frame.shape, dtype=np.uint8)
+
+            # HUD: energy bar (bottom right) and a notification (bottom left)
+            bar_top = height - 260 + int(200 * i / max(1, frames - 1))
+            frame[height - 260:height - 60, width - 120:width - 96] = (40, 40, 40)
+            frame[bar_top:height - 60, width - 120:width - 96] = (40, 200, 60)
+            if i % 40 < 10:
+                frame[height - 140:height - 90, 20:260] = (200, 220, 240)
+            writer.add(frame)
+        return writer.frame_count
+
+
+class ReplayClock:
+    """
+    Playback clock for ReplayReader, like the native one: seq 1 is shown
+    at start, seq n at start + (n - 1) * interval.
+    """
+
+    def __init__(self, frame_interval_us: int, start_us: Optional[int] = None):
+        self.interval = frame_interval_us
+        self.start_us = start_us if start_us is not None else int(time.perf_counter() * 1e6)
+
+    def seq_at(self, t_us: int) -> int:
+        return max(0, t_us - self.start_us) // self.interval + 1
+
+    def present_us(self, seq: int) -> int:
+        return self.start_us + (seq - 1) * self.interval
@@ -0,0 +1,126 @@
+"""
+Scheduling - Which Cores the Native Threads Run On
+
+Teacher Note: Capture, input, the step pipeline, the recorder and the
+window tracker are native threads (src/cpp/scheduling.h). They share the
+CPU with the game and with PyTorch, and when Windows parks the input or
+capture thread behind a busy game thread, that step is late - the p99
+spikes that line up with the game's own frame hitches.
+
+Each thread has a role, and each role a policy:
+
+    scheduling.set_policy("input", cores="performance", priority=2, mmcss="Games")
+    scheduling.set_policy("recorder", cores="efficiency", priority=-1)
+    ...
+    print(scheduling.report())        # CPU time per native thread
+
+or all at once with pin_for_game(). Set policies before creating the env:
+affinity and priority reach running threads too, but a thread can only
+join an MMCSS task itself, when it starts.
+
+cores is "performance" / "efficiency" (P- and E-cores on hybrid Intel
+chips; without them every core is a performance core and "efficiency"
+means any core), a list of logical processor numbers, or None for any.
+
+Without the C++ extension there are no native threads: everything here is
+a no-op and thread_stats() is empty.
+"""
+
+from typing import Dict, Iterable, List, Optional, Union
+
+try:
+    import src.gametrainer.clib as clib
+    HAS_NATIVE_SCHEDULING = hasattr(clib, "thread_policy")
+except ImportError:
+    clib = None
+    HAS_NATIVE_SCHEDULING = False
+
+# Thread roles (ThreadRole in src/cpp/scheduling.h)
+ROLES = {
+    "input": getattr(clib, "THREAD_INPUT", 0),
+    "capture": getattr(clib, "THREAD_CAPTURE", 1),
+    "pipeline": getattr(clib, "THREAD_PIPELINE", 2),
+    "recorder": getattr(clib, "THREAD_RECORDER", 3),
+    "window": getattr(clib, "THREAD_WINDOW", 4),
+}
+
+Cores = Union[None, str, int, Iterable[int]]
+
+
+def core_masks() -> Dict[str, int]:
+    """{performance, efficiency, logical}: processor bit masks and count."""
+    if not HAS_NATIVE_SCHEDULING:
+        return {"performance": 0, "efficiency": 0, "logical": 0}
+    performance, efficiency, logical = clib.core_masks()
+    return {"performance": performance, "efficiency": efficiency, "logical": logical}
+
+
+def _mask(cores: Cores) -> int:
+    if cores is None:
+        return 0
+    if isinstance(cores, int):
+        return cores
+    if isinstance(cores, str):
+        masks = core_masks()
+        if cores not in ("performance", "efficiency"):
+            raise ValueError(f"cores must be 'performance' or 'efficiency', not {cores!r}")
+        return masks[cores]         # 0 (no E-cores) = any core
+    mask = 0
+    for cpu in cores:
+        mask |= 1 << cpu
+    return mask
+
+
+def set_policy(role: str, cores: Cores = None, priority: int = 0,
+               mmcss: Optional[str] = None) -> None:
+    """
+    Where and how urgently `role`'s threads run. priority is -2 .. 2
+    (lowest .. highest); mmcss an MMCSS task such as "Games" or "Capture".
+    """
+    if role not in ROLES:
+        raise ValueError(f"unknown thread role {role!r} (one of {', '.join(ROLES)})")
+    if HAS_NATIVE_SCHEDULING:
+        clib.thread_policy(ROLES[role], _mask(cores), priority, mmcss)
+
+
+def pin_for_game() -> bool:
+    """
+    The policy we train with: input and capture on performance cores under
+    MMCSS, the pipeline next to them, the recorder and window tracker on
+    efficiency cores out of the way. False without the extension.
+    """
+    if not HAS_NATIVE_SCHEDULING:
+        return False
+    set_policy("input", cores="performance", priority=2, mmcss="Games")
+    set_policy("capture", cores="performance", priority=1, mmcss="Capture")
+    set_policy("pipeline", cores="performance", priority=1)
+    set_policy("recorder", cores="efficiency", priority=-1)
+    set_policy("window", cores="efficiency", priority=0)
+    return True
+
+
+def thread_stats() -> List[dict]:
+    """[{role, id, user_us, kernel_us, cycles, affinity, mmcss}] per running native thread."""
+    if not HAS_NATIVE_SCHEDULING:
+        return []
+    return clib.thread_stats()
+
+
+def report(title: Optional[str] = "NATIVE THREADS") -> str:
+    """thread_stats() as a table, busiest first."""
+    rows = sorted(thread_stats(), key=lambda t: t["user_us"] + t["kernel_us"], reverse=True)
+    lines = []
+    if title:
+        lines += ["=" * 72, title, "=" * 72]
+    if not rows:
+        lines.append("  (no native threads)")
+        return "\n".join(lines)
+    lines.append(f"  {'role':10s} {'id':>7s} {'user':>10s} {'kernel':>10s} {'Mcycles':>10s}  affinity")
+    for t in rows:
+        affinity = f"{t['affinity']:#x}" if t["affinity"] else "(refused)"
+        lines.append(
+            f"  {t['role']:10s} {t['id']:7d} {t['user_us'] / 1000:10.1f} {t['kernel_us'] / 1000:10.1f} "
+            f"{t['cycles'] / 1e6:10.1f}  {affinity}{'  MMCSS' if t['mmcss'] else ''}"
+        )
+    lines.append("  (CPU time in ms)")
+    return "\n".join(lines)
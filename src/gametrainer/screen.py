@@ -14,12 +14,29 @@ Why mss instead of PIL or pyautogui?
     - It captures directly from the screen buffer
     - Lower latency = more responsive bot
 
+On Windows, when the C++ extension is built, grab() uses DXGI Desktop
+Duplication instead (see src/cpp/capture.cpp): the GPU's own copy of the
+desktop, written into preallocated buffers with no per-frame allocation.
+start_stream() goes one step further: a background thread captures every
+new frame with its timestamp (src/cpp/capture_ring.cpp), and latest() /
+at_or_after(t) pick frames from it without capturing again.
+
+Every frame also gets a sequence number (frame_seq), and changed_since(seq,
+rect) says whether a region may have changed after it - from DXGI's dirty
+rectangles, or per-tile hashes on the mss path - so callers can skip work
+on frames where nothing moved.
+
+For benchmarks, backend="replay" plays a recorded frame file instead of
+the desktop (see replay.py): same API, same buffers, frames on the
+replay's own clock.
+
 The capture region can be:
     - Full screen (monitor)
     - A specific window (by title)
     - A custom rectangle (x, y, width, height)
 """
 
+import time
 import numpy as np
 from typing import Optional, Dict, Tuple
 import mss
@@ -33,6 +50,20 @@ try:
 except ImportError:
     HAS_WIN32 = False
 
+# Teacher Note: The C++ extension (built at M5, see setup.py) can capture with
+# DXGI Desktop Duplication, which is much faster than mss on big windows.
+# If it isn't built we silently stay on mss.
+try:
+    import src.gametrainer.clib as clib
+    HAS_NATIVE_CAPTURE = hasattr(clib, "capture_grab")
+    HAS_NATIVE_REPLAY = hasattr(clib, "replay_open")
+    HAS_NATIVE_WINDOWS = hasattr(clib, "window_track")
+except ImportError:
+    clib = None
+    HAS_NATIVE_CAPTURE = False
+    HAS_NATIVE_REPLAY = False
+    HAS_NATIVE_WINDOWS = False
+
 
 class ScreenCapture:
     """
@@ -53,27 +84,80 @@ class ScreenCapture:
             process(frame)
     """
 
-    def __init__(self):
+    def __init__(self, backend: str = "auto", buffers: int = 2, replay: Optional[str] = None):
         """
         Initialize the screen capture.
 
+        Args:
+            backend: "mss" (GDI, works everywhere), "dxgi" (C++ Desktop
+                     Duplication, Windows + built extension), "replay" (a
+                     recorded frame file, see replay.py) or "auto" (dxgi
+                     when available, else mss)
+            buffers: dxgi/replay - how many preallocated frame buffers to
+                     rotate through. A frame returned by grab() stays valid
+                     until `buffers` more grabs have happened.
+            replay: the replay file, for backend="replay". The region is
+                    the whole recorded frame (set_region_custom picks a
+                    part of it, in frame pixels).
+
         Teacher Note: We create the mss instance here. mss uses a context
         manager pattern, but we keep it alive for the lifetime of this object
         to avoid the overhead of recreating it every frame.
+        (We always need it: it also tells us where the monitors are.)
         """
         # The mss screenshot object - our connection to the screen
         self._sct = mss.mss()
 
+        if backend not in ("auto", "mss", "dxgi", "replay"):
+            raise ValueError(f"Unknown capture backend: {backend}")
+        if backend == "replay" and replay is None:
+            raise ValueError("backend='replay' needs a replay file")
+        if backend == "dxgi" and not HAS_NATIVE_CAPTURE:
+            print("DXGI capture needs the C++ extension - falling back to mss")
+        self._use_dxgi = backend in ("auto", "dxgi") and HAS_NATIVE_CAPTURE
+
+        # dxgi: preallocated BGRA buffers, rotated round-robin, and the
+        # region they were allocated for
+        self._num_buffers = max(1, buffers)
+        self._buffers = []
+        self._buffer_index = 0
+        self._buffer_region: Optional[Dict[str, int]] = None
+
+        # dxgi: background capture ring (start_stream) and its slot count
+        self._streaming = False
+        self._stream_slots = 4
+
+        # When the last returned frame was shown (now_us() clock)
+        self._last_timestamp_us: Optional[int] = None
+
+        # Change tracking: sequence number of the last returned frame, and
+        # (mss only) per-tile hashes + the seq at which each tile last changed
+        self._frame_seq = 0
+        self._tile_hashes: Optional[np.ndarray] = None
+        self._tile_seq: Optional[np.ndarray] = None
+
         # The region we're capturing: {"left": x, "top": y, "width": w, "height": h}
         # None means "not set yet"
         self._region: Optional[Dict[str, int]] = None
 
+        # The window the region follows (native window tracker) and the
+        # tracker version our region was taken at
+        self._window: Optional[int] = None
+        self._window_version = 0
+
         # Cache the last frame for debugging/display purposes
         self._last_frame: Optional[np.ndarray] = None
 
         # Statistics
         self._capture_count = 0
 
+        # replay: native handle (or numpy reader + clock) of the frame file
+        self._replay_handle = None
+        self._replay_reader = None
+        self._replay_clock = None
+        if backend == "replay":
+            self._open_replay(replay)
+
     def set_region_fullscreen(self, monitor_index: int = 1) -> bool:
         """
         Set capture region to a full monitor.
@@ -184,6 +268,7 @@ class ScreenCapture:
                     }
                     actual_title = win32gui.GetWindowText(hwnd)
                     print(f"SUCCESS: Captured '{actual_title}' ({width}x{height})")
+                    self._follow(hwnd)
                     return True
                 else:
                     print(f"Attempt {attempt+1}: Found window, but too small ({width}x{height}). Ignoring...")
@@ -196,10 +281,101 @@ class ScreenCapture:
         print(f"FAILED: Could not find a valid game window for '{window_title}' after {retry_count} attempts.")
         return False
 
+    def set_region_from_hwnd(self, hwnd: int) -> bool:
+        """
+        Set capture region to one specific window (see find_windows).
+
+        Teacher Note: With several game instances open they all have the
+        same title, so the vectorized env picks each one by its handle.
+        """
+        if not HAS_WIN32:
+            print("win32gui not available - can't read window rectangles")
+            return False
+        try:
+            x, y, right, bottom = win32gui.GetWindowRect(hwnd)
+        except Exception as e:
+            print(f"ERROR: Could not read window {hwnd}: {e}")
+            return False
+        if not self.set_region_custom(x, y, right - x, bottom - y):
+            return False
+        self._follow(hwnd)
+        return True
+
+    def _follow(self, hwnd: int) -> None:
+        """Let the native window tracker keep the region on this window."""
+        if HAS_NATIVE_WINDOWS:
+            self._window = hwnd
+            self._window_version = clib.window_track(hwnd)
+
+    def follow_window(self) -> bool:
+        """
+        Move the region to where the followed window is now. True if it
+        changed (the next grab reopens the capture for the new place).
+
+        Teacher Note: Windows tells the tracker about every move/resize
+        (SetWinEventHook), so this is one native call that compares a
+        counter - cheap enough for every step. Call it between steps,
+        never between a "before" and an "after" frame. A minimized window
+        keeps its old region.
+        """
+        if self._window is None:
+            return False
+        version = clib.window_version(self._window)
+        if version == self._window_version:
+            return False
+        self._window_version = version
+        state = clib.window_state(self._window)
+        if state is None:
+            return False
+        _, x, y, width, height, flags = state
+        if not flags & clib.WINDOW_ALIVE or flags & clib.WINDOW_MINIMIZED or width <= 0 or height <= 0:
+            return False
+        region = {"left": x, "top": y, "width": width, "height": height}
+        if region == self._region:
+            return False
+        self._region = region
+        print(f"Capture region follows window: {region}")
+        return True
+
+    @property
+    def window(self) -> Optional[int]:
+        """Handle of the window the region follows (None: not tracked)."""
+        return self._window
+
+    def find_windows(self, partial_title: str, min_area: int = 800 * 600) -> list:
+        """
+        Handles of all visible windows whose title contains partial_title and
+        that are at least min_area pixels, left to right then top to bottom.
+        """
+        if HAS_NATIVE_WINDOWS:
+            return clib.window_find_all(partial_title, min_area)
+        if not HAS_WIN32:
+            return []
+        found = []
+        partial_lower = partial_title.lower()
+
+        def callback(hwnd, _):
+            if win32gui.IsWindowVisible(hwnd) and partial_lower in win32gui.GetWindowText(hwnd).lower():
+                try:
+                    x, y, right, bottom = win32gui.GetWindowRect(hwnd)
+                    if (right - x) * (bottom - y) >= min_area:
+                        found.append((x, y, hwnd))
+                except Exception:
+                    pass
+            return True
+
+        win32gui.EnumWindows(callback, None)
+        return [hwnd for x, y, hwnd in sorted(found)]
+
     def _find_window_by_title(self, partial_title: str) -> Optional[int]:
         """
         Find the largest window handle by partial title match.
+
+        Teacher Note: The native search walks the windows in C++; the
+        fallback below calls back into Python once per top-level window.
         """
+        if HAS_NATIVE_WINDOWS:
+            return clib.window_find(partial_title) or None
         candidates = []
         partial_lower = partial_title.lower()
 
@@ -245,6 +421,13 @@ class ScreenCapture:
             print("Capture region not set! Call set_region_* first.")
             return None
 
+        if self.is_replay:
+            return self._grab_replay(self._replay_seq_at(self.now_us()))
+        if self._streaming:
+            return self.latest()
+        if self._use_dxgi:
+            return self._grab_dxgi()
+
         try:
             # Grab the screenshot - this is the fast part
             sct_img = self._sct.grab(self._region)
@@ -256,7 +439,10 @@ class ScreenCapture:
 
             # Cache for debugging
             self._last_frame = frame
+            self._last_timestamp_us = self.now_us()
             self._capture_count += 1
+            self._frame_seq += 1
+            self._update_tiles(frame)
 
             return frame
 
@@ -264,6 +450,317 @@ class ScreenCapture:
             print(f"Screen capture failed: {e}")
             return None
 
+    def _prepare_dxgi(self) -> None:
+        """
+        Make sure the DXGI output and our buffers match the current region.
+
+        Teacher Note: Nothing is allocated per frame. The C++ code copies the
+        pixels straight into one of our preallocated numpy buffers (through
+        Python's "buffer protocol" - a way to share raw memory between
+        Python and C). [:, :, :3] is a view that skips alpha, not a copy.
+        """
+        region = self._region
+        if region == self._buffer_region:
+            return
+        # New region: (re)open the monitor it's on, allocate buffers once
+        try:
+            clib.capture_open(region["left"], region["top"])
+        except OSError as e:
+            # Teacher Note: HDR, FP16 and rotated desktops aren't BGRA8 in
+            # desktop orientation - mss reads those fine, only slower.
+            print(f"DXGI capture unavailable ({e}) - falling back to mss")
+            self._use_dxgi = False
+            self._streaming = False
+            raise
+        shape = (region["height"], region["width"], 4)
+        self._buffers = [np.zeros(shape, dtype=np.uint8) for _ in range(self._num_buffers)]
+        self._buffer_index = 0
+        self._buffer_region = dict(region)
+        if self._streaming:
+            clib.capture_ring_start(region["left"], region["top"], region["width"],
+                                    region["height"], self._stream_slots)
+
+    def _next_buffer(self) -> np.ndarray:
+        """The next preallocated BGRA buffer, round-robin."""
+        buf = self._buffers[self._buffer_index]
+        self._buffer_index = (self._buffer_index + 1) % len(self._buffers)
+        return buf
+
+    def _grab_dxgi(self) -> Optional[np.ndarray]:
+        """grab() via the C++ DXGI backend."""
+        region = self._region
+        try:
+            self._prepare_dxgi()
+            buf = self._next_buffer()
+            clib.capture_grab(buf, region["left"], region["top"], region["width"], region["height"])
+
+            frame = buf[:, :, :3]
+            self._last_frame = frame
+            self._last_timestamp_us = self.now_us()
+            self._capture_count += 1
+            self._frame_seq = clib.capture_frame_seq()
+            return frame
+
+        except Exception as e:
+            if not self._use_dxgi:
+                return self.grab()          # this desktop is mss-only now
+            print(f"Screen capture failed: {e}")
+            return None
+
+    # =========================================================================
+    # REPLAY (recorded frames, for benchmarks)
+    # =========================================================================
+
+    def _open_replay(self, path: str) -> None:
+        """Open a replay file; the region becomes its whole frame."""
+        if HAS_NATIVE_REPLAY:
+            self._replay_handle = clib.replay_open(path)
+            width, height, count, interval_us = clib.replay_info(self._replay_handle)
+        else:
+            from src.gametrainer.replay import ReplayReader, ReplayClock
+            self._replay_reader = ReplayReader(path)
+            width, height = self._replay_reader.width, self._replay_reader.height
+            count, interval_us = self._replay_reader.frame_count, self._replay_reader.frame_interval_us
+            self._replay_clock = ReplayClock(interval_us, self.now_us())
+        self._region = {"left": 0, "top": 0, "width": width, "height": height}
+        print(f"Capture: replay {path} ({width}x{height}, {count} frames "
+              f"@ {1e6 / interval_us:.0f} FPS, {'native' if HAS_NATIVE_REPLAY else 'numpy'})")
+
+    @property
+    def is_replay(self) -> bool:
+        """True if frames come from a replay file instead of the screen."""
+        return self._replay_handle is not None or self._replay_reader is not None
+
+    def restart_replay(self) -> None:
+        """Play the replay from its first frame again, starting now."""
+        if self._replay_handle is not None:
+            clib.replay_start(self._replay_handle, self.now_us())
+        elif self._replay_clock is not None:
+            self._replay_clock.start_us = self.now_us()
+
+    def _replay_seq_at(self, t_us: int) -> int:
+        if self._replay_handle is not None:
+            return clib.replay_seq_at(self._replay_handle, t_us)
+        return self._replay_clock.seq_at(t_us)
+
+    def _grab_replay(self, seq: int) -> Optional[np.ndarray]:
+        """Copy replay frame `seq` (our region of it) into the next buffer."""
+        region = self._region
+        try:
+            shape = (region["height"], region["width"], 4)
+            if self._buffer_region != region:
+                self._buffers = [np.zeros(shape, dtype=np.uint8) for _ in range(self._num_buffers)]
+                self._buffer_index = 0
+                self._buffer_region = dict(region)
+            buf = self._next_buffer()
+            if self._replay_handle is not None:
+                stamp = clib.replay_read(self._replay_handle, buf, seq, region["left"], region["top"])
+            else:
+                src = self._replay_reader.frame(seq - 1)
+                x, y = region["left"], region["top"]
+                part = src[y:y + region["height"], x:x + region["width"]]
+                buf[:part.shape[0], :part.shape[1]] = part
+                stamp = (self._replay_clock.present_us(seq), seq)
+            return self.stream_frame(buf, stamp)
+
+        except Exception as e:
+            print(f"Screen capture failed: {e}")
+            return None
+
+    def close(self) -> None:
+        """Stop streaming, stop following the window and release a replay file."""
+        self.stop_stream()
+        if self._window is not None:
+            clib.window_untrack(self._window)
+            self._window = None
+        if self._replay_handle is not None:
+            clib.replay_close(self._replay_handle)
+            self._replay_handle = None
+        self._replay_reader = None
+
+    # =========================================================================
+    # STREAMING (background capture ring)
+    # =========================================================================
+
+    def start_stream(self, slots: int = 4) -> bool:
+        """
+        Start capturing continuously in a background C++ thread.
+
+        Args:
+            slots: how many timestamped frames the ring keeps
+
+        Returns:
+            True if streaming started (needs the dxgi backend and a region)
+
+        Teacher Note: Without a stream, latest() and at_or_after() still work:
+        they just grab on demand (and at_or_after sleeps until the time).
+        """
+        if not self._use_dxgi or not hasattr(clib, "capture_ring_start") or self._region is None:
+            return False
+        try:
+            self._stream_slots = max(2, slots)
+            self._buffer_region = None   # force _prepare_dxgi to (re)start the ring
+            self._streaming = True
+            self._prepare_dxgi()
+            return True
+        except Exception as e:
+            print(f"ERROR: Could not start capture stream: {e}")
+            self._streaming = False
+            return False
+
+    def stop_stream(self) -> None:
+        """Stop the background capture thread (grab() captures on demand again)."""
+        if self._streaming:
+            self._streaming = False
+            try:
+                clib.capture_ring_stop()
+            except Exception as e:
+                print(f"ERROR: Could not stop capture stream: {e}")
+
+    @property
+    def streaming(self) -> bool:
+        """True while the background capture ring is running."""
+        return self._streaming
+
+    def now_us(self) -> int:
+        """
+        Current time in microseconds, on the same clock as frame timestamps.
+
+        Teacher Note: Use this (not time.time()) to say "the frame 30 ms after
+        I pressed the key": at_or_after(cap.now_us() + 30_000).
+        """
+        if clib is not None and hasattr(clib, "qpc_us"):
+            return clib.qpc_us()
+        return int(time.perf_counter() * 1e6)
+
+    def latest(self, timeout: float = 0.1) -> Optional[np.ndarray]:
+        """
+        The newest frame (BGR view), or None if none arrived within timeout.
+        """
+        if not self._streaming:
+            return self.grab()
+        return self._read_stream(lambda buf: clib.capture_ring_latest(buf, int(timeout * 1000)))
+
+    def at_or_after(self, t_us: int, timeout: float = 0.1) -> Optional[np.ndarray]:
+        """
+        The first frame on screen at or after time t_us (see now_us()).
+
+        Waits for it if t_us is in the future; None after `timeout` seconds
+        past t_us without a frame.
+        """
+        if not self._streaming:
+            delay = (t_us - self.now_us()) / 1e6
+            if delay > 0:
+                time.sleep(delay)
+            if self.is_replay:
+                return self._grab_replay(self._replay_seq_at(max(t_us, self.now_us())))
+            return self.grab()
+        wait_ms = max(0, (t_us - self.now_us()) // 1000) + int(timeout * 1000)
+        return self._read_stream(lambda buf: clib.capture_ring_at_or_after(buf, t_us, wait_ms))
+
+    def _read_stream(self, read) -> Optional[np.ndarray]:
+        """Copy one ring frame into our next buffer using `read(buf)`."""
+        try:
+            buf = self.stream_buffer()
+            stamp = read(buf)
+            if stamp is None:
+                return None
+            return self.stream_frame(buf, stamp)
+
+        except Exception as e:
+            print(f"Screen capture failed: {e}")
+            return None
+
+    def stream_buffer(self) -> np.ndarray:
+        """
+        The next BGRA frame buffer, for native code that reads ring frames
+        itself (see pipeline.py). Pass it to stream_frame() once filled.
+        """
+        self._prepare_dxgi()
+        return self._next_buffer()
+
+    def stream_frame(self, buf: np.ndarray, stamp) -> np.ndarray:
+        """
+        Record a ring frame that was copied into buf ((present_us, seq)
+        stamp) as our latest; returns its BGR view.
+        """
+        frame = buf[:, :, :3]
+        self._last_frame = frame
+        self._last_timestamp_us, self._frame_seq = stamp
+        self._capture_count += 1
+        return frame
+
+    @property
+    def last_timestamp_us(self) -> Optional[int]:
+        """When the last returned frame was shown, in now_us() time."""
+        return self._last_timestamp_us
+
+    # =========================================================================
+    # CHANGE DETECTION
+    # =========================================================================
+
+    @property
+    def frame_seq(self) -> int:
+        """Sequence number of the last returned frame (for changed_since)."""
+        return self._frame_seq
+
+    def changed_since(self, seq: Optional[int], rect: Optional[Tuple[int, int, int, int]] = None) -> bool:
+        """
+        May anything in rect have changed after frame `seq`?
+
+        Args:
+            seq: a frame_seq seen earlier (None = "I have nothing", so True)
+            rect: (x, y, w, h) in frame pixels; None = the whole frame
+
+        Teacher Note: This errs on the side of True. False is a promise the
+        pixels are identical, so the caller can reuse last time's result.
+        Without the C++ extension there is no change info and it's always True.
+        """
+        if seq is None or self._region is None:
+            return True
+        if self.is_replay:
+            return self._frame_seq != seq
+        region = self._region
+        x, y, w, h = rect if rect is not None else (0, 0, region["width"], region["height"])
+
+        if self._use_dxgi:
+            try:
+                return clib.capture_changed_since(region["left"] + x, region["top"] + y, w, h, seq)
+            except Exception:
+                return True
+
+        if self._tile_seq is None:
+            return True
+        t = clib.CAPTURE_TILE
+        tiles = self._tile_seq[max(0, y) // t:-(-(y + h) // t), max(0, x) // t:-(-(x + w) // t)]
+        return tiles.size > 0 and int(tiles.max()) > seq
+
+    def _update_tiles(self, frame: np.ndarray) -> None:
+        """mss path: hash each tile and note which changed in this frame."""
+        if clib is None or not hasattr(clib, "tile_hashes"):
+            return
+        try:
+            t = clib.CAPTURE_TILE
+            h, w = frame.shape[:2]
+            hashes = np.empty((-(-h // t), -(-w // t)), dtype=np.uint64)
+            clib.tile_hashes(frame, hashes, t)
+
+            if self._tile_hashes is None or self._tile_hashes.shape != hashes.shape:
+                self._tile_seq = np.full(hashes.shape, self._frame_seq, dtype=np.uint64)
+            else:
+                self._tile_seq[hashes != self._tile_hashes] = self._frame_seq
+            self._tile_hashes = hashes
+        except Exception as e:
+            print(f"ERROR: Tile hashing failed: {e}")
+            self._tile_seq = None
+
+    @property
+    def backend(self) -> str:
+        """Which capture backend is in use ("dxgi", "mss" or "replay")."""
+        if self.is_replay:
+            return "replay"
+        return "dxgi" if self._use_dxgi else "mss"
+
     def grab_and_save(self, filename: str) -> bool:
         """
         Capture a screenshot and save it to a file.
@@ -0,0 +1,310 @@
+"""
+ShmSubprocVecEnv - One Process per Game Instance, Observations in Shared Memory
+
+Teacher Note: SB3's SubprocVecEnv runs each env in its own process and sends
+every result back through a pipe - which means pickling the (3, 224, 224)
+observation (150 KB) on one side and unpickling it on the other, every step,
+for every env. Past a handful of envs that copying becomes the bottleneck.
+
+Here the observations never go through the pipe. One shared-memory block
+(multiprocessing.shared_memory) holds a ring of SLOTS, and each slot holds
+one observation per env, laid out as one (N, 3, 224, 224) array:
+
+    slot 0: [env 0][env 1]...[env N-1]
+    slot 1: [env 0][env 1]...[env N-1]
+    ...
+
+Each step uses the next slot. Every worker writes its observation straight
+into its place in that slot (StardewViTEnv.obs_out: the C++ preprocess
+writes there directly) and stamps it with the step's sequence number. The
+pipe only carries the reward, done flag and info. The trainer then gets
+arena.obs[slot] - a numpy view of the whole batch, with nothing copied.
+
+A returned batch stays valid for (slots - 1) more steps. SB3 keeps the last
+observation until after the next step, so at least 2 slots are needed.
+"""
+
+import multiprocessing as mp
+from multiprocessing import shared_memory
+from typing import Callable, List, Optional, Sequence
+
+import gymnasium as gym
+import numpy as np
+from stable_baselines3.common.vec_env.base_vec_env import CloudpickleWrapper, VecEnv
+
+# Observation buffers start on a cache line
+ARENA_ALIGN = 64
+
+
+class ObservationArena:
+    """
+    The shared block: a (slots, N) uint64 sequence-number table, then the
+    (slots, N, *shape) observations.
+    """
+
+    def __init__(self, shm: shared_memory.SharedMemory, slots: int, num_envs: int,
+                 shape: Sequence[int], dtype, owner: bool):
+        self.shm = shm
+        self.slots = slots
+        self.owner = owner
+        seq_bytes = slots * num_envs * 8
+        obs_offset = (seq_bytes + ARENA_ALIGN - 1) // ARENA_ALIGN * ARENA_ALIGN
+        self.seq = np.ndarray((slots, num_envs), dtype=np.uint64, buffer=shm.buf)
+        self.obs = np.ndarray((slots, num_envs) + tuple(shape), dtype=dtype,
+                              buffer=shm.buf, offset=obs_offset)
+
+    @staticmethod
+    def nbytes(slots: int, num_envs: int, shape: Sequence[int], dtype) -> int:
+        seq_bytes = slots * num_envs * 8
+        obs_offset = (seq_bytes + ARENA_ALIGN - 1) // ARENA_ALIGN * ARENA_ALIGN
+        return obs_offset + slots * num_envs * int(np.prod(shape)) * np.dtype(dtype).itemsize
+
+    @classmethod
+    def create(cls, slots: int, num_envs: int, shape: Sequence[int], dtype) -> "ObservationArena":
+        shm = shared_memory.SharedMemory(create=True, size=cls.nbytes(slots, num_envs, shape, dtype))
+        arena = cls(shm, slots, num_envs, shape, dtype, owner=True)
+        arena.seq[:] = 0
+        return arena
+
+    @classmethod
+    def attach(cls, name: str, slots: int, num_envs: int, shape: Sequence[int], dtype) -> "ObservationArena":
+        return cls(shared_memory.SharedMemory(name=name), slots, num_envs, shape, dtype, owner=False)
+
+    @property
+    def name(self) -> str:
+        return self.shm.name
+
+    def close(self) -> None:
+        # Drop our views first: the mapping can't close while they exist
+        self.seq = self.obs = None
+        try:
+            self.shm.close()
+        except BufferError:
+            pass   # a caller still holds a batch; the mapping goes with it
+        if self.owner:
+            self.shm.unlink()
+
+
+def _publish(arena: ObservationArena, slot: int, index: int, seq: int, obs) -> None:
+    """Make sure obs is in its arena place, then stamp it with seq."""
+    target = arena.obs[slot, index]
+    if not np.shares_memory(obs, target):
+        target[...] = obs   # env built its own array (lost capture, ...)
+    arena.seq[slot, index] = seq
+
+
+def _worker(remote, parent_remote, env_fn_wrapper, index: int) -> None:
+    """
+    Worker process: steps one env, observations into the arena.
+    (Same commands as SB3's SubprocVecEnv worker.)
+
+    The arena is sized from the envs' observation space, so each worker
+    first reports its spaces and then waits for the arena to attach to
+    (None: the parent gave up, just close).
+    """
+    parent_remote.close()
+    env = env_fn_wrapper.var()
+    remote.send((env.observation_space, env.action_space))
+    arena_args = remote.recv()
+    if arena_args is None:
+        env.close()
+        remote.close()
+        return
+    arena = ObservationArena.attach(*arena_args)
+    try:
+        while True:
+            cmd, data = remote.recv()
+            if cmd == "step":
+                slot, seq, action = data
+                env.obs_out = arena.obs[slot, index]
+                obs, reward, terminated, truncated, info = env.step(action)
+                done = terminated or truncated
+                info["TimeLimit.truncated"] = truncated and not terminated
+                reset_info = {}
+                if done:
+                    # Rare: the terminal observation travels in info (a copy),
+                    # the first one of the new episode takes its slot
+                    info["terminal_observation"] = np.array(obs)
+                    obs, reset_info = env.reset()
+                _publish(arena, slot, index, seq, obs)
+                remote.send((reward, done, info, reset_info))
+            elif cmd == "reset":
+                slot, seq, seed, options = data
+                env.obs_out = arena.obs[slot, index]
+                obs, reset_info = env.reset(seed=seed, options=options)
+                _publish(arena, slot, index, seq, obs)
+                remote.send(reset_info)
+            elif cmd == "env_method":
+                method = getattr(env, data[0])
+                remote.send(method(*data[1], **data[2]))
+            elif cmd == "get_attr":
+                remote.send(getattr(env, data))
+            elif cmd == "set_attr":
+                remote.send(setattr(env, data[0], data[1]))
+            elif cmd == "is_wrapped":
+                remote.send(isinstance(env, data))
+            elif cmd == "close":
+                env.close()
+                remote.close()
+                break
+            else:
+                raise NotImplementedError(f"`{cmd}` is not implemented in the worker")
+    except KeyboardInterrupt:
+        pass
+    finally:
+        env.obs_out = None
+        arena.close()
+
+
+class ShmSubprocVecEnv(VecEnv):
+    """
+    SubprocVecEnv with observations in a shared-memory arena.
+
+    Observation space must be a uint8 (or any fixed-dtype) Box; the envs
+    should honour an `obs_out` attribute (StardewViTEnv does) to skip the
+    last copy, but any gym env works.
+    """
+
+    def __init__(self, env_fns: List[Callable[[], gym.Env]], slots: int = 2,
+                 start_method: Optional[str] = None):
+        """
+        Args:
+            env_fns: one function per worker process, each creating its env
+            slots: observation batches kept in the ring (>= 2)
+            start_method: multiprocessing start method (default: forkserver
+                          where available, else spawn - as SubprocVecEnv)
+        """
+        if slots < 2:
+            raise ValueError("ShmSubprocVecEnv needs at least 2 slots")
+        self.waiting = False
+        self.closed = False
+        n = len(env_fns)
+
+        if start_method is None:
+            start_method = "forkserver" if "forkserver" in mp.get_all_start_methods() else "spawn"
+        ctx = mp.get_context(start_method)
+
+        self.remotes, self.work_remotes = zip(*[ctx.Pipe() for _ in range(n)])
+        self.processes = []
+        for index, (work_remote, remote, env_fn) in enumerate(zip(self.work_remotes, self.remotes, env_fns)):
+            args = (work_remote, remote, CloudpickleWrapper(env_fn), index)
+            process = ctx.Process(target=_worker, args=args, daemon=True)
+            process.start()
+            self.processes.append(process)
+            work_remote.close()
+
+        # The arena's size depends on the observation space, which only the
+        # envs know. Every worker builds its env and reports its spaces; we
+        # size the arena from env 0's and hand it to all of them.
+        # Teacher Note: No extra env just to read a shape - for a game env
+        # that would mean another window lookup and capture setup.
+        spaces = [remote.recv() for remote in self.remotes]
+        self.observation_space, self.action_space = spaces[0]
+        space = self.observation_space
+        error = None
+        if not isinstance(space, gym.spaces.Box):
+            error = "ShmSubprocVecEnv needs a Box observation space"
+        else:
+            mismatched = [i for i, (obs_space, _) in enumerate(spaces)
+                          if obs_space.shape != space.shape or obs_space.dtype != space.dtype]
+            if mismatched:
+                error = f"env(s) {mismatched} observation space differs from env 0's {space}"
+        if error is not None:
+            for remote in self.remotes:
+                remote.send(None)
+            for process in self.processes:
+                process.join()
+            raise ValueError(error)
+
+        self.arena = ObservationArena.create(slots, n, space.shape, space.dtype)
+        arena_args = (self.arena.name, slots, n, space.shape, space.dtype)
+        for remote in self.remotes:
+            remote.send(arena_args)
+
+        super().__init__(n, self.observation_space, self.action_space)
+        self._slot = 0
+        self._seq = 0
+
+    # =========================================================================
+    # VecEnv API
+    # =========================================================================
+
+    def _next_slot(self):
+        """The slot and sequence number for the next batch."""
+        self._slot = (self._slot + 1) % self.arena.slots
+        self._seq += 1
+        return self._slot, self._seq
+
+    def _batch(self, slot: int, seq: int) -> np.ndarray:
+        """arena.obs[slot], after checking every env stamped it with seq."""
+        stamps = self.arena.seq[slot]
+        if not np.all(stamps == seq):
+            stale = np.nonzero(stamps != seq)[0].tolist()
+            raise RuntimeError(f"observation slot {slot} not written for step {seq} by env(s) {stale}")
+        return self.arena.obs[slot]
+
+    def reset(self):
+        slot, seq = self._next_slot()
+        seeds = getattr(self, "_seeds", [None] * self.num_envs)
+        options = getattr(self, "_options", [{}] * self.num_envs)
+        for remote, seed, opts in zip(self.remotes, seeds, options):
+            remote.send(("reset", (slot, seq, seed, opts)))
+        self.reset_infos = [remote.recv() for remote in self.remotes]
+        if hasattr(self, "_reset_seeds"):
+            self._reset_seeds()
+        if hasattr(self, "_reset_options"):
+            self._reset_options()
+        return self._batch(slot, seq)
+
+    def step_async(self, actions: np.ndarray) -> None:
+        self._step = self._next_slot()
+        slot, seq = self._step
+        for remote, action in zip(self.remotes, actions):
+            remote.send(("step", (slot, seq, action)))
+        self.waiting = True
+
+    def step_wait(self):
+        results = [remote.recv() for remote in self.remotes]
+        self.waiting = False
+        rewards, dones, infos, self.reset_infos = zip(*results)
+        obs = self._batch(*self._step)
+        return obs, np.array(rewards, dtype=np.float32), np.array(dones, dtype=bool), list(infos)
+
+    def close(self) -> None:
+        if self.closed:
+            return
+        if self.waiting:
+            for remote in self.remotes:
+                remote.recv()
+        for remote in self.remotes:
+            remote.send(("close", None))
+        for process in self.processes:
+            process.join()
+        self.arena.close()
+        self.closed = True
+
+    def get_attr(self, attr_name: str, indices=None) -> list:
+        targets = [self.remotes[i] for i in self._get_indices(indices)]
+        for remote in targets:
+            remote.send(("get_attr", attr_name))
+        return [remote.recv() for remote in targets]
+
+    def set_attr(self, attr_name: str, value, indices=None) -> None:
+        targets = [self.remotes[i] for i in self._get_indices(indices)]
+        for remote in targets:
+            remote.send(("set_attr", (attr_name, value)))
+        for remote in targets:
+            remote.recv()
+
+    def env_method(self, method_name: str, *method_args, indices=None, **method_kwargs) -> list:
+        targets = [self.remotes[i] for i in self._get_indices(indices)]
+        for remote in targets:
+            remote.send(("env_method", (method_name, method_args, method_kwargs)))
+        return [remote.recv() for remote in targets]
+
+    def env_is_wrapped(self, wrapper_class, indices=None) -> List[bool]:
+        targets = [self.remotes[i] for i in self._get_indices(indices)]
+        for remote in targets:
+            remote.send(("is_wrapped", wrapper_class))
+        return [remote.recv() for remote in targets]
+
@@ -0,0 +1,348 @@
+"""
+StardewVecEnv - Several Game Instances, One Batched Step
+
+Teacher Note: scripts/train.py used to wrap ONE StardewViTEnv in a
+DummyVecEnv, so every step was: capture, act, wait 30 ms, capture, reward,
+preprocess, ViT forward pass - all strictly one after another, with the GPU
+idle most of the time. Running N copies of the game side by side gives PPO
+N observations per forward pass, but doing N of those sequential steps
+would just make each one N times slower.
+
+So this VecEnv steps all instances together:
+
+    1. Send every instance its action (one after another - input is fast)
+    2. Wait the 30 ms ONCE, for all of them
+    3. Capture ONE frame covering every game window (the bounding box)
+    4. In C++ (src/cpp/batch_observe.cpp), on one thread per instance:
+       preprocess each window's part of the frame into one contiguous
+       (N, 3, 224, 224) buffer, and compute its reward pixel statistics
+    5. Turn those statistics into rewards with each instance's own
+       StardewViTEnv logic (its stuck counter, energy history...)
+
+With pipelined=True, step_async sends the actions and queues each frame-skip
+repeat's capture + batch observation on the C++ step pipeline (see
+pipeline.py), and step_wait collects them; each instance's UI scan then
+runs in the background during the policy's next forward pass.
+
+Limitations:
+    - All game windows must be on the same monitor (DXGI duplicates one
+      output) and must not overlap.
+    - Input is posted to each instance's own window (no focus needed). A
+      game that rejects window messages falls back to SendInput, and that
+      instance is brought to the front right before its input is sent.
+"""
+
+from typing import List, Optional
+
+import gymnasium as gym
+import numpy as np
+from stable_baselines3.common.vec_env.base_vec_env import VecEnv
+
+from src.gametrainer.env_vit import StardewViTEnv
+from src.gametrainer.pipeline import StepPipeline
+from src.gametrainer import profiler
+from src.gametrainer.screen import ScreenCapture
+
+try:
+    import src.gametrainer.clib as clib
+    HAS_NATIVE_BATCH = hasattr(clib, "observe_batch")
+except ImportError:
+    clib = None
+    HAS_NATIVE_BATCH = False
+
+
+class StardewVecEnv(VecEnv):
+    """
+    Vectorized environment over every open game window (or the first N).
+
+    Observation: (N, 3, 224, 224) uint8, one contiguous array
+    Action: one Discrete(12) action per instance
+    """
+
+    def __init__(self, window_title: str = "Stardew Valley", num_envs: Optional[int] = None,
+                 render_mode=None, threads: int = 0, pipelined: bool = False,
+                 sendinput: bool = False):
+        """
+        Args:
+            window_title: title of the game windows (partial match)
+            num_envs: use only the first N windows (None = all of them)
+            render_mode: passed to each StardewViTEnv
+            threads: C++ worker threads for the batch (0 = one per core)
+            pipelined: step through the C++ step pipeline (see step_async)
+            sendinput: SendInput instead of window messages (see StardewViTEnv)
+        """
+        # Three buffers: a "before" frame and an "after" frame are in use at
+        # once, while the previous step's frame may still be referenced.
+        # Pipelined, every frame of a step is in flight at once.
+        self.cap = ScreenCapture(buffers=StardewViTEnv.FRAME_SKIP + 2 if pipelined else 3)
+        hwnds = self.cap.find_windows(window_title)
+        if num_envs is not None:
+            hwnds = hwnds[:num_envs]
+        if not hwnds:
+            raise RuntimeError(f"No '{window_title}' windows found")
+
+        self.envs: List[StardewViTEnv] = [
+            StardewViTEnv(render_mode=render_mode, window_title=window_title, hwnd=hwnd, stream=False,
+                          sendinput=sendinput)
+            for hwnd in hwnds
+        ]
+
+        # One capture region around all windows; each instance is a rect in it
+        regions = [env.cap.region for env in self.envs]
+        left = min(r["left"] for r in regions)
+        top = min(r["top"] for r in regions)
+        right = max(r["left"] + r["width"] for r in regions)
+        bottom = max(r["top"] + r["height"] for r in regions)
+        self.cap.set_region_custom(left, top, right - left, bottom - top)
+        self.cap.start_stream()
+        self._rects = [(r["left"] - left, r["top"] - top, r["width"], r["height"]) for r in regions]
+
+        env = self.envs[0]
+        super().__init__(len(self.envs), env.observation_space, env.action_space)
+
+        # Teacher Note: Two observation buffers, used in turn. PPO keeps the
+        # last observation we returned and only copies it into its rollout
+        # buffer AFTER the next step() - so that step must not overwrite it.
+        self._obs = [np.zeros((self.num_envs,) + env.observation_space.shape, dtype=np.uint8)
+                     for _ in range(2)]
+        self._obs_index = 0
+        self._actions = None
+        self._threads = threads
+        self._pipeline = StepPipeline(self.cap, threads) if pipelined else None
+        self._jobs = None
+
+        print(f"StardewVecEnv: {self.num_envs} instance(s), capture {right - left}x{bottom - top}"
+              f"{' (native batch)' if HAS_NATIVE_BATCH else ''}"
+              f"{' (pipelined)' if self._pipelined() else ''}")
+
+    # =========================================================================
+    # VecEnv API
+    # =========================================================================
+
+    def reset(self):
+        if self._pipeline is not None:
+            self._pipeline.drain()
+            self._jobs = None
+        for env in self.envs:
+            env._join_scan()
+        seeds = getattr(self, "_seeds", [None] * self.num_envs)
+        for env, seed in zip(self.envs, seeds):
+            gym.Env.reset(env, seed=seed)
+            env._reset_state()
+        if hasattr(self, "_reset_seeds"):
+            self._reset_seeds()
+
+        frame = self.cap.grab()
+        obs = self._next_obs()
+        if frame is None:
+            obs[:] = 0
+        else:
+            self._observe(frame, None, None, obs, rewards=False)
+        return obs
+
+    def step_async(self, actions) -> None:
+        self._actions = actions
+        if self._pipelined():
+            self._submit_step(self._clip_actions(actions))
+
+    def step_wait(self):
+        with profiler.span(profiler.ENV_STEP):
+            return self._step_wait()
+
+    def _step_wait(self):
+        if self._jobs is not None:
+            return self._collect_step()
+        n = self.num_envs
+        actions = self._clip_actions(self._actions)
+        rewards = np.zeros(n, dtype=np.float32)
+        obs = self._next_obs()
+        frame = None
+
+        # Same frame-skip loop as StardewViTEnv.step, for every instance at once
+        for repeat in range(StardewViTEnv.FRAME_SKIP):
+            frame_before = frame if frame is not None else self.cap.latest()
+
+            for env, action in zip(self.envs, actions):
+                env._take_action(action)
+
+            frame = self.cap.at_or_after(self.cap.now_us() + 30_000)
+            if frame is None:
+                return self._lost(obs, rewards)
+
+            last = repeat == StardewViTEnv.FRAME_SKIP - 1
+            features = self._observe(frame, frame_before, actions, obs if last else None)
+            for i, (env, action) in enumerate(zip(self.envs, actions)):
+                rewards[i] += env._reward_from_features(features[i], action, frame_before is not None)
+
+        return self._finish(frame, actions, rewards, obs, self.cap.frame_seq)
+
+    def _clip_actions(self, actions) -> list:
+        return [int(np.clip(a, 0, self.action_space.n - 1)) for a in np.asarray(actions).reshape(-1)]
+
+    def _lost(self, obs, rewards):
+        """Capture lost - end every episode, like StardewViTEnv does."""
+        n = self.num_envs
+        obs[:] = 0
+        infos = [{"terminal_observation": obs[i].copy()} for i in range(n)]
+        for env in self.envs:
+            env._reset_state()
+        return obs, rewards, np.ones(n, dtype=bool), infos
+
+    def _finish(self, frame, actions, rewards, obs, frame_seq, defer_scan: bool = False):
+        """Per-instance bookkeeping + auto-reset after the frame-skip loop."""
+        n = self.num_envs
+        dones = np.zeros(n, dtype=bool)
+        infos = []
+        for i, (env, action) in enumerate(zip(self.envs, actions)):
+            terminated, truncated, info = env._finish_step(self._view(frame, i), action, float(rewards[i]),
+                                                           frame_seq, defer_scan=defer_scan)
+            dones[i] = terminated or truncated
+            if dones[i]:
+                # Auto-reset (VecEnv convention): the next observation is the
+                # first of a new episode. The screen is the same either way.
+                info["terminal_observation"] = obs[i].copy()
+                info["TimeLimit.truncated"] = truncated and not terminated
+                env._reset_state()
+            infos.append(info)
+
+        return obs, rewards, dones, infos
+
+    # =========================================================================
+    # Pipelined step (native capture + batch observation thread)
+    # =========================================================================
+
+    def _pipelined(self) -> bool:
+        return (self._pipeline is not None and self._pipeline.available
+                and all(env._reward_handle is not None for env in self.envs))
+
+    def _submit_step(self, actions) -> None:
+        """
+        step_async, pipelined: act and queue each frame-skip repeat's
+        capture + batch observation (same loop as StardewViTEnv.step_async).
+        """
+        for env in self.envs:
+            env._join_scan()   # their UI boxes feed the energy rects
+        jobs = []
+        obs = None
+        handles = [env._reward_handle for env in self.envs]
+        frame_before = self.cap.latest()
+        for repeat in range(StardewViTEnv.FRAME_SKIP):
+            if jobs:
+                frame_before = self._pipeline.captured(jobs[-1][0])
+                if frame_before is None:
+                    break
+
+            for env, action in zip(self.envs, actions):
+                env._take_action(action)
+
+            if frame_before is not None:
+                energy, cursor = self._reward_rects(frame_before, frame_before, actions)
+            else:
+                energy = cursor = [None] * self.num_envs
+            if repeat == StardewViTEnv.FRAME_SKIP - 1:
+                obs = self._next_obs()
+            clicked = any(rect is not None for rect in cursor)
+            job = self._pipeline.submit(self.cap.now_us() + 30_000, frame_before if clicked else None,
+                                        self._rects, obs, handles, energy, cursor)
+            jobs.append((job, frame_before is not None))
+        self._jobs = (actions, jobs, obs)
+
+    def _collect_step(self):
+        """step_wait, pipelined: rewards from every queued repeat, then finish."""
+        actions, jobs, obs = self._jobs
+        self._jobs = None
+        rewards = np.zeros(self.num_envs, dtype=np.float32)
+        if obs is None:
+            obs = self._next_obs()
+        frame = frame_seq = None
+        lost = len(jobs) < StardewViTEnv.FRAME_SKIP
+        for job, has_before in jobs:
+            features = self._pipeline.result(job)
+            if features is None:
+                lost = True
+                break
+            for i, (env, action) in enumerate(zip(self.envs, actions)):
+                rewards[i] += env._reward_from_features(features[i], action, has_before)
+            frame, frame_seq = job.frame, job.frame_seq
+        if lost:
+            self._pipeline.drain()
+            return self._lost(obs, rewards)
+        return self._finish(frame, actions, rewards, obs, frame_seq, defer_scan=True)
+
+    def close(self) -> None:
+        if self._pipeline is not None:
+            self._pipeline.close()
+        self.cap.stop_stream()
+        for env in self.envs:
+            env.close()
+
+    def get_attr(self, attr_name: str, indices=None) -> list:
+        return [getattr(self.envs[i], attr_name) for i in self._get_indices(indices)]
+
+    def set_attr(self, attr_name: str, value, indices=None) -> None:
+        for i in self._get_indices(indices):
+            setattr(self.envs[i], attr_name, value)
+
+    def env_method(self, method_name: str, *method_args, indices=None, **method_kwargs) -> list:
+        return [getattr(self.envs[i], method_name)(*method_args, **method_kwargs)
+                for i in self._get_indices(indices)]
+
+    def env_is_wrapped(self, wrapper_class, indices=None) -> List[bool]:
+        return [False for _ in self._get_indices(indices)]
+
+    # =========================================================================
+    # Batched observation + reward features
+    # =========================================================================
+
+    def _next_obs(self) -> np.ndarray:
+        """The observation buffer not returned last time."""
+        self._obs_index ^= 1
+        return self._obs[self._obs_index]
+
+    def _view(self, frame: np.ndarray, i: int) -> np.ndarray:
+        """Instance i's window inside the shared frame (a view, no copy)."""
+        x, y, w, h = self._rects[i]
+        return frame[y:y + h, x:x + w]
+
+    def _reward_rects(self, frame, frame_before, actions):
+        """
+        Per-instance energy box (from frame) and cursor box (from
+        frame_before, clicks only) for the native reward features.
+        """
+        energy, cursor = [], []
+        for i, (env, action) in enumerate(zip(self.envs, actions)):
+            energy.append(env.interface.get_energy_rect(self._view(frame, i)))
+            clicked = action in [5, 6] and frame_before is not None
+            cursor.append(env._cursor_rect(self._view(frame_before, i)) if clicked else None)
+        return energy, cursor
+
+    def _observe(self, frame, frame_before, actions, obs, rewards: bool = True) -> list:
+        """
+        Preprocess every instance into obs (unless obs is None) and return
+        each one's reward features (notif_diff, motion_diff, energy_pct,
+        cursor_diff), or a list of None if rewards is False.
+        """
+        n = self.num_envs
+        if not rewards:
+            actions = [0] * n
+
+        if HAS_NATIVE_BATCH and frame.dtype == np.uint8:
+            handles = energy = cursor = None
+            if rewards:
+                handles = [env._reward_handle for env in self.envs]
+                energy, cursor = self._reward_rects(frame, frame_before, actions)
+            return clib.observe_batch(frame, self._rects, obs, handles, energy,
+                                      frame_before, cursor, self._threads)
+
+        # Python fallback: the same work, one instance at a time
+        features = []
+        for i, (env, action) in enumerate(zip(self.envs, actions)):
+            view = self._view(frame, i)
+            if obs is not None:
+                obs[i] = env._preprocess_frame(view)
+            if rewards:
+                before = self._view(frame_before, i) if frame_before is not None else None
+                features.append(env._reward_features(view, action, before))
+            else:
+                features.append(None)
+        return features
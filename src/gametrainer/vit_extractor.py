@@ -74,9 +74,14 @@ This is MUCH faster than training from scratch.
 
 import torch
 import torch.nn as nn
+import torch.nn.functional as F
 import gymnasium as gym
 from stable_baselines3.common.torch_layers import BaseFeaturesExtractor
 
+# ImageNet statistics (what the pretrained ViT expects)
+IMAGENET_MEAN = (0.485, 0.456, 0.406)
+IMAGENET_STD = (0.229, 0.224, 0.225)
+
 
 class ViTFeaturesExtractor(BaseFeaturesExtractor):
     """
@@ -95,7 +100,8 @@ class ViTFeaturesExtractor(BaseFeaturesExtractor):
         features_dim: int = 768,  # ViT-Base outputs 768-dim vectors
         pretrained: bool = True,
         freeze_backbone: bool = False,
-        model_name: str = "vit_base_patch16_224"
+        model_name: str = "vit_base_patch16_224",
+        raw_pixels: bool = False,
     ):
         """
         Initialize the ViT feature extractor.
@@ -107,6 +113,9 @@ class ViTFeaturesExtractor(BaseFeaturesExtractor):
             freeze_backbone: If True, don't update ViT weights during training
                            (faster but less adaptable to games)
             model_name: Which ViT variant to use (see timm for options)
+            raw_pixels: Float observations are 0..255 (the policy was built
+                        with normalize_images=False) instead of 0..1. Then
+                        the /255 is folded into our normalization too.
 
         Teacher Note on freeze_backbone:
         - freeze_backbone=True: ViT stays fixed, only policy network learns
@@ -168,6 +177,229 @@ class ViTFeaturesExtractor(BaseFeaturesExtractor):
         # Store config for later reference
         self._features_dim = features_dim
         self.freeze_backbone = freeze_backbone
+        self.raw_pixels = raw_pixels
+
+        # Teacher Note: ImageNet normalization, (x / 255 - mean) / std, is
+        # just x * scale + shift per channel. We keep scale/shift as buffers
+        # (they move to the GPU with the model, once) and apply them with
+        # ONE fused multiply-add instead of building mean/std tensors and
+        # running sub + div on every call.
+        input_scale = 255.0 if raw_pixels else 1.0
+        mean = torch.tensor(IMAGENET_MEAN).view(1, 3, 1, 1)
+        std = torch.tensor(IMAGENET_STD).view(1, 3, 1, 1)
+        self.register_buffer("norm_scale", 1.0 / (input_scale * std), persistent=False)
+        self.register_buffer("norm_shift", -mean / std, persistent=False)
+
+        # Teacher Note: Better still, the first layer of the ViT (the patch
+        # embedding) is a convolution - also linear - so scale/shift can be
+        # folded INTO its weights and bias and cost nothing at all. We only
+        # do it for a frozen backbone: folding rescales the weights, which
+        # would change how fast the optimizer moves them when fine-tuning.
+        # norm_folded is saved with the model, so a checkpoint's weights are
+        # always interpreted the way they were saved.
+        self.register_buffer("norm_folded", torch.zeros((), dtype=torch.uint8))
+        self._fold_wanted = freeze_backbone and self._patch_conv() is not None
+        self._set_folded(self._fold_wanted)
+        self.register_load_state_dict_post_hook(ViTFeaturesExtractor._after_load)
+        print(f"  Normalization: {'folded into patch embedding' if self.norm_folded else 'fused multiply-add'}")
+
+        # Feature caching (see feature_cache.py): remember the last batch we
+        # encoded without gradients, so the rollout buffer can store its
+        # features instead of computing them a second time.
+        self.remember_features = False
+        self._last_batch = None   # (observations, features)
+
+        # Incremental mode (off until enable_incremental())
+        self.incremental = False
+        self._incr = None         # _IncrementalState of the last batch
+
+    def _patch_conv(self):
+        """The patch-embedding conv, if normalization can be folded into it."""
+        proj = getattr(getattr(self.vit, "patch_embed", None), "proj", None)
+        if not isinstance(proj, nn.Conv2d) or proj.in_channels != 3 or proj.bias is None:
+            return None
+        # Zero padding would see 0 instead of the (normalized) border value
+        if proj.padding not in ((0, 0), "valid"):
+            return None
+        return proj
+
+    def _set_folded(self, folded: bool) -> None:
+        """Fold scale/shift into the patch conv (or take them back out)."""
+        if bool(self.norm_folded) == folded:
+            return
+        proj = self._patch_conv()
+        scale = self.norm_scale.to(proj.weight)
+        shift = self.norm_shift.to(proj.weight)
+        with torch.no_grad():
+            # conv(W, b)(x * s + t) = conv(W * s, b + sum(W * t))(x)
+            if folded:
+                proj.bias += (proj.weight * shift).sum(dim=(1, 2, 3))
+                proj.weight *= scale
+            else:
+                proj.weight /= scale
+                proj.bias -= (proj.weight * shift).sum(dim=(1, 2, 3))
+        self.norm_folded.fill_(int(folded))
+
+    def _load_from_state_dict(self, state_dict, prefix, *args, **kwargs):
+        # Checkpoints from before norm_folded existed hold unfolded weights
+        state_dict.setdefault(prefix + "norm_folded", torch.zeros((), dtype=torch.uint8))
+        super()._load_from_state_dict(state_dict, prefix, *args, **kwargs)
+
+    @staticmethod
+    def _after_load(module, incompatible_keys) -> None:
+        # Runs after the ViT's weights are in: bring them to our folding
+        module._set_folded(module._fold_wanted)
+
+    def cached_features(self, observations: torch.Tensor) -> torch.Tensor:
+        """
+        The features of a batch, without gradients: reused from the last
+        forward() if it saw this same batch, computed otherwise.
+        """
+        if self._last_batch is not None:
+            seen, features = self._last_batch
+            if seen.shape == observations.shape and torch.equal(seen, observations.to(seen)):
+                return features
+        with torch.no_grad():
+            return self(observations)
+
+    # =========================================================================
+    # INCREMENTAL MODE (token pruning on mostly-static scenes)
+    # =========================================================================
+
+    def enable_incremental(self, threshold: float = 8.0, max_changed: float = 0.5,
+                           refresh_every: int = 32) -> bool:
+        """
+        Only re-encode the patches that changed since the previous frame.
+
+        Teacher Note: Most Stardew frames differ from the last one in a few
+        patches (the player, a tool swing, the clock) - yet every step runs
+        all 196 patches through all 12 layers. In incremental mode each
+        layer keeps the keys/values of every token from last time. A new
+        frame's unchanged patches are left out of the computation entirely:
+        only CLS and the CHANGED patches go through the layers, attending
+        to the fresh keys/values of the changed patches and the cached ones
+        of the rest. Work shrinks with the number of changed patches (a
+        static frame costs nothing at all).
+
+        It's an approximation - an unchanged patch's cached state doesn't
+        see the changes elsewhere - so every `refresh_every` frames (and
+        whenever more than `max_changed` of the patches changed) a full
+        pass starts over. Only used without gradients (acting/playing);
+        PPO's training passes always run the full ViT.
+
+        Args:
+            threshold: a patch changed if any pixel moved more than this (0..255)
+            max_changed: above this fraction of changed patches, run a full pass
+            refresh_every: full pass at least every this many frames
+
+        Returns:
+            False if this ViT's structure isn't supported (mode stays off)
+        """
+        if not self._incremental_supported():
+            print("  [!] Incremental ViT: unsupported model structure, staying off")
+            return False
+        self.incremental = True
+        self.incr_threshold = float(threshold)
+        self.incr_max_changed = float(max_changed)
+        self.incr_refresh = max(1, int(refresh_every))
+        self._incr = None
+        return True
+
+    def disable_incremental(self) -> None:
+        self.incremental = False
+        self._incr = None
+
+    def _incremental_supported(self) -> bool:
+        """The timm VisionTransformer layout the incremental pass relies on."""
+        vit = self.vit
+        patch_embed = getattr(vit, "patch_embed", None)
+        if (patch_embed is None or not hasattr(vit, "_pos_embed") or not hasattr(vit, "blocks")
+                or getattr(vit, "global_pool", None) != "token"
+                or getattr(vit, "attn_pool", None) is not None
+                or getattr(patch_embed, "dynamic_img_size", False)
+                or not getattr(patch_embed, "flatten", True)):
+            return False
+        return all(hasattr(getattr(b, "attn", None), "qkv") and hasattr(b, "mlp") for b in vit.blocks)
+
+    def _changed_patches(self, pixels: torch.Tensor, before: torch.Tensor) -> torch.Tensor:
+        """(batch, patches) largest pixel change in each patch, in 0..255."""
+        ph, pw = self.vit.patch_embed.patch_size
+        gh, gw = self.vit.patch_embed.grid_size
+        diff = (pixels - before).abs().amax(dim=1)                     # (B, H, W)
+        diff = diff[:, :gh * ph, :gw * pw].reshape(-1, gh, ph, gw, pw)
+        return diff.amax(dim=(2, 4)).flatten(1)
+
+    def _encode_incremental(self, pixels: torch.Tensor, observations: torch.Tensor) -> torch.Tensor:
+        """
+        CLS features of a normalized batch, re-using the last batch's
+        per-layer keys/values for patches whose pixels didn't change.
+        """
+        vit = self.vit
+        batch = observations.shape[0]
+        state = self._incr
+        prefix = vit.num_prefix_tokens
+
+        active = None   # token indices to compute; None = all of them
+        # (cached tensors made under inference_mode can't be updated outside it)
+        inference = torch.is_inference_mode_enabled()
+        if (state is not None and state.batch == batch and state.age < self.incr_refresh
+                and state.inference == inference):
+            score = self._changed_patches(pixels, state.pixels)
+            changed = int((score > self.incr_threshold).sum(dim=1).max())
+            if changed == 0:
+                # Nothing moved: same frame, same features
+                state.age += 1
+                return state.features
+            if changed <= self.incr_max_changed * score.shape[1]:
+                # The same count for every frame of the batch (a few extra
+                # unchanged patches just get refreshed)
+                patches = score.topk(changed, dim=1).indices + prefix
+                head = torch.arange(prefix, device=patches.device).expand(batch, prefix)
+                active = torch.cat([head, patches], dim=1)          # (B, T)
+
+        tokens = getattr(vit, "norm_pre", nn.Identity())(vit._pos_embed(vit.patch_embed(observations)))
+        if active is None:
+            state = _IncrementalState(batch, inference)
+            x = tokens
+        else:
+            state.age += 1
+            x = tokens.gather(1, active[..., None].expand(-1, -1, tokens.shape[-1]))
+
+        for layer, block in enumerate(vit.blocks):
+            x = self._block_incremental(block, x, state, layer, active)
+
+        state.pixels = pixels
+        state.features = vit.forward_head(vit.norm(x))   # CLS is token 0 of x
+        self._incr = state
+        return state.features
+
+    @staticmethod
+    def _block_incremental(block, x: torch.Tensor, state, layer: int, active) -> torch.Tensor:
+        """One timm Block on the active tokens x, against all tokens' keys/values."""
+        attn = block.attn
+        same = nn.Identity()   # for parts older timm versions don't have
+        batch, tokens, dim = x.shape
+        heads = attn.num_heads
+        qkv = attn.qkv(block.norm1(x)).reshape(batch, tokens, 3, heads, dim // heads).permute(2, 0, 3, 1, 4)
+        q, k, v = qkv.unbind(0)
+        q, k = getattr(attn, "q_norm", same)(q), getattr(attn, "k_norm", same)(k)
+
+        if active is None:
+            # Full pass: these are every token's keys/values
+            if layer == len(state.keys):
+                state.keys.append(k)
+                state.values.append(v)
+            keys, values = k, v
+        else:
+            where = active[:, None, :, None].expand(-1, heads, -1, k.shape[-1])
+            keys = state.keys[layer].scatter_(2, where, k)
+            values = state.values[layer].scatter_(2, where, v)
+
+        out = F.scaled_dot_product_attention(q, keys, values)
+        out = out.transpose(1, 2).reshape(batch, tokens, dim)
+        out = attn.proj(getattr(attn, "norm", same)(out))
+        x = x + getattr(block, "ls1", same)(out)
+        return x + getattr(block, "ls2", same)(block.mlp(block.norm2(x)))
 
     def forward(self, observations: torch.Tensor) -> torch.Tensor:
         """
@@ -176,6 +408,8 @@ class ViTFeaturesExtractor(BaseFeaturesExtractor):
         Args:
             observations: Tensor of shape (batch, channels, height, width)
                          Values should be in [0, 255] (uint8) or [0, 1] (float)
+                         - or (batch, features_dim): features cached by a
+                         FeatureCacheRolloutBuffer, passed straight through
 
         Returns:
             features: Tensor of shape (batch, features_dim)
@@ -185,31 +419,52 @@ class ViTFeaturesExtractor(BaseFeaturesExtractor):
         "see" the game. The ViT processes the image and outputs a 768-dim
         vector that captures "what's important in this frame."
         """
-        # Normalize to [0, 1] if input is uint8 [0, 255]
-        # Teacher Note: Neural networks work better with small values
+        if observations.dim() == 2:
+            # Already features (a frozen backbone gives the same answer for
+            # the same frame, so PPO's epochs reuse them)
+            return observations.float()
+        inputs = observations
+
+        # uint8 [0, 255] -> float (on the GPU, if that's where the batch is)
         if observations.dtype == torch.uint8:
-            observations = observations.float() / 255.0
+            observations = observations.float()
+            if not self.raw_pixels:
+                observations = observations / 255.0
 
         # ImageNet normalization (what the pretrained ViT expects)
         # Teacher Note: The ViT was trained on ImageNet with specific mean/std.
-        # We normalize our game images the same way so the learned features apply.
-        mean = torch.tensor([0.485, 0.456, 0.406], device=observations.device)
-        std = torch.tensor([0.229, 0.224, 0.225], device=observations.device)
-
-        # Reshape for broadcasting: (3,) -> (1, 3, 1, 1)
-        mean = mean.view(1, 3, 1, 1)
-        std = std.view(1, 3, 1, 1)
-
-        # Apply normalization: (x - mean) / std
-        observations = (observations - mean) / std
+        # We normalize our game images the same way so the learned features
+        # apply: (x - mean) / std as one fused op, or nothing at all when it's
+        # folded into the patch embedding.
+        if not self.norm_folded:
+            observations = torch.addcmul(self.norm_shift, observations, self.norm_scale)
 
         # Forward through ViT
         # Output shape: (batch, features_dim) = (batch, 768) for ViT-Base
-        features = self.vit(observations)
+        if self.incremental and not torch.is_grad_enabled():
+            pixels = inputs.float() if (inputs.dtype == torch.uint8 or self.raw_pixels) else inputs * 255.0
+            features = self._encode_incremental(pixels, observations)
+        else:
+            features = self.vit(observations)
 
+        if self.remember_features and not torch.is_grad_enabled():
+            self._last_batch = (inputs, features)
         return features
 
 
+class _IncrementalState:
+    """What the incremental pass keeps from one batch to the next."""
+
+    def __init__(self, batch: int, inference: bool):
+        self.batch = batch
+        self.inference = inference   # made under torch.inference_mode
+        self.age = 0                 # incremental frames since the last full pass
+        self.keys = []               # per layer: (batch, heads, tokens, head_dim)
+        self.values = []
+        self.pixels = None           # the batch's input, 0..255 floats
+        self.features = None         # its CLS features
+
+
 class ViTSmallFeaturesExtractor(ViTFeaturesExtractor):
     """
     Smaller, faster ViT variant.
@@ -230,13 +485,15 @@ class ViTSmallFeaturesExtractor(ViTFeaturesExtractor):
         observation_space: gym.Space,
         pretrained: bool = True,
         freeze_backbone: bool = False,
+        raw_pixels: bool = False,
     ):
         super().__init__(
             observation_space,
             features_dim=384,  # ViT-Small outputs 384-dim
             pretrained=pretrained,
             freeze_backbone=freeze_backbone,
-            model_name="vit_small_patch16_224"
+            model_name="vit_small_patch16_224",
+            raw_pixels=raw_pixels,
         )
 
 
@@ -255,13 +512,15 @@ class ViTTinyFeaturesExtractor(ViTFeaturesExtractor):
         observation_space: gym.Space,
         pretrained: bool = True,
         freeze_backbone: bool = False,
+        raw_pixels: bool = False,
     ):
         super().__init__(
             observation_space,
             features_dim=192,  # ViT-Tiny outputs 192-dim
             pretrained=pretrained,
             freeze_backbone=freeze_backbone,
-            model_name="vit_tiny_patch16_224"
+            model_name="vit_tiny_patch16_224",
+            raw_pixels=raw_pixels,
         )
 
 
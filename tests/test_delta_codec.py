@@ -0,0 +1,133 @@
+import sys
+from pathlib import Path
+
+import pytest
+
+np = pytest.importorskip("numpy")
+
+# Project root = parent of tests/
+_project_root = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(_project_root))
+from src.gametrainer import delta_codec
+from src.gametrainer.delta_codec import BLOCK, HEADER, MAX_RUN
+
+
+@pytest.fixture(params=["numpy", "native"])
+def codec(request, monkeypatch):
+    """delta_codec with the numpy implementation, then with clib if built."""
+    if request.param == "native":
+        if not delta_codec.HAS_NATIVE_DELTA:
+            pytest.skip("needs the C++ extension")
+    else:
+        monkeypatch.setattr(delta_codec, "HAS_NATIVE_DELTA", False)
+    return delta_codec
+
+
+def _round_trip(codec, cur, prev=None):
+    packet = codec.encode(cur, prev)
+    dst = np.zeros_like(cur) if prev is None else prev.copy()
+    assert codec.decode(packet, dst) is dst
+    assert np.array_equal(dst, cur)
+    return packet
+
+
+def test_keyframe_and_delta_round_trip(codec):
+    rng = np.random.default_rng(0)
+    prev = rng.integers(0, 256, (3, 224, 224), dtype=np.uint8)
+    cur = prev.copy()
+    cur[:, 100:120, 50:60] = 7
+
+    key = _round_trip(codec, cur)
+    assert codec.is_key(key)
+    # A keyframe decodes over anything
+    dst = np.full_like(cur, 0xAB)
+    codec.decode(key, dst)
+    assert np.array_equal(dst, cur)
+
+    delta = _round_trip(codec, cur, prev)
+    assert not codec.is_key(delta)
+    assert len(delta) < len(key) // 10
+
+
+def test_identical_frame_is_header_and_tokens_only(codec):
+    frame = np.arange(BLOCK * 10, dtype=np.uint8)
+    packet = _round_trip(codec, frame, frame.copy())
+    raw_bytes, flags, literal_blocks, token_count = HEADER.unpack_from(packet)
+    assert (raw_bytes, flags, literal_blocks, token_count) == (frame.size, 0, 0, 1)
+    assert len(packet) == HEADER.size + 4
+
+
+@pytest.mark.parametrize("extra", [0, 1, 5])
+def test_runs_longer_than_max_run(codec, extra):
+    blocks = MAX_RUN + extra
+    prev = np.zeros(2 * blocks * BLOCK + BLOCK, dtype=np.uint8)
+    cur = prev.copy()
+    # An unchanged run of `blocks`, then a literal run of `blocks`, then one more same
+    cur[blocks * BLOCK:2 * blocks * BLOCK] = 1
+    packet = _round_trip(codec, cur, prev)
+    _, _, literal_blocks, token_count = HEADER.unpack_from(packet)
+    assert literal_blocks == blocks
+    tokens = np.frombuffer(packet, dtype="<u2", count=2 * token_count,
+                           offset=len(packet) - 4 * token_count).reshape(-1, 2)
+    assert tokens.max() <= MAX_RUN
+    assert tokens[:, 0].sum() == blocks + 1 and tokens[:, 1].sum() == blocks
+
+
+@pytest.mark.parametrize("size", [1, 63, 64, 65, 130, 3 * 224 * 224 + 5])
+def test_sizes_with_a_tail(codec, size):
+    rng = np.random.default_rng(size)
+    prev = rng.integers(0, 256, size, dtype=np.uint8)
+    cur = prev.copy()
+    cur[-1] ^= 0xFF                     # the tail (or the last block) changes
+    _round_trip(codec, cur)
+    _round_trip(codec, cur, prev)
+
+
+def test_malformed_packets_raise(codec):
+    frame = np.arange(BLOCK * 4 + 3, dtype=np.uint8)
+    packet = bytearray(codec.encode(frame))
+    dst = np.zeros_like(frame)
+
+    with pytest.raises(ValueError):
+        codec.decode(bytes(packet[:-1]), dst)                # truncated
+    with pytest.raises(ValueError):
+        codec.decode(bytes(packet), np.zeros(frame.size + 1, np.uint8))   # wrong frame size
+    bad = bytearray(packet)
+    token_offset = len(bad) - 4 * HEADER.unpack_from(bad)[3]
+    bad[token_offset] ^= 1                                   # tokens no longer cover the frame
+    with pytest.raises(ValueError):
+        codec.decode(bytes(bad), dst)
+    assert not dst.any()                                     # untouched
+
+
+def test_decode_rejects_non_contiguous_dst(codec):
+    frame = np.arange(BLOCK * 8, dtype=np.uint8).reshape(8, BLOCK)
+    packet = codec.encode(frame[:, ::2].copy())
+    dst = np.zeros((8, BLOCK), dtype=np.uint8)[:, ::2]
+    with pytest.raises(ValueError):
+        codec.decode(packet, dst)
+
+
+def test_numpy_packets_match_native(monkeypatch):
+    if not delta_codec.HAS_NATIVE_DELTA:
+        pytest.skip("needs the C++ extension")
+    rng = np.random.default_rng(1)
+    prev = rng.integers(0, 256, (MAX_RUN + 3) * BLOCK + 17, dtype=np.uint8)
+    cases = [(prev, None)]
+    for changed in (0.0, 0.01, 0.5, 1.0):
+        cur = prev.copy()
+        mask = rng.random(cur.size // BLOCK) < changed
+        cur[:mask.size * BLOCK].reshape(-1, BLOCK)[mask] ^= 0x5A
+        cases.append((cur, prev))
+    # Exactly MAX_RUN unchanged blocks before a literal
+    cur = prev.copy()
+    cur[MAX_RUN * BLOCK] ^= 1
+    cases.append((cur, prev))
+
+    native = [delta_codec.encode(cur, ref) for cur, ref in cases]
+    monkeypatch.setattr(delta_codec, "HAS_NATIVE_DELTA", False)
+    for (cur, ref), packet in zip(cases, native):
+        assert delta_codec.encode(cur, ref) == packet
+        dst = np.zeros_like(cur) if ref is None else ref.copy()
+        delta_codec.decode(packet, dst)
+        assert np.array_equal(dst, cur)
@@ -0,0 +1,92 @@
+import sys
+from pathlib import Path
+
+import pytest
+
+np = pytest.importorskip("numpy")
+
+# Project root = parent of tests/
+_project_root = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(_project_root))
+from src.gametrainer import events
+
+
+@pytest.fixture
+def py_bus(monkeypatch):
+    """The Python fallback ring, 8 slots, whether or not the extension is built."""
+    bus = events._PyBus(8)
+    monkeypatch.setattr(events, "HAS_NATIVE_BUS", False)
+    monkeypatch.setattr(events, "_py_bus", bus)
+    return bus
+
+
+def test_publish_without_subscribers_is_a_no_op(py_bus):
+    assert not events.active()
+    events.publish(events.STEP, 0, 1, 2)
+    assert events.published() == 0
+
+
+def test_publish_and_poll(py_bus):
+    with events.subscribe() as sub:
+        assert events.active()
+        for step in range(3):
+            events.publish(events.STEP, 7, step, 4, 0.5 * step, 1.0)
+        assert events.published() == 3
+
+        batch = sub.poll()
+        assert batch.dtype == events.EVENT_DTYPE
+        assert batch["type"].tolist() == [events.STEP] * 3
+        assert batch["source"].tolist() == [7] * 3
+        assert batch["i"][:, 0].tolist() == [0, 1, 2]
+        assert batch["f"][:, 0].tolist() == [0.0, 0.5, 1.0]
+        assert np.all(np.diff(batch["time_us"]) >= 0)
+        assert len(sub.poll()) == 0 and sub.dropped == 0
+
+        # A later subscriber starts at the next event
+        with events.subscribe() as late:
+            events.publish(events.EPISODE, 0, 10)
+            assert late.poll()["i"][:, 0].tolist() == [10]
+        assert sub.poll()["i"][:, 0].tolist() == [10]
+
+        # max_events: the rest stays for the next poll
+        for step in range(5):
+            events.publish(events.STEP, 0, step)
+        assert sub.poll(2)["i"][:, 0].tolist() == [0, 1]
+        assert sub.poll()["i"][:, 0].tolist() == [2, 3, 4]
+    assert not events.active()
+
+
+def test_lapped_subscriber_counts_drops(py_bus):
+    sub = events.subscribe()
+    for step in range(13):
+        events.publish(events.STEP, 0, step)
+    batch = sub.poll()
+    assert batch["i"][:, 0].tolist() == list(range(5, 13))   # the newest ring (8 slots)
+    assert sub.dropped == 5
+    events.publish(events.STEP, 0, 13)
+    assert sub.poll()["i"][:, 0].tolist() == [13] and sub.dropped == 5
+    sub.close()
+
+
+def test_close_twice_unsubscribes_once(py_bus):
+    keep = events.subscribe()
+    sub = events.subscribe()
+    sub.close()
+    sub.close()
+    assert py_bus.subscribers == 1 and events.active()
+    assert len(sub.poll()) == 0
+    keep.close()
+    assert not events.active()
+
+
+def test_native_unsubscribe_twice_keeps_the_count():
+    clib = pytest.importorskip("src.gametrainer.clib")
+    if not hasattr(clib, "bus_subscribe"):
+        pytest.skip("extension built without the event bus")
+    keep = clib.bus_subscribe()
+    handle = clib.bus_subscribe()
+    clib.bus_unsubscribe(handle)
+    clib.bus_unsubscribe(handle)     # already gone: must not count keep out
+    assert clib.bus_active()
+    clib.bus_unsubscribe(keep)
+    assert not clib.bus_active()
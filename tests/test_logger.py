@@ -1,10 +1,12 @@
 import sys
 from pathlib import Path
 from tempfile import TemporaryDirectory
+from unittest import mock
 
 # Project root = parent of tests/
 _project_root = Path(__file__).resolve().parents[1]
 sys.path.insert(0, str(_project_root))
+from src.gametrainer import logger as logger_module
 from src.gametrainer.logger import Logger
 
 
@@ -16,3 +18,90 @@ def test_log_creates_file_with_message():
         assert len(log_files) == 1
         content = log_files[0].read_text()
         assert "hello" in content
+
+
+def _lines(logger):
+    """The session file's lines without their "[HH:MM:SS] " stamps."""
+    logger.flush()
+    with open(logger.log_file, encoding="utf-8") as f:
+        return [line.rstrip("\n").split("] ", 1)[1] for line in f]
+
+
+def test_rate_limit_per_tag():
+    clock = [100.0]
+    with TemporaryDirectory() as tmpdir, mock.patch.object(logger_module.time, "monotonic", lambda: clock[0]):
+        logger = Logger(log_dir=tmpdir, max_per_second=3)
+        for i in range(10):
+            logger.log(f"[SPAM] {i}")
+        logger.log("[OTHER] own budget")
+        logger.log("untagged lines are never limited")
+        for i in range(5):
+            logger.event("[EVT]", "value %d", i)
+        clock[0] += 1.5
+        logger.log("[SPAM] later")
+        logger.event("[EVT]", "value %d", 99)
+        assert _lines(logger) == [
+            "[SPAM] 0", "[SPAM] 1", "[SPAM] 2",
+            "[OTHER] own budget",
+            "untagged lines are never limited",
+            "[EVT] value 0", "[EVT] value 1", "[EVT] value 2",
+            "[SPAM] later (+7 suppressed)",
+            "[EVT] value 99 (+2 suppressed)",
+        ]
+        logger.close()
+
+
+def test_repeated_lines_fold():
+    with TemporaryDirectory() as tmpdir:
+        logger = Logger(log_dir=tmpdir, max_per_second=0)
+        for _ in range(4):
+            logger.log("[STUCK] same")
+        logger.log("[STUCK] different")
+        for _ in range(3):
+            logger.event("[E]", "x=%d", 1)
+        logger.close()              # writes the pending repeat count too
+        with open(logger.log_file, encoding="utf-8") as f:
+            lines = [line.rstrip("\n").split("] ", 1)[1] for line in f]
+        assert lines == [
+            "[STUCK] same", "(last message repeated 3x)",
+            "[STUCK] different",
+            "[E] x=1", "(last message repeated 2x)",
+        ]
+
+
+def test_flush_writes_background_lines_in_order():
+    with TemporaryDirectory() as tmpdir:
+        # A long flush interval: only flush() gets the lines out in time
+        logger = Logger(log_dir=tmpdir, background=True, max_per_second=0, flush_interval=60.0)
+        expected = []
+        for i in range(200):
+            if i % 2:
+                logger.event("[EVT]", "%d", i)
+                expected.append(f"[EVT] {i}")
+            else:
+                logger.log(f"line {i}")
+                expected.append(f"line {i}")
+        assert _lines(logger) == expected
+        logger.log("after flush")
+        assert _lines(logger) == expected + ["after flush"]
+        logger.close()
+
+
+def test_loggers_share_a_writer_per_log_dir():
+    with TemporaryDirectory() as tmpdir, TemporaryDirectory() as otherdir:
+        a = Logger(log_dir=tmpdir)
+        b = Logger(log_dir=tmpdir, background=True)
+        other = Logger(log_dir=otherdir)
+        assert a.log_file == b.log_file
+        assert other.log_file != a.log_file
+
+        a.log("from a")
+        b.log("from b")
+        b.flush()
+        a.log("from a")
+        b.log("from a")             # identical to the previous line, whoever logged it
+        assert len(list(Path(tmpdir).glob("session_*.log"))) == 1
+        assert _lines(a) == ["from a", "from b", "from a"]
+        a.close()                   # closes the file for b as well
+        assert _lines(b)[-1] == "(last message repeated 1x)"
+        other.close()
@@ -0,0 +1,68 @@
+import sys
+import time
+from array import array
+from pathlib import Path
+
+import pytest
+
+# Project root = parent of tests/
+_project_root = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(_project_root))
+
+# Windows + GAMETRAINER_BUILD_CPP=1 only; everything here runs against the
+# null sink, so no input reaches the desktop.
+clib = pytest.importorskip("src.gametrainer.clib")
+
+
+@pytest.fixture(autouse=True)
+def null_sink():
+    clib.input_null_sink(True)
+    yield
+    clib.release_all()
+    clib.wait(1000)
+    clib.input_null_sink(False)
+
+
+def test_send_batch_accepts_int32_triplets():
+    events = array("i", [clib.EVENT_MOUSE_MOVE, 1, 2, clib.EVENT_LEFT_DOWN, 0, 0])
+    assert clib.send_batch(events) == 2
+
+
+@pytest.mark.parametrize("buffer", [
+    array("f", [0.0, 1.0, 2.0]),            # float32, same byte count
+    array("q", [0, 1, 2]),                   # int64
+    bytes(12),
+])
+def test_send_batch_rejects_other_buffers(buffer):
+    with pytest.raises(TypeError):
+        clib.send_batch(buffer)
+
+
+@pytest.mark.parametrize("hold_ms", [0, -5])
+def test_hold_key_rejects_holds_without_release(hold_ms):
+    with pytest.raises(ValueError):
+        clib.hold_key(0x57, hold_ms)
+    with pytest.raises(ValueError):
+        clib.hold_keys([0x57, 0x44], hold_ms)
+    assert clib.wait(1000)
+    assert clib.pending() == 0              # nothing was queued
+
+
+def test_hold_key_releases_after_hold():
+    before = clib.input_null_sink_events()
+    clib.hold_key(0x57, 5)
+    assert clib.wait(1000)
+    # The release is scheduled, not queued: poll for it rather than guessing
+    # how late a loaded machine runs it.
+    deadline = time.monotonic() + 2.0
+    while clib.input_null_sink_events() - before < 2 and time.monotonic() < deadline:
+        time.sleep(0.001)
+    assert clib.input_null_sink_events() - before == 2      # down + up
+
+
+def test_hold_table_overflow_is_counted():
+    before = clib.dropped_holds()
+    clib.hold_keys(list(range(0x41, 0x41 + 16)), 10_000)    # A..P fill the table
+    clib.hold_key(0x51, 10_000)                                # Q: one too many
+    assert clib.wait(1000)
+    assert clib.dropped_holds() - before == 1
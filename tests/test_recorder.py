@@ -0,0 +1,115 @@
+import sys
+from pathlib import Path
+from tempfile import TemporaryDirectory
+
+import pytest
+
+np = pytest.importorskip("numpy")
+pytest.importorskip("stable_baselines3")
+
+# Project root = parent of tests/
+_project_root = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(_project_root))
+from src.gametrainer import recorder
+from src.gametrainer.recorder import HEADER, TrajectoryReader, TrajectoryRecorder
+
+SHAPE = (3, 8, 10)
+
+
+def _frames(count, envs=2, seed=0):
+    """Mostly static frames per env with a few changed pixels, like the game."""
+    rng = np.random.default_rng(seed)
+    base = [rng.integers(0, 256, SHAPE, dtype=np.uint8) for _ in range(envs)]
+    frames = []
+    for i in range(count):
+        frame = base[i % envs].copy()
+        frame[:, i % SHAPE[1], :3] = i
+        base[i % envs] = frame
+        frames.append(frame)
+    return frames
+
+
+def _record(path, frames, codec, chunk_records=4, envs=2):
+    with TrajectoryRecorder(path, SHAPE, chunk_records=chunk_records, codec=codec) as rec:
+        for i, frame in enumerate(frames):
+            assert rec.add(frame, action=i % 5, reward=i * 0.5, timestamp_us=1000 + i,
+                           features=[0.1, None, 0.3, None], env_id=i % envs,
+                           flags=recorder.EPISODE_START if i < envs else 0, step=i)
+    return rec.stats()
+
+
+@pytest.mark.parametrize("codec", ["raw", "delta"])
+def test_round_trip(codec):
+    frames = _frames(11)   # two full chunks and a partial one
+    with TemporaryDirectory() as tmpdir:
+        path = str(Path(tmpdir) / "run.gtt")
+        stats = _record(path, frames, codec)
+        assert stats["records"] == 11 and stats["chunks"] == 3 and not stats["write_error"]
+
+        traj = TrajectoryReader(path)
+        assert len(traj) == 11 and traj.obs_shape == SHAPE
+        assert traj.index["count"].tolist() == [4, 4, 3]
+        assert set(traj.index["codec"].tolist()) == {recorder.CODECS[codec]}
+        for i, frame in enumerate(frames):
+            assert np.array_equal(traj.obs(i), frame)
+        # Out of order (delta: from a keyframe again)
+        for i in (10, 3, 7, 0, -1):
+            assert np.array_equal(traj.obs(i), frames[i])
+
+        meta = traj.meta
+        assert meta["action"].tolist() == [i % 5 for i in range(11)]
+        assert np.allclose(meta["reward"], [i * 0.5 for i in range(11)])
+        assert meta["timestamp_us"].tolist() == [1000 + i for i in range(11)]
+        assert meta["env_id"].tolist() == [i % 2 for i in range(11)]
+        assert meta["step"].tolist() == list(range(11))
+        assert meta["flags"].tolist()[:3] == [recorder.EPISODE_START, recorder.EPISODE_START, 0]
+        assert np.allclose(meta["features"][0], [0.1, -1.0, 0.3, -1.0])
+
+        obs, batch_meta = traj.batch([5, 2])
+        assert np.array_equal(obs[0], frames[5]) and np.array_equal(obs[1], frames[2])
+        assert batch_meta["step"].tolist() == [5, 2]
+        with pytest.raises(IndexError):
+            traj.obs(11)
+        del traj
+
+
+@pytest.mark.parametrize("codec", ["raw", "delta"])
+def test_reader_rebuilds_missing_index(codec):
+    frames = _frames(9)
+    with TemporaryDirectory() as tmpdir:
+        path = Path(tmpdir) / "crashed.gtt"
+        _record(str(path), frames, codec)
+        # What a writer that died leaves: index_offset 0, the chunks intact
+        data = bytearray(path.read_bytes())
+        fields = list(HEADER.unpack_from(data))
+        fields[7] = fields[8] = fields[9] = 0     # record_count, index_offset, chunk_count
+        HEADER.pack_into(data, 0, *fields)
+        path.write_bytes(bytes(data))
+
+        traj = TrajectoryReader(str(path))
+        assert len(traj) == 9
+        for i, frame in enumerate(frames):
+            assert np.array_equal(traj.obs(i), frame)
+        del traj
+
+
+def test_rejects_chunks_too_large_for_delta_offsets():
+    with TemporaryDirectory() as tmpdir:
+        with pytest.raises(OSError):
+            TrajectoryRecorder(str(Path(tmpdir) / "big.gtt"), (3, 224, 224),
+                               chunk_records=40000, codec="delta")
+
+
+def test_native_add_rejects_non_uint8_obs():
+    if not recorder.HAS_NATIVE_RECORDER:
+        pytest.skip("needs the C++ extension")
+    clib = recorder.clib
+    with TemporaryDirectory() as tmpdir:
+        handle = clib.recorder_open(str(Path(tmpdir) / "run.gtt"), *SHAPE, 4, 2, recorder.CODECS["raw"])
+        size = int(np.prod(SHAPE))
+        for obs in (np.zeros(size, dtype=np.int8),            # same bytes, signed
+                    np.zeros(size // 4, dtype=np.float32)):    # same byte count
+            with pytest.raises(ValueError):
+                clib.recorder_add(handle, obs, 0, 0.0, 0)
+        assert clib.recorder_add(handle, np.zeros(SHAPE, dtype=np.uint8), 0, 0.0, 0)
+        assert clib.recorder_close(handle)["records"] == 1
@@ -0,0 +1,104 @@
+import sys
+from functools import partial
+from pathlib import Path
+
+import pytest
+
+np = pytest.importorskip("numpy")
+gym = pytest.importorskip("gymnasium")
+pytest.importorskip("stable_baselines3")
+
+# Project root = parent of tests/
+_project_root = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(_project_root))
+from src.gametrainer.shm_vec_env import ARENA_ALIGN, ObservationArena, ShmSubprocVecEnv, _publish
+
+SHAPE = (3, 4, 5)
+
+
+class CounterEnv(gym.Env):
+    """Every pixel of the observation is the env's id plus its step count."""
+
+    observation_space = gym.spaces.Box(0, 255, SHAPE, dtype=np.uint8)
+    action_space = gym.spaces.Discrete(2)
+
+    def __init__(self, env_id=0, episode=3):
+        self.env_id = env_id
+        self.episode = episode
+        self.steps = 0
+        self.obs_out = None
+
+    def _obs(self):
+        obs = self.obs_out if self.obs_out is not None else np.empty(SHAPE, np.uint8)
+        obs[...] = 10 * self.env_id + self.steps
+        return obs
+
+    def reset(self, seed=None, options=None):
+        self.steps = 0
+        return self._obs(), {}
+
+    def step(self, action):
+        self.steps += 1
+        return self._obs(), float(action), self.steps >= self.episode, False, {}
+
+
+def test_arena_layout():
+    arena = ObservationArena.create(3, 2, SHAPE, np.uint8)
+    try:
+        assert arena.seq.shape == (3, 2) and not arena.seq.any()
+        assert arena.obs.shape == (3, 2) + SHAPE
+        offset = arena.obs.__array_interface__["data"][0] - arena.seq.__array_interface__["data"][0]
+        assert offset >= arena.seq.nbytes and offset % ARENA_ALIGN == 0
+        assert arena.shm.size >= ObservationArena.nbytes(3, 2, SHAPE, np.uint8)
+        assert ObservationArena.nbytes(3, 2, SHAPE, np.uint8) == ARENA_ALIGN + 3 * 2 * 60
+
+        # A second mapping of the same block sees the same observations
+        other = ObservationArena.attach(arena.name, 3, 2, SHAPE, np.uint8)
+        other.obs[1, 1] = 7
+        other.seq[1, 1] = 5
+        assert (arena.obs[1, 1] == 7).all() and arena.seq[1, 1] == 5
+        assert not arena.obs[1, 0].any()
+        other.close()
+    finally:
+        arena.close()
+
+
+def test_publish_stamps_and_copies_only_foreign_arrays():
+    arena = ObservationArena.create(2, 2, SHAPE, np.uint8)
+    try:
+        # Written in place (obs_out): nothing to copy, just the stamp
+        target = arena.obs[1, 0]
+        target[...] = 3
+        _publish(arena, 1, 0, 9, target)
+        assert arena.seq[1, 0] == 9 and (arena.obs[1, 0] == 3).all()
+
+        # The env's own array: copied into its place
+        _publish(arena, 0, 1, 4, np.full(SHAPE, 8, np.uint8))
+        assert arena.seq[0, 1] == 4 and (arena.obs[0, 1] == 8).all()
+        assert arena.seq[0, 0] == 0 and not arena.obs[0, 0].any()
+    finally:
+        arena.close()
+
+
+def test_vec_env_steps_through_the_arena():
+    env = ShmSubprocVecEnv([partial(CounterEnv, i) for i in range(2)], slots=2, start_method="spawn")
+    try:
+        assert env.observation_space.shape == SHAPE
+        obs = env.reset()
+        assert obs.shape == (2,) + SHAPE
+        assert np.shares_memory(obs, env.arena.obs)
+        assert (obs[0] == 0).all() and (obs[1] == 10).all()
+
+        obs, rewards, dones, infos = env.step(np.array([1, 0]))
+        assert (obs[0] == 1).all() and (obs[1] == 11).all()
+        assert rewards.tolist() == [1.0, 0.0] and not dones.any()
+
+        env.step(np.array([0, 0]))
+        obs, _, dones, infos = env.step(np.array([0, 0]))
+        # Episode end: the terminal observation travels in info, the slot
+        # holds the first observation of the next episode
+        assert dones.all()
+        assert (infos[0]["terminal_observation"] == 3).all()
+        assert (obs[0] == 0).all() and (obs[1] == 10).all()
+    finally:
+        env.close()
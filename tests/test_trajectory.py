@@ -0,0 +1,42 @@
+import sys
+from pathlib import Path
+
+import pytest
+
+# Project root = parent of tests/
+_project_root = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(_project_root))
+
+clib = pytest.importorskip("src.gametrainer.clib")
+
+
+@pytest.mark.parametrize("dx, dy, duration_ms", [
+    (123, -45, 150),
+    (-300, 0, 333),
+    (0, 7, 8),
+    (5, 5, 0),
+    (1000, 1000, 10_000),
+])
+def test_deltas_sum_to_target(dx, dy, duration_ms):
+    path, step_us, seed = clib.trajectory(dx, dy, duration_ms, 42)
+    assert seed == 42
+    assert sum(p[0] for p in path) == dx
+    assert sum(p[1] for p in path) == dy
+    # The last step lands on duration_ms: steps - 1 waits of step_us, the
+    # rounding remainder (< one us per wait) spread over them.
+    gaps = len(path) - 1
+    if gaps:
+        assert 0 <= duration_ms * 1000 - step_us * gaps < gaps
+
+
+def test_fixed_seed_reproduces_path():
+    first = clib.trajectory(200, 80, 150, 1234)
+    assert clib.trajectory(200, 80, 150, 1234) == first
+    assert clib.trajectory(200, 80, 150, 4321)[0] != first[0]
+
+
+def test_huge_duration_is_clamped():
+    # 2^32 / 1000 ms used to wrap in 32-bit microseconds
+    path, step_us, _ = clib.trajectory(10, 10, 4_300_000, 7)
+    assert step_us * (len(path) - 1) <= 60_000 * 1000
+    assert step_us > 0